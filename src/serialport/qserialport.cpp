@@ -59,6 +59,139 @@ QSerialPortPrivate::QSerialPortPrivate()
     readBufferChunkSize = QSERIALPORT_BUFFERSIZE;
 }
 
+// Applies all the settings at once to an open device, so that a complete
+// reconfiguration costs a single update of the device settings.
+bool QSerialPortPrivate::updateSettings(qint32 newBaudRate, QSerialPort::DataBits newDataBits,
+                                        QSerialPort::Parity newParity, QSerialPort::StopBits newStopBits,
+                                        QSerialPort::FlowControl newFlowControl)
+{
+    Q_Q(QSerialPort);
+
+    QSerialPort::Directions baudRateDirections;
+    if (inputBaudRate != newBaudRate)
+        baudRateDirections |= QSerialPort::Input;
+    if (outputBaudRate != newBaudRate)
+        baudRateDirections |= QSerialPort::Output;
+    const bool dataBitsChanged = dataBits.value() != newDataBits;
+    const bool parityChanged = parity.value() != newParity;
+    const bool stopBitsChanged = stopBits.value() != newStopBits;
+    const bool flowControlChanged = flowControl.value() != newFlowControl;
+
+    if (!baudRateDirections && !dataBitsChanged && !parityChanged
+            && !stopBitsChanged && !flowControlChanged) {
+        return true;
+    }
+
+    if (q->isOpen() && !applySettings(newBaudRate, newDataBits, newParity,
+                                      newStopBits, newFlowControl)) {
+        return false;
+    }
+
+    if (baudRateDirections) {
+        inputBaudRate = newBaudRate;
+        outputBaudRate = newBaudRate;
+        emit q->baudRateChanged(newBaudRate, baudRateDirections);
+    }
+    if (dataBitsChanged) {
+        dataBits.removeBindingUnlessInWrapper();
+        dataBits.setValueBypassingBindings(newDataBits);
+        dataBits.notify();
+        emit q->dataBitsChanged(newDataBits);
+    }
+    if (parityChanged) {
+        parity.removeBindingUnlessInWrapper();
+        parity.setValueBypassingBindings(newParity);
+        parity.notify();
+        emit q->parityChanged(newParity);
+    }
+    if (stopBitsChanged) {
+        stopBits.removeBindingUnlessInWrapper();
+        stopBits.setValueBypassingBindings(newStopBits);
+        stopBits.notify();
+        emit q->stopBitsChanged(newStopBits);
+    }
+    if (flowControlChanged) {
+        flowControl.removeBindingUnlessInWrapper();
+        flowControl.setValueBypassingBindings(newFlowControl);
+        flowControl.notify();
+        emit q->flowControlChanged(newFlowControl);
+    }
+    return true;
+}
+
+// Returns the time it takes to transfer a single character, which consists of
+// a start bit, the data bits, an optional parity bit and the stop bits.
+qint64 QSerialPortPrivate::characterTimeNSecs() const
+{
+    int halfBits = 2 * (1 + int(dataBits.value()));
+    if (parity.value() != QSerialPort::NoParity)
+        halfBits += 2;
+    switch (stopBits.value()) {
+    case QSerialPort::OneAndHalfStop:
+        halfBits += 3;
+        break;
+    case QSerialPort::TwoStop:
+        halfBits += 4;
+        break;
+    default:
+        halfBits += 2;
+        break;
+    }
+    return halfBits * Q_INT64_C(500000000) / qMax(inputBaudRate, qint32(1));
+}
+
+// Records the stages of one read notification, which was activated and has
+// read bytesRead bytes at the given times, once its readyRead() has returned.
+void QSerialPortPrivate::recordLatencies(qint64 activated, qint64 read, qint64 bytesRead)
+{
+    const qint64 delivered = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+
+    // The bytes came in at the line rate, so the first one was received at
+    // least this long before the last one.
+    latencyRecorder->record(QSerialPort::QueueLatency, (bytesRead - 1) * characterTimeNSecs());
+    latencyRecorder->record(QSerialPort::ReadLatency, read - activated);
+    latencyRecorder->record(QSerialPort::ReadyReadLatency, delivered - read);
+    latencyRecorder->record(QSerialPort::NotificationLatency, delivered - activated);
+}
+
+// Small chunks are released by the ring buffers once they are drained,
+// whereas a chunk of up to the chunk size is kept for the next use.
+void QSerialPortPrivate::setIdleMemoryModeEnabled(bool enable)
+{
+    Q_Q(QSerialPort);
+
+    const int chunkSize = enable ? QSERIALPORT_IDLE_BUFFERSIZE : QSERIALPORT_BUFFERSIZE;
+    idleMemoryModeEnabled = enable;
+    readBufferChunkSize = chunkSize;
+    writeBufferChunkSize = chunkSize;
+
+    // The buffers of an open device exist for its open directions only.
+    if (q->isReadable())
+        buffer.setChunkSize(chunkSize);
+    if (q->isWritable())
+        writeBuffer.setChunkSize(chunkSize);
+}
+
+qint64 QSerialPortPrivate::memoryFootprint() const
+{
+    Q_Q(const QSerialPort);
+
+    qint64 footprint = sizeof(QSerialPort) + sizeof(QSerialPortPrivate)
+            + systemLocation.capacity() * qint64(sizeof(QChar));
+
+    // The ring buffers do not tell their capacity. Their data is held in
+    // chunks of at least the chunk size, and a drained buffer keeps one.
+    if (q->isReadable())
+        footprint += qMax(buffer.size(), readBufferChunkSize);
+    if (q->isWritable())
+        footprint += qMax(writeBuffer.size(), writeBufferChunkSize);
+
+    if (latencyRecorder)
+        footprint += sizeof(QSerialPortLatencyRecorder);
+
+    return footprint + platformMemoryFootprint();
+}
+
 void QSerialPortPrivate::setError(const QSerialPortErrorInfo &errorInfo)
 {
     Q_Q(QSerialPort);
@@ -91,6 +224,8 @@ void QSerialPortPrivate::setError(const QSerialPortErrorInfo &errorInfo)
 
     \note The serial port is always opened with exclusive access
     (that is, no other process or thread can access an already opened serial port).
+    On Unix, the way this access is enforced can be selected with
+    setLockingPolicy().
 
     Use the close() method to close the port and cancel the I/O operations.
 
@@ -331,6 +466,59 @@ void QSerialPortPrivate::setError(const QSerialPortErrorInfo &errorInfo)
     \sa QSerialPort::error
 */
 
+/*!
+    \enum QSerialPort::LockingPolicy
+    \since 6.6
+
+    This enum describes how exclusive access to the serial port is enforced
+    when the port is opened on Unix.
+
+    \value LockFileLocking      A UUCP style lock file is created in the
+                                system lock directory before the device is
+                                opened, and the device is additionally put
+                                into exclusive mode (\c TIOCEXCL). This
+                                protects the port against all programs that
+                                honor lock files. This is the default.
+    \value FlockLocking         An advisory \c flock() lock is placed on the
+                                device file descriptor, and the device is put
+                                into exclusive mode. No file is written.
+    \value ExclusiveModeLocking Only the exclusive mode of the device is set.
+    \value NoLocking            No locking is performed at all.
+
+    \note On Windows, serial ports are always opened for exclusive access by
+    the operating system, and the locking policy has no effect.
+
+    \sa setLockingPolicy()
+*/
+
+/*!
+    \enum QSerialPort::LatencyStage
+    \since 6.6
+
+    This enum describes the stages of handling incoming data for which
+    latencies are recorded when setLatencyRecordingEnabled() is enabled.
+    Each time the port is notified of incoming data, one value is recorded
+    for every stage.
+
+    \value QueueLatency         The time that must at least have passed
+                                between the arrival of the first and the last
+                                of the bytes read, derived from their number
+                                and the character time at the current
+                                settings. Large values show that the event
+                                loop did not get to the port in time.
+    \value ReadLatency          The time from the notification to the data
+                                being read from the device into the read
+                                buffer.
+    \value ReadyReadLatency     The time spent in the readyRead() handlers.
+    \value NotificationLatency  The time from the notification to the return
+                                of the readyRead() handlers.
+
+    \note Devices that do not transfer the data at the configured baud rate,
+    such as USB CDC ACM adapters, make the QueueLatency meaningless.
+
+    \sa latencyHistogram()
+*/
+
 
 
 /*!
@@ -370,7 +558,7 @@ QSerialPort::QSerialPort(const QSerialPortInfo &serialPortInfo, QObject *parent)
 QSerialPort::~QSerialPort()
 {
     /**/
-    if (isOpen())
+    if (isOpen() || isSuspended())
         close();
 }
 
@@ -385,7 +573,10 @@ QSerialPort::~QSerialPort()
 void QSerialPort::setPortName(const QString &name)
 {
     Q_D(QSerialPort);
-    d->systemLocation = QSerialPortInfoPrivate::portNameToSystemLocation(name);
+    const QString systemLocation = QSerialPortInfoPrivate::portNameToSystemLocation(name);
+    if (d->suspended && systemLocation != d->systemLocation)
+        close();
+    d->systemLocation = systemLocation;
 }
 
 /*!
@@ -396,7 +587,10 @@ void QSerialPort::setPortName(const QString &name)
 void QSerialPort::setPort(const QSerialPortInfo &serialPortInfo)
 {
     Q_D(QSerialPort);
-    d->systemLocation = serialPortInfo.systemLocation();
+    const QString systemLocation = serialPortInfo.systemLocation();
+    if (d->suspended && systemLocation != d->systemLocation)
+        close();
+    d->systemLocation = systemLocation;
 }
 
 /*!
@@ -440,7 +634,11 @@ QString QSerialPort::portName() const
     \warning The \a mode has to be QIODeviceBase::ReadOnly, QIODeviceBase::WriteOnly,
     or QIODeviceBase::ReadWrite. Other modes are unsupported.
 
-    \sa QIODeviceBase::OpenMode, setPort()
+    If the port was suspended with suspend() and is opened again with the
+    same access mode, the retained device is reused, and only the settings
+    changed in the meantime are applied to it.
+
+    \sa QIODeviceBase::OpenMode, setPort(), suspend()
 */
 bool QSerialPort::open(OpenMode mode)
 {
@@ -459,6 +657,16 @@ bool QSerialPort::open(OpenMode mode)
     }
 
     clearError();
+
+    if (d->suspended) {
+        if (d->resume(mode)) {
+            QIODevice::open(mode);
+            return true;
+        }
+        if (error() != QSerialPort::NoError)
+            clearError();
+    }
+
     if (!d->open(mode))
         return false;
 
@@ -477,6 +685,12 @@ bool QSerialPort::open(OpenMode mode)
 void QSerialPort::close()
 {
     Q_D(QSerialPort);
+    if (d->suspended) {
+        d->suspended = false;
+        d->close();
+        return;
+    }
+
     if (!isOpen()) {
         d->setError(QSerialPortErrorInfo(QSerialPort::NotOpenError));
         return;
@@ -487,6 +701,68 @@ void QSerialPort::close()
     QIODevice::close();
 }
 
+/*!
+    \since 6.6
+
+    Logically closes the serial port, but keeps the underlying device open.
+
+    The QIODevice is closed as with close(): the internal buffers are
+    discarded and no more data is read from the port. However, the native
+    handle, the lock of the port and its current settings are retained, so
+    that a subsequent open() with the same access mode takes effect
+    immediately, without locking, opening and configuring the device again.
+    The data received by the device while it is suspended is discarded on
+    reopening.
+
+    Calling close() on a suspended port, changing its name or destroying the
+    QSerialPort object releases the device.
+
+    Returns \c true on success; otherwise returns \c false and sets an error
+    code.
+
+    \note This function is only supported on Unix; on other platforms it sets
+    the UnsupportedOperationError error code.
+
+    \note The serial port has to be open before trying to suspend it;
+    otherwise returns \c false and sets the NotOpenError error code.
+
+    \sa isSuspended(), open(), close()
+*/
+bool QSerialPort::suspend()
+{
+    Q_D(QSerialPort);
+
+    if (!isOpen()) {
+        d->setError(QSerialPortErrorInfo(QSerialPort::NotOpenError));
+        qWarning("%s: device not open", Q_FUNC_INFO);
+        return false;
+    }
+
+    if (d->isBreakEnabled)
+        d->setBreakEnabled(false);
+
+    if (!d->suspend(openMode()))
+        return false;
+
+    d->isBreakEnabled.setValue(false);
+    QIODevice::close();
+    return true;
+}
+
+/*!
+    \since 6.6
+
+    Returns \c true if the serial port is suspended, i.e. it is logically
+    closed but retains the underlying device; otherwise returns \c false.
+
+    \sa suspend()
+*/
+bool QSerialPort::isSuspended() const
+{
+    Q_D(const QSerialPort);
+    return d->suspended;
+}
+
 /*!
     \property QSerialPort::baudRate
     \brief the data baud rate for the desired direction
@@ -1021,6 +1297,176 @@ void QSerialPort::setReadBufferSize(qint64 size)
         d->startAsyncRead();
 }
 
+/*!
+    \since 6.6
+
+    Returns the policy used to lock the serial port when it is opened.
+
+    \sa setLockingPolicy()
+*/
+QSerialPort::LockingPolicy QSerialPort::lockingPolicy() const
+{
+    Q_D(const QSerialPort);
+    return d->lockingPolicy;
+}
+
+/*!
+    \since 6.6
+
+    Sets the \a policy used to lock the serial port when it is opened.
+
+    The cheaper policies skip the lock file handling that is otherwise
+    performed on every open(), which is useful when the application is
+    known to be the only user of the serial ports on the system.
+
+    \note The policy is applied by the next call to open(); it does not
+    affect a port that is already open.
+
+    \sa lockingPolicy(), open()
+*/
+void QSerialPort::setLockingPolicy(LockingPolicy policy)
+{
+    Q_D(QSerialPort);
+    d->lockingPolicy = policy;
+}
+
+/*!
+    \since 6.6
+
+    Returns \c true if the port records the latencies of handling incoming
+    data; otherwise returns \c false. By default, they are not recorded.
+
+    \sa setLatencyRecordingEnabled()
+*/
+bool QSerialPort::isLatencyRecordingEnabled() const
+{
+    Q_D(const QSerialPort);
+    return d->latencyRecordingEnabled;
+}
+
+/*!
+    \since 6.6
+
+    Enables recording of the latencies of handling incoming data if \a enable
+    is \c true, or disables it otherwise.
+
+    While it is enabled, the port takes three timestamps each time it is
+    notified of incoming data: when the notification arrives, after the data
+    is read into the read buffer, and after the readyRead() handlers return.
+    The resulting durations are added to one histogram per
+    \l{QSerialPort::LatencyStage}{stage}, which tells whether a late reaction
+    to incoming data is due to the event loop, the device or the handlers.
+
+    The histograms take a few kilobytes, which are allocated when recording
+    is first enabled. Disabling the recording keeps the values recorded so far.
+
+    \sa latencyHistogram(), resetLatencyHistograms()
+*/
+void QSerialPort::setLatencyRecordingEnabled(bool enable)
+{
+    Q_D(QSerialPort);
+    if (enable && !d->latencyRecorder)
+        d->latencyRecorder = std::make_unique<QSerialPortLatencyRecorder>();
+    d->latencyRecordingEnabled = enable;
+}
+
+/*!
+    \since 6.6
+
+    Returns a snapshot of the latencies recorded for \a stage, or an empty
+    histogram if the recording was never enabled.
+
+    Once the recording is enabled, this function can be called from any
+    thread, also while the port is recording.
+
+    \sa setLatencyRecordingEnabled()
+*/
+QSerialPortLatencyHistogram QSerialPort::latencyHistogram(LatencyStage stage) const
+{
+    Q_D(const QSerialPort);
+    if (!d->latencyRecorder)
+        return QSerialPortLatencyHistogram();
+    return d->latencyRecorder->histogram(stage);
+}
+
+/*!
+    \since 6.6
+
+    Discards the latencies recorded so far.
+
+    \sa latencyHistogram()
+*/
+void QSerialPort::resetLatencyHistograms()
+{
+    Q_D(QSerialPort);
+    if (d->latencyRecorder)
+        d->latencyRecorder->reset();
+}
+
+/*!
+    \since 6.6
+
+    Returns \c true if the port keeps its memory footprint small while
+    little data flows; otherwise returns \c false. By default, it does not.
+
+    \sa setIdleMemoryModeEnabled()
+*/
+bool QSerialPort::isIdleMemoryModeEnabled() const
+{
+    Q_D(const QSerialPort);
+    return d->idleMemoryModeEnabled;
+}
+
+/*!
+    \since 6.6
+
+    Enables the idle memory mode if \a enable is \c true, or disables it
+    otherwise.
+
+    By default, the port is tuned for throughput: every read reserves room
+    for 32 KiB of data, and the read and write buffers each keep a chunk of
+    that size around once they are drained. In the idle memory mode, which
+    suits applications that keep hundreds of mostly idle ports open, the
+    port trades some throughput for a smaller footprint:
+
+    \list
+        \li Reads reserve no more than the data that is waiting, and the
+            buffers release their chunks once they are drained.
+        \li Writes start from the event loop without a write notifier. The
+            notifier is only created when the device does not take all the
+            data at once, and it is deleted once the write buffer is drained.
+    \endlist
+
+    \note On Windows, only the buffers of the device are affected.
+
+    \sa memoryFootprint()
+*/
+void QSerialPort::setIdleMemoryModeEnabled(bool enable)
+{
+    Q_D(QSerialPort);
+    d->setIdleMemoryModeEnabled(enable);
+}
+
+/*!
+    \since 6.6
+
+    Returns an estimate in bytes of the memory held by the port: the port
+    object and its private data, the read and write buffers, the notifiers
+    and the lock file of an open port, and the latency histograms.
+
+    The size of the objects that Qt allocates internally is estimated, and
+    the memory that the operating system uses for the device is not
+    included, so the value is meant for comparing configurations rather
+    than for accounting.
+
+    \sa setIdleMemoryModeEnabled()
+*/
+qint64 QSerialPort::memoryFootprint() const
+{
+    Q_D(const QSerialPort);
+    return d->memoryFootprint();
+}
+
 /*!
     \reimp
 
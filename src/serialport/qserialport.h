@@ -8,6 +8,7 @@
 #include <QtCore/qiodevice.h>
 
 #include <QtSerialPort/qserialportglobal.h>
+#include <QtSerialPort/qserialportlatencyhistogram.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -122,6 +123,22 @@ public:
     };
     Q_ENUM(SerialPortError)
 
+    enum LockingPolicy {
+        LockFileLocking,
+        FlockLocking,
+        ExclusiveModeLocking,
+        NoLocking
+    };
+    Q_ENUM(LockingPolicy)
+
+    enum LatencyStage {
+        QueueLatency,
+        ReadLatency,
+        ReadyReadLatency,
+        NotificationLatency
+    };
+    Q_ENUM(LatencyStage)
+
     explicit QSerialPort(QObject *parent = nullptr);
     explicit QSerialPort(const QString &name, QObject *parent = nullptr);
     explicit QSerialPort(const QSerialPortInfo &info, QObject *parent = nullptr);
@@ -135,6 +152,9 @@ public:
     bool open(OpenMode mode) override;
     void close() override;
 
+    bool suspend();
+    bool isSuspended() const;
+
     bool setBaudRate(qint32 baudRate, Directions directions = AllDirections);
     qint32 baudRate(Directions directions = AllDirections) const;
 
@@ -172,6 +192,18 @@ public:
     qint64 readBufferSize() const;
     void setReadBufferSize(qint64 size);
 
+    LockingPolicy lockingPolicy() const;
+    void setLockingPolicy(LockingPolicy policy);
+
+    bool isLatencyRecordingEnabled() const;
+    void setLatencyRecordingEnabled(bool enable);
+    QSerialPortLatencyHistogram latencyHistogram(LatencyStage stage) const;
+    void resetLatencyHistograms();
+
+    bool isIdleMemoryModeEnabled() const;
+    void setIdleMemoryModeEnabled(bool enable);
+    qint64 memoryFootprint() const;
+
     bool isSequential() const override;
 
     qint64 bytesAvailable() const override;
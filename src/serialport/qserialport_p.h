@@ -18,6 +18,7 @@
 //
 
 #include "qserialport.h"
+#include "qserialportlatencyhistogram_p.h"
 
 #include <qdeadlinetimer.h>
 
@@ -69,14 +70,21 @@ struct serial_struct {
 #define QSERIALPORT_BUFFERSIZE 32768
 #endif
 
+#ifndef QSERIALPORT_IDLE_BUFFERSIZE
+#define QSERIALPORT_IDLE_BUFFERSIZE 512
+#endif
+
 QT_BEGIN_NAMESPACE
 
 class QWinOverlappedIoNotifier;
+class QSerialPortTrafficCapturePrivate;
+class QSerialPortTransport;
 class QTimer;
 class QSocketNotifier;
 
 #if defined(Q_OS_UNIX)
 QString serialPortLockFilePath(const QString &portName);
+void serialPortLockDirectoryInvalidate();
 #endif
 
 class QSerialPortErrorInfo
@@ -98,6 +106,9 @@ public:
     bool open(QIODevice::OpenMode mode);
     void close();
 
+    bool suspend(QIODevice::OpenMode mode);
+    bool resume(QIODevice::OpenMode mode);
+
     QSerialPort::PinoutSignals pinoutSignals();
 
     bool setDataTerminalReady(bool set);
@@ -118,6 +129,12 @@ public:
     bool setParity(QSerialPort::Parity parity);
     bool setStopBits(QSerialPort::StopBits stopBits);
     bool setFlowControl(QSerialPort::FlowControl flowControl);
+    bool applySettings(qint32 baudRate, QSerialPort::DataBits dataBits,
+                       QSerialPort::Parity parity, QSerialPort::StopBits stopBits,
+                       QSerialPort::FlowControl flowControl);
+    bool updateSettings(qint32 baudRate, QSerialPort::DataBits dataBits,
+                        QSerialPort::Parity parity, QSerialPort::StopBits stopBits,
+                        QSerialPort::FlowControl flowControl);
 
     QSerialPortErrorInfo getSystemError(int systemErrorCode = -1) const;
 
@@ -132,7 +149,22 @@ public:
 
     static QList<qint32> standardBaudRates();
 
+    static QSerialPortPrivate *get(QSerialPort *port) { return port->d_func(); }
+
+    qint64 characterTimeNSecs() const;
+    void recordLatencies(qint64 activated, qint64 read, qint64 bytesRead);
+
+    void setIdleMemoryModeEnabled(bool enable);
+    qint64 memoryFootprint() const;
+    qint64 platformMemoryFootprint() const;
+
     qint64 readBufferMaxSize = 0;
+    qint64 lastReadTimestamp = 0;
+    QSerialPort::LockingPolicy lockingPolicy = QSerialPort::LockFileLocking;
+    std::unique_ptr<QSerialPortLatencyRecorder> latencyRecorder;
+    bool latencyRecordingEnabled = false;
+    bool idleMemoryModeEnabled = false;
+    QSerialPortTrafficCapturePrivate *capture = nullptr;
 
     void setBindableError(QSerialPort::SerialPortError error)
     { setError(error); }
@@ -164,6 +196,7 @@ public:
         &QSerialPortPrivate::setBindableFlowControl, QSerialPort::NoFlowControl)
 
     bool settingsRestoredOnClose = true;
+    bool suspended = false;
 
     bool setBindableBreakEnabled(bool isBreakEnabled)
     { return q_func()->setBreakEnabled(isBreakEnabled); }
@@ -210,6 +243,8 @@ public:
 
     static qint32 settingFromBaudRate(qint32 baudRate);
 
+    bool lockDescriptor();
+
     bool setTermios(const termios *tio);
     bool getTermios(termios *tio);
 
@@ -233,11 +268,23 @@ public:
 #endif
 
     bool readNotification();
+    qint64 writeNextBlock();
     bool startAsyncWrite();
     bool completeAsyncWrite();
+    void scheduleWrite();
+    void startScheduledWrite();
+    void releaseWriteNotifier();
 
     struct termios restoredTermios;
     int descriptor = -1;
+    // Not owned; when set, reads and writes go through it instead of the
+    // system calls.
+    QSerialPortTransport *transport = nullptr;
+
+    struct termios suspendedTermios;
+    QIODevice::OpenMode suspendedMode = QIODevice::NotOpen;
+    qint32 suspendedInputBaudRate = 0;
+    qint32 suspendedOutputBaudRate = 0;
 
     QSocketNotifier *readNotifier = nullptr;
     QSocketNotifier *writeNotifier = nullptr;
@@ -251,8 +298,12 @@ public:
 
     qint64 pendingBytesWritten = 0;
     bool writeSequenceStarted = false;
+    bool writeScheduled = false;
 
     std::unique_ptr<QLockFile> lockFileScopedPointer;
+    // The policy the port was opened with, which close() undoes; the
+    // lockingPolicy may have been changed since.
+    QSerialPort::LockingPolicy openLockingPolicy = QSerialPort::NoLocking;
 
 #endif
 };
@@ -5,16 +5,24 @@
 
 #include "qserialport_p.h"
 #include "qserialportinfo_p.h"
+#include "qserialporttrafficcapture_p.h"
+#include "qserialporttransport_p.h"
+
+#include <qtserialport_tracepoints_p.h>
 
 #include <QtCore/qelapsedtimer.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qsocketnotifier.h>
 #include <QtCore/qstandardpaths.h>
 
 #include <private/qcore_unix_p.h>
 
+#include <algorithm>
+
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/file.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -66,7 +74,34 @@ struct termios2 {
 
 QT_BEGIN_NAMESPACE
 
-QString serialPortLockFilePath(const QString &portName)
+namespace {
+
+enum {
+    // Estimates of the private data of the objects, and of the
+    // registration of a notifier with the event dispatcher, which are not
+    // visible from here.
+    NotifierFootprint = sizeof(QSocketNotifier) + 256,
+    LockFileFootprint = sizeof(QLockFile) + 64
+};
+
+// The lock directory is resolved once per process: probing all candidate
+// directories costs several stat() calls, which used to be paid on every
+// open(). It is resolved again only after a failure was reported through
+// serialPortLockDirectoryInvalidate().
+struct SerialPortLockDirectory
+{
+    void resolve();
+
+    QMutex mutex;
+    // The first readable and writable directory.
+    QString writablePath;
+    // The readable directories preceding writablePath, in which a lock
+    // file created by another process may still be found.
+    QStringList readOnlyPaths;
+    bool resolved = false;
+};
+
+static const QStringList &serialPortLockDirectoryCandidates()
 {
     static const QStringList lockDirectoryPaths = QStringList()
         << QStringLiteral("/var/lock")
@@ -81,33 +116,77 @@ QString serialPortLockFilePath(const QString &portName)
         << QStringLiteral("/data/local/tmp")
 #endif
         << QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    return lockDirectoryPaths;
+}
 
-    QString fileName = portName;
-    fileName.replace(QLatin1Char('/'), QLatin1Char('_'));
-    fileName.prepend(QLatin1String("/LCK.."));
-
-    QString lockFilePath;
+void SerialPortLockDirectory::resolve()
+{
+    writablePath.clear();
+    readOnlyPaths.clear();
 
+    const QStringList &lockDirectoryPaths = serialPortLockDirectoryCandidates();
     for (const QString &lockDirectoryPath : lockDirectoryPaths) {
-        const QString filePath = lockDirectoryPath + fileName;
-
         QFileInfo lockDirectoryInfo(lockDirectoryPath);
-        if (lockDirectoryInfo.isReadable()) {
-            if (QFile::exists(filePath) || lockDirectoryInfo.isWritable()) {
-                lockFilePath = filePath;
-                break;
-            }
+        if (!lockDirectoryInfo.isReadable())
+            continue;
+        if (lockDirectoryInfo.isWritable()) {
+            writablePath = lockDirectoryPath;
+            break;
         }
+        readOnlyPaths.append(lockDirectoryPath);
     }
 
-    if (lockFilePath.isEmpty()) {
+    resolved = !writablePath.isEmpty();
+}
+
+} // namespace
+
+Q_GLOBAL_STATIC(SerialPortLockDirectory, serialPortLockDirectory)
+
+static QString serialPortLockFilePath(const QString &lockDirectoryPath, const QString &portName)
+{
+    static const QLatin1String prefix("/LCK..");
+
+    QString lockFilePath;
+    lockFilePath.reserve(lockDirectoryPath.size() + prefix.size() + portName.size());
+    lockFilePath += lockDirectoryPath;
+    lockFilePath += prefix;
+    const qsizetype fileNameStart = lockFilePath.size();
+    lockFilePath += portName;
+    std::replace(lockFilePath.begin() + fileNameStart, lockFilePath.end(),
+                 QLatin1Char('/'), QLatin1Char('_'));
+    return lockFilePath;
+}
+
+QString serialPortLockFilePath(const QString &portName)
+{
+    SerialPortLockDirectory *lockDirectory = serialPortLockDirectory();
+    QMutexLocker locker(&lockDirectory->mutex);
+
+    if (!lockDirectory->resolved)
+        lockDirectory->resolve();
+
+    for (const QString &lockDirectoryPath : std::as_const(lockDirectory->readOnlyPaths)) {
+        const QString filePath = serialPortLockFilePath(lockDirectoryPath, portName);
+        if (QFile::exists(filePath))
+            return filePath;
+    }
+
+    if (lockDirectory->writablePath.isEmpty()) {
         qWarning("The following directories are not readable or writable for detaling with lock files\n");
-        for (const QString &lockDirectoryPath : lockDirectoryPaths)
+        for (const QString &lockDirectoryPath : serialPortLockDirectoryCandidates())
             qWarning("\t%s\n", qPrintable(lockDirectoryPath));
         return QString();
     }
 
-    return lockFilePath;
+    return serialPortLockFilePath(lockDirectory->writablePath, portName);
+}
+
+void serialPortLockDirectoryInvalidate()
+{
+    SerialPortLockDirectory *lockDirectory = serialPortLockDirectory();
+    QMutexLocker locker(&lockDirectory->mutex);
+    lockDirectory->resolved = false;
 }
 
 class ReadNotifier : public QSocketNotifier
@@ -272,19 +351,37 @@ static inline void qt_set_flowcontrol(termios *tio, QSerialPort::FlowControl flo
 
 bool QSerialPortPrivate::open(QIODevice::OpenMode mode)
 {
-    QString lockFilePath = serialPortLockFilePath(QSerialPortInfoPrivate::portNameFromSystemLocation(systemLocation));
-    bool isLockFileEmpty = lockFilePath.isEmpty();
-    if (isLockFileEmpty) {
-        qWarning("Failed to create a lock file for opening the device");
-        setError(QSerialPortErrorInfo(QSerialPort::PermissionError, QSerialPort::tr("Permission error while creating lock file")));
-        return false;
-    }
+    Q_TRACE_SCOPE(QSerialPortPrivate_open, systemLocation, mode.toInt());
 
-    auto newLockFileScopedPointer = std::make_unique<QLockFile>(lockFilePath);
+    std::unique_ptr<QLockFile> newLockFileScopedPointer;
+    openLockingPolicy = lockingPolicy;
 
-    if (!newLockFileScopedPointer->tryLock()) {
-        setError(QSerialPortErrorInfo(QSerialPort::PermissionError, QSerialPort::tr("Permission error while locking the device")));
-        return false;
+    if (openLockingPolicy == QSerialPort::LockFileLocking) {
+        QString lockFilePath = serialPortLockFilePath(QSerialPortInfoPrivate::portNameFromSystemLocation(systemLocation));
+        bool isLockFileEmpty = lockFilePath.isEmpty();
+        if (isLockFileEmpty) {
+            qWarning("Failed to create a lock file for opening the device");
+            setError(QSerialPortErrorInfo(QSerialPort::PermissionError, QSerialPort::tr("Permission error while creating lock file")));
+            return false;
+        }
+
+        newLockFileScopedPointer = std::make_unique<QLockFile>(lockFilePath);
+
+        if (!newLockFileScopedPointer->tryLock()
+                && newLockFileScopedPointer->error() != QLockFile::LockFailedError) {
+            // The cached lock directory may have become unusable, resolve it again.
+            serialPortLockDirectoryInvalidate();
+            const QString newLockFilePath = serialPortLockFilePath(QSerialPortInfoPrivate::portNameFromSystemLocation(systemLocation));
+            if (!newLockFilePath.isEmpty() && newLockFilePath != lockFilePath) {
+                newLockFileScopedPointer = std::make_unique<QLockFile>(newLockFilePath);
+                newLockFileScopedPointer->tryLock();
+            }
+        }
+
+        if (!newLockFileScopedPointer->isLocked()) {
+            setError(QSerialPortErrorInfo(QSerialPort::PermissionError, QSerialPort::tr("Permission error while locking the device")));
+            return false;
+        }
     }
 
     int flags = O_NOCTTY | O_NONBLOCK;
@@ -308,6 +405,12 @@ bool QSerialPortPrivate::open(QIODevice::OpenMode mode)
         return false;
     }
 
+    if (openLockingPolicy == QSerialPort::FlockLocking && !lockDescriptor()) {
+        qt_safe_close(descriptor);
+        descriptor = -1;
+        return false;
+    }
+
     if (!initialize(mode)) {
         qt_safe_close(descriptor);
         return false;
@@ -318,13 +421,33 @@ bool QSerialPortPrivate::open(QIODevice::OpenMode mode)
     return true;
 }
 
+bool QSerialPortPrivate::lockDescriptor()
+{
+#ifdef LOCK_EX
+    if (::flock(descriptor, LOCK_EX | LOCK_NB) == -1) {
+        if (errno == EWOULDBLOCK) {
+            setError(QSerialPortErrorInfo(QSerialPort::PermissionError, QSerialPort::tr("Permission error while locking the device")));
+        } else {
+            setError(getSystemError());
+        }
+        return false;
+    }
+    return true;
+#else
+    setError(QSerialPortErrorInfo(QSerialPort::UnsupportedOperationError,
+                                  QSerialPort::tr("Locking the device descriptor is not supported")));
+    return false;
+#endif
+}
+
 void QSerialPortPrivate::close()
 {
     if (settingsRestoredOnClose)
         ::tcsetattr(descriptor, TCSANOW, &restoredTermios);
 
 #ifdef TIOCNXCL
-    ::ioctl(descriptor, TIOCNXCL);
+    if (openLockingPolicy != QSerialPort::NoLocking)
+        ::ioctl(descriptor, TIOCNXCL);
 #endif
 
     delete readNotifier;
@@ -340,6 +463,69 @@ void QSerialPortPrivate::close()
     descriptor = -1;
     pendingBytesWritten = 0;
     writeSequenceStarted = false;
+    writeScheduled = false;
+}
+
+bool QSerialPortPrivate::suspend(QIODevice::OpenMode mode)
+{
+    if (!getTermios(&suspendedTermios))
+        return false;
+
+    setReadNotificationEnabled(false);
+    if (idleMemoryModeEnabled)
+        releaseWriteNotifier();
+    else
+        setWriteNotificationEnabled(false);
+
+    suspendedMode = mode;
+    suspendedInputBaudRate = inputBaudRate;
+    suspendedOutputBaudRate = outputBaudRate;
+
+    pendingBytesWritten = 0;
+    writeSequenceStarted = false;
+    suspended = true;
+    return true;
+}
+
+bool QSerialPortPrivate::resume(QIODevice::OpenMode mode)
+{
+    suspended = false;
+
+    if ((mode & QIODevice::ReadWrite) != (suspendedMode & QIODevice::ReadWrite)) {
+        close();
+        return false;
+    }
+
+    // Discard the data received while the port was suspended, as if it
+    // had been closed, this also verifies that the device is still there.
+    if (::tcflush(descriptor, TCIFLUSH) == -1) {
+        close();
+        return false;
+    }
+
+    // Only touch the device if the settings were changed in the meantime.
+    termios tio = suspendedTermios;
+    qt_set_common_props(&tio, mode);
+    qt_set_databits(&tio, dataBits);
+    qt_set_parity(&tio, parity);
+    qt_set_stopbits(&tio, stopBits);
+    qt_set_flowcontrol(&tio, flowControl);
+
+    if (::memcmp(&tio, &suspendedTermios, sizeof(termios)) != 0 && !setTermios(&tio)) {
+        close();
+        return false;
+    }
+
+    if ((inputBaudRate != suspendedInputBaudRate || outputBaudRate != suspendedOutputBaudRate)
+            && !setBaudRate()) {
+        close();
+        return false;
+    }
+
+    if (mode & QIODevice::ReadOnly)
+        setReadNotificationEnabled(true);
+
+    return true;
 }
 
 QSerialPort::PinoutSignals QSerialPortPrivate::pinoutSignals()
@@ -470,8 +656,14 @@ bool QSerialPortPrivate::waitForReadyRead(int msecs)
             return false;
         }
 
-        if (readyToRead)
-            return readNotification();
+        if (readyToRead) {
+            // Keep waiting after a notification without data.
+            const qint64 previousReadTimestamp = lastReadTimestamp;
+            if (!readNotification())
+                return false;
+            if (lastReadTimestamp != previousReadTimestamp)
+                return true;
+        }
 
         if (readyToWrite && !completeAsyncWrite())
             return false;
@@ -499,8 +691,14 @@ bool QSerialPortPrivate::waitForBytesWritten(int msecs)
         if (readyToRead && !readNotification())
             return false;
 
-        if (readyToWrite)
-            return completeAsyncWrite();
+        if (readyToWrite) {
+            // Keep waiting while the previous write was refused.
+            const bool hadPendingBytes = pendingBytesWritten > 0;
+            if (!completeAsyncWrite())
+                return false;
+            if (hadPendingBytes)
+                return true;
+        }
     }
     return false;
 }
@@ -721,6 +919,44 @@ bool QSerialPortPrivate::setFlowControl(QSerialPort::FlowControl flowControl)
     return setTermios(&tio);
 }
 
+bool QSerialPortPrivate::applySettings(qint32 baudRate, QSerialPort::DataBits dataBits,
+                                       QSerialPort::Parity parity, QSerialPort::StopBits stopBits,
+                                       QSerialPort::FlowControl flowControl)
+{
+    if (baudRate <= 0) {
+        setError(QSerialPortErrorInfo(QSerialPort::UnsupportedOperationError, QSerialPort::tr("Invalid baud rate value")));
+        return false;
+    }
+
+    const bool baudRateChanged = inputBaudRate != baudRate || outputBaudRate != baudRate;
+    const qint32 unixBaudRate = QSerialPortPrivate::settingFromBaudRate(baudRate);
+    const bool customBaudRateSet = QSerialPortPrivate::settingFromBaudRate(inputBaudRate) <= 0
+            || QSerialPortPrivate::settingFromBaudRate(outputBaudRate) <= 0;
+
+    // Custom baud rates require their own ioctls, as does switching
+    // away from them. Otherwise, everything goes into a single update.
+    const bool baudRateInTermios = baudRateChanged && unixBaudRate > 0 && !customBaudRateSet;
+    if (baudRateChanged && !baudRateInTermios && !setBaudRate(baudRate, QSerialPort::AllDirections))
+        return false;
+
+    termios tio;
+    if (!getTermios(&tio))
+        return false;
+
+    qt_set_databits(&tio, dataBits);
+    qt_set_parity(&tio, parity);
+    qt_set_stopbits(&tio, stopBits);
+    qt_set_flowcontrol(&tio, flowControl);
+
+    if (baudRateInTermios && (::cfsetispeed(&tio, unixBaudRate) < 0
+                              || ::cfsetospeed(&tio, unixBaudRate) < 0)) {
+        setError(getSystemError());
+        return false;
+    }
+
+    return setTermios(&tio);
+}
+
 bool QSerialPortPrivate::startAsyncRead()
 {
     setReadNotificationEnabled(true);
@@ -730,11 +966,26 @@ bool QSerialPortPrivate::startAsyncRead()
 bool QSerialPortPrivate::readNotification()
 {
     Q_Q(QSerialPort);
+    Q_TRACE_SCOPE(QSerialPortPrivate_readNotification, descriptor, buffer.size());
+
+    const bool recordLatency = latencyRecordingEnabled;
+    const qint64 activated = recordLatency
+            ? QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs() : 0;
 
     // Always buffered, read data from the port into the read buffer
     qint64 newBytes = buffer.size();
     qint64 bytesToRead = QSERIALPORT_BUFFERSIZE;
 
+#ifdef FIONREAD
+    if (idleMemoryModeEnabled) {
+        // Reserve no more than what is waiting, rather than a full chunk
+        // that lingers in the read buffer until the data is read.
+        int queuedBytes = 0;
+        if (::ioctl(descriptor, FIONREAD, &queuedBytes) != -1)
+            bytesToRead = qBound(1, queuedBytes, QSERIALPORT_BUFFERSIZE);
+    }
+#endif
+
     if (readBufferMaxSize && bytesToRead > (readBufferMaxSize - buffer.size())) {
         bytesToRead = readBufferMaxSize - buffer.size();
         if (bytesToRead <= 0) {
@@ -747,11 +998,21 @@ bool QSerialPortPrivate::readNotification()
 
     char *ptr = buffer.reserve(bytesToRead);
     const qint64 readBytes = readFromPort(ptr, bytesToRead);
+    const int readErrorCode = errno;
+    if (readBytes > 0) {
+        lastReadTimestamp = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+        if (capture)
+            capture->record(QSerialPortTrafficCapture::ReceivedRecord, ptr, readBytes);
+    }
 
     buffer.chop(bytesToRead - qMax(readBytes, qint64(0)));
 
     if (readBytes <= 0) {
-        QSerialPortErrorInfo error = getSystemError();
+        // A notification without data, as after another reader took it,
+        // is not an error.
+        if (readBytes < 0 && (readErrorCode == EAGAIN || readErrorCode == EWOULDBLOCK))
+            return true;
+        QSerialPortErrorInfo error = getSystemError(readErrorCode);
         if (error.errorCode != QSerialPort::ResourceError)
             error.errorCode = QSerialPort::ReadError;
         else
@@ -771,26 +1032,46 @@ bool QSerialPortPrivate::readNotification()
         emittedReadyRead = false;
     }
 
+    if (recordLatency)
+        recordLatencies(activated, lastReadTimestamp, readBytes);
+
     return true;
 }
 
-bool QSerialPortPrivate::startAsyncWrite()
+qint64 QSerialPortPrivate::writeNextBlock()
 {
-    if (writeBuffer.isEmpty() || writeSequenceStarted)
-        return true;
-
     // Attempt to write it all in one chunk.
-    qint64 written = writeToPort(writeBuffer.readPointer(), writeBuffer.nextDataBlockSize());
+    const qint64 bytesToWrite = writeBuffer.nextDataBlockSize();
+    qint64 written = writeToPort(writeBuffer.readPointer(), bytesToWrite);
+    const int writeErrorCode = errno;
+    // The output queue of the driver is full; retry once it drains.
+    if (written < 0 && (writeErrorCode == EAGAIN || writeErrorCode == EWOULDBLOCK))
+        written = 0;
+    Q_TRACE(QSerialPortPrivate_startAsyncWrite, descriptor, bytesToWrite, written);
     if (written < 0) {
-        QSerialPortErrorInfo error = getSystemError();
+        QSerialPortErrorInfo error = getSystemError(writeErrorCode);
         if (error.errorCode != QSerialPort::ResourceError)
             error.errorCode = QSerialPort::WriteError;
         setError(error);
-        return false;
+        return -1;
     }
 
+    if (capture && written > 0)
+        capture->record(QSerialPortTrafficCapture::TransmittedRecord, writeBuffer.readPointer(), written);
+
     writeBuffer.free(written);
     pendingBytesWritten += written;
+    return written;
+}
+
+bool QSerialPortPrivate::startAsyncWrite()
+{
+    if (writeBuffer.isEmpty() || writeSequenceStarted)
+        return true;
+
+    if (writeNextBlock() < 0)
+        return false;
+
     writeSequenceStarted = true;
 
     if (!isWriteNotificationEnabled())
@@ -801,6 +1082,7 @@ bool QSerialPortPrivate::startAsyncWrite()
 bool QSerialPortPrivate::completeAsyncWrite()
 {
     Q_Q(QSerialPort);
+    Q_TRACE(QSerialPortPrivate_completeAsyncWrite, descriptor, pendingBytesWritten);
 
     if (pendingBytesWritten > 0) {
         if (!emittedBytesWritten) {
@@ -814,17 +1096,75 @@ bool QSerialPortPrivate::completeAsyncWrite()
     writeSequenceStarted = false;
 
     if (writeBuffer.isEmpty()) {
-        setWriteNotificationEnabled(false);
+        if (idleMemoryModeEnabled)
+            releaseWriteNotifier();
+        else
+            setWriteNotificationEnabled(false);
         return true;
     }
 
     return startAsyncWrite();
 }
 
+// In the idle memory mode, the writing starts from the event loop without
+// a write notifier, which is only needed when the driver does not take all
+// the data at once.
+void QSerialPortPrivate::scheduleWrite()
+{
+    Q_Q(QSerialPort);
+
+    if (writeScheduled || isWriteNotificationEnabled())
+        return;
+
+    writeScheduled = true;
+    QMetaObject::invokeMethod(q, [this]() { startScheduledWrite(); }, Qt::QueuedConnection);
+}
+
+void QSerialPortPrivate::startScheduledWrite()
+{
+    if (!writeScheduled)
+        return;
+    writeScheduled = false;
+
+    if (descriptor == -1 || suspended || writeSequenceStarted || writeBuffer.isEmpty())
+        return;
+
+    for (;;) {
+        const qint64 bytesToWrite = writeBuffer.nextDataBlockSize();
+        const qint64 written = writeNextBlock();
+        if (written < 0)
+            return;
+        if (written < bytesToWrite || writeBuffer.isEmpty())
+            break;
+    }
+
+    // The write stalled; go on when the port is writable again.
+    if (!writeBuffer.isEmpty()) {
+        writeSequenceStarted = true;
+        setWriteNotificationEnabled(true);
+        return;
+    }
+
+    completeAsyncWrite();
+}
+
+void QSerialPortPrivate::releaseWriteNotifier()
+{
+    if (!writeNotifier)
+        return;
+
+    // This may be called from the event handler of the notifier.
+    writeNotifier->setEnabled(false);
+    writeNotifier->deleteLater();
+    writeNotifier = nullptr;
+}
+
 inline bool QSerialPortPrivate::initialize(QIODevice::OpenMode mode)
 {
+    Q_TRACE_SCOPE(QSerialPortPrivate_initialize, descriptor);
+
 #ifdef TIOCEXCL
-    if (::ioctl(descriptor, TIOCEXCL) == -1)
+    if (openLockingPolicy != QSerialPort::NoLocking && ::ioctl(descriptor, TIOCEXCL) == -1)
         setError(getSystemError());
 #endif
 
@@ -855,13 +1195,18 @@ inline bool QSerialPortPrivate::initialize(QIODevice::OpenMode mode)
 qint64 QSerialPortPrivate::writeData(const char *data, qint64 maxSize)
 {
     writeBuffer.append(data, maxSize);
-    if (!writeBuffer.isEmpty() && !isWriteNotificationEnabled())
+    if (writeBuffer.isEmpty())
+        return maxSize;
+    if (idleMemoryModeEnabled)
+        scheduleWrite();
+    else if (!isWriteNotificationEnabled())
         setWriteNotificationEnabled(true);
     return maxSize;
 }
 
 bool QSerialPortPrivate::setTermios(const termios *tio)
 {
+    Q_TRACE(QSerialPortPrivate_setTermios, descriptor, quint32(tio->c_iflag), quint32(tio->c_cflag));
     if (::tcsetattr(descriptor, TCSANOW, tio) == -1) {
         setError(getSystemError());
         return false;
@@ -883,6 +1228,7 @@ QSerialPortErrorInfo QSerialPortPrivate::getSystemError(int systemErrorCode) con
 {
     if (systemErrorCode == -1)
         systemErrorCode = errno;
+    Q_TRACE(QSerialPortPrivate_systemError, descriptor, systemErrorCode);
 
     QSerialPortErrorInfo error;
     error.errorString = qt_error_string(systemErrorCode);
@@ -977,6 +1323,20 @@ void QSerialPortPrivate::setWriteNotificationEnabled(bool enable)
     }
 }
 
+qint64 QSerialPortPrivate::platformMemoryFootprint() const
+{
+    qint64 footprint = 0;
+    if (readNotifier)
+        footprint += NotifierFootprint;
+    if (writeNotifier)
+        footprint += NotifierFootprint;
+    if (lockFileScopedPointer) {
+        footprint += LockFileFootprint
+                + lockFileScopedPointer->fileName().size() * qint64(sizeof(QChar));
+    }
+    return footprint;
+}
+
 bool QSerialPortPrivate::waitForReadOrWrite(bool *selectForRead, bool *selectForWrite,
                                            bool checkRead, bool checkWrite,
                                            int msecs)
@@ -1013,18 +1373,26 @@ bool QSerialPortPrivate::waitForReadOrWrite(bool *selectForRead, bool *selectFor
 
 qint64 QSerialPortPrivate::readFromPort(char *data, qint64 maxSize)
 {
-    return qt_safe_read(descriptor, data, maxSize);
+    const qint64 bytesRead = transport ? transport->read(descriptor, data, maxSize)
+                                       : qt_safe_read(descriptor, data, maxSize);
+    // The caller checks errno after the read; a trace probe may clobber it.
+    const int readErrorCode = errno;
+    Q_TRACE(QSerialPortPrivate_readFromPort, descriptor, maxSize, bytesRead);
+    errno = readErrorCode;
+    return bytesRead;
 }
 
 qint64 QSerialPortPrivate::writeToPort(const char *data, qint64 maxSize)
 {
     qint64 bytesWritten = 0;
 #if defined(CMSPAR)
-    bytesWritten = qt_safe_write(descriptor, data, maxSize);
+    bytesWritten = transport ? transport->write(descriptor, data, maxSize)
+                             : qt_safe_write(descriptor, data, maxSize);
 #else
     if (parity != QSerialPort::MarkParity
             && parity != QSerialPort::SpaceParity) {
-        bytesWritten = qt_safe_write(descriptor, data, maxSize);
+        bytesWritten = transport ? transport->write(descriptor, data, maxSize)
+                                 : qt_safe_write(descriptor, data, maxSize);
     } else {// Perform parity emulation.
         bytesWritten = writePerChar(data, maxSize);
     }
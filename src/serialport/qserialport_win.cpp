@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qserialport_p.h"
+#include "qserialporttrafficcapture_p.h"
 #include "qwinoverlappedionotifier_p.h"
 
 #include <QtCore/qcoreevent.h>
@@ -186,6 +187,23 @@ void QSerialPortPrivate::close()
     handle = INVALID_HANDLE_VALUE;
 }
 
+bool QSerialPortPrivate::suspend(QIODevice::OpenMode mode)
+{
+    Q_UNUSED(mode);
+
+    setError(QSerialPortErrorInfo(QSerialPort::UnsupportedOperationError,
+                                  QSerialPort::tr("Suspending the device is not supported")));
+    return false;
+}
+
+bool QSerialPortPrivate::resume(QIODevice::OpenMode mode)
+{
+    Q_UNUSED(mode);
+
+    suspended = false;
+    return false;
+}
+
 QSerialPort::PinoutSignals QSerialPortPrivate::pinoutSignals()
 {
     DWORD modemStat = 0;
@@ -376,6 +394,23 @@ bool QSerialPortPrivate::setBaudRate(qint32 baudRate, QSerialPort::Directions di
     return setDcb(&dcb);
 }
 
+bool QSerialPortPrivate::applySettings(qint32 baudRate, QSerialPort::DataBits dataBits,
+                                       QSerialPort::Parity parity, QSerialPort::StopBits stopBits,
+                                       QSerialPort::FlowControl flowControl)
+{
+    DCB dcb;
+    if (!getDcb(&dcb))
+        return false;
+
+    qt_set_baudrate(&dcb, baudRate);
+    qt_set_databits(&dcb, dataBits);
+    qt_set_parity(&dcb, parity);
+    qt_set_stopbits(&dcb, stopBits);
+    qt_set_flowcontrol(&dcb, flowControl);
+
+    return setDcb(&dcb);
+}
+
 bool QSerialPortPrivate::setDataBits(QSerialPort::DataBits dataBits)
 {
     DCB dcb;
@@ -432,12 +467,22 @@ bool QSerialPortPrivate::completeAsyncCommunication(qint64 bytesTransferred)
 
 bool QSerialPortPrivate::completeAsyncRead(qint64 bytesTransferred)
 {
+    const bool recordLatency = latencyRecordingEnabled && bytesTransferred > 0;
+    const qint64 activated = recordLatency
+            ? QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs() : 0;
+
     if (bytesTransferred == qint64(-1)) {
         readStarted = false;
         return false;
     }
-    if (bytesTransferred > 0)
+    if (bytesTransferred > 0) {
+        lastReadTimestamp = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
         buffer.append(readChunkBuffer.constData(), bytesTransferred);
+        if (capture) {
+            capture->record(QSerialPortTrafficCapture::ReceivedRecord,
+                            readChunkBuffer.constData(), bytesTransferred);
+        }
+    }
 
     readStarted = false;
 
@@ -452,6 +497,9 @@ bool QSerialPortPrivate::completeAsyncRead(qint64 bytesTransferred)
     if (bytesTransferred > 0)
         emitReadyRead();
 
+    if (recordLatency)
+        recordLatencies(activated, lastReadTimestamp, bytesTransferred);
+
     return result;
 }
 
@@ -466,6 +514,10 @@ bool QSerialPortPrivate::completeAsyncWrite(qint64 bytesTransferred)
             return false;
         }
         Q_ASSERT(bytesTransferred == writeChunkBuffer.size());
+        if (capture) {
+            capture->record(QSerialPortTrafficCapture::TransmittedRecord,
+                            writeChunkBuffer.constData(), bytesTransferred);
+        }
         writeChunkBuffer.clear();
         emit q->bytesWritten(bytesTransferred);
         writeStarted = false;
@@ -607,6 +659,16 @@ OVERLAPPED *QSerialPortPrivate::waitForNotified(QDeadlineTimer deadline)
     return overlapped;
 }
 
+qint64 QSerialPortPrivate::platformMemoryFootprint() const
+{
+    qint64 footprint = readChunkBuffer.capacity() + writeChunkBuffer.capacity();
+    if (notifier)
+        footprint += sizeof(QWinOverlappedIoNotifier);
+    if (startAsyncWriteTimer)
+        footprint += sizeof(QTimer);
+    return footprint;
+}
+
 qint64 QSerialPortPrivate::queuedBytesCount(QSerialPort::Direction direction) const
 {
     COMSTAT comstat;
@@ -0,0 +1,443 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportchecksum.h"
+#include "qserialportchecksum_p.h"
+
+#include <QtCore/qendian.h>
+
+#include <private/qsimd_p.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// Lookup tables for the "slicing-by-8" algorithm: table[k][b] holds the
+// remainder of the byte b followed by k zero bytes, which lets us fold
+// eight input bytes per iteration. The remainders of the reflected
+// algorithms are kept in the low bits, the ones of the others in the high
+// bits of the table entries.
+struct CrcTable
+{
+    quint32 table[8][256] = {};
+
+    constexpr CrcTable(quint32 polynomial, int width, bool reflected)
+    {
+        for (quint32 byte = 0; byte < 256; ++byte) {
+            quint32 remainder = 0;
+            if (reflected) {
+                remainder = byte;
+                for (int bit = 0; bit < 8; ++bit)
+                    remainder = (remainder & 1) ? (remainder >> 1) ^ polynomial : remainder >> 1;
+            } else {
+                const quint32 alignedPolynomial = polynomial << (32 - width);
+                remainder = byte << 24;
+                for (int bit = 0; bit < 8; ++bit) {
+                    remainder = (remainder & 0x80000000)
+                            ? (remainder << 1) ^ alignedPolynomial : remainder << 1;
+                }
+            }
+            table[0][byte] = remainder;
+        }
+        for (int slice = 1; slice < 8; ++slice) {
+            for (quint32 byte = 0; byte < 256; ++byte) {
+                const quint32 previous = table[slice - 1][byte];
+                table[slice][byte] = reflected
+                        ? (previous >> 8) ^ table[0][previous & 0xFF]
+                        : (previous << 8) ^ table[0][previous >> 24];
+            }
+        }
+    }
+};
+
+constexpr CrcTable crc8Table(0x07, 8, false);
+constexpr CrcTable crc8MaximTable(0x8C, 8, true);
+constexpr CrcTable crc8RohcTable(0xE0, 8, true);
+constexpr CrcTable crc16ModbusTable(0xA001, 16, true);
+constexpr CrcTable crc16CcittTable(0x1021, 16, false);
+constexpr CrcTable crc16KermitTable(0x8408, 16, true);
+constexpr CrcTable crc32Table(0xEDB88320, 32, true);
+constexpr CrcTable crc32cTable(0x82F63B78, 32, true);
+
+struct CrcParameters
+{
+    const CrcTable *table;
+    int width;
+    quint32 initial;
+    quint32 finalXor;
+    bool reflected;
+};
+
+} // namespace
+
+static quint32 updateReflectedCrc(const CrcTable &crcTable, quint32 crc,
+                                  const uchar *data, qsizetype size)
+{
+    const auto &table = crcTable.table;
+    for (; size >= 8; data += 8, size -= 8) {
+        const quint32 low = qFromLittleEndian<quint32>(data) ^ crc;
+        const quint32 high = qFromLittleEndian<quint32>(data + 4);
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF]
+                ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+                ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF]
+                ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+    }
+    for (; size > 0; ++data, --size)
+        crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xFF];
+    return crc;
+}
+
+static quint32 updateNormalCrc(const CrcTable &crcTable, quint32 crc,
+                               const uchar *data, qsizetype size)
+{
+    const auto &table = crcTable.table;
+    for (; size >= 8; data += 8, size -= 8) {
+        const quint32 high = qFromBigEndian<quint32>(data) ^ crc;
+        const quint32 low = qFromBigEndian<quint32>(data + 4);
+        crc = table[7][high >> 24] ^ table[6][(high >> 16) & 0xFF]
+                ^ table[5][(high >> 8) & 0xFF] ^ table[4][high & 0xFF]
+                ^ table[3][low >> 24] ^ table[2][(low >> 16) & 0xFF]
+                ^ table[1][(low >> 8) & 0xFF] ^ table[0][low & 0xFF];
+    }
+    for (; size > 0; ++data, --size)
+        crc = (crc << 8) ^ table[0][(crc >> 24) ^ *data];
+    return crc;
+}
+
+#if defined(Q_PROCESSOR_X86) && QT_COMPILER_SUPPORTS_HERE(SSE4_2)
+QT_FUNCTION_TARGET(SSE4_2)
+static quint32 updateCrc32cSse42(quint32 crc, const uchar *data, qsizetype size)
+{
+#  if defined(Q_PROCESSOR_X86_64)
+    quint64 crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8)
+        crc64 = _mm_crc32_u64(crc64, qFromUnaligned<quint64>(data));
+    crc = quint32(crc64);
+#  endif
+    for (; size >= 4; data += 4, size -= 4)
+        crc = _mm_crc32_u32(crc, qFromUnaligned<quint32>(data));
+    for (; size > 0; ++data, --size)
+        crc = _mm_crc32_u8(crc, *data);
+    return crc;
+}
+#endif
+
+#if defined(Q_PROCESSOR_X86) && QT_COMPILER_SUPPORTS_HERE(PCLMUL)
+QT_FUNCTION_TARGET(PCLMUL)
+static inline __m128i foldCrc32(__m128i value, __m128i next, __m128i constants)
+{
+    const __m128i low = _mm_clmulepi64_si128(value, constants, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(value, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, low), next);
+}
+
+static inline __m128i loadCrc32Block(const uchar *data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+}
+
+// Folds the data 64 bytes at a time with carry-less multiplications, as
+// described in "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+// Instruction" by Intel. Requires a size of at least 64 that is a multiple
+// of 16.
+QT_FUNCTION_TARGET(PCLMUL)
+static quint32 updateCrc32Pclmul(quint32 crc, const uchar *data, qsizetype size)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124);
+    const __m128i polynomial = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_xor_si128(loadCrc32Block(data), _mm_cvtsi32_si128(int(crc)));
+    __m128i x2 = loadCrc32Block(data + 16);
+    __m128i x3 = loadCrc32Block(data + 32);
+    __m128i x4 = loadCrc32Block(data + 48);
+    data += 64;
+    size -= 64;
+
+    for (; size >= 64; data += 64, size -= 64) {
+        x1 = foldCrc32(x1, loadCrc32Block(data), k1k2);
+        x2 = foldCrc32(x2, loadCrc32Block(data + 16), k1k2);
+        x3 = foldCrc32(x3, loadCrc32Block(data + 32), k1k2);
+        x4 = foldCrc32(x4, loadCrc32Block(data + 48), k1k2);
+    }
+
+    x1 = foldCrc32(x1, x2, k3k4);
+    x1 = foldCrc32(x1, x3, k3k4);
+    x1 = foldCrc32(x1, x4, k3k4);
+    for (; size >= 16; data += 16, size -= 16)
+        x1 = foldCrc32(x1, loadCrc32Block(data), k3k4);
+
+    // Reduce to 64 bits, then to 32 bits with a Barrett reduction.
+    __m128i reduced = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), reduced);
+
+    reduced = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, reduced);
+
+    reduced = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), polynomial, 0x10);
+    reduced = _mm_clmulepi64_si128(_mm_and_si128(reduced, low32), polynomial, 0x00);
+    x1 = _mm_xor_si128(x1, reduced);
+
+    return quint32(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+}
+#endif
+
+static quint32 updateCrc32(quint32 crc, const uchar *data, qsizetype size)
+{
+#if defined(Q_PROCESSOR_X86) && QT_COMPILER_SUPPORTS_HERE(PCLMUL)
+    if (size >= 64 && qCpuHasFeature(PCLMUL)) {
+        const qsizetype foldedSize = size & ~qsizetype(15);
+        crc = updateCrc32Pclmul(crc, data, foldedSize);
+        data += foldedSize;
+        size -= foldedSize;
+    }
+#endif
+    return updateReflectedCrc(crc32Table, crc, data, size);
+}
+
+static quint32 updateCrc32c(quint32 crc, const uchar *data, qsizetype size)
+{
+#if defined(Q_PROCESSOR_X86) && QT_COMPILER_SUPPORTS_HERE(SSE4_2)
+    if (qCpuHasFeature(SSE4_2))
+        return updateCrc32cSse42(crc, data, size);
+#endif
+    return updateReflectedCrc(crc32cTable, crc, data, size);
+}
+
+static const CrcParameters *crcParameters(QSerialPortChecksum::Algorithm algorithm)
+{
+    static constexpr CrcParameters crc8 = { &crc8Table, 8, 0, 0, false };
+    static constexpr CrcParameters crc8Maxim = { &crc8MaximTable, 8, 0, 0, true };
+    static constexpr CrcParameters crc16Modbus = { &crc16ModbusTable, 16, 0xFFFF, 0, true };
+    static constexpr CrcParameters crc16CcittFalse = { &crc16CcittTable, 16, 0xFFFF, 0, false };
+    static constexpr CrcParameters crc16Kermit = { &crc16KermitTable, 16, 0, 0, true };
+    static constexpr CrcParameters crc16Xmodem = { &crc16CcittTable, 16, 0, 0, false };
+    static constexpr CrcParameters crc16X25 = { &crc16KermitTable, 16, 0xFFFF, 0xFFFF, true };
+    static constexpr CrcParameters crc32 = { &crc32Table, 32, 0xFFFFFFFF, 0xFFFFFFFF, true };
+    static constexpr CrcParameters crc32C = { &crc32cTable, 32, 0xFFFFFFFF, 0xFFFFFFFF, true };
+
+    switch (algorithm) {
+    case QSerialPortChecksum::Crc8:
+        return &crc8;
+    case QSerialPortChecksum::Crc8Maxim:
+        return &crc8Maxim;
+    case QSerialPortChecksum::Crc16Modbus:
+        return &crc16Modbus;
+    case QSerialPortChecksum::Crc16CcittFalse:
+        return &crc16CcittFalse;
+    case QSerialPortChecksum::Crc16Kermit:
+        return &crc16Kermit;
+    case QSerialPortChecksum::Crc16Xmodem:
+        return &crc16Xmodem;
+    case QSerialPortChecksum::Crc16X25:
+        return &crc16X25;
+    case QSerialPortChecksum::Crc32:
+        return &crc32;
+    case QSerialPortChecksum::Crc32C:
+        return &crc32C;
+    case QSerialPortChecksum::Lrc:
+    case QSerialPortChecksum::Xor:
+        break;
+    }
+    return nullptr;
+}
+
+quint16 qt_fcs16(quint16 fcs, const char *data, qsizetype size)
+{
+    return quint16(updateReflectedCrc(crc16KermitTable, fcs,
+                                      reinterpret_cast<const uchar *>(data), size));
+}
+
+quint32 qt_fcs32(quint32 fcs, const char *data, qsizetype size)
+{
+    return updateCrc32(fcs, reinterpret_cast<const uchar *>(data), size);
+}
+
+quint16 qt_crc16_modbus(quint16 crc, const char *data, qsizetype size)
+{
+    return quint16(updateReflectedCrc(crc16ModbusTable, crc,
+                                      reinterpret_cast<const uchar *>(data), size));
+}
+
+quint8 qt_fcs8(quint8 fcs, const char *data, qsizetype size)
+{
+    return quint8(updateReflectedCrc(crc8RohcTable, fcs,
+                                     reinterpret_cast<const uchar *>(data), size));
+}
+
+/*!
+    \class QSerialPortChecksum
+    \since 6.6
+
+    \brief Computes the checksums used by serial line protocols.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    QSerialPortChecksum computes the cyclic redundancy checks and the simple
+    checksums that protect the frames of many serial protocols. The data may
+    be added in several parts with addData(), for example block by block as
+    it arrives from a device, without collecting it into a single buffer
+    first. Use checksum() to compute the checksum of a single buffer.
+
+    The CRCs are computed eight bytes at a time with lookup tables generated
+    at compile time. On x86 processors, the CRC-32 and CRC-32C algorithms use
+    the carry-less multiplication and the CRC32 instructions respectively,
+    when the processor supports them.
+
+    \code
+    QSerialPortChecksum crc(QSerialPortChecksum::Crc16Modbus);
+    crc.addData(header);
+    crc.addData(payload);
+    const quint16 value = crc.result();
+    \endcode
+*/
+
+/*!
+    \enum QSerialPortChecksum::Algorithm
+
+    This enum describes the supported checksum algorithms. The check value
+    is the checksum of the ASCII string "123456789".
+
+    \value Crc8             CRC-8 with the polynomial 0x07, as used by SMBus.
+                            Check value 0xF4.
+    \value Crc8Maxim        The CRC-8 of Dallas/Maxim 1-Wire devices.
+                            Check value 0xA1.
+    \value Crc16Modbus      The CRC-16 of Modbus RTU. Check value 0x4B37.
+    \value Crc16CcittFalse  CRC-16 with the CCITT polynomial 0x1021 and the
+                            initial value 0xFFFF. Check value 0x29B1.
+    \value Crc16Kermit      CRC-16 with the reflected CCITT polynomial, as
+                            used by Kermit. Check value 0x2189.
+    \value Crc16Xmodem      The CRC-16 of XMODEM and YMODEM. Check value 0x31C3.
+    \value Crc16X25         The CRC-16 of X.25 and the FCS-16 of PPP and HDLC.
+                            Check value 0x906E.
+    \value Crc32            The CRC-32 of Ethernet, ZMODEM and zlib, and the
+                            FCS-32 of PPP. Check value 0xCBF43926.
+    \value Crc32C           The CRC-32 with the Castagnoli polynomial.
+                            Check value 0xE3069283.
+    \value Lrc              The longitudinal redundancy check of Modbus ASCII:
+                            the two's complement of the sum of all bytes.
+                            Check value 0x23.
+    \value Xor              The exclusive or of all bytes, as used by NMEA 0183.
+                            Check value 0x31.
+*/
+
+/*!
+    Constructs an object to compute checksums with the given \a algorithm.
+*/
+QSerialPortChecksum::QSerialPortChecksum(Algorithm algorithm)
+    : m_algorithm(algorithm)
+{
+    reset();
+}
+
+/*!
+    \fn QSerialPortChecksum::Algorithm QSerialPortChecksum::algorithm() const
+
+    Returns the algorithm of the checksum.
+*/
+
+/*!
+    Resets the object, so that a new checksum can be computed.
+*/
+void QSerialPortChecksum::reset()
+{
+    const CrcParameters *parameters = crcParameters(m_algorithm);
+    if (!parameters)
+        m_state = 0;
+    else if (parameters->reflected)
+        m_state = parameters->initial;
+    else
+        m_state = parameters->initial << (32 - parameters->width);
+}
+
+/*!
+    Adds the first \a length bytes of \a data to the checksum.
+*/
+void QSerialPortChecksum::addData(const char *data, qsizetype length)
+{
+    const uchar *ptr = reinterpret_cast<const uchar *>(data);
+
+    switch (m_algorithm) {
+    case Crc32:
+        m_state = updateCrc32(m_state, ptr, length);
+        return;
+    case Crc32C:
+        m_state = updateCrc32c(m_state, ptr, length);
+        return;
+    case Lrc: {
+        quint32 sum = m_state;
+        for (; length > 0; ++ptr, --length)
+            sum += *ptr;
+        m_state = sum & 0xFF;
+        return;
+    }
+    case Xor: {
+        quint64 value = 0;
+        for (; length >= 8; ptr += 8, length -= 8)
+            value ^= qFromUnaligned<quint64>(ptr);
+        value ^= value >> 32;
+        value ^= value >> 16;
+        value ^= value >> 8;
+        quint32 state = m_state ^ quint32(value & 0xFF);
+        for (; length > 0; ++ptr, --length)
+            state ^= *ptr;
+        m_state = state;
+        return;
+    }
+    default:
+        break;
+    }
+
+    const CrcParameters *parameters = crcParameters(m_algorithm);
+    if (parameters->reflected)
+        m_state = updateReflectedCrc(*parameters->table, m_state, ptr, length);
+    else
+        m_state = updateNormalCrc(*parameters->table, m_state, ptr, length);
+}
+
+/*!
+    \fn void QSerialPortChecksum::addData(QByteArrayView data)
+    \overload
+*/
+
+/*!
+    Returns the checksum of the data added so far. Only the low size() bytes
+    of the result are significant.
+*/
+quint32 QSerialPortChecksum::result() const
+{
+    if (m_algorithm == Lrc)
+        return (0x100 - m_state) & 0xFF;
+
+    const CrcParameters *parameters = crcParameters(m_algorithm);
+    if (!parameters)
+        return m_state;
+    if (parameters->reflected)
+        return m_state ^ parameters->finalXor;
+    return (m_state >> (32 - parameters->width)) ^ parameters->finalXor;
+}
+
+/*!
+    Returns the checksum of \a data computed with \a algorithm.
+*/
+quint32 QSerialPortChecksum::checksum(QByteArrayView data, Algorithm algorithm)
+{
+    QSerialPortChecksum checksum(algorithm);
+    checksum.addData(data);
+    return checksum.result();
+}
+
+/*!
+    Returns the size in bytes of the checksums computed with \a algorithm.
+*/
+int QSerialPortChecksum::size(Algorithm algorithm)
+{
+    const CrcParameters *parameters = crcParameters(algorithm);
+    return parameters ? parameters->width / 8 : 1;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,49 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTCHECKSUM_H
+#define QSERIALPORTCHECKSUM_H
+
+#include <QtCore/qbytearrayview.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class Q_SERIALPORT_EXPORT QSerialPortChecksum
+{
+public:
+    enum Algorithm {
+        Crc8,
+        Crc8Maxim,
+        Crc16Modbus,
+        Crc16CcittFalse,
+        Crc16Kermit,
+        Crc16Xmodem,
+        Crc16X25,
+        Crc32,
+        Crc32C,
+        Lrc,
+        Xor
+    };
+
+    explicit QSerialPortChecksum(Algorithm algorithm);
+
+    Algorithm algorithm() const { return m_algorithm; }
+
+    void reset();
+    void addData(const char *data, qsizetype length);
+    void addData(QByteArrayView data) { addData(data.data(), data.size()); }
+    quint32 result() const;
+
+    static quint32 checksum(QByteArrayView data, Algorithm algorithm);
+    static int size(Algorithm algorithm);
+
+private:
+    Algorithm m_algorithm;
+    quint32 m_state;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTCHECKSUM_H
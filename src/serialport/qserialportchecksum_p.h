@@ -0,0 +1,55 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTCHECKSUM_P_H
+#define QSERIALPORTCHECKSUM_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+enum : quint16 {
+    QtFcs16Initial = 0xFFFF,
+    QtFcs16Good = 0xF0B8
+};
+
+enum : quint32 {
+    QtFcs32Initial = 0xFFFFFFFF,
+    QtFcs32Good = 0xDEBB20E3
+};
+
+// PPP frame check sequences, as described in RFC 1662.
+quint16 qt_fcs16(quint16 fcs, const char *data, qsizetype size);
+quint32 qt_fcs32(quint32 fcs, const char *data, qsizetype size);
+
+// The CRC-16 of Modbus RTU, transmitted least significant byte first. The
+// CRC of a frame including its CRC is zero.
+enum : quint16 {
+    QtCrc16ModbusInitial = 0xFFFF
+};
+
+quint16 qt_crc16_modbus(quint16 crc, const char *data, qsizetype size);
+
+// The frame check sequence of 3GPP TS 27.010, transmitted as its ones
+// complement.
+enum : quint8 {
+    QtFcs8Initial = 0xFF,
+    QtFcs8Good = 0xCF
+};
+
+quint8 qt_fcs8(quint8 fcs, const char *data, qsizetype size);
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTCHECKSUM_P_H
@@ -0,0 +1,1175 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportfiletransfer.h"
+#include "qserialportfiletransfer_p.h"
+#include "qserialport.h"
+#include "qserialportchecksum.h"
+
+#include <QtCore/qdatetime.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qtimer.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum : char {
+    SOH = 0x01,
+    STX = 0x02,
+    EOT = 0x04,
+    ACK = 0x06,
+    BS = 0x08,
+    NAK = 0x15,
+    CAN = 0x18,
+    CPMEOF = 0x1A,
+    CRC = 'C'
+};
+
+enum : char {
+    ZPAD = '*',
+    ZDLE = 0x18,
+    ZBIN = 'A',
+    ZHEX = 'B',
+    ZBIN32 = 'C',
+    ZCRCE = 'h',
+    ZCRCG = 'i',
+    ZCRCQ = 'j',
+    ZCRCW = 'k',
+    ZRUB0 = 'l',
+    ZRUB1 = 'm',
+    XON = 0x11
+};
+
+enum : quint8 {
+    ZRQINIT = 0,
+    ZRINIT = 1,
+    ZACK = 3,
+    ZFILE = 4,
+    ZSKIP = 5,
+    ZNAK = 6,
+    ZABORT = 7,
+    ZFIN = 8,
+    ZRPOS = 9,
+    ZDATA = 10,
+    ZEOF = 11,
+    ZFERR = 12,
+    ZCHALLENGE = 14,
+    ZCAN = 16
+};
+
+enum : quint8 {
+    CANFC32 = 0x20
+};
+
+enum : qsizetype {
+    ShortBlockSize = 128,
+    LongBlockSize = 1024,
+    SubpacketSize = 1024,
+    OutputHighWatermark = 16384
+};
+
+} // namespace
+
+static bool needsEscape(char c, char previous)
+{
+    switch (quint8(c)) {
+    case 0x10: case 0x11: case 0x13: case 0x18:
+    case 0x90: case 0x91: case 0x93: case 0x98:
+        return true;
+    case 0x0D: case 0x8D:
+        // Telenet uses "@<CR>" as an escape sequence.
+        return (previous & 0x7F) == '@';
+    default:
+        return false;
+    }
+}
+
+static void appendEscaped(QByteArray &out, const char *data, qsizetype size)
+{
+    char previous = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        const char c = data[i];
+        if (needsEscape(c, previous)) {
+            out.append(ZDLE);
+            out.append(char(c ^ 0x40));
+        } else {
+            out.append(c);
+        }
+        previous = c;
+    }
+}
+
+static char unescape(char c)
+{
+    if (c == ZRUB0)
+        return char(0x7F);
+    if (c == ZRUB1)
+        return char(0xFF);
+    return char(c ^ 0x40);
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/*!
+    \class QSerialPortFileTransfer
+    \since 6.6
+
+    \brief Sends files over a serial port with the XMODEM, YMODEM and ZMODEM
+    protocols.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    QSerialPortFileTransfer implements the sending side of the classic file
+    transfer protocols, as used by boot loaders and terminal programs to
+    receive firmware images and other files. The transfer is driven by the
+    event loop: sendFile() or sendFiles() starts it and returns at once, and
+    the end of the transfer is reported with the finished() or the
+    errorOccurred() signal.
+
+    The protocol is selected with setProtocol():
+
+    \list
+        \li \l Xmodem sends a single file in blocks of 128 bytes, with
+            either an arithmetic checksum or a CRC, as requested by the
+            receiver.
+        \li \l Xmodem1K sends blocks of 1024 bytes when the receiver
+            requests CRC mode.
+        \li \l Ymodem sends a batch of files in blocks of 1024 bytes, with
+            the name, size and modification time of each file in a header
+            block.
+        \li \l Zmodem streams a batch of files without waiting for an
+            acknowledgment of each block. The receiver asks for a
+            retransmission from a given offset if data is lost.
+    \endlist
+
+    With ZMODEM, setWindowSize() limits the amount of data that may be sent
+    ahead of the last position acknowledged by the receiver. The window is
+    also limited by the buffer size the receiver announces, if any.
+
+    The files are mapped into memory while they are sent, so that the blocks
+    are built directly from the page cache.
+
+    The transfer takes over the read channel of the port while it is active.
+
+    \sa QSerialPort
+*/
+
+/*!
+    \enum QSerialPortFileTransfer::Protocol
+
+    This enum describes the file transfer protocols.
+
+    \value Xmodem       XMODEM with 128 byte blocks, checksum or CRC.
+    \value Xmodem1K     XMODEM with 1024 byte blocks in CRC mode.
+    \value Ymodem       YMODEM batch transfer with 1024 byte blocks.
+    \value Zmodem       ZMODEM streaming batch transfer.
+*/
+
+/*!
+    \enum QSerialPortFileTransfer::Error
+
+    This enum describes the reasons why a transfer failed.
+
+    \value NoError          No error occurred.
+    \value FileError        A file could not be opened or read.
+    \value CancelledError   The receiver cancelled the transfer.
+    \value TimeoutError     The receiver did not answer in time, after all
+                            retries.
+    \value ProtocolError    The receiver rejected a block too many times, or
+                            sent an invalid answer.
+    \value WriteError       The data could not be written to the port.
+    \value AbortedError     The transfer was aborted with abort().
+*/
+
+quint32 QSerialPortFileTransferPrivate::Header::position() const
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+bool QSerialPortFileTransferPrivate::openNextFile()
+{
+    closeFile();
+
+    if (++fileIndex >= fileNames.size())
+        return true;
+
+    file.setFileName(fileNames.at(fileIndex));
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail(QSerialPortFileTransfer::FileError);
+        return false;
+    }
+
+    fileSize = file.size();
+    if (fileSize > 0) {
+        if (uchar *mapped = file.map(0, fileSize)) {
+            fileData = reinterpret_cast<const char *>(mapped);
+        } else {
+            fileBuffer = file.readAll();
+            if (fileBuffer.size() != fileSize) {
+                fail(QSerialPortFileTransfer::FileError);
+                return false;
+            }
+            fileData = fileBuffer.constData();
+        }
+    }
+    return true;
+}
+
+void QSerialPortFileTransferPrivate::closeFile()
+{
+    // Closing the file also unmaps it.
+    file.close();
+    fileBuffer.clear();
+    fileData = nullptr;
+    fileSize = 0;
+    offset = 0;
+}
+
+bool QSerialPortFileTransferPrivate::hasFile() const
+{
+    return fileIndex >= 0 && fileIndex < fileNames.size();
+}
+
+QByteArray QSerialPortFileTransferPrivate::fileInformation() const
+{
+    QByteArray info;
+    if (!hasFile())
+        return info;
+
+    const QFileInfo fileInfo(file);
+    info = QFile::encodeName(fileInfo.fileName());
+    info.append('\0');
+    info.append(QByteArray::number(fileSize));
+    info.append(' ');
+    info.append(QByteArray::number(fileInfo.lastModified().toSecsSinceEpoch(), 8));
+    info.append('\0');
+    return info;
+}
+
+void QSerialPortFileTransferPrivate::readFromPort()
+{
+    if (phase == Idle || !port)
+        return;
+
+    const QByteArray data = port->readAll();
+    if (protocol != QSerialPortFileTransfer::Zmodem) {
+        for (char c : data) {
+            if (phase == Idle)
+                return;
+            handleBlockResponse(c);
+        }
+        return;
+    }
+
+    received.append(data);
+
+    // Five CAN characters in a row cancel a ZMODEM session.
+    if (received.contains(QByteArrayView("\x18\x18\x18\x18\x18"))) {
+        fail(QSerialPortFileTransfer::CancelledError);
+        return;
+    }
+
+    Header header;
+    while (phase != Idle && takeHeader(&header))
+        handleHeader(header);
+}
+
+void QSerialPortFileTransferPrivate::handleTimeout()
+{
+    if (phase == Idle)
+        return;
+
+    if (!port) {
+        fail(QSerialPortFileTransfer::WriteError);
+        return;
+    }
+    if (++retries > maximumRetries) {
+        fail(QSerialPortFileTransfer::TimeoutError);
+        return;
+    }
+
+    switch (phase) {
+    case WaitingForStart:
+        restartTimer();
+        break;
+    case WaitingForBlockAck:
+        if (headerPending)
+            sendHeaderBlock();
+        else
+            sendBlock();
+        break;
+    case WaitingForEotAck:
+        sendEot();
+        break;
+    case WaitingForReceiverInit:
+        startZmodem();
+        break;
+    case WaitingForFilePosition:
+        sendFileHeader();
+        break;
+    case SendingData:
+    case WaitingForDataAck:
+        // Go back to the last acknowledged position.
+        port->clear(QSerialPort::Output);
+        offset = acknowledgedOffset;
+        phase = SendingData;
+        sendDataHeader();
+        sendMoreData();
+        break;
+    case WaitingForEofAck:
+        sendBinaryHeader(ZEOF, quint32(fileSize));
+        restartTimer();
+        break;
+    case WaitingForFinish:
+        sendHexHeader(ZFIN, 0);
+        restartTimer();
+        break;
+    case Idle:
+        break;
+    }
+}
+
+void QSerialPortFileTransferPrivate::restartTimer()
+{
+    timer->start(timeout);
+}
+
+void QSerialPortFileTransferPrivate::fail(QSerialPortFileTransfer::Error transferError)
+{
+    Q_Q(QSerialPortFileTransfer);
+
+    if (phase == Idle)
+        return;
+
+    // Tell the receiver to give up, unless it did so itself.
+    if (transferError != QSerialPortFileTransfer::CancelledError && port && port->isOpen()) {
+        port->clear(QSerialPort::Output);
+        port->write(QByteArray(8, CAN) + QByteArray(8, BS));
+    }
+
+    phase = Idle;
+    timer->stop();
+    closeFile();
+    received.clear();
+    error = transferError;
+    emit q->errorOccurred(transferError);
+}
+
+void QSerialPortFileTransferPrivate::finish()
+{
+    Q_Q(QSerialPortFileTransfer);
+
+    phase = Idle;
+    timer->stop();
+    closeFile();
+    received.clear();
+    emit q->finished();
+}
+
+bool QSerialPortFileTransferPrivate::write(const QByteArray &data)
+{
+    if (!port || port->write(data) != data.size()) {
+        fail(QSerialPortFileTransfer::WriteError);
+        return false;
+    }
+    return true;
+}
+
+void QSerialPortFileTransferPrivate::handleBlockResponse(char response)
+{
+    Q_Q(QSerialPortFileTransfer);
+
+    // Two CAN characters in a row cancel an XMODEM or YMODEM transfer.
+    if (response == CAN) {
+        if (++cancelCount >= 2)
+            fail(QSerialPortFileTransfer::CancelledError);
+        return;
+    }
+    cancelCount = 0;
+
+    switch (phase) {
+    case WaitingForStart:
+        if (response == CRC)
+            crcMode = true;
+        else if (response == NAK)
+            crcMode = false;
+        else
+            return;
+        retries = 0;
+        if (headerPending)
+            sendHeaderBlock();
+        else if (offset < fileSize)
+            sendBlock();
+        else
+            sendEot();
+        break;
+
+    case WaitingForBlockAck:
+        if (response == NAK) {
+            if (++retries > maximumRetries)
+                fail(QSerialPortFileTransfer::ProtocolError);
+            else if (headerPending)
+                sendHeaderBlock();
+            else
+                sendBlock();
+            return;
+        }
+        if (response != ACK)
+            return;
+
+        retries = 0;
+        if (headerPending) {
+            headerPending = false;
+            if (!hasFile()) {
+                // The empty header block ends the batch.
+                finish();
+                return;
+            }
+            // The receiver asks for the data with another 'C'.
+            blockNumber = 1;
+            phase = WaitingForStart;
+            restartTimer();
+            return;
+        }
+
+        offset = qMin(offset + blockSize, fileSize);
+        ++blockNumber;
+        emit q->progress(file.fileName(), offset, fileSize);
+        if (phase == Idle)
+            return;
+        if (offset < fileSize)
+            sendBlock();
+        else
+            sendEot();
+        break;
+
+    case WaitingForEotAck:
+        if (response == NAK) {
+            // Many receivers reject the first EOT to guard against noise.
+            if (++retries > maximumRetries)
+                fail(QSerialPortFileTransfer::ProtocolError);
+            else
+                sendEot();
+            return;
+        }
+        if (response != ACK)
+            return;
+
+        retries = 0;
+        emit q->fileSent(file.fileName());
+        if (phase == Idle)
+            return;
+        if (protocol != QSerialPortFileTransfer::Ymodem) {
+            finish();
+            return;
+        }
+        if (!openNextFile())
+            return;
+        headerPending = true;
+        blockNumber = 0;
+        phase = WaitingForStart;
+        restartTimer();
+        break;
+
+    default:
+        break;
+    }
+}
+
+qsizetype QSerialPortFileTransferPrivate::blockPayloadSize() const
+{
+    if (!crcMode || protocol == QSerialPortFileTransfer::Xmodem)
+        return ShortBlockSize;
+    // YMODEM sends the tail of a file in a short block, to save time.
+    return fileSize - offset > ShortBlockSize ? LongBlockSize : ShortBlockSize;
+}
+
+void QSerialPortFileTransferPrivate::writeBlock(const char *data, qsizetype size,
+                                                qsizetype payloadSize, char padding)
+{
+    QByteArray block;
+    block.reserve(payloadSize + 5);
+    block.append(payloadSize == LongBlockSize ? STX : SOH);
+    block.append(char(blockNumber));
+    block.append(char(~blockNumber));
+    block.append(data, size);
+    block.append(payloadSize - size, padding);
+
+    const char *payload = block.constData() + 3;
+    if (crcMode) {
+        char crc[2];
+        qToBigEndian<quint16>(quint16(QSerialPortChecksum::checksum(
+                QByteArrayView(payload, payloadSize), QSerialPortChecksum::Crc16Xmodem)), crc);
+        block.append(crc, sizeof(crc));
+    } else {
+        quint8 sum = 0;
+        for (qsizetype i = 0; i < payloadSize; ++i)
+            sum += quint8(payload[i]);
+        block.append(char(sum));
+    }
+
+    if (!write(block))
+        return;
+    phase = WaitingForBlockAck;
+    restartTimer();
+}
+
+void QSerialPortFileTransferPrivate::sendBlock()
+{
+    blockSize = blockPayloadSize();
+    const qsizetype size = qMin<qint64>(blockSize, fileSize - offset);
+    writeBlock(fileData + offset, size, blockSize, CPMEOF);
+}
+
+void QSerialPortFileTransferPrivate::sendHeaderBlock()
+{
+    // Block 0 holds the file name and size, or nothing at the end of the
+    // batch. It is always sent with a CRC.
+    crcMode = true;
+    const QByteArray info = fileInformation();
+    blockSize = info.size() > ShortBlockSize ? LongBlockSize : ShortBlockSize;
+    writeBlock(info.constData(), qMin(info.size(), blockSize), blockSize, 0);
+}
+
+void QSerialPortFileTransferPrivate::sendEot()
+{
+    if (!write(QByteArray(1, EOT)))
+        return;
+    phase = WaitingForEotAck;
+    restartTimer();
+}
+
+void QSerialPortFileTransferPrivate::startZmodem()
+{
+    // Start the receiver on systems that run it on demand.
+    if (!write(QByteArrayLiteral("rz\r")))
+        return;
+    sendHexHeader(ZRQINIT, 0);
+    phase = WaitingForReceiverInit;
+    restartTimer();
+}
+
+// Removes the next valid header from the received data, and discards the
+// garbage in front of it. Returns false if no complete header is left.
+bool QSerialPortFileTransferPrivate::takeHeader(Header *header)
+{
+    for (;;) {
+        const qsizetype start = received.indexOf(ZPAD);
+        if (start < 0) {
+            received.clear();
+            return false;
+        }
+
+        const qsizetype size = received.size();
+        qsizetype i = start;
+        while (i < size && received.at(i) == ZPAD)
+            ++i;
+        if (i + 1 >= size) {
+            received.remove(0, start);
+            return false;
+        }
+        if (received.at(i) != ZDLE) {
+            received.remove(0, i);
+            continue;
+        }
+
+        const char format = received.at(i + 1);
+        i += 2;
+
+        quint8 bytes[9];
+        const qsizetype count = format == ZBIN32 ? 9 : 7;
+        bool valid = true;
+
+        if (format == ZHEX) {
+            if (size - i < 2 * count) {
+                received.remove(0, start);
+                return false;
+            }
+            for (qsizetype n = 0; n < count; ++n, i += 2) {
+                const int high = hexValue(received.at(i));
+                const int low = hexValue(received.at(i + 1));
+                valid = valid && high >= 0 && low >= 0;
+                bytes[n] = quint8(high << 4 | low);
+            }
+        } else if (format == ZBIN || format == ZBIN32) {
+            qsizetype n = 0;
+            while (n < count && i < size) {
+                char c = received.at(i++);
+                if (c == ZDLE) {
+                    if (i >= size)
+                        break;
+                    c = unescape(received.at(i++));
+                }
+                bytes[n++] = quint8(c);
+            }
+            if (n < count) {
+                received.remove(0, start);
+                return false;
+            }
+        } else {
+            received.remove(0, i);
+            continue;
+        }
+
+        received.remove(0, i);
+        if (!valid)
+            continue;
+
+        const QByteArrayView content(reinterpret_cast<const char *>(bytes), 5);
+        if (format == ZBIN32) {
+            if (QSerialPortChecksum::checksum(content, QSerialPortChecksum::Crc32)
+                    != qFromLittleEndian<quint32>(bytes + 5)) {
+                continue;
+            }
+        } else if (QSerialPortChecksum::checksum(content, QSerialPortChecksum::Crc16Xmodem)
+                   != qFromBigEndian<quint16>(bytes + 5)) {
+            continue;
+        }
+
+        header->type = bytes[0];
+        std::memcpy(header->data, bytes + 1, sizeof(header->data));
+        return true;
+    }
+}
+
+void QSerialPortFileTransferPrivate::handleHeader(const Header &header)
+{
+    Q_Q(QSerialPortFileTransfer);
+
+    switch (header.type) {
+    case ZRINIT:
+        if (phase == WaitingForReceiverInit) {
+            // ZF0 holds the capabilities, ZP0 and ZP1 the buffer size.
+            useCrc32 = header.data[3] & CANFC32;
+            receiverBufferSize = header.data[0] | header.data[1] << 8;
+            retries = 0;
+            if (!openNextFile())
+                return;
+        } else if (phase == WaitingForEofAck) {
+            retries = 0;
+            emit q->fileSent(file.fileName());
+            if (phase == Idle || !openNextFile())
+                return;
+        } else {
+            return;
+        }
+        if (hasFile()) {
+            sendFileHeader();
+        } else {
+            sendHexHeader(ZFIN, 0);
+            phase = WaitingForFinish;
+            restartTimer();
+        }
+        break;
+
+    case ZRPOS:
+        if (phase != WaitingForFilePosition && phase != SendingData
+                && phase != WaitingForDataAck && phase != WaitingForEofAck) {
+            return;
+        }
+        if (header.position() > fileSize) {
+            fail(QSerialPortFileTransfer::ProtocolError);
+            return;
+        }
+        if (phase == WaitingForFilePosition) {
+            retries = 0;
+        } else {
+            // The receiver lost data; drop what is still queued.
+            if (++retries > maximumRetries) {
+                fail(QSerialPortFileTransfer::ProtocolError);
+                return;
+            }
+            port->clear(QSerialPort::Output);
+        }
+        timer->stop();
+        offset = header.position();
+        acknowledgedOffset = offset;
+        phase = SendingData;
+        sendDataHeader();
+        sendMoreData();
+        break;
+
+    case ZACK:
+        if (phase != SendingData && phase != WaitingForDataAck)
+            return;
+        if (header.position() > acknowledgedOffset && header.position() <= offset) {
+            acknowledgedOffset = header.position();
+            retries = 0;
+        }
+        if (phase == WaitingForDataAck) {
+            // The frame ended with ZCRCW; a new one needs a new header.
+            phase = SendingData;
+            sendDataHeader();
+        }
+        timer->stop();
+        sendMoreData();
+        break;
+
+    case ZSKIP:
+        if (phase != WaitingForFilePosition && phase != SendingData
+                && phase != WaitingForDataAck) {
+            return;
+        }
+        port->clear(QSerialPort::Output);
+        retries = 0;
+        if (!openNextFile())
+            return;
+        if (hasFile()) {
+            sendFileHeader();
+        } else {
+            sendHexHeader(ZFIN, 0);
+            phase = WaitingForFinish;
+            restartTimer();
+        }
+        break;
+
+    case ZFIN:
+        if (phase != WaitingForFinish)
+            return;
+        // "Over and out"
+        if (write(QByteArrayLiteral("OO")))
+            finish();
+        break;
+
+    case ZNAK:
+        // The receiver got a damaged header; repeat it.
+        if (phase == WaitingForReceiverInit)
+            sendHexHeader(ZRQINIT, 0);
+        else if (phase == WaitingForFilePosition)
+            sendFileHeader();
+        else if (phase == WaitingForEofAck)
+            sendBinaryHeader(ZEOF, quint32(fileSize));
+        else if (phase == WaitingForFinish)
+            sendHexHeader(ZFIN, 0);
+        break;
+
+    case ZCHALLENGE:
+        sendHexHeader(ZACK, header.position());
+        break;
+
+    case ZABORT:
+    case ZFERR:
+    case ZCAN:
+        fail(QSerialPortFileTransfer::CancelledError);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void QSerialPortFileTransferPrivate::sendHexHeader(quint8 type, quint32 value)
+{
+    char bytes[7];
+    bytes[0] = char(type);
+    qToLittleEndian<quint32>(value, bytes + 1);
+    qToBigEndian<quint16>(quint16(QSerialPortChecksum::checksum(
+            QByteArrayView(bytes, 5), QSerialPortChecksum::Crc16Xmodem)), bytes + 5);
+
+    QByteArray out;
+    out.reserve(22);
+    out.append(ZPAD);
+    out.append(ZPAD);
+    out.append(ZDLE);
+    out.append(ZHEX);
+    out.append(QByteArrayView(bytes, sizeof(bytes)).toByteArray().toHex());
+    out.append('\r');
+    out.append(char(0x8A));
+    if (type != ZACK && type != ZFIN)
+        out.append(XON);
+    write(out);
+}
+
+void QSerialPortFileTransferPrivate::sendBinaryHeader(quint8 type, quint32 value)
+{
+    char bytes[9];
+    bytes[0] = char(type);
+    qToLittleEndian<quint32>(value, bytes + 1);
+    qsizetype size = 5;
+    if (useCrc32) {
+        qToLittleEndian<quint32>(QSerialPortChecksum::checksum(
+                QByteArrayView(bytes, 5), QSerialPortChecksum::Crc32), bytes + 5);
+        size += 4;
+    } else {
+        qToBigEndian<quint16>(quint16(QSerialPortChecksum::checksum(
+                QByteArrayView(bytes, 5), QSerialPortChecksum::Crc16Xmodem)), bytes + 5);
+        size += 2;
+    }
+
+    QByteArray out;
+    out.reserve(3 + 2 * size);
+    out.append(ZPAD);
+    out.append(ZDLE);
+    out.append(useCrc32 ? ZBIN32 : ZBIN);
+    appendEscaped(out, bytes, size);
+    write(out);
+}
+
+void QSerialPortFileTransferPrivate::sendFileHeader()
+{
+    const QByteArray info = fileInformation();
+
+    sendBinaryHeader(ZFILE, 0);
+    QByteArray out;
+    appendSubpacket(out, info.constData(), info.size(), ZCRCW);
+    if (!write(out))
+        return;
+    phase = WaitingForFilePosition;
+    restartTimer();
+}
+
+void QSerialPortFileTransferPrivate::sendDataHeader()
+{
+    sendBinaryHeader(ZDATA, quint32(offset));
+    frameStartOffset = offset;
+    ackRequestOffset = offset;
+}
+
+// Queues data subpackets until the output buffer of the port is full, the
+// window is exhausted or the file is complete.
+void QSerialPortFileTransferPrivate::sendMoreData()
+{
+    Q_Q(QSerialPortFileTransfer);
+
+    while (phase == SendingData && port) {
+        if (port->bytesToWrite() >= OutputHighWatermark)
+            return;
+
+        if (windowSize > 0 && offset - acknowledgedOffset >= windowSize) {
+            if (!timer->isActive())
+                restartTimer();
+            return;
+        }
+
+        qint64 size = qMin<qint64>(SubpacketSize, fileSize - offset);
+        if (receiverBufferSize > 0)
+            size = qMin(size, receiverBufferSize - (offset - frameStartOffset));
+        const qint64 end = offset + size;
+
+        char frameEnd = ZCRCG;
+        if (end >= fileSize) {
+            frameEnd = ZCRCE;
+        } else if (receiverBufferSize > 0 && end - frameStartOffset >= receiverBufferSize) {
+            frameEnd = ZCRCW;
+        } else if (windowSize > 0 && end - ackRequestOffset >= windowSize / 4) {
+            frameEnd = ZCRCQ;
+            ackRequestOffset = end;
+        }
+
+        QByteArray out;
+        out.reserve(2 * size + 16);
+        appendSubpacket(out, fileData + offset, size, frameEnd);
+        if (!write(out))
+            return;
+        offset = end;
+        emit q->progress(file.fileName(), offset, fileSize);
+
+        if (frameEnd == ZCRCE) {
+            sendBinaryHeader(ZEOF, quint32(fileSize));
+            phase = WaitingForEofAck;
+            restartTimer();
+        } else if (frameEnd == ZCRCW) {
+            phase = WaitingForDataAck;
+            restartTimer();
+        }
+    }
+}
+
+void QSerialPortFileTransferPrivate::appendSubpacket(QByteArray &out, const char *data,
+                                                     qsizetype size, char frameEnd) const
+{
+    appendEscaped(out, data, size);
+    out.append(ZDLE);
+    out.append(frameEnd);
+
+    // The CRC covers the frame end character as well.
+    char crc[4];
+    if (useCrc32) {
+        QSerialPortChecksum checksum(QSerialPortChecksum::Crc32);
+        checksum.addData(data, size);
+        checksum.addData(&frameEnd, 1);
+        qToLittleEndian<quint32>(checksum.result(), crc);
+        appendEscaped(out, crc, 4);
+    } else {
+        QSerialPortChecksum checksum(QSerialPortChecksum::Crc16Xmodem);
+        checksum.addData(data, size);
+        checksum.addData(&frameEnd, 1);
+        qToBigEndian<quint16>(quint16(checksum.result()), crc);
+        appendEscaped(out, crc, 2);
+    }
+
+    if (frameEnd == ZCRCW)
+        out.append(XON);
+}
+
+/*!
+    Constructs a new file transfer with the given \a parent, which sends
+    files on \a port.
+*/
+QSerialPortFileTransfer::QSerialPortFileTransfer(QSerialPort *port, QObject *parent)
+    : QObject(*new QSerialPortFileTransferPrivate, parent)
+{
+    Q_D(QSerialPortFileTransfer);
+
+    d->port = port;
+
+    d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
+    connect(d->timer, &QTimer::timeout, this, [d]() {
+        d->handleTimeout();
+    });
+
+    if (port) {
+        connect(port, &QIODevice::readyRead, this, [d]() {
+            d->readFromPort();
+        });
+        connect(port, &QIODevice::bytesWritten, this, [d]() {
+            d->sendMoreData();
+        });
+    }
+}
+
+/*!
+    Destroys the file transfer. A transfer that is still active is dropped
+    without notifying the receiver.
+*/
+QSerialPortFileTransfer::~QSerialPortFileTransfer()
+{
+}
+
+/*!
+    Returns the port on which the files are sent.
+*/
+QSerialPort *QSerialPortFileTransfer::port() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->port;
+}
+
+/*!
+    Sets the \a protocol used by the next transfer. The default is
+    \l Xmodem1K.
+*/
+void QSerialPortFileTransfer::setProtocol(Protocol protocol)
+{
+    Q_D(QSerialPortFileTransfer);
+    d->protocol = protocol;
+}
+
+/*!
+    Returns the protocol used by the transfers.
+*/
+QSerialPortFileTransfer::Protocol QSerialPortFileTransfer::protocol() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->protocol;
+}
+
+/*!
+    Sets the time to wait for an answer of the receiver to \a msecs
+    milliseconds. When the time is up, the last block or header is sent
+    again.
+
+    The default timeout is 10 seconds.
+*/
+void QSerialPortFileTransfer::setTimeout(int msecs)
+{
+    Q_D(QSerialPortFileTransfer);
+    d->timeout = qMax(msecs, 0);
+}
+
+/*!
+    Returns the time to wait for an answer of the receiver, in milliseconds.
+*/
+int QSerialPortFileTransfer::timeout() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->timeout;
+}
+
+/*!
+    Sets the number of times a block or header is sent again, after a
+    timeout or a rejection by the receiver, to \a retries. The default
+    is 10.
+*/
+void QSerialPortFileTransfer::setMaximumRetries(int retries)
+{
+    Q_D(QSerialPortFileTransfer);
+    d->maximumRetries = qMax(retries, 0);
+}
+
+/*!
+    Returns the number of times a block or header is sent again.
+*/
+int QSerialPortFileTransfer::maximumRetries() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->maximumRetries;
+}
+
+/*!
+    Sets the ZMODEM window to \a size bytes. At most this amount of data is
+    sent ahead of the last position acknowledged by the receiver, and an
+    acknowledgment is requested every quarter of the window.
+
+    The default size is 0, which streams the whole file without waiting
+    for acknowledgments.
+*/
+void QSerialPortFileTransfer::setWindowSize(qint64 size)
+{
+    Q_D(QSerialPortFileTransfer);
+    d->windowSize = qMax(size, qint64(0));
+}
+
+/*!
+    Returns the ZMODEM window size, in bytes.
+*/
+qint64 QSerialPortFileTransfer::windowSize() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->windowSize;
+}
+
+/*!
+    Starts sending the file \a fileName. Returns \c true if the transfer
+    was started.
+
+    \sa sendFiles()
+*/
+bool QSerialPortFileTransfer::sendFile(const QString &fileName)
+{
+    return sendFiles(QStringList(fileName));
+}
+
+/*!
+    Starts sending the files \a fileNames. Returns \c true if the transfer
+    was started.
+
+    The transfer is not started if another one is active, if the port is
+    not open, or if one of the files is not readable. XMODEM can send only
+    one file.
+
+    \sa finished(), errorOccurred()
+*/
+bool QSerialPortFileTransfer::sendFiles(const QStringList &fileNames)
+{
+    Q_D(QSerialPortFileTransfer);
+
+    if (d->phase != QSerialPortFileTransferPrivate::Idle || !d->port || !d->port->isOpen())
+        return false;
+    if (fileNames.isEmpty())
+        return false;
+    if (fileNames.size() > 1 && (d->protocol == Xmodem || d->protocol == Xmodem1K))
+        return false;
+    for (const QString &fileName : fileNames) {
+        const QFileInfo fileInfo(fileName);
+        if (!fileInfo.isFile() || !fileInfo.isReadable())
+            return false;
+    }
+
+    d->fileNames = fileNames;
+    d->fileIndex = -1;
+    d->error = NoError;
+    d->retries = 0;
+    d->cancelCount = 0;
+    d->received.clear();
+    d->acknowledgedOffset = 0;
+
+    if (d->protocol == Zmodem) {
+        // The first file is opened once the receiver is ready.
+        d->startZmodem();
+    } else {
+        // The phase is still Idle, so that a failure to open the file is
+        // not reported to a receiver that never heard of the transfer.
+        if (!d->openNextFile())
+            return false;
+        d->headerPending = d->protocol == Ymodem;
+        d->blockNumber = d->headerPending ? 0 : 1;
+        d->phase = QSerialPortFileTransferPrivate::WaitingForStart;
+        d->restartTimer();
+    }
+
+    // The receiver may have asked for the data already.
+    if (d->port->bytesAvailable() > 0) {
+        QMetaObject::invokeMethod(this, [d]() {
+            d->readFromPort();
+        }, Qt::QueuedConnection);
+    }
+    return d->phase != QSerialPortFileTransferPrivate::Idle;
+}
+
+/*!
+    Aborts the active transfer, and tells the receiver to cancel it. The
+    errorOccurred() signal is emitted with AbortedError.
+*/
+void QSerialPortFileTransfer::abort()
+{
+    Q_D(QSerialPortFileTransfer);
+    d->fail(AbortedError);
+}
+
+/*!
+    Returns \c true while a transfer is active.
+*/
+bool QSerialPortFileTransfer::isActive() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->phase != QSerialPortFileTransferPrivate::Idle;
+}
+
+/*!
+    Returns the error of the last transfer.
+*/
+QSerialPortFileTransfer::Error QSerialPortFileTransfer::error() const
+{
+    Q_D(const QSerialPortFileTransfer);
+    return d->error;
+}
+
+/*!
+    \fn void QSerialPortFileTransfer::progress(const QString &fileName, qint64 bytesSent, qint64 bytesTotal)
+
+    This signal is emitted whenever more of the file \a fileName was sent.
+    \a bytesSent is the position in the file, and \a bytesTotal its size.
+
+    With XMODEM and YMODEM, the position advances when a block is
+    acknowledged. With ZMODEM, it advances when the data is queued, and
+    goes back when the receiver asks for a retransmission.
+*/
+
+/*!
+    \fn void QSerialPortFileTransfer::fileSent(const QString &fileName)
+
+    This signal is emitted when the receiver confirmed the end of the file
+    \a fileName.
+*/
+
+/*!
+    \fn void QSerialPortFileTransfer::finished()
+
+    This signal is emitted when all files were sent.
+*/
+
+/*!
+    \fn void QSerialPortFileTransfer::errorOccurred(QSerialPortFileTransfer::Error error)
+
+    This signal is emitted when the transfer failed with \a error.
+*/
+
+QT_END_NAMESPACE
+
+#include "moc_qserialportfiletransfer.cpp"
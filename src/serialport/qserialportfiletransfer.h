@@ -0,0 +1,78 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTFILETRANSFER_H
+#define QSERIALPORTFILETRANSFER_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qstringlist.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPort;
+class QSerialPortFileTransferPrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortFileTransfer : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortFileTransfer)
+
+public:
+    enum Protocol {
+        Xmodem,
+        Xmodem1K,
+        Ymodem,
+        Zmodem
+    };
+    Q_ENUM(Protocol)
+
+    enum Error {
+        NoError,
+        FileError,
+        CancelledError,
+        TimeoutError,
+        ProtocolError,
+        WriteError,
+        AbortedError
+    };
+    Q_ENUM(Error)
+
+    explicit QSerialPortFileTransfer(QSerialPort *port, QObject *parent = nullptr);
+    ~QSerialPortFileTransfer();
+
+    QSerialPort *port() const;
+
+    void setProtocol(Protocol protocol);
+    Protocol protocol() const;
+
+    void setTimeout(int msecs);
+    int timeout() const;
+
+    void setMaximumRetries(int retries);
+    int maximumRetries() const;
+
+    void setWindowSize(qint64 size);
+    qint64 windowSize() const;
+
+    bool sendFile(const QString &fileName);
+    bool sendFiles(const QStringList &fileNames);
+    void abort();
+
+    bool isActive() const;
+    Error error() const;
+
+Q_SIGNALS:
+    void progress(const QString &fileName, qint64 bytesSent, qint64 bytesTotal);
+    void fileSent(const QString &fileName);
+    void finished();
+    void errorOccurred(QSerialPortFileTransfer::Error error);
+
+private:
+    Q_DISABLE_COPY(QSerialPortFileTransfer)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTFILETRANSFER_H
@@ -0,0 +1,127 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTFILETRANSFER_P_H
+#define QSERIALPORTFILETRANSFER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportfiletransfer.h"
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qpointer.h>
+
+#include <private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+class QSerialPortFileTransferPrivate : public QObjectPrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortFileTransfer)
+
+    enum Phase {
+        Idle,
+        // XMODEM and YMODEM
+        WaitingForStart,
+        WaitingForBlockAck,
+        WaitingForEotAck,
+        // ZMODEM
+        WaitingForReceiverInit,
+        WaitingForFilePosition,
+        SendingData,
+        WaitingForDataAck,
+        WaitingForEofAck,
+        WaitingForFinish
+    };
+
+    struct Header
+    {
+        quint8 type = 0;
+        quint8 data[4] = {};
+
+        quint32 position() const;
+    };
+
+    bool openNextFile();
+    void closeFile();
+    bool hasFile() const;
+    QByteArray fileInformation() const;
+
+    void readFromPort();
+    void handleTimeout();
+    void restartTimer();
+    void fail(QSerialPortFileTransfer::Error error);
+    void finish();
+    bool write(const QByteArray &data);
+
+    // XMODEM and YMODEM
+    void handleBlockResponse(char response);
+    void writeBlock(const char *data, qsizetype size, qsizetype payloadSize, char padding);
+    void sendBlock();
+    void sendHeaderBlock();
+    void sendEot();
+    qsizetype blockPayloadSize() const;
+
+    // ZMODEM
+    void startZmodem();
+    bool takeHeader(Header *header);
+    void handleHeader(const Header &header);
+    void sendHexHeader(quint8 type, quint32 value);
+    void sendBinaryHeader(quint8 type, quint32 value);
+    void sendFileHeader();
+    void sendDataHeader();
+    void sendMoreData();
+    void appendSubpacket(QByteArray &out, const char *data, qsizetype size, char frameEnd) const;
+
+    QPointer<QSerialPort> port;
+    QTimer *timer = nullptr;
+
+    QSerialPortFileTransfer::Protocol protocol = QSerialPortFileTransfer::Xmodem1K;
+    QSerialPortFileTransfer::Error error = QSerialPortFileTransfer::NoError;
+    int timeout = 10000;
+    int maximumRetries = 10;
+    qint64 windowSize = 0;
+
+    Phase phase = Idle;
+    int retries = 0;
+    QByteArray received;
+
+    QStringList fileNames;
+    qsizetype fileIndex = -1;
+    QFile file;
+    QByteArray fileBuffer;
+    const char *fileData = nullptr;
+    qint64 fileSize = 0;
+    qint64 offset = 0;
+
+    // XMODEM and YMODEM
+    bool crcMode = false;
+    bool headerPending = false;
+    quint8 blockNumber = 1;
+    qsizetype blockSize = 0;
+    int cancelCount = 0;
+
+    // ZMODEM
+    bool useCrc32 = false;
+    qint64 receiverBufferSize = 0;
+    qint64 acknowledgedOffset = 0;
+    qint64 ackRequestOffset = 0;
+    qint64 frameStartOffset = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTFILETRANSFER_P_H
@@ -0,0 +1,1357 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportframer.h"
+#include "qserialportframer_p.h"
+#include "qserialport.h"
+#include "qserialport_p.h"
+#include "qserialportchecksum.h"
+#include "qserialportchecksum_p.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qtimer.h>
+#include <private/qsimd_p.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum : char {
+    SlipEnd = char(0xC0),
+    SlipEscape = char(0xDB),
+    SlipEscapedEnd = char(0xDC),
+    SlipEscapedEscape = char(0xDD)
+};
+
+enum : int {
+    CobsMaximumBlockSize = 254
+};
+
+enum : char {
+    HdlcFlag = char(0x7E),
+    HdlcEscape = char(0x7D),
+    HdlcEscapeBit = char(0x20)
+};
+
+enum : char {
+    NmeaStart = '$',
+    NmeaEncapsulationStart = '!',
+    NmeaChecksumDelimiter = '*'
+};
+
+} // namespace
+
+// Returns the position of the first occurrence of \a first or \a second
+// in the range, or \a end if there is none. Payload bytes are far more
+// common than the special ones, so we compare a whole vector at once.
+static const char *findFirstOf(const char *begin, const char *end, char first, char second)
+{
+#if defined(__SSE2__)
+    const __m128i firstMask = _mm_set1_epi8(first);
+    const __m128i secondMask = _mm_set1_epi8(second);
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, firstMask),
+                                             _mm_cmpeq_epi8(chunk, secondMask));
+        const uint mask = uint(_mm_movemask_epi8(matches));
+        if (mask)
+            return begin + qCountTrailingZeroBits(mask);
+    }
+#elif defined(__ARM_NEON__) && defined(Q_PROCESSOR_ARM_64)
+    const uint8x16_t firstMask = vdupq_n_u8(uchar(first));
+    const uint8x16_t secondMask = vdupq_n_u8(uchar(second));
+    for (; end - begin >= 16; begin += 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uchar *>(begin));
+        const uint8x16_t matches = vorrq_u8(vceqq_u8(chunk, firstMask),
+                                            vceqq_u8(chunk, secondMask));
+        if (vmaxvq_u8(matches))
+            break;
+    }
+#endif
+    for (; begin != end; ++begin) {
+        if (*begin == first || *begin == second)
+            return begin;
+    }
+    return end;
+}
+
+// Returns the position of the first line feed or sentence start in the
+// range, or \a end if there is none.
+static const char *findNmeaSpecial(const char *begin, const char *end)
+{
+#if defined(__SSE2__)
+    const __m128i lineFeedMask = _mm_set1_epi8('\n');
+    const __m128i startMask = _mm_set1_epi8(NmeaStart);
+    const __m128i encapsulationStartMask = _mm_set1_epi8(NmeaEncapsulationStart);
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lineFeedMask),
+                                                          _mm_cmpeq_epi8(chunk, startMask)),
+                                             _mm_cmpeq_epi8(chunk, encapsulationStartMask));
+        const uint mask = uint(_mm_movemask_epi8(matches));
+        if (mask)
+            return begin + qCountTrailingZeroBits(mask);
+    }
+#elif defined(__ARM_NEON__) && defined(Q_PROCESSOR_ARM_64)
+    const uint8x16_t lineFeedMask = vdupq_n_u8(uchar('\n'));
+    const uint8x16_t startMask = vdupq_n_u8(uchar(NmeaStart));
+    const uint8x16_t encapsulationStartMask = vdupq_n_u8(uchar(NmeaEncapsulationStart));
+    for (; end - begin >= 16; begin += 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uchar *>(begin));
+        const uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(chunk, lineFeedMask),
+                                                     vceqq_u8(chunk, startMask)),
+                                            vceqq_u8(chunk, encapsulationStartMask));
+        if (vmaxvq_u8(matches))
+            break;
+    }
+#endif
+    for (; begin != end; ++begin) {
+        if (*begin == '\n' || *begin == NmeaStart || *begin == NmeaEncapsulationStart)
+            return begin;
+    }
+    return end;
+}
+
+static const char *findByte(const char *begin, const char *end, char byte)
+{
+    if (begin == end)
+        return end;
+    const void *found = std::memchr(begin, byte, size_t(end - begin));
+    return found ? static_cast<const char *>(found) : end;
+}
+
+static bool isHdlcSpecial(char byte, quint32 accm)
+{
+    const uchar value = uchar(byte);
+    return byte == HdlcFlag || byte == HdlcEscape || (value < 0x20 && (accm >> value) & 1);
+}
+
+// Returns the position of the first flag, escape or mapped control
+// character in the range, or \a end if there is none.
+static const char *findHdlcSpecial(const char *begin, const char *end, quint32 accm)
+{
+    if (!accm)
+        return findFirstOf(begin, end, HdlcFlag, HdlcEscape);
+
+#if defined(__SSE2__)
+    const __m128i flagMask = _mm_set1_epi8(HdlcFlag);
+    const __m128i escapeMask = _mm_set1_epi8(HdlcEscape);
+    const __m128i controlMask = _mm_set1_epi8(0x1F);
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(chunk, controlMask), chunk);
+        const __m128i candidates = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, flagMask),
+                                                             _mm_cmpeq_epi8(chunk, escapeMask)),
+                                                controls);
+        // Control characters outside of the map are still payload.
+        for (uint mask = uint(_mm_movemask_epi8(candidates)); mask; mask &= mask - 1) {
+            const char *candidate = begin + qCountTrailingZeroBits(mask);
+            if (isHdlcSpecial(*candidate, accm))
+                return candidate;
+        }
+    }
+#endif
+    for (; begin != end; ++begin) {
+        if (isHdlcSpecial(*begin, accm))
+            return begin;
+    }
+    return end;
+}
+
+static qsizetype frameCheckSequenceSize(QSerialPortFramer::FrameCheckSequence fcs)
+{
+    switch (fcs) {
+    case QSerialPortFramer::Fcs16:
+        return 2;
+    case QSerialPortFramer::Fcs32:
+        return 4;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*!
+    \class QSerialPortFramer
+    \since 6.6
+
+    \brief Splits the data stream of a serial port into frames.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    Many devices exchange packets delimited by byte stuffing, such as SLIP
+    (RFC 1055), COBS (Consistent Overhead Byte Stuffing) or the HDLC-like
+    framing of PPP (RFC 1662). A
+    QSerialPortFramer attached to an open QSerialPort decodes such frames
+    incrementally, as soon as the data arrives from the device, and encodes
+    the frames written with writeFrame().
+
+    The framer takes over the read channel of the port: the received data is
+    decoded directly from the read buffer of the port, without being copied
+    by QIODevice::read() first. The decoded frames are queued, and the
+    frameReceived() signal is emitted each time new frames are available.
+    Use readFrame() to take them from the queue.
+
+    A frame that cannot be decoded is dropped, and the frameError() signal
+    is emitted. Decoding resumes with the next frame delimiter.
+
+    Protocols that delimit their messages only by a silence on the line are
+    supported with the IdleGap protocol, and binary protocols that carry the
+    size of a message in its header with the LengthField protocol. The Nmea
+    protocol extracts the sentences of NMEA 0183 devices such as GNSS
+    receivers, whose fields can be read with QSerialPortNmeaSentence.
+
+    Instead of queuing the decoded frames, the framer can pass them to a
+    function set with setFrameHandler(). Frames of the LengthField and Nmea
+    protocols that are complete in the read buffer of the port are then
+    passed as a view into that buffer, without being copied.
+
+    If the read buffer of the port is limited with
+    QSerialPort::setReadBufferSize(), the framer stops taking data from the
+    port while the pending frames occupy as many bytes, and resumes as they
+    are read. The port in turn stops reading from the device when its own
+    buffer is full, so a slow reader holds back the device as if it read the
+    port directly. This does not apply to the IdleGap protocol, which
+    depends on the time the data arrived.
+
+    \sa QSerialPort
+*/
+
+/*!
+    \enum QSerialPortFramer::Protocol
+
+    This enum describes the framing protocols supported by the framer.
+
+    \value Slip     Serial Line Internet Protocol, as described in RFC 1055.
+                    Every frame is terminated, and preceded, by the END
+                    byte 0xC0. Empty frames are ignored.
+    \value Cobs     Consistent Overhead Byte Stuffing. Every frame is
+                    encoded without zero bytes, and terminated by a zero
+                    byte.
+    \value Hdlc     HDLC-like asynchronous framing, as used by PPP and
+                    described in RFC 1662. Frames are delimited by the flag
+                    byte 0x7E, and end with a frame check sequence. The
+                    flag, the control escape byte 0x7D and the control
+                    characters selected by asyncControlCharacterMap() are
+                    escaped.
+    \value IdleGap  Frames are delimited by a silence on the line of at
+                    least idleGap() character times. The frames are written
+                    unchanged, and it is up to the caller to leave the
+                    required silence between them.
+    \value LengthField  Frames start with a header that contains the size
+                    of the frame in a length field, as described for
+                    setLengthFieldOffset(). The frames, including their
+                    header, are decoded and written unchanged.
+    \value Nmea     NMEA 0183 sentences, which start with \c{$} or \c{!}
+                    and end with a line feed. The checksum of a sentence
+                    is verified if it has one, and removed together with
+                    the line terminator: a decoded frame looks like
+                    \c{$GPGGA,123519,...}. writeFrame() appends the
+                    checksum and the line terminator.
+*/
+
+/*!
+    \enum QSerialPortFramer::FrameError
+
+    This enum describes the errors that may occur while decoding frames.
+
+    \value NoFrameError         No error occurred.
+    \value MalformedFrameError  The frame contains an invalid escape
+                                sequence or is truncated, or the length
+                                field of a LengthField frame is smaller
+                                than its header.
+    \value OversizedFrameError  The frame is larger than maximumFrameSize().
+                                The rest of a LengthField frame is
+                                skipped.
+    \value ChecksumError        The frame check sequence of the frame does
+                                not match its contents.
+*/
+
+/*!
+    \enum QSerialPortFramer::FrameCheckSequence
+
+    This enum describes the frame check sequences of the Hdlc protocol.
+
+    \value NoFrameCheckSequence The frames carry no frame check sequence.
+    \value Fcs16                The 16-bit frame check sequence of RFC 1662.
+    \value Fcs32                The 32-bit frame check sequence of RFC 1662.
+*/
+
+void QSerialPortFramerPrivate::readFromPort()
+{
+    if (!port)
+        return;
+
+    // Decode straight from the read buffer of the port.
+    QSerialPortPrivate *portPrivate = QSerialPortPrivate::get(port);
+    const qsizetype framesBefore = frames.size();
+    if (protocol == QSerialPortFramer::IdleGap)
+        startIdleGapRead(portPrivate->buffer.size());
+
+    // The pending frames count against the read buffer size of the port.
+    // What is left in its buffer waits until they are read.
+    const qint64 limit = protocol != QSerialPortFramer::IdleGap ? portPrivate->readBufferMaxSize : 0;
+    while (!portPrivate->buffer.isEmpty()) {
+        qint64 blockSize = portPrivate->buffer.nextDataBlockSize();
+        if (limit > 0) {
+            if (pendingFrameBytes >= limit) {
+                readPaused = true;
+                break;
+            }
+            blockSize = qMin(blockSize, limit - pendingFrameBytes);
+        }
+        decode(portPrivate->buffer.readPointer(), blockSize);
+        portPrivate->buffer.free(blockSize);
+    }
+
+    // The read notifications may have been disabled by a full read buffer.
+    portPrivate->startAsyncRead();
+
+    if (protocol == QSerialPortFramer::IdleGap && frameStarted) {
+        const qint64 remaining = lastByteTimestamp + idleGapNSecs()
+                - QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+        idleGapTimer->start(int((qMax(remaining, qint64(0)) + 999999) / 1000000));
+    }
+
+    emitPendingSignals(framesBefore);
+}
+
+void QSerialPortFramerPrivate::emitPendingSignals(qsizetype framesBefore)
+{
+    Q_Q(QSerialPortFramer);
+
+    const QList<QSerialPortFramer::FrameError> errors = std::exchange(pendingErrors, {});
+    for (QSerialPortFramer::FrameError error : errors)
+        emit q->frameError(error);
+
+    if (frames.size() > framesBefore)
+        emit q->frameReceived();
+}
+
+void QSerialPortFramerPrivate::decode(const char *data, qsizetype size)
+{
+    switch (protocol) {
+    case QSerialPortFramer::Slip:
+        decodeSlip(data, size);
+        break;
+    case QSerialPortFramer::Cobs:
+        decodeCobs(data, size);
+        break;
+    case QSerialPortFramer::Hdlc:
+        decodeHdlc(data, size);
+        break;
+    case QSerialPortFramer::IdleGap:
+        appendPayload(data, size);
+        break;
+    case QSerialPortFramer::LengthField:
+        decodeLengthField(data, size);
+        break;
+    case QSerialPortFramer::Nmea:
+        decodeNmea(data, size);
+        break;
+    }
+}
+
+void QSerialPortFramerPrivate::decodeSlip(const char *data, qsizetype size)
+{
+    const char *ptr = data;
+    const char *const end = data + size;
+
+    while (ptr != end) {
+        if (escaped) {
+            escaped = false;
+            const char byte = *ptr++;
+            if (byte == SlipEscapedEnd) {
+                const char decoded = SlipEnd;
+                appendPayload(&decoded, 1);
+            } else if (byte == SlipEscapedEscape) {
+                const char decoded = SlipEscape;
+                appendPayload(&decoded, 1);
+            } else if (byte == SlipEnd) {
+                discardFrame(QSerialPortFramer::MalformedFrameError);
+                finishFrame();
+            } else {
+                discardFrame(QSerialPortFramer::MalformedFrameError);
+            }
+            continue;
+        }
+
+        const char *special = findFirstOf(ptr, end, SlipEnd, SlipEscape);
+        appendPayload(ptr, special - ptr);
+        ptr = special;
+        if (ptr == end)
+            break;
+
+        if (*ptr == SlipEnd)
+            finishFrame();
+        else
+            escaped = true;
+        ++ptr;
+    }
+}
+
+void QSerialPortFramerPrivate::decodeCobs(const char *data, qsizetype size)
+{
+    const char *ptr = data;
+    const char *const end = data + size;
+
+    while (ptr != end) {
+        const char *delimiter = findByte(ptr, end, '\0');
+
+        while (ptr != delimiter) {
+            if (cobsBlockRemaining == 0) {
+                if (cobsZeroPending) {
+                    const char zero = '\0';
+                    appendPayload(&zero, 1);
+                }
+                const int code = uchar(*ptr++);
+                cobsBlockRemaining = code - 1;
+                cobsZeroPending = code != CobsMaximumBlockSize + 1;
+                frameStarted = true;
+                continue;
+            }
+
+            const qsizetype chunk = qMin(qsizetype(cobsBlockRemaining), qsizetype(delimiter - ptr));
+            appendPayload(ptr, chunk);
+            ptr += chunk;
+            cobsBlockRemaining -= int(chunk);
+        }
+
+        if (delimiter == end)
+            break;
+
+        if (cobsBlockRemaining != 0)
+            discardFrame(QSerialPortFramer::MalformedFrameError);
+        if (frameStarted)
+            finishFrame();
+        cobsBlockRemaining = 0;
+        cobsZeroPending = false;
+        ptr = delimiter + 1;
+    }
+}
+
+void QSerialPortFramerPrivate::decodeHdlc(const char *data, qsizetype size)
+{
+    const char *ptr = data;
+    const char *const end = data + size;
+
+    while (ptr != end) {
+        if (escaped) {
+            const char byte = *ptr++;
+            if (byte == HdlcFlag) {
+                // The abort sequence.
+                escaped = false;
+                discardFrame(QSerialPortFramer::MalformedFrameError);
+                finishHdlcFrame();
+            } else if (uchar(byte) >= 0x20 || !((asyncControlCharacterMap >> uchar(byte)) & 1)) {
+                escaped = false;
+                const char decoded = byte ^ HdlcEscapeBit;
+                appendPayload(&decoded, 1);
+            }
+            continue;
+        }
+
+        const char *special = findHdlcSpecial(ptr, end, asyncControlCharacterMap);
+        appendPayload(ptr, special - ptr);
+        ptr = special;
+        if (ptr == end)
+            break;
+
+        // The mapped control characters are inserted by the link, and dropped.
+        if (*ptr == HdlcFlag)
+            finishHdlcFrame();
+        else if (*ptr == HdlcEscape)
+            escaped = true;
+        ++ptr;
+    }
+}
+
+void QSerialPortFramerPrivate::decodeLengthField(const char *data, qsizetype size)
+{
+    const char *ptr = data;
+    const char *const end = data + size;
+    const qsizetype headerSize = lengthFieldOffset + lengthFieldSize;
+
+    while (ptr != end) {
+        if (frameBytesRemaining > 0) {
+            const qsizetype chunk = qMin(qsizetype(frameBytesRemaining), qsizetype(end - ptr));
+            if (!discarding)
+                currentFrame.append(ptr, chunk);
+            ptr += chunk;
+            frameBytesRemaining -= chunk;
+            if (frameBytesRemaining == 0)
+                finishFrame();
+            continue;
+        }
+
+        // The header is parsed in place if it is complete in this block.
+        const char *header = ptr;
+        if (!currentFrame.isEmpty() || end - ptr < headerSize) {
+            const qsizetype chunk = qMin(headerSize - currentFrame.size(), qsizetype(end - ptr));
+            currentFrame.append(ptr, chunk);
+            ptr += chunk;
+            if (currentFrame.size() < headerSize)
+                break;
+            header = currentFrame.constData();
+        }
+
+        const bool inPlace = header == ptr;
+        const qint64 frameSize = headerSize + readLengthField(header + lengthFieldOffset)
+                + lengthAdjustment;
+        if (frameSize < headerSize) {
+            // There is no way to tell where the next frame starts, so we
+            // carry on right after the header.
+            discardFrame(QSerialPortFramer::MalformedFrameError);
+            if (inPlace)
+                ptr += headerSize;
+            finishFrame();
+            continue;
+        }
+
+        if (maximumFrameSize > 0 && frameSize > maximumFrameSize) {
+            discardFrame(QSerialPortFramer::OversizedFrameError);
+            frameBytesRemaining = inPlace ? frameSize : frameSize - headerSize;
+            if (frameBytesRemaining == 0)
+                finishFrame();
+            continue;
+        }
+
+        if (inPlace) {
+            if (end - ptr >= frameSize) {
+                deliverFrame(QByteArrayView(ptr, frameSize));
+                ptr += frameSize;
+                continue;
+            }
+            currentFrame.append(ptr, headerSize);
+            ptr += headerSize;
+        }
+        frameBytesRemaining = frameSize - headerSize;
+        if (frameBytesRemaining == 0)
+            finishFrame();
+    }
+}
+
+qint64 QSerialPortFramerPrivate::readLengthField(const char *field) const
+{
+    quint64 value = 0;
+    for (int i = 0; i < lengthFieldSize; ++i) {
+        const int index = lengthFieldByteOrder == QSysInfo::BigEndian ? i : lengthFieldSize - 1 - i;
+        value = (value << 8) | uchar(field[index]);
+    }
+    return qint64(value);
+}
+
+void QSerialPortFramerPrivate::decodeNmea(const char *data, qsizetype size)
+{
+    const char *ptr = data;
+    const char *const end = data + size;
+
+    while (ptr != end) {
+        if (!frameStarted) {
+            // The noise between the sentences is dropped.
+            ptr = findFirstOf(ptr, end, NmeaStart, NmeaEncapsulationStart);
+            if (ptr == end)
+                break;
+            frameStarted = true;
+
+            const char *lineEnd = findNmeaSpecial(ptr + 1, end);
+            if (lineEnd != end && *lineEnd == '\n') {
+                // The whole sentence is in this block.
+                QByteArrayView sentence(ptr, lineEnd - ptr);
+                const QSerialPortFramer::FrameError error = verifyNmeaSentence(sentence);
+                if (error == QSerialPortFramer::NoFrameError)
+                    deliverFrame(sentence);
+                else
+                    pendingErrors.append(error);
+                frameStarted = false;
+                ptr = lineEnd + 1;
+                continue;
+            }
+            appendPayload(ptr++, 1);
+        }
+
+        const char *special = findNmeaSpecial(ptr, end);
+        appendPayload(ptr, special - ptr);
+        ptr = special;
+        if (ptr == end)
+            break;
+
+        if (*ptr == '\n') {
+            ++ptr;
+            finishNmeaSentence();
+        } else {
+            // A new sentence starts before the current one ended.
+            discardFrame(QSerialPortFramer::MalformedFrameError);
+            finishFrame();
+        }
+    }
+}
+
+void QSerialPortFramerPrivate::finishNmeaSentence()
+{
+    if (!discarding) {
+        QByteArrayView sentence(currentFrame);
+        const QSerialPortFramer::FrameError error = verifyNmeaSentence(sentence);
+        if (error == QSerialPortFramer::NoFrameError) {
+            currentFrame.truncate(sentence.size());
+            deliverCurrentFrame();
+        } else {
+            discardFrame(error);
+        }
+    }
+    finishFrame();
+}
+
+// Verifies the checksum of \a sentence, and removes it from the sentence
+// together with the line terminator.
+QSerialPortFramer::FrameError QSerialPortFramerPrivate::verifyNmeaSentence(QByteArrayView &sentence) const
+{
+    if (sentence.endsWith('\r'))
+        sentence.chop(1);
+    if (maximumFrameSize > 0 && sentence.size() > maximumFrameSize)
+        return QSerialPortFramer::OversizedFrameError;
+
+    const qsizetype size = sentence.size();
+    if (size < 4 || sentence.at(size - 3) != NmeaChecksumDelimiter)
+        return QSerialPortFramer::NoFrameError;
+
+    bool ok = false;
+    const uint expected = QByteArrayView(sentence.data() + size - 2, 2).toUInt(&ok, 16);
+    if (!ok)
+        return QSerialPortFramer::MalformedFrameError;
+
+    sentence.chop(3);
+    const quint32 checksum = QSerialPortChecksum::checksum(sentence.sliced(1),
+                                                           QSerialPortChecksum::Xor);
+    return checksum == expected ? QSerialPortFramer::NoFrameError
+                                : QSerialPortFramer::ChecksumError;
+}
+
+void QSerialPortFramerPrivate::appendPayload(const char *data, qsizetype size)
+{
+    if (discarding || size == 0)
+        return;
+
+    frameStarted = true;
+    // The trailers that are removed once the frame is complete.
+    qsizetype trailerSize = 0;
+    if (protocol == QSerialPortFramer::Hdlc)
+        trailerSize = frameCheckSequenceSize(frameCheckSequence);
+    else if (protocol == QSerialPortFramer::Nmea)
+        trailerSize = 4;
+    if (maximumFrameSize > 0 && currentFrame.size() + size > maximumFrameSize + trailerSize) {
+        discardFrame(QSerialPortFramer::OversizedFrameError);
+        return;
+    }
+    currentFrame.append(data, size);
+}
+
+void QSerialPortFramerPrivate::finishFrame()
+{
+    // SLIP senders may emit END bytes between frames to flush line noise,
+    // and HDLC frames may share their flags. The resulting empty frames
+    // carry no data.
+    const bool emptyFrame = protocol != QSerialPortFramer::Cobs && currentFrame.isEmpty();
+    if (!discarding && !emptyFrame)
+        deliverCurrentFrame();
+
+    // Keep the capacity for the next frame.
+    currentFrame.resize(0);
+    discarding = false;
+    frameStarted = false;
+}
+
+void QSerialPortFramerPrivate::finishHdlcFrame()
+{
+    // Consecutive flags delimit empty frames, which are ignored.
+    if (discarding || currentFrame.isEmpty()) {
+        finishFrame();
+        return;
+    }
+
+    const qsizetype fcsSize = frameCheckSequenceSize(frameCheckSequence);
+    if (currentFrame.size() < fcsSize) {
+        discardFrame(QSerialPortFramer::MalformedFrameError);
+        finishFrame();
+        return;
+    }
+
+    bool valid = true;
+    if (frameCheckSequence == QSerialPortFramer::Fcs16)
+        valid = qt_fcs16(QtFcs16Initial, currentFrame.constData(), currentFrame.size()) == QtFcs16Good;
+    else if (frameCheckSequence == QSerialPortFramer::Fcs32)
+        valid = qt_fcs32(QtFcs32Initial, currentFrame.constData(), currentFrame.size()) == QtFcs32Good;
+
+    if (!valid) {
+        discardFrame(QSerialPortFramer::ChecksumError);
+    } else {
+        currentFrame.chop(fcsSize);
+        deliverCurrentFrame();
+    }
+    finishFrame();
+}
+
+void QSerialPortFramerPrivate::deliverFrame(QByteArrayView frame)
+{
+    if (frameHandler) {
+        frameHandler(frame);
+        return;
+    }
+    frames.append(frame.toByteArray());
+    pendingFrameBytes += frame.size();
+}
+
+void QSerialPortFramerPrivate::deliverCurrentFrame()
+{
+    if (frameHandler) {
+        frameHandler(currentFrame);
+        currentFrame.resize(0);
+        return;
+    }
+    pendingFrameBytes += currentFrame.size();
+    frames.append(std::exchange(currentFrame, {}));
+}
+
+// Decodes the data left in the read buffer of the port once the pending
+// frames no longer fill it.
+void QSerialPortFramerPrivate::resumeReading()
+{
+    Q_Q(QSerialPortFramer);
+
+    if (!readPaused || !port)
+        return;
+    const qint64 limit = QSerialPortPrivate::get(port)->readBufferMaxSize;
+    if (limit > 0 && pendingFrameBytes >= limit)
+        return;
+
+    readPaused = false;
+    QMetaObject::invokeMethod(q, [this]() {
+        readFromPort();
+    }, Qt::QueuedConnection);
+}
+
+// Called with the number of bytes of a read, before they are decoded. The
+// silence is measured between the time stamps that the port takes for each
+// read, so it is only seen between reads: frames that arrive while the event
+// loop is busy end up in the same read, and are merged.
+void QSerialPortFramerPrivate::startIdleGapRead(qint64 bytes)
+{
+    Q_Q(QSerialPortFramer);
+
+    if (!idleGapTimer) {
+        idleGapTimer = new QTimer(q);
+        idleGapTimer->setSingleShot(true);
+        idleGapTimer->setTimerType(Qt::PreciseTimer);
+        QObject::connect(idleGapTimer, &QTimer::timeout, q, [this]() {
+            finishIdleGapFrame();
+        });
+    }
+
+    qint64 timestamp = QSerialPortPrivate::get(port)->lastReadTimestamp;
+    if (timestamp == 0)
+        timestamp = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+
+    if (frameStarted) {
+        const qint64 characterTime = QSerialPortPrivate::get(port)->characterTimeNSecs();
+        const qint64 silence = timestamp - lastByteTimestamp - bytes * characterTime;
+        if (silence >= idleGapNSecs())
+            finishFrame();
+    }
+    lastByteTimestamp = timestamp;
+}
+
+void QSerialPortFramerPrivate::finishIdleGapFrame()
+{
+    const qsizetype framesBefore = frames.size();
+    finishFrame();
+    emitPendingSignals(framesBefore);
+}
+
+qint64 QSerialPortFramerPrivate::idleGapNSecs() const
+{
+    const qint64 characterTime = port ? QSerialPortPrivate::get(port)->characterTimeNSecs() : 0;
+    return qint64(idleGap * characterTime);
+}
+
+void QSerialPortFramerPrivate::discardFrame(QSerialPortFramer::FrameError error)
+{
+    if (!discarding)
+        pendingErrors.append(error);
+    discarding = true;
+    currentFrame.clear();
+}
+
+void QSerialPortFramerPrivate::resetDecoder()
+{
+    currentFrame.clear();
+    discarding = false;
+    frameStarted = false;
+    escaped = false;
+    cobsBlockRemaining = 0;
+    cobsZeroPending = false;
+    frameBytesRemaining = 0;
+    if (idleGapTimer)
+        idleGapTimer->stop();
+}
+
+void QSerialPortFramerPrivate::encodeSlip(QByteArray &out, QByteArrayView payload)
+{
+    const char *ptr = payload.data();
+    const char *const end = ptr + payload.size();
+
+    out.reserve(out.size() + payload.size() + 2);
+    out.append(SlipEnd);
+    while (ptr != end) {
+        const char *special = findFirstOf(ptr, end, SlipEnd, SlipEscape);
+        out.append(ptr, special - ptr);
+        ptr = special;
+        if (ptr == end)
+            break;
+        out.append(SlipEscape);
+        out.append(*ptr == SlipEnd ? SlipEscapedEnd : SlipEscapedEscape);
+        ++ptr;
+    }
+    out.append(SlipEnd);
+}
+
+void QSerialPortFramerPrivate::encodeCobs(QByteArray &out, QByteArrayView payload)
+{
+    const char *ptr = payload.data();
+    const char *const end = ptr + payload.size();
+
+    out.reserve(out.size() + payload.size() + payload.size() / CobsMaximumBlockSize + 2);
+    for (;;) {
+        const char *limit = ptr + qMin(qsizetype(end - ptr), qsizetype(CobsMaximumBlockSize));
+        const char *zero = findByte(ptr, limit, '\0');
+        const qsizetype blockSize = zero - ptr;
+
+        out.append(char(blockSize + 1));
+        out.append(ptr, blockSize);
+        ptr = zero;
+
+        if (zero != limit) {
+            // The zero byte is implied by the block code.
+            ++ptr;
+            continue;
+        }
+        if (blockSize < CobsMaximumBlockSize || ptr == end)
+            break;
+    }
+    out.append('\0');
+}
+
+static void appendHdlcEscaped(QByteArray &out, QByteArrayView data, quint32 accm)
+{
+    const char *ptr = data.data();
+    const char *const end = ptr + data.size();
+
+    while (ptr != end) {
+        const char *special = findHdlcSpecial(ptr, end, accm);
+        out.append(ptr, special - ptr);
+        ptr = special;
+        if (ptr == end)
+            break;
+        out.append(HdlcEscape);
+        out.append(char(*ptr ^ HdlcEscapeBit));
+        ++ptr;
+    }
+}
+
+void QSerialPortFramerPrivate::encodeHdlc(QByteArray &out, QByteArrayView payload,
+                                          QSerialPortFramer::FrameCheckSequence fcs, quint32 accm)
+{
+    char trailer[4];
+    qsizetype trailerSize = 0;
+    if (fcs == QSerialPortFramer::Fcs16) {
+        qToLittleEndian<quint16>(~qt_fcs16(QtFcs16Initial, payload.data(), payload.size()), trailer);
+        trailerSize = 2;
+    } else if (fcs == QSerialPortFramer::Fcs32) {
+        qToLittleEndian<quint32>(~qt_fcs32(QtFcs32Initial, payload.data(), payload.size()), trailer);
+        trailerSize = 4;
+    }
+
+    out.reserve(out.size() + payload.size() + payload.size() / 8 + 2 * trailerSize + 2);
+    out.append(HdlcFlag);
+    appendHdlcEscaped(out, payload, accm);
+    appendHdlcEscaped(out, QByteArrayView(trailer, trailerSize), accm);
+    out.append(HdlcFlag);
+}
+
+void QSerialPortFramerPrivate::encodeNmea(QByteArray &out, QByteArrayView payload)
+{
+    const bool hasStart = payload.startsWith(NmeaStart) || payload.startsWith(NmeaEncapsulationStart);
+    const quint32 checksum = QSerialPortChecksum::checksum(hasStart ? payload.sliced(1) : payload,
+                                                           QSerialPortChecksum::Xor);
+
+    out.reserve(out.size() + payload.size() + 6);
+    if (!hasStart)
+        out.append(NmeaStart);
+    out.append(payload);
+    out.append(NmeaChecksumDelimiter);
+    out.append(QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper());
+    out.append("\r\n");
+}
+
+/*!
+    Constructs a new framer with the given \a parent, without a port.
+
+    \sa setPort()
+*/
+QSerialPortFramer::QSerialPortFramer(QObject *parent)
+    : QObject(*new QSerialPortFramerPrivate, parent)
+{
+}
+
+/*!
+    Constructs a new framer with the given \a parent, which decodes the
+    frames of the given \a protocol received on \a port.
+*/
+QSerialPortFramer::QSerialPortFramer(QSerialPort *port, Protocol protocol, QObject *parent)
+    : QObject(*new QSerialPortFramerPrivate, parent)
+{
+    Q_D(QSerialPortFramer);
+    d->protocol = protocol;
+    setPort(port);
+}
+
+/*!
+    Destroys the framer. The port is not closed.
+*/
+QSerialPortFramer::~QSerialPortFramer()
+{
+}
+
+/*!
+    Attaches the framer to \a port, and discards the state of the frame
+    being decoded. Pass \c nullptr to detach the framer from its port.
+
+    The data already present in the read buffer of \a port is decoded the
+    next time the port emits the QIODevice::readyRead() signal.
+*/
+void QSerialPortFramer::setPort(QSerialPort *port)
+{
+    Q_D(QSerialPortFramer);
+
+    if (d->port == port)
+        return;
+
+    disconnect(d->readyReadConnection);
+    d->port = port;
+    d->resetDecoder();
+
+    if (port) {
+        d->readyReadConnection = connect(port, &QIODevice::readyRead, this, [d]() {
+            d->readFromPort();
+        });
+    }
+}
+
+/*!
+    Returns the port the framer is attached to.
+*/
+QSerialPort *QSerialPortFramer::port() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->port;
+}
+
+/*!
+    Sets the framing \a protocol, and discards the state of the frame being
+    decoded.
+
+    The default protocol is Slip.
+*/
+void QSerialPortFramer::setProtocol(Protocol protocol)
+{
+    Q_D(QSerialPortFramer);
+    d->protocol = protocol;
+    d->resetDecoder();
+}
+
+/*!
+    Returns the framing protocol.
+*/
+QSerialPortFramer::Protocol QSerialPortFramer::protocol() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->protocol;
+}
+
+/*!
+    Sets the maximum size of a decoded frame to \a size bytes. Larger frames
+    are dropped with the OversizedFrameError error.
+
+    The default maximum size is 64 KiB. It bounds the memory that the
+    decoder uses for a frame, which matters most with the LengthField
+    protocol: without a limit, a single corrupt length field would make the
+    decoder buffer up to 4 GiB while waiting for the rest of the frame.
+
+    A maximum size of 0 means that the size of the frames is not limited.
+    Only set it when the frames come from a trusted, error-free source.
+*/
+void QSerialPortFramer::setMaximumFrameSize(qsizetype size)
+{
+    Q_D(QSerialPortFramer);
+    d->maximumFrameSize = qMax(size, qsizetype(0));
+}
+
+/*!
+    Returns the maximum size of a decoded frame.
+*/
+qsizetype QSerialPortFramer::maximumFrameSize() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->maximumFrameSize;
+}
+
+/*!
+    Sets the frame check sequence of the Hdlc protocol to \a fcs, and
+    discards the state of the frame being decoded.
+
+    The frame check sequence is appended to the frames written with
+    writeFrame(), and verified and removed from the received frames. The
+    frames that fail the verification are dropped with the ChecksumError
+    error.
+
+    The default frame check sequence is Fcs16.
+*/
+void QSerialPortFramer::setFrameCheckSequence(FrameCheckSequence fcs)
+{
+    Q_D(QSerialPortFramer);
+    d->frameCheckSequence = fcs;
+    d->resetDecoder();
+}
+
+/*!
+    Returns the frame check sequence of the Hdlc protocol.
+*/
+QSerialPortFramer::FrameCheckSequence QSerialPortFramer::frameCheckSequence() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->frameCheckSequence;
+}
+
+/*!
+    Sets the async control character map of the Hdlc protocol to \a map.
+
+    Each bit of the map, starting from the least significant one, stands
+    for one of the control characters 0x00 to 0x1F. The selected characters
+    are escaped in the frames written with writeFrame(), and ignored when
+    they are received unescaped.
+
+    The default map is 0xFFFFFFFF, which selects all the control characters.
+*/
+void QSerialPortFramer::setAsyncControlCharacterMap(quint32 map)
+{
+    Q_D(QSerialPortFramer);
+    d->asyncControlCharacterMap = map;
+}
+
+/*!
+    Returns the async control character map of the Hdlc protocol.
+*/
+quint32 QSerialPortFramer::asyncControlCharacterMap() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->asyncControlCharacterMap;
+}
+
+/*!
+    Sets the silence that ends a frame of the IdleGap protocol to
+    \a characterTimes times the time it takes to transfer a character
+    with the current settings of the port.
+
+    The silence is measured between the reads from the device, using the
+    time each read took place, so it is resolved at the granularity of the
+    reads only. If the event loop is busy while several frames arrive, they
+    are read at once and delivered as a single frame. The IdleGap protocol
+    is therefore only reliable when the port is read promptly, as from a
+    thread of its own.
+
+    The default idle gap is 3.5 character times.
+*/
+void QSerialPortFramer::setIdleGap(qreal characterTimes)
+{
+    Q_D(QSerialPortFramer);
+    d->idleGap = qMax(characterTimes, qreal(0));
+}
+
+/*!
+    Returns the silence that ends a frame of the IdleGap protocol, in
+    character times.
+*/
+qreal QSerialPortFramer::idleGap() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->idleGap;
+}
+
+/*!
+    Sets the position of the length field in the header of a frame of the
+    LengthField protocol to \a offset bytes from the start of the frame, and
+    discards the state of the frame being decoded.
+
+    The header of a frame ends with the length field, and the size of the
+    frame in bytes is
+
+    \code
+    lengthFieldOffset() + lengthFieldSize() + length + lengthAdjustment()
+    \endcode
+
+    where \c length is the value of the length field. For example, a frame
+    made of a type byte, a length byte and as many bytes of value as the
+    length byte says, is described by an offset of 1, a size of 1 and an
+    adjustment of 0.
+
+    The default offset is 0.
+
+    \sa setLengthFieldSize(), setLengthAdjustment()
+*/
+void QSerialPortFramer::setLengthFieldOffset(qsizetype offset)
+{
+    Q_D(QSerialPortFramer);
+    d->lengthFieldOffset = qMax(offset, qsizetype(0));
+    d->resetDecoder();
+}
+
+/*!
+    Returns the position of the length field in the header of a frame of
+    the LengthField protocol.
+*/
+qsizetype QSerialPortFramer::lengthFieldOffset() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->lengthFieldOffset;
+}
+
+/*!
+    Sets the size of the length field of the LengthField protocol to
+    \a size bytes, from 1 to 4, and discards the state of the frame being
+    decoded.
+
+    The default size is 2 bytes.
+*/
+void QSerialPortFramer::setLengthFieldSize(int size)
+{
+    Q_D(QSerialPortFramer);
+    d->lengthFieldSize = qBound(1, size, 4);
+    d->resetDecoder();
+}
+
+/*!
+    Returns the size of the length field of the LengthField protocol, in
+    bytes.
+*/
+int QSerialPortFramer::lengthFieldSize() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->lengthFieldSize;
+}
+
+/*!
+    Sets the byte order of the length field of the LengthField protocol to
+    \a byteOrder, and discards the state of the frame being decoded.
+
+    The default byte order is QSysInfo::BigEndian.
+*/
+void QSerialPortFramer::setLengthFieldByteOrder(QSysInfo::Endian byteOrder)
+{
+    Q_D(QSerialPortFramer);
+    d->lengthFieldByteOrder = byteOrder;
+    d->resetDecoder();
+}
+
+/*!
+    Returns the byte order of the length field of the LengthField protocol.
+*/
+QSysInfo::Endian QSerialPortFramer::lengthFieldByteOrder() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->lengthFieldByteOrder;
+}
+
+/*!
+    Sets the number of bytes added to the value of the length field to
+    \a adjustment, and discards the state of the frame being decoded.
+
+    Use a negative adjustment if the length field counts the header as
+    well, and a positive one if it does not count a trailer such as a
+    checksum. A frame whose size comes out smaller than its header is
+    dropped with the MalformedFrameError error.
+
+    The default adjustment is 0.
+
+    \sa setLengthFieldOffset()
+*/
+void QSerialPortFramer::setLengthAdjustment(qsizetype adjustment)
+{
+    Q_D(QSerialPortFramer);
+    d->lengthAdjustment = adjustment;
+    d->resetDecoder();
+}
+
+/*!
+    Returns the number of bytes added to the value of the length field.
+*/
+qsizetype QSerialPortFramer::lengthAdjustment() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->lengthAdjustment;
+}
+
+/*!
+    \typealias QSerialPortFramer::FrameHandler
+
+    A function that is called with each decoded frame.
+*/
+
+/*!
+    Passes the decoded frames to \a handler, instead of queuing them for
+    readFrame(). Pass an empty function to queue the frames again.
+
+    The handler is called while the data of the port is decoded. The view
+    it receives is only valid during the call, and may point straight into
+    the read buffer of the port, so the frame must be copied if it is kept.
+    The handler must not read from the port, nor change the settings of the
+    framer.
+
+    The frames already queued remain available to readFrame(). The
+    frameReceived() signal is not emitted for the frames passed to the
+    handler.
+*/
+void QSerialPortFramer::setFrameHandler(const FrameHandler &handler)
+{
+    Q_D(QSerialPortFramer);
+    d->frameHandler = handler;
+}
+
+/*!
+    Returns \c true if there are decoded frames waiting to be read;
+    otherwise returns \c false.
+
+    \sa readFrame()
+*/
+bool QSerialPortFramer::hasPendingFrames() const
+{
+    Q_D(const QSerialPortFramer);
+    return !d->frames.isEmpty();
+}
+
+/*!
+    Returns the number of decoded frames waiting to be read.
+*/
+qsizetype QSerialPortFramer::pendingFrameCount() const
+{
+    Q_D(const QSerialPortFramer);
+    return d->frames.size();
+}
+
+/*!
+    Takes the oldest decoded frame from the queue and returns its payload.
+    Returns an empty QByteArray if there are no pending frames.
+
+    \sa hasPendingFrames(), frameReceived()
+*/
+QByteArray QSerialPortFramer::readFrame()
+{
+    Q_D(QSerialPortFramer);
+
+    if (d->frames.isEmpty())
+        return QByteArray();
+
+    const QByteArray frame = d->frames.takeFirst();
+    d->pendingFrameBytes -= frame.size();
+    d->resumeReading();
+    return frame;
+}
+
+/*!
+    Encodes \a payload into a frame and writes it to the port.
+
+    Returns the number of bytes written to the port, or -1 if an error
+    occurred.
+
+    \sa encodeFrame()
+*/
+qint64 QSerialPortFramer::writeFrame(QByteArrayView payload)
+{
+    Q_D(QSerialPortFramer);
+
+    if (!d->port)
+        return -1;
+
+    if (d->protocol != Hdlc)
+        return d->port->write(encodeFrame(d->protocol, payload));
+
+    QByteArray frame;
+    QSerialPortFramerPrivate::encodeHdlc(frame, payload, d->frameCheckSequence,
+                                         d->asyncControlCharacterMap);
+    return d->port->write(frame);
+}
+
+/*!
+    Discards the pending frames and the state of the frame being decoded.
+*/
+void QSerialPortFramer::reset()
+{
+    Q_D(QSerialPortFramer);
+    d->frames.clear();
+    d->pendingFrameBytes = 0;
+    d->pendingErrors.clear();
+    d->resetDecoder();
+    d->resumeReading();
+}
+
+/*!
+    Returns \a payload encoded into a single frame of the given \a protocol.
+
+    Frames of the Hdlc protocol are encoded with the default frame check
+    sequence and async control character map.
+*/
+QByteArray QSerialPortFramer::encodeFrame(Protocol protocol, QByteArrayView payload)
+{
+    QByteArray frame;
+    switch (protocol) {
+    case Slip:
+        QSerialPortFramerPrivate::encodeSlip(frame, payload);
+        break;
+    case Cobs:
+        QSerialPortFramerPrivate::encodeCobs(frame, payload);
+        break;
+    case Hdlc:
+        QSerialPortFramerPrivate::encodeHdlc(frame, payload, Fcs16, 0xFFFFFFFF);
+        break;
+    case IdleGap:
+    case LengthField:
+        frame = payload.toByteArray();
+        break;
+    case Nmea:
+        QSerialPortFramerPrivate::encodeNmea(frame, payload);
+        break;
+    }
+    return frame;
+}
+
+/*!
+    \fn void QSerialPortFramer::frameReceived()
+
+    This signal is emitted once every time new frames have been decoded.
+
+    \sa readFrame()
+*/
+
+/*!
+    \fn void QSerialPortFramer::frameError(QSerialPortFramer::FrameError error)
+
+    This signal is emitted when a received frame is dropped because of
+    \a error.
+*/
+
+QT_END_NAMESPACE
+
+#include "moc_qserialportframer.cpp"
@@ -0,0 +1,111 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTFRAMER_H
+#define QSERIALPORTFRAMER_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qbytearrayview.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qsysinfo.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPort;
+class QSerialPortFramerPrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortFramer : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortFramer)
+
+public:
+    enum Protocol {
+        Slip,
+        Cobs,
+        Hdlc,
+        IdleGap,
+        LengthField,
+        Nmea
+    };
+    Q_ENUM(Protocol)
+
+    enum FrameError {
+        NoFrameError,
+        MalformedFrameError,
+        OversizedFrameError,
+        ChecksumError
+    };
+    Q_ENUM(FrameError)
+
+    enum FrameCheckSequence {
+        NoFrameCheckSequence,
+        Fcs16,
+        Fcs32
+    };
+    Q_ENUM(FrameCheckSequence)
+
+    using FrameHandler = std::function<void(QByteArrayView frame)>;
+
+    explicit QSerialPortFramer(QObject *parent = nullptr);
+    explicit QSerialPortFramer(QSerialPort *port, Protocol protocol = Slip,
+                               QObject *parent = nullptr);
+    ~QSerialPortFramer();
+
+    void setPort(QSerialPort *port);
+    QSerialPort *port() const;
+
+    void setProtocol(Protocol protocol);
+    Protocol protocol() const;
+
+    void setMaximumFrameSize(qsizetype size);
+    qsizetype maximumFrameSize() const;
+
+    void setFrameCheckSequence(FrameCheckSequence fcs);
+    FrameCheckSequence frameCheckSequence() const;
+
+    void setAsyncControlCharacterMap(quint32 map);
+    quint32 asyncControlCharacterMap() const;
+
+    void setIdleGap(qreal characterTimes);
+    qreal idleGap() const;
+
+    void setLengthFieldOffset(qsizetype offset);
+    qsizetype lengthFieldOffset() const;
+
+    void setLengthFieldSize(int size);
+    int lengthFieldSize() const;
+
+    void setLengthFieldByteOrder(QSysInfo::Endian byteOrder);
+    QSysInfo::Endian lengthFieldByteOrder() const;
+
+    void setLengthAdjustment(qsizetype adjustment);
+    qsizetype lengthAdjustment() const;
+
+    void setFrameHandler(const FrameHandler &handler);
+
+    bool hasPendingFrames() const;
+    qsizetype pendingFrameCount() const;
+    QByteArray readFrame();
+
+    qint64 writeFrame(QByteArrayView payload);
+
+    void reset();
+
+    static QByteArray encodeFrame(Protocol protocol, QByteArrayView payload);
+
+Q_SIGNALS:
+    void frameReceived();
+    void frameError(QSerialPortFramer::FrameError error);
+
+private:
+    Q_DISABLE_COPY(QSerialPortFramer)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTFRAMER_H
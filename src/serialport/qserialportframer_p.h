@@ -0,0 +1,102 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTFRAMER_P_H
+#define QSERIALPORTFRAMER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportframer.h"
+
+#include <QtCore/qlist.h>
+#include <QtCore/qpointer.h>
+
+#include <private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+class QSerialPortFramerPrivate : public QObjectPrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortFramer)
+
+    void readFromPort();
+    void emitPendingSignals(qsizetype framesBefore);
+    void decode(const char *data, qsizetype size);
+    void decodeSlip(const char *data, qsizetype size);
+    void decodeCobs(const char *data, qsizetype size);
+    void decodeHdlc(const char *data, qsizetype size);
+    void decodeLengthField(const char *data, qsizetype size);
+    qint64 readLengthField(const char *header) const;
+    void decodeNmea(const char *data, qsizetype size);
+    void finishNmeaSentence();
+    QSerialPortFramer::FrameError verifyNmeaSentence(QByteArrayView &sentence) const;
+
+    void appendPayload(const char *data, qsizetype size);
+    void finishFrame();
+    void finishHdlcFrame();
+    void deliverFrame(QByteArrayView frame);
+    void deliverCurrentFrame();
+    void resumeReading();
+    void startIdleGapRead(qint64 bytes);
+    void finishIdleGapFrame();
+    qint64 idleGapNSecs() const;
+    void discardFrame(QSerialPortFramer::FrameError error);
+    void resetDecoder();
+
+    static void encodeSlip(QByteArray &out, QByteArrayView payload);
+    static void encodeCobs(QByteArray &out, QByteArrayView payload);
+    static void encodeHdlc(QByteArray &out, QByteArrayView payload,
+                           QSerialPortFramer::FrameCheckSequence fcs, quint32 accm);
+    static void encodeNmea(QByteArray &out, QByteArrayView payload);
+
+    QPointer<QSerialPort> port;
+    QMetaObject::Connection readyReadConnection;
+    QSerialPortFramer::Protocol protocol = QSerialPortFramer::Slip;
+    qsizetype maximumFrameSize = 64 * 1024;
+    QSerialPortFramer::FrameCheckSequence frameCheckSequence = QSerialPortFramer::Fcs16;
+    quint32 asyncControlCharacterMap = 0xFFFFFFFF;
+    qreal idleGap = 3.5;
+    qsizetype lengthFieldOffset = 0;
+    int lengthFieldSize = 2;
+    QSysInfo::Endian lengthFieldByteOrder = QSysInfo::BigEndian;
+    qsizetype lengthAdjustment = 0;
+    QSerialPortFramer::FrameHandler frameHandler;
+
+    QList<QByteArray> frames;
+    qint64 pendingFrameBytes = 0;
+    bool readPaused = false;
+    QByteArray currentFrame;
+    QList<QSerialPortFramer::FrameError> pendingErrors;
+    bool discarding = false;
+    bool frameStarted = false;
+
+    // SLIP and HDLC decoder state
+    bool escaped = false;
+
+    // COBS decoder state
+    int cobsBlockRemaining = 0;
+    bool cobsZeroPending = false;
+
+    // Length field decoder state
+    qint64 frameBytesRemaining = 0;
+
+    // Idle gap decoder state
+    qint64 lastByteTimestamp = 0;
+    QTimer *idleGapTimer = nullptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTFRAMER_P_H
@@ -75,12 +75,19 @@ QSerialPortInfo::QSerialPortInfo(const QSerialPort &port)
     This constructor finds the relevant serial port among the available ones
     according to the port name \a name, and constructs the serial port info
     instance for that port.
+
+    Since Qt 6.6, \a name may also be one of the persistent locations of the
+    port, as returned by persistentIdLocation() and persistentPathLocation().
 */
 QSerialPortInfo::QSerialPortInfo(const QString &name)
 {
     const auto infos = QSerialPortInfo::availablePorts();
     for (const QSerialPortInfo &info : infos) {
-        if (name == info.portName()) {
+        if (name == info.portName()
+                || (!info.d_ptr->persistentIdLocation.isEmpty()
+                    && name == info.d_ptr->persistentIdLocation)
+                || (!info.d_ptr->persistentPathLocation.isEmpty()
+                    && name == info.d_ptr->persistentPathLocation)) {
             *this = info;
             break;
         }
@@ -180,6 +187,59 @@ QString QSerialPortInfo::serialNumber() const
     return !d ? QString() : d->serialNumber;
 }
 
+/*!
+    \since 6.6
+
+    Returns the persistent, identity based location of the serial port,
+    if available; otherwise returns an empty string.
+
+    On Linux, this is the symbolic link created by udev in the
+    \c{/dev/serial/by-id} directory. Unlike the system location, it is
+    derived from the vendor, model and serial number of the device and
+    does not change when the device is re-attached or the system reboots.
+
+    \sa persistentPathLocation(), usbPortPath(), persistentIdentifierIndex()
+*/
+QString QSerialPortInfo::persistentIdLocation() const
+{
+    Q_D(const QSerialPortInfo);
+    return !d ? QString() : d->persistentIdLocation;
+}
+
+/*!
+    \since 6.6
+
+    Returns the persistent, topology based location of the serial port,
+    if available; otherwise returns an empty string.
+
+    On Linux, this is the symbolic link created by udev in the
+    \c{/dev/serial/by-path} directory. It identifies the physical
+    connector the device is plugged into rather than the device itself.
+
+    \sa persistentIdLocation(), usbPortPath(), persistentIdentifierIndex()
+*/
+QString QSerialPortInfo::persistentPathLocation() const
+{
+    Q_D(const QSerialPortInfo);
+    return !d ? QString() : d->persistentPathLocation;
+}
+
+/*!
+    \since 6.6
+
+    Returns the position of the serial port in the USB bus topology, for
+    example \c{1-1.4.2} for port 2 of a hub attached to port 4 of a hub
+    attached to port 1 of bus 1, if available; otherwise returns an empty
+    string.
+
+    \sa persistentIdLocation(), persistentPathLocation()
+*/
+QString QSerialPortInfo::usbPortPath() const
+{
+    Q_D(const QSerialPortInfo);
+    return !d ? QString() : d->usbPortPath;
+}
+
 /*!
     Returns the 16-bit vendor number for the serial port, if available;
     otherwise returns zero.
@@ -252,4 +312,124 @@ QList<qint32> QSerialPortInfo::standardBaudRates()
     Returns a list of available serial ports on the system.
 */
 
+/*!
+    \since 6.6
+
+    Returns a hash that maps every persistent identifier of the available
+    serial ports to the current port information.
+
+    The keys are the persistent locations returned by persistentIdLocation()
+    and persistentPathLocation(), and the USB port paths returned by
+    usbPortPath(). As the ports of a multi-port adapter share the USB port
+    path of the adapter, the key of such a port is followed by the
+    configuration and the number of its USB interface, such as
+    \c{1-1.4:1.2}. The values hold the current system location of the
+    corresponding port. The hash is built in a single enumeration pass, so
+    resolving a stable identifier to its current device node afterwards
+    takes constant time.
+
+    \sa availablePorts()
+*/
+QHash<QString, QSerialPortInfo> QSerialPortInfo::persistentIdentifierIndex()
+{
+    QHash<QString, QSerialPortInfo> index;
+    const auto infos = QSerialPortInfo::availablePorts();
+    index.reserve(infos.size() * 3);
+    for (const QSerialPortInfo &info : infos) {
+        const QStringList identifiers = info.d_ptr->persistentIdentifiers();
+        for (const QString &identifier : identifiers)
+            index.insert(identifier, info);
+    }
+    return index;
+}
+
+static bool isUsbPortPathComponent(QStringView component)
+{
+    // USB devices are named "<bus>-<port>[.<port>...]" in sysfs, the
+    // interfaces below them have an additional ":<config>.<interface>".
+    const qsizetype dash = component.indexOf(QLatin1Char('-'));
+    if (dash <= 0 || dash == component.size() - 1)
+        return false;
+
+    for (qsizetype i = 0; i < dash; ++i) {
+        if (!component.at(i).isDigit())
+            return false;
+    }
+
+    bool expectDigit = true;
+    for (qsizetype i = dash + 1; i < component.size(); ++i) {
+        const QChar c = component.at(i);
+        if (c.isDigit()) {
+            expectDigit = false;
+        } else if (c == QLatin1Char('.') && !expectDigit) {
+            expectDigit = true;
+        } else {
+            return false;
+        }
+    }
+    return !expectDigit;
+}
+
+// The root hub of a USB bus, "usb<bus>", above which no USB device is found.
+static bool isUsbBusComponent(QStringView component)
+{
+    if (component.size() <= 3 || !component.startsWith(QLatin1String("usb")))
+        return false;
+    for (qsizetype i = 3; i < component.size(); ++i) {
+        if (!component.at(i).isDigit())
+            return false;
+    }
+    return true;
+}
+
+// Other buses name their devices alike, such as "1-0048" for an I2C UART, so
+// a component only counts as a USB device below the root hub of a USB bus.
+QString QSerialPortInfoPrivate::usbPortPathFromSysfsPath(QStringView sysfsPath,
+                                                        QString *usbInterface)
+{
+    QStringView device;
+    QStringView child;
+    QStringView interfaceName;
+    qsizetype end = sysfsPath.size();
+    while (end > 0) {
+        const qsizetype slash = sysfsPath.lastIndexOf(QLatin1Char('/'), end - 1);
+        const QStringView component = sysfsPath.mid(slash + 1, end - slash - 1);
+        if (device.isNull()) {
+            if (isUsbPortPathComponent(component)) {
+                device = component;
+                if (child.size() > component.size() + 1 && child.startsWith(component)
+                        && child.at(component.size()) == QLatin1Char(':')) {
+                    interfaceName = child.mid(component.size() + 1);
+                }
+            }
+        } else if (isUsbBusComponent(component)) {
+            if (usbInterface)
+                *usbInterface = interfaceName.toString();
+            return device.toString();
+        }
+        if (slash < 0)
+            break;
+        child = component;
+        end = slash;
+    }
+    if (usbInterface)
+        usbInterface->clear();
+    return QString();
+}
+
+QStringList QSerialPortInfoPrivate::persistentIdentifiers() const
+{
+    QStringList identifiers;
+    if (!persistentIdLocation.isEmpty())
+        identifiers.append(persistentIdLocation);
+    if (!persistentPathLocation.isEmpty())
+        identifiers.append(persistentPathLocation);
+    // The interfaces of a multi-port adapter share the USB port path.
+    if (!usbPortPath.isEmpty()) {
+        identifiers.append(usbInterface.isEmpty()
+                           ? usbPortPath : usbPortPath + QLatin1Char(':') + usbInterface);
+    }
+    return identifiers;
+}
+
 QT_END_NAMESPACE
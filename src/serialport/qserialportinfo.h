@@ -5,6 +5,7 @@
 #ifndef QSERIALPORTINFO_H
 #define QSERIALPORTINFO_H
 
+#include <QtCore/qhash.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qscopedpointer.h>
 
@@ -34,6 +35,10 @@ public:
     QString manufacturer() const;
     QString serialNumber() const;
 
+    QString persistentIdLocation() const;
+    QString persistentPathLocation() const;
+    QString usbPortPath() const;
+
     quint16 vendorIdentifier() const;
     quint16 productIdentifier() const;
 
@@ -44,6 +49,7 @@ public:
 
     static QList<qint32> standardBaudRates();
     static QList<QSerialPortInfo> availablePorts();
+    static QHash<QString, QSerialPortInfo> persistentIdentifierIndex();
 
 private:
     QSerialPortInfo(const QSerialPortInfoPrivate &dd);
@@ -18,6 +18,7 @@
 //
 
 #include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
 #include <QtCore/private/qglobal_p.h>
 
 QT_BEGIN_NAMESPACE
@@ -27,6 +28,10 @@ class Q_AUTOTEST_EXPORT QSerialPortInfoPrivate
 public:
     static QString portNameToSystemLocation(const QString &source);
     static QString portNameFromSystemLocation(const QString &source);
+    static QString usbPortPathFromSysfsPath(QStringView sysfsPath,
+                                            QString *usbInterface = nullptr);
+
+    QStringList persistentIdentifiers() const;
 
     QString portName;
     QString device;
@@ -34,6 +39,11 @@ public:
     QString manufacturer;
     QString serialNumber;
 
+    QString persistentIdLocation;
+    QString persistentPathLocation;
+    QString usbPortPath;
+    QString usbInterface;
+
     quint16 vendorIdentifier = 0;
     quint16 productIdentifier = 0;
 
@@ -246,6 +246,9 @@ QList<QSerialPortInfo> availablePortsBySysfs(bool &ok)
         if (isSerial8250Driver(driverName) && !isValidSerial8250(priv.device))
             continue;
 
+        priv.usbPortPath = QSerialPortInfoPrivate::usbPortPathFromSysfsPath(
+                    targetDir.absolutePath(), &priv.usbInterface);
+
         do {
             if (priv.description.isEmpty())
                 priv.description = deviceDescription(targetDir);
@@ -344,6 +347,12 @@ static QString deviceLocation(struct ::udev_device *dev)
     return QString::fromLatin1(::udev_device_get_devnode(dev));
 }
 
+static QString deviceUsbPortPath(struct ::udev_device *dev, QString *usbInterface)
+{
+    return QSerialPortInfoPrivate::usbPortPathFromSysfsPath(
+                QString::fromLatin1(::udev_device_get_syspath(dev)), usbInterface);
+}
+
 QList<QSerialPortInfo> availablePortsByUdev(bool &ok)
 {
     ok = false;
@@ -398,6 +407,7 @@ QList<QSerialPortInfo> availablePortsByUdev(bool &ok)
             priv.serialNumber = deviceSerialNumber(dev.get());
             priv.vendorIdentifier = deviceVendorIdentifier(dev.get(), priv.hasVendorIdentifier);
             priv.productIdentifier = deviceProductIdentifier(dev.get(), priv.hasProductIdentifier);
+            priv.usbPortPath = deviceUsbPortPath(dev.get(), &priv.usbInterface);
         } else {
             if (!isRfcommDevice(priv.portName)
                     && !isVirtualNullModemDevice(priv.portName)
@@ -412,6 +422,30 @@ QList<QSerialPortInfo> availablePortsByUdev(bool &ok)
     return serialPortInfoList;
 }
 
+// Maps the device nodes to the symbolic links, which udev creates for
+// them in the given directory, e.g. /dev/serial/by-id.
+static QHash<QString, QString> persistentDeviceLinks(const QString &linksDirectoryPath)
+{
+    QHash<QString, QString> links;
+
+    QDir linksDir(linksDirectoryPath);
+    if (!linksDir.exists())
+        return links;
+
+    linksDir.setFilter(QDir::Files | QDir::System);
+    const auto linkInfos = linksDir.entryInfoList();
+    links.reserve(linkInfos.size());
+    for (const QFileInfo &linkInfo : linkInfos) {
+        if (!linkInfo.isSymLink())
+            continue;
+        const QString deviceFilePath = linkInfo.symLinkTarget();
+        if (!links.contains(deviceFilePath))
+            links.insert(deviceFilePath, linkInfo.absoluteFilePath());
+    }
+
+    return links;
+}
+
 QList<QSerialPortInfo> QSerialPortInfo::availablePorts()
 {
     bool ok;
@@ -426,6 +460,16 @@ QList<QSerialPortInfo> QSerialPortInfo::availablePorts()
     if (!ok)
         serialPortInfoList = availablePortsByFiltersOfDevices(ok);
 
+    const QHash<QString, QString> byIdLinks = persistentDeviceLinks(QStringLiteral("/dev/serial/by-id"));
+    const QHash<QString, QString> byPathLinks = persistentDeviceLinks(QStringLiteral("/dev/serial/by-path"));
+    if (!byIdLinks.isEmpty() || !byPathLinks.isEmpty()) {
+        for (QSerialPortInfo &serialPortInfo : serialPortInfoList) {
+            QSerialPortInfoPrivate *d = serialPortInfo.d_ptr.get();
+            d->persistentIdLocation = byIdLinks.value(d->device);
+            d->persistentPathLocation = byPathLinks.value(d->device);
+        }
+    }
+
     return serialPortInfoList;
 }
 
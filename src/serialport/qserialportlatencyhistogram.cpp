@@ -0,0 +1,175 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportlatencyhistogram.h"
+#include "qserialportlatencyhistogram_p.h"
+
+#include <QtCore/qalgorithms.h>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QSerialPortLatencyHistogram
+    \since 6.6
+
+    \brief Holds the distribution of latencies recorded by a serial port.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    When latency recording is enabled with
+    QSerialPort::setLatencyRecordingEnabled(), the serial port measures how
+    the time is spent each time it is notified of incoming data, and
+    QSerialPort::latencyHistogram() returns a snapshot of the values
+    recorded so far for one stage of that notification.
+
+    All values are in nanoseconds. They are grouped into buckets whose width
+    grows with the value, so that the histogram has a fixed size while its
+    relative precision is better than one eighth over the whole range.
+    The percentiles are reported as the highest value of their bucket.
+
+    \code
+    const QSerialPortLatencyHistogram histogram =
+            port->latencyHistogram(QSerialPort::ReadyReadLatency);
+    qInfo() << "p99" << histogram.percentile(99) << "max" << histogram.maximum();
+    \endcode
+
+    \sa QSerialPort::LatencyStage
+*/
+
+/*!
+    \fn QSerialPortLatencyHistogram::QSerialPortLatencyHistogram()
+
+    Constructs an empty histogram.
+*/
+
+/*!
+    \fn bool QSerialPortLatencyHistogram::isEmpty() const
+
+    Returns \c true if no value is recorded in the histogram.
+*/
+
+/*!
+    \fn quint64 QSerialPortLatencyHistogram::count() const
+
+    Returns the number of values recorded in the histogram.
+*/
+
+/*!
+    \fn qint64 QSerialPortLatencyHistogram::minimum() const
+
+    Returns the smallest value recorded, or 0 if the histogram is empty.
+*/
+
+/*!
+    \fn qint64 QSerialPortLatencyHistogram::maximum() const
+
+    Returns the largest value recorded, or 0 if the histogram is empty.
+*/
+
+/*!
+    Returns the mean of the values recorded, or 0 if the histogram is empty.
+*/
+qint64 QSerialPortLatencyHistogram::mean() const
+{
+    return m_count ? m_sum / qint64(m_count) : 0;
+}
+
+/*!
+    Returns the value below which \a percent percent of the recorded values
+    fall, or 0 if the histogram is empty.
+
+    For example, percentile(50) returns the median and percentile(100) the
+    maximum.
+*/
+qint64 QSerialPortLatencyHistogram::percentile(double percent) const
+{
+    if (m_count == 0)
+        return 0;
+
+    const quint64 rank = qMax(quint64(1), quint64(std::ceil(qBound(0.0, percent, 100.0)
+                                                            * double(m_count) / 100)));
+    quint64 total = 0;
+    for (int i = 0; i < m_counts.size(); ++i) {
+        total += m_counts.at(i);
+        if (total >= rank)
+            return qBound(m_minimum, QSerialPortLatencyRecorder::bucketHighestValue(i), m_maximum);
+    }
+    return m_maximum;
+}
+
+int QSerialPortLatencyRecorder::bucketIndex(qint64 value)
+{
+    if (value < SubBucketCount)
+        return int(qMax(value, qint64(0)));
+
+    // The top SubBucketBits bits below the most significant one select the
+    // bucket within its power of two.
+    const int shift = 63 - qCountLeadingZeroBits(quint64(value)) - SubBucketBits;
+    return shift * SubBucketCount + int(value >> shift);
+}
+
+qint64 QSerialPortLatencyRecorder::bucketHighestValue(int index)
+{
+    if (index < 2 * SubBucketCount)
+        return index;
+
+    const int shift = index / SubBucketCount - 1;
+    const qint64 lowest = qint64(SubBucketCount + index % SubBucketCount) << shift;
+    return lowest + (qint64(1) << shift) - 1;
+}
+
+void QSerialPortLatencyRecorder::record(QSerialPort::LatencyStage stage, qint64 value)
+{
+    Histogram &histogram = m_histograms[stage];
+    histogram.counts[bucketIndex(value)].fetchAndAddRelaxed(1);
+    histogram.sum.fetchAndAddRelaxed(value);
+
+    qint64 minimum = histogram.minimum.loadRelaxed();
+    while (value < minimum && !histogram.minimum.testAndSetRelaxed(minimum, value, minimum)) {
+    }
+    qint64 maximum = histogram.maximum.loadRelaxed();
+    while (value > maximum && !histogram.maximum.testAndSetRelaxed(maximum, value, maximum)) {
+    }
+}
+
+QSerialPortLatencyHistogram QSerialPortLatencyRecorder::histogram(
+        QSerialPort::LatencyStage stage) const
+{
+    const Histogram &histogram = m_histograms[stage];
+    QSerialPortLatencyHistogram result;
+
+    // Only the buckets up to the last used one are kept.
+    int size = BucketCount;
+    while (size > 0 && histogram.counts[size - 1].loadRelaxed() == 0)
+        --size;
+    if (size == 0)
+        return result;
+
+    result.m_counts.resize(size);
+    for (int i = 0; i < size; ++i) {
+        result.m_counts[i] = histogram.counts[i].loadRelaxed();
+        result.m_count += result.m_counts.at(i);
+    }
+    result.m_minimum = histogram.minimum.loadRelaxed();
+    result.m_maximum = histogram.maximum.loadRelaxed();
+    result.m_sum = histogram.sum.loadRelaxed();
+    // A value being recorded right now may be counted before its minimum is.
+    result.m_minimum = qMin(result.m_minimum, result.m_maximum);
+    return result;
+}
+
+void QSerialPortLatencyRecorder::reset()
+{
+    for (Histogram &histogram : m_histograms) {
+        for (auto &count : histogram.counts)
+            count.storeRelaxed(0);
+        histogram.minimum.storeRelaxed(std::numeric_limits<qint64>::max());
+        histogram.maximum.storeRelaxed(0);
+        histogram.sum.storeRelaxed(0);
+    }
+}
+
+QT_END_NAMESPACE
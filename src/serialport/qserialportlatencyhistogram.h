@@ -0,0 +1,38 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTLATENCYHISTOGRAM_H
+#define QSERIALPORTLATENCYHISTOGRAM_H
+
+#include <QtCore/qlist.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class Q_SERIALPORT_EXPORT QSerialPortLatencyHistogram
+{
+public:
+    QSerialPortLatencyHistogram() = default;
+
+    bool isEmpty() const { return m_count == 0; }
+    quint64 count() const { return m_count; }
+
+    qint64 minimum() const { return m_minimum; }
+    qint64 maximum() const { return m_maximum; }
+    qint64 mean() const;
+    qint64 percentile(double percent) const;
+
+private:
+    friend class QSerialPortLatencyRecorder;
+
+    QList<quint64> m_counts;
+    quint64 m_count = 0;
+    qint64 m_minimum = 0;
+    qint64 m_maximum = 0;
+    qint64 m_sum = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTLATENCYHISTOGRAM_H
@@ -0,0 +1,63 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTLATENCYHISTOGRAM_P_H
+#define QSERIALPORTLATENCYHISTOGRAM_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportlatencyhistogram.h"
+#include "qserialport.h"
+
+#include <QtCore/qatomic.h>
+
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+// Records the read notification latencies of one serial port. Recording is
+// done by the thread of the port, with relaxed atomic operations only, so
+// that histograms can be taken from any other thread at the same time.
+class QSerialPortLatencyRecorder
+{
+public:
+    enum {
+        // Each power of two is split into this many buckets, which keeps
+        // the error of a recorded value below 1/8.
+        SubBucketBits = 3,
+        SubBucketCount = 1 << SubBucketBits,
+        BucketCount = (64 - SubBucketBits) * SubBucketCount,
+        StageCount = QSerialPort::NotificationLatency + 1
+    };
+
+    static int bucketIndex(qint64 value);
+    static qint64 bucketHighestValue(int index);
+
+    void record(QSerialPort::LatencyStage stage, qint64 value);
+    QSerialPortLatencyHistogram histogram(QSerialPort::LatencyStage stage) const;
+    void reset();
+
+private:
+    struct Histogram
+    {
+        QAtomicInteger<quint64> counts[BucketCount];
+        QAtomicInteger<qint64> minimum = std::numeric_limits<qint64>::max();
+        QAtomicInteger<qint64> maximum = 0;
+        QAtomicInteger<qint64> sum = 0;
+    };
+
+    Histogram m_histograms[StageCount];
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTLATENCYHISTOGRAM_P_H
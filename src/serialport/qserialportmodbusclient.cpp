@@ -0,0 +1,570 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportmodbusclient.h"
+#include "qserialportmodbusclient_p.h"
+#include "qserialport.h"
+#include "qserialport_p.h"
+#include "qserialportchecksum_p.h"
+
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qtimer.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum : quint8 {
+    BroadcastAddress = 0,
+    ExceptionFlag = 0x80
+};
+
+enum : qsizetype {
+    MinimumAduSize = 4,
+    MaximumAduSize = 256
+};
+
+} // namespace
+
+static qint64 currentTimestamp()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+static int timerInterval(qint64 nsecs)
+{
+    return int((qMax(nsecs, qint64(0)) + 999999) / 1000000);
+}
+
+/*!
+    \class QSerialPortModbusClient
+    \since 6.6
+
+    \brief Sends Modbus RTU requests to the servers on a serial line.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    QSerialPortModbusClient implements the client (master) side of the
+    Modbus RTU protocol on an open QSerialPort. Requests for any number of
+    servers are queued with sendRequest(), and transmitted one at a time, as
+    soon as the line has been silent for the inter-frame delay (t3.5).
+
+    The character time used for the t1.5 and t3.5 delays is derived from the
+    baud rate, data bits, parity and stop bits of the port. For baud rates
+    above 19200, the fixed delays of the Modbus specification are used.
+
+    The end of a response is detected as soon as the expected number of
+    bytes for the function code has arrived, or else after a silence of
+    t3.5. Every read of the port is time-stamped, so the silences between
+    the characters are measured at the time the data arrived rather than at
+    the time it was processed. A response with a silence of more than t1.5
+    within the frame is rejected with FramingError.
+
+    A request that is due to be sent while there is no open port fails
+    with WriteError.
+
+    The client takes over the read channel of the port.
+
+    \sa QSerialPort
+*/
+
+/*!
+    \enum QSerialPortModbusClient::Error
+
+    This enum describes the reasons why a request failed.
+
+    \value NoError          No error occurred.
+    \value TimeoutError     The server did not answer in time.
+    \value ChecksumError    The CRC of the response is wrong.
+    \value FramingError     The response contained a silence of more than
+                            1.5 character times, or is too short.
+    \value ProtocolError    The response does not match the request.
+    \value ExceptionError   The server answered with an exception response.
+    \value WriteError       The request could not be written to the port,
+                            or the port was not open.
+*/
+
+// The next request is always sent from the event loop: the result of the
+// previous one is reported first, a failure is never reported from within
+// sendRequest(), and a run of failing requests does not recurse.
+void QSerialPortModbusClientPrivate::scheduleNext()
+{
+    if (transactionActive || requests.isEmpty())
+        return;
+
+    const bool portOpen = port && port->isOpen();
+    sendTimer->start(portOpen ? timerInterval(busIdleTimestamp - currentTimestamp()) : 0);
+}
+
+void QSerialPortModbusClientPrivate::sendCurrent()
+{
+    if (transactionActive || requests.isEmpty())
+        return;
+
+    // Nothing would send the request once the port is open.
+    if (!port || !port->isOpen()) {
+        finishCurrent(QSerialPortModbusClient::WriteError);
+        return;
+    }
+
+    // Drop anything received while the line was idle.
+    port->skip(port->bytesAvailable());
+
+    transactionActive = true;
+    response.clear();
+    framingViolated = false;
+
+    const Request &request = requests.constFirst();
+    if (port->write(request.adu) != request.adu.size()) {
+        finishCurrent(QSerialPortModbusClient::WriteError);
+        return;
+    }
+
+    const qint64 characterTime = QSerialPortPrivate::get(port)->characterTimeNSecs();
+    const qint64 transmissionTime = request.adu.size() * characterTime;
+    busIdleTimestamp = currentTimestamp() + transmissionTime + q_func()->interFrameDelayNSecs();
+
+    // No server answers a broadcast, so wait for the turnaround delay only.
+    if (request.serverAddress == BroadcastAddress)
+        responseTimer->start(timerInterval(transmissionTime) + turnaroundDelay);
+    else
+        responseTimer->start(timerInterval(transmissionTime) + timeout);
+}
+
+void QSerialPortModbusClientPrivate::readFromPort()
+{
+    Q_Q(QSerialPortModbusClient);
+
+    if (!port)
+        return;
+
+    const QByteArray data = port->readAll();
+    if (data.isEmpty())
+        return;
+
+    const qint64 characterTime = QSerialPortPrivate::get(port)->characterTimeNSecs();
+    qint64 timestamp = QSerialPortPrivate::get(port)->lastReadTimestamp;
+    if (timestamp == 0)
+        timestamp = currentTimestamp();
+    busIdleTimestamp = qMax(busIdleTimestamp, timestamp + q->interFrameDelayNSecs());
+
+    const Request *request = transactionActive ? &requests.constFirst() : nullptr;
+    if (!request || request->serverAddress == BroadcastAddress)
+        return;
+
+    if (!response.isEmpty()) {
+        // The time between the last character of the previous read and the
+        // first character of this one.
+        const qint64 silence = timestamp - lastByteTimestamp - data.size() * characterTime;
+        if (silence > q->interFrameDelayNSecs())
+            response.clear();
+        else if (silence > q->interCharacterTimeoutNSecs())
+            framingViolated = true;
+    }
+
+    response.append(data);
+    lastByteTimestamp = timestamp;
+
+    const qsizetype expectedLength = expectedResponseLength();
+    if (expectedLength > 0 && response.size() >= expectedLength) {
+        response.truncate(expectedLength);
+        processResponse();
+    } else if (response.size() > MaximumAduSize) {
+        frameGapTimer->stop();
+        retryOrFail(QSerialPortModbusClient::FramingError);
+    } else {
+        frameGapTimer->start(timerInterval(q->interFrameDelayNSecs()));
+    }
+}
+
+void QSerialPortModbusClientPrivate::processResponse()
+{
+    frameGapTimer->stop();
+
+    if (!transactionActive)
+        return;
+
+    if (framingViolated || response.size() < MinimumAduSize) {
+        retryOrFail(QSerialPortModbusClient::FramingError);
+        return;
+    }
+
+    // The CRC over a frame including its own CRC is zero.
+    if (qt_crc16_modbus(QtCrc16ModbusInitial, response.constData(), response.size()) != 0) {
+        retryOrFail(QSerialPortModbusClient::ChecksumError);
+        return;
+    }
+
+    const Request &request = requests.constFirst();
+    const quint8 serverAddress = quint8(response.at(0));
+    const quint8 functionCode = quint8(response.at(1));
+    if (serverAddress != request.serverAddress
+            || (functionCode & ~ExceptionFlag) != request.functionCode) {
+        retryOrFail(QSerialPortModbusClient::ProtocolError);
+        return;
+    }
+
+    if (functionCode & ExceptionFlag)
+        finishCurrent(QSerialPortModbusClient::ExceptionError, quint8(response.at(2)));
+    else
+        finishCurrent(QSerialPortModbusClient::NoError);
+}
+
+void QSerialPortModbusClientPrivate::handleResponseTimeout()
+{
+    if (!transactionActive)
+        return;
+
+    if (requests.constFirst().serverAddress == BroadcastAddress) {
+        finishCurrent(QSerialPortModbusClient::NoError);
+        return;
+    }
+
+    // Give a response that is still arriving the chance to complete.
+    if (!response.isEmpty() && frameGapTimer->isActive()) {
+        responseTimer->start(frameGapTimer->remainingTime() + 1);
+        return;
+    }
+
+    retryOrFail(QSerialPortModbusClient::TimeoutError);
+}
+
+void QSerialPortModbusClientPrivate::retryOrFail(QSerialPortModbusClient::Error error)
+{
+    Request &request = requests.first();
+    if (request.retriesLeft > 0) {
+        --request.retriesLeft;
+        responseTimer->stop();
+        frameGapTimer->stop();
+        transactionActive = false;
+        response.clear();
+        scheduleNext();
+        return;
+    }
+    finishCurrent(error);
+}
+
+void QSerialPortModbusClientPrivate::finishCurrent(QSerialPortModbusClient::Error error,
+                                                   quint8 exceptionCode)
+{
+    Q_Q(QSerialPortModbusClient);
+
+    responseTimer->stop();
+    frameGapTimer->stop();
+    transactionActive = false;
+
+    const Request request = requests.takeFirst();
+    const QByteArray data = error == QSerialPortModbusClient::NoError && !response.isEmpty()
+            ? response.mid(2, response.size() - MinimumAduSize)
+            : QByteArray();
+    response.clear();
+
+    // Schedule the next transaction before handing out the result, as the
+    // slots may delete the client.
+    scheduleNext();
+
+    if (error == QSerialPortModbusClient::NoError)
+        emit q->replyReceived(request.requestId, request.serverAddress, request.functionCode, data);
+    else
+        emit q->requestFailed(request.requestId, error, exceptionCode);
+}
+
+// Returns the length of the response, as far as it can be determined from
+// its header, or 0 if the end of the frame must be detected by silence.
+qsizetype QSerialPortModbusClientPrivate::expectedResponseLength() const
+{
+    if (response.size() < 2)
+        return 0;
+
+    const quint8 functionCode = quint8(response.at(1));
+    if (functionCode & ExceptionFlag)
+        return 5;
+
+    switch (functionCode) {
+    case 0x01: // Read Coils
+    case 0x02: // Read Discrete Inputs
+    case 0x03: // Read Holding Registers
+    case 0x04: // Read Input Registers
+    case 0x0C: // Get Comm Event Log
+    case 0x11: // Report Server ID
+    case 0x17: // Read/Write Multiple Registers
+        return response.size() < 3 ? 0 : 5 + quint8(response.at(2));
+    case 0x07: // Read Exception Status
+        return 5;
+    case 0x05: // Write Single Coil
+    case 0x06: // Write Single Register
+    case 0x08: // Diagnostics
+    case 0x0B: // Get Comm Event Counter
+    case 0x0F: // Write Multiple Coils
+    case 0x10: // Write Multiple Registers
+        return 8;
+    case 0x16: // Mask Write Register
+        return 10;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*!
+    Constructs a new Modbus client with the given \a parent, without a port.
+
+    \sa setPort()
+*/
+QSerialPortModbusClient::QSerialPortModbusClient(QObject *parent)
+    : QSerialPortModbusClient(nullptr, parent)
+{
+}
+
+/*!
+    Constructs a new Modbus client with the given \a parent, which sends
+    its requests on \a port.
+*/
+QSerialPortModbusClient::QSerialPortModbusClient(QSerialPort *port, QObject *parent)
+    : QObject(*new QSerialPortModbusClientPrivate, parent)
+{
+    Q_D(QSerialPortModbusClient);
+
+    d->sendTimer = new QTimer(this);
+    d->sendTimer->setSingleShot(true);
+    d->sendTimer->setTimerType(Qt::PreciseTimer);
+    connect(d->sendTimer, &QTimer::timeout, this, [d]() {
+        d->sendCurrent();
+    });
+
+    d->responseTimer = new QTimer(this);
+    d->responseTimer->setSingleShot(true);
+    d->responseTimer->setTimerType(Qt::PreciseTimer);
+    connect(d->responseTimer, &QTimer::timeout, this, [d]() {
+        d->handleResponseTimeout();
+    });
+
+    d->frameGapTimer = new QTimer(this);
+    d->frameGapTimer->setSingleShot(true);
+    d->frameGapTimer->setTimerType(Qt::PreciseTimer);
+    connect(d->frameGapTimer, &QTimer::timeout, this, [d]() {
+        d->processResponse();
+    });
+
+    setPort(port);
+}
+
+/*!
+    Destroys the Modbus client. The pending requests are dropped, and the
+    port is not closed.
+*/
+QSerialPortModbusClient::~QSerialPortModbusClient()
+{
+}
+
+/*!
+    Sets the \a port on which the requests are sent. The requests that are
+    still pending are kept and sent on the new port, or fail with WriteError
+    if it is not open.
+*/
+void QSerialPortModbusClient::setPort(QSerialPort *port)
+{
+    Q_D(QSerialPortModbusClient);
+
+    if (d->port == port)
+        return;
+
+    disconnect(d->readyReadConnection);
+    d->port = port;
+
+    d->responseTimer->stop();
+    d->frameGapTimer->stop();
+    d->transactionActive = false;
+    d->response.clear();
+    d->busIdleTimestamp = 0;
+
+    if (port) {
+        d->readyReadConnection = connect(port, &QIODevice::readyRead, this, [d]() {
+            d->readFromPort();
+        });
+    }
+    d->scheduleNext();
+}
+
+/*!
+    Returns the port on which the requests are sent.
+*/
+QSerialPort *QSerialPortModbusClient::port() const
+{
+    Q_D(const QSerialPortModbusClient);
+    return d->port;
+}
+
+/*!
+    Sets the time to wait for a response to \a msecs milliseconds, counted
+    from the end of the transmission of the request.
+
+    The default timeout is 200 milliseconds.
+*/
+void QSerialPortModbusClient::setTimeout(int msecs)
+{
+    Q_D(QSerialPortModbusClient);
+    d->timeout = qMax(msecs, 0);
+}
+
+/*!
+    Returns the time to wait for a response, in milliseconds.
+*/
+int QSerialPortModbusClient::timeout() const
+{
+    Q_D(const QSerialPortModbusClient);
+    return d->timeout;
+}
+
+/*!
+    Sets the \a number of times a request is repeated when its response is
+    missing or invalid. The default is 3.
+*/
+void QSerialPortModbusClient::setNumberOfRetries(int number)
+{
+    Q_D(QSerialPortModbusClient);
+    d->numberOfRetries = qMax(number, 0);
+}
+
+/*!
+    Returns the number of times a request is repeated.
+*/
+int QSerialPortModbusClient::numberOfRetries() const
+{
+    Q_D(const QSerialPortModbusClient);
+    return d->numberOfRetries;
+}
+
+/*!
+    Sets the delay after a broadcast request to \a msecs milliseconds. The
+    servers need this time to process a broadcast before the next request.
+
+    The default delay is 100 milliseconds.
+*/
+void QSerialPortModbusClient::setTurnaroundDelay(int msecs)
+{
+    Q_D(QSerialPortModbusClient);
+    d->turnaroundDelay = qMax(msecs, 0);
+}
+
+/*!
+    Returns the delay after a broadcast request, in milliseconds.
+*/
+int QSerialPortModbusClient::turnaroundDelay() const
+{
+    Q_D(const QSerialPortModbusClient);
+    return d->turnaroundDelay;
+}
+
+/*!
+    Queues the request with the function code \a functionCode and the payload
+    \a data for the server with the address \a serverAddress, and returns the
+    identifier of the request.
+
+    The request is answered with either the replyReceived() or the
+    requestFailed() signal. Requests to the broadcast address 0 are not
+    answered by the servers, and succeed after the turnaround delay.
+
+    \sa cancelRequest()
+*/
+quint64 QSerialPortModbusClient::sendRequest(quint8 serverAddress, quint8 functionCode,
+                                             const QByteArray &data)
+{
+    Q_D(QSerialPortModbusClient);
+
+    QSerialPortModbusClientPrivate::Request request;
+    request.requestId = d->nextRequestId++;
+    request.serverAddress = serverAddress;
+    request.functionCode = functionCode;
+    request.retriesLeft = serverAddress == BroadcastAddress ? 0 : d->numberOfRetries;
+
+    // The frame is built once, so that retries and queued requests go out
+    // without delay.
+    request.adu.reserve(data.size() + MinimumAduSize);
+    request.adu.append(char(serverAddress));
+    request.adu.append(char(functionCode));
+    request.adu.append(data);
+    char crc[2];
+    qToLittleEndian<quint16>(qt_crc16_modbus(QtCrc16ModbusInitial, request.adu.constData(),
+                                             request.adu.size()), crc);
+    request.adu.append(crc, sizeof(crc));
+
+    d->requests.append(request);
+    d->scheduleNext();
+    return request.requestId;
+}
+
+/*!
+    Removes the request with the identifier \a requestId from the queue. A
+    request that is already being transmitted is not cancelled.
+*/
+void QSerialPortModbusClient::cancelRequest(quint64 requestId)
+{
+    Q_D(QSerialPortModbusClient);
+
+    const qsizetype first = d->transactionActive ? 1 : 0;
+    for (qsizetype i = first; i < d->requests.size(); ++i) {
+        if (d->requests.at(i).requestId == requestId) {
+            d->requests.removeAt(i);
+            return;
+        }
+    }
+}
+
+/*!
+    Returns the number of requests that are not answered yet.
+*/
+qsizetype QSerialPortModbusClient::pendingRequestCount() const
+{
+    Q_D(const QSerialPortModbusClient);
+    return d->requests.size();
+}
+
+/*!
+    Returns the minimum silence between two frames (t3.5), in nanoseconds,
+    for the current settings of the port.
+*/
+qint64 QSerialPortModbusClient::interFrameDelayNSecs() const
+{
+    Q_D(const QSerialPortModbusClient);
+
+    if (!d->port || d->port->baudRate(QSerialPort::Input) > 19200)
+        return 1750000;
+    return QSerialPortPrivate::get(d->port)->characterTimeNSecs() * 7 / 2;
+}
+
+/*!
+    Returns the maximum silence between two characters of a frame (t1.5),
+    in nanoseconds, for the current settings of the port.
+*/
+qint64 QSerialPortModbusClient::interCharacterTimeoutNSecs() const
+{
+    Q_D(const QSerialPortModbusClient);
+
+    if (!d->port || d->port->baudRate(QSerialPort::Input) > 19200)
+        return 750000;
+    return QSerialPortPrivate::get(d->port)->characterTimeNSecs() * 3 / 2;
+}
+
+/*!
+    \fn void QSerialPortModbusClient::replyReceived(quint64 requestId, quint8 serverAddress, quint8 functionCode, const QByteArray &data)
+
+    This signal is emitted when the request with the identifier \a requestId
+    for the server with the address \a serverAddress and the function code
+    \a functionCode is answered. The \a data holds the payload of the
+    response, without the address, function code and CRC.
+*/
+
+/*!
+    \fn void QSerialPortModbusClient::requestFailed(quint64 requestId, QSerialPortModbusClient::Error error, quint8 exceptionCode)
+
+    This signal is emitted when the request with the identifier \a requestId
+    failed with \a error. If the server answered with an exception response,
+    \a exceptionCode holds the exception code; otherwise it is 0.
+*/
+
+QT_END_NAMESPACE
+
+#include "moc_qserialportmodbusclient.cpp"
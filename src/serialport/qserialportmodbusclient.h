@@ -0,0 +1,69 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTMODBUSCLIENT_H
+#define QSERIALPORTMODBUSCLIENT_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qobject.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPort;
+class QSerialPortModbusClientPrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortModbusClient : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortModbusClient)
+
+public:
+    enum Error {
+        NoError,
+        TimeoutError,
+        ChecksumError,
+        FramingError,
+        ProtocolError,
+        ExceptionError,
+        WriteError
+    };
+    Q_ENUM(Error)
+
+    explicit QSerialPortModbusClient(QObject *parent = nullptr);
+    explicit QSerialPortModbusClient(QSerialPort *port, QObject *parent = nullptr);
+    ~QSerialPortModbusClient();
+
+    void setPort(QSerialPort *port);
+    QSerialPort *port() const;
+
+    void setTimeout(int msecs);
+    int timeout() const;
+
+    void setNumberOfRetries(int number);
+    int numberOfRetries() const;
+
+    void setTurnaroundDelay(int msecs);
+    int turnaroundDelay() const;
+
+    quint64 sendRequest(quint8 serverAddress, quint8 functionCode, const QByteArray &data);
+    void cancelRequest(quint64 requestId);
+    qsizetype pendingRequestCount() const;
+
+    qint64 interFrameDelayNSecs() const;
+    qint64 interCharacterTimeoutNSecs() const;
+
+Q_SIGNALS:
+    void replyReceived(quint64 requestId, quint8 serverAddress, quint8 functionCode,
+                       const QByteArray &data);
+    void requestFailed(quint64 requestId, QSerialPortModbusClient::Error error,
+                       quint8 exceptionCode);
+
+private:
+    Q_DISABLE_COPY(QSerialPortModbusClient)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTMODBUSCLIENT_H
@@ -0,0 +1,76 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTMODBUSCLIENT_P_H
+#define QSERIALPORTMODBUSCLIENT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportmodbusclient.h"
+
+#include <QtCore/qlist.h>
+#include <QtCore/qpointer.h>
+
+#include <private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+class QSerialPortModbusClientPrivate : public QObjectPrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortModbusClient)
+
+    struct Request
+    {
+        quint64 requestId = 0;
+        quint8 serverAddress = 0;
+        quint8 functionCode = 0;
+        int retriesLeft = 0;
+        QByteArray adu;
+    };
+
+    void scheduleNext();
+    void sendCurrent();
+    void readFromPort();
+    void processResponse();
+    void handleResponseTimeout();
+    void retryOrFail(QSerialPortModbusClient::Error error);
+    void finishCurrent(QSerialPortModbusClient::Error error, quint8 exceptionCode = 0);
+
+    qsizetype expectedResponseLength() const;
+
+    QPointer<QSerialPort> port;
+    QMetaObject::Connection readyReadConnection;
+
+    QList<Request> requests;
+    bool transactionActive = false;
+    quint64 nextRequestId = 1;
+
+    QByteArray response;
+    qint64 lastByteTimestamp = 0;
+    qint64 busIdleTimestamp = 0;
+    bool framingViolated = false;
+
+    QTimer *sendTimer = nullptr;
+    QTimer *responseTimer = nullptr;
+    QTimer *frameGapTimer = nullptr;
+
+    int timeout = 200;
+    int numberOfRetries = 3;
+    int turnaroundDelay = 100;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTMODBUSCLIENT_P_H
@@ -0,0 +1,965 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportmultiplexer.h"
+#include "qserialportmultiplexer_p.h"
+#include "qserialport.h"
+#include "qserialport_p.h"
+#include "qserialportchecksum_p.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qtimer.h>
+
+#include <cstring>
+#include <limits>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum : quint8 {
+    Flag = 0xF9,
+    EA = 0x01,
+    CR = 0x02,
+    PF = 0x10
+};
+
+// Frame types, without the P/F bit.
+enum : quint8 {
+    SABM = 0x2F,
+    UA = 0x63,
+    DM = 0x0F,
+    DISC = 0x43,
+    UIH = 0xEF,
+    UI = 0x03
+};
+
+// Control channel message types, without the C/R bit.
+enum : quint8 {
+    PSC = 0x41,
+    CLD = 0xC1,
+    TEST = 0x21,
+    FCON = 0xA1,
+    FCOFF = 0x61,
+    MSC = 0xE1,
+    NSC = 0x11
+};
+
+// V.24 signals of the modem status command.
+enum : quint8 {
+    FC = 0x02,
+    RTC = 0x04,
+    RTR = 0x08,
+    DV = 0x80
+};
+
+enum : int {
+    MaximumBasicFrameSize = 32767
+};
+
+} // namespace
+
+/*!
+    \class QSerialPortMultiplexer
+    \since 6.6
+
+    \brief Multiplexes several virtual channels over one serial port, as
+    described in 3GPP TS 27.010.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    Cellular modems offer several independent data streams, such as AT
+    commands, PPP and GNSS output, over a single serial line with the
+    multiplexer protocol of 3GPP TS 27.010 (also known as GSM 07.10 or
+    CMUX). QSerialPortMultiplexer implements the initiating side of the
+    basic option of this protocol, and presents every data link connection
+    (DLC) as a QIODevice.
+
+    The modem must be switched to multiplexer mode first, usually with the
+    \c{AT+CMUX} command, and the maximum frame size must match the one
+    configured there. open() then establishes the control channel, and
+    openChannel() the data link connections, each with its DLC identifier
+    (DLCI) from 1 to 63:
+
+    \code
+    QSerialPortMultiplexer mux(port);
+    mux.setMaximumFrameSize(127);
+    connect(&mux, &QSerialPortMultiplexer::opened, [&mux]() {
+        QIODevice *at = mux.openChannel(1);
+        at->write("AT+CSQ\r");
+    });
+    mux.open();
+    \endcode
+
+    The frames are decoded straight from the read buffer of the port,
+    without an intermediate copy, and their data is appended to the buffer
+    of the channel. Data written to a channel is sent in frames of at most
+    maximumFrameSize() bytes, as soon as the channel is established and the
+    modem has not stopped the flow on it.
+
+    If setChannelReadBufferSize() limits the buffers of the channels, the
+    modem is asked to stop sending on a channel whose buffer is full, and
+    to resume once the data was read.
+
+    Commands that the modem does not answer are repeated after timeout()
+    milliseconds, up to maximumRetries() times.
+
+    The multiplexer takes over the read channel of the port.
+
+    \sa QSerialPort
+*/
+
+/*!
+    \enum QSerialPortMultiplexer::Error
+
+    This enum describes the errors of the multiplexer.
+
+    \value NoError          No error occurred.
+    \value TimeoutError     The modem did not answer a command.
+    \value RejectedError    The modem rejected a connection.
+*/
+
+QSerialPortMultiplexerChannelPrivate::QSerialPortMultiplexerChannelPrivate()
+{
+    writeBufferChunkSize = 4096;
+    readBufferChunkSize = 4096;
+}
+
+QSerialPortMultiplexerChannel::QSerialPortMultiplexerChannel(
+        QSerialPortMultiplexerPrivate *multiplexer, int dlci, QObject *parent)
+    : QIODevice(*new QSerialPortMultiplexerChannelPrivate, parent)
+{
+    Q_D(QSerialPortMultiplexerChannel);
+    d->multiplexer = multiplexer;
+    d->dlci = dlci;
+}
+
+bool QSerialPortMultiplexerChannel::isSequential() const
+{
+    return true;
+}
+
+void QSerialPortMultiplexerChannel::close()
+{
+    Q_D(QSerialPortMultiplexerChannel);
+
+    const QSerialPortMultiplexerPrivate::LinkState state = d->multiplexer->links[d->dlci].state;
+    if (state == QSerialPortMultiplexerPrivate::Connecting
+            || state == QSerialPortMultiplexerPrivate::Connected) {
+        // The writes are flushed from the event loop, and QIODevice::close()
+        // drops what is still buffered. Send it ahead of the DISC command.
+        if (!d->multiplexer->aggregateFlowStopped)
+            d->multiplexer->flushChannel(d->dlci);
+        d->multiplexer->startCommand(d->dlci, QSerialPortMultiplexerPrivate::Disconnecting);
+    }
+    QIODevice::close();
+}
+
+qint64 QSerialPortMultiplexerChannel::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    // The data is in the buffer of QIODevice. Reading it may have made
+    // room for more.
+    Q_D(QSerialPortMultiplexerChannel);
+    d->multiplexer->resumeFlow(d->dlci);
+    return 0;
+}
+
+qint64 QSerialPortMultiplexerChannel::bytesAvailable() const
+{
+    // QIODevice serves reads that fit in its buffer without calling
+    // readData(). Applications that read in chunks ask for the size in
+    // between, so check here whether they made room.
+    Q_D(const QSerialPortMultiplexerChannel);
+    d->multiplexer->resumeFlow(d->dlci);
+    return QIODevice::bytesAvailable();
+}
+
+qint64 QSerialPortMultiplexerChannel::writeData(const char *data, qint64 maxSize)
+{
+    Q_D(QSerialPortMultiplexerChannel);
+    d->writeBuffer.append(data, maxSize);
+    d->multiplexer->scheduleFlush();
+    return maxSize;
+}
+
+void QSerialPortMultiplexerPrivate::readFromPort()
+{
+    if (!port)
+        return;
+
+    // Decode straight from the read buffer of the port.
+    QSerialPortPrivate *portPrivate = QSerialPortPrivate::get(port);
+    while (!portPrivate->buffer.isEmpty()) {
+        const qint64 blockSize = portPrivate->buffer.nextDataBlockSize();
+        decode(portPrivate->buffer.readPointer(), blockSize);
+        portPrivate->buffer.free(blockSize);
+    }
+
+    // The read notifications may have been disabled by a full read buffer.
+    portPrivate->startAsyncRead();
+
+    emitPendingSignals();
+}
+
+void QSerialPortMultiplexerPrivate::decode(const char *data, qsizetype size)
+{
+    qsizetype i = 0;
+    while (i < size) {
+        const char c = data[i];
+        switch (decoderState) {
+        case WaitingForFlag: {
+            const void *flag = std::memchr(data + i, Flag, size - i);
+            if (!flag)
+                return;
+            i = static_cast<const char *>(flag) - data + 1;
+            decoderState = ReadingAddress;
+            break;
+        }
+        case ReadingAddress:
+            ++i;
+            // Skip the flags between frames.
+            if (quint8(c) == Flag)
+                break;
+            if (!(c & EA)) {
+                decoderState = WaitingForFlag;
+                break;
+            }
+            address = quint8(c);
+            fcs = qt_fcs8(QtFcs8Initial, &c, 1);
+            decoderState = ReadingControl;
+            break;
+        case ReadingControl:
+            ++i;
+            control = quint8(c);
+            fcs = qt_fcs8(fcs, &c, 1);
+            decoderState = ReadingLength;
+            break;
+        case ReadingLength:
+            ++i;
+            fcs = qt_fcs8(fcs, &c, 1);
+            length = quint8(c) >> 1;
+            if (c & EA)
+                startInformation();
+            else
+                decoderState = ReadingExtendedLength;
+            break;
+        case ReadingExtendedLength:
+            ++i;
+            fcs = qt_fcs8(fcs, &c, 1);
+            length |= qsizetype(quint8(c)) << 7;
+            startInformation();
+            break;
+        case ReadingInformation: {
+            const qsizetype chunk = qMin(length - received, size - i);
+            if (target || (address >> 2) == 0)
+                information.append(data + i, chunk);
+            // The FCS of UI frames covers the information field as well.
+            if ((control & ~PF) == UI)
+                fcs = qt_fcs8(fcs, data + i, chunk);
+            received += chunk;
+            i += chunk;
+            if (received == length)
+                decoderState = ReadingFcs;
+            break;
+        }
+        case ReadingFcs:
+            ++i;
+            fcs = qt_fcs8(fcs, &c, 1);
+            if (fcs == QtFcs8Good) {
+                decoderState = ReadingClosingFlag;
+            } else {
+                discardFrame();
+                decoderState = WaitingForFlag;
+            }
+            break;
+        case ReadingClosingFlag:
+            if (quint8(c) != Flag) {
+                discardFrame();
+                decoderState = WaitingForFlag;
+                break;
+            }
+            // The closing flag may open the next frame.
+            ++i;
+            handleFrame();
+            decoderState = ReadingAddress;
+            break;
+        }
+    }
+}
+
+void QSerialPortMultiplexerPrivate::startInformation()
+{
+    received = 0;
+    target = nullptr;
+    information.clear();
+
+    if (length > maximumFrameSize) {
+        decoderState = WaitingForFlag;
+        return;
+    }
+
+    // The data of established channels is collected, and only goes to
+    // their buffers once the frame is known to be intact.
+    const quint8 type = control & ~PF;
+    const int dlci = address >> 2;
+    if (dlci != 0 && (type == UIH || type == UI)) {
+        const Link &link = links[dlci];
+        if (link.state == Connected && link.channel && link.channel->isOpen())
+            target = link.channel;
+    }
+    decoderState = length > 0 ? ReadingInformation : ReadingFcs;
+}
+
+void QSerialPortMultiplexerPrivate::discardFrame()
+{
+    target = nullptr;
+    information.clear();
+}
+
+void QSerialPortMultiplexerPrivate::handleFrame()
+{
+    const int dlci = address >> 2;
+    Link &link = links[dlci];
+    const quint8 type = control & ~PF;
+
+    switch (type) {
+    case SABM:
+        // The modem is not expected to open connections itself.
+        sendFrame(dlci, DM | PF, false);
+        break;
+
+    case UA:
+        if (link.state == Connecting)
+            setConnected(dlci);
+        else if (link.state == Disconnecting)
+            closeLink(dlci);
+        break;
+
+    case DM:
+        if (link.state == Connecting)
+            pendingEvents.append({ Event::Error, dlci, QSerialPortMultiplexer::RejectedError });
+        if (link.state != Disconnected)
+            closeLink(dlci);
+        break;
+
+    case DISC:
+        sendFrame(dlci, UA | PF, false);
+        if (link.state != Disconnected)
+            closeLink(dlci);
+        break;
+
+    case UIH:
+    case UI:
+        if (dlci == 0) {
+            const QByteArray messages = std::exchange(information, {});
+            handleControlMessages(messages.constData(), messages.size());
+        } else if (target) {
+            auto &buffer = QSerialPortMultiplexerChannel::get(target)->buffer;
+            buffer.append(information);
+            information.clear();
+            target = nullptr;
+            pendingReadyRead |= quint64(1) << dlci;
+            const qint64 buffered = buffer.size();
+            if (channelReadBufferSize > 0 && buffered >= channelReadBufferSize
+                    && !link.flowStopped) {
+                link.flowStopped = true;
+                sendModemStatus(dlci, true);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void QSerialPortMultiplexerPrivate::handleControlMessages(const char *data, qsizetype size)
+{
+    qsizetype i = 0;
+    while (i + 2 <= size) {
+        const quint8 type = quint8(data[i++]);
+        qsizetype valueLength = quint8(data[i]) >> 1;
+        if (!(data[i++] & EA)) {
+            if (i >= size)
+                return;
+            valueLength |= qsizetype(quint8(data[i++])) << 7;
+        }
+        if (size - i < valueLength)
+            return;
+        const QByteArray value(data + i, valueLength);
+        i += valueLength;
+
+        // Responses to our commands need no further action.
+        if (!(type & CR))
+            continue;
+
+        switch (type & ~CR) {
+        case MSC:
+            if (value.size() >= 2) {
+                const int dlci = quint8(value.at(0)) >> 2;
+                const bool stopped = value.at(1) & FC;
+                links[dlci].peerFlowStopped = stopped;
+                if (!stopped)
+                    scheduleFlush();
+            }
+            sendControlMessage(MSC, false, value);
+            break;
+        case FCON:
+            aggregateFlowStopped = false;
+            sendControlMessage(FCON, false, value);
+            scheduleFlush();
+            break;
+        case FCOFF:
+            aggregateFlowStopped = true;
+            sendControlMessage(FCOFF, false, value);
+            break;
+        case CLD:
+            sendControlMessage(CLD, false, value);
+            closeAllLinks();
+            return;
+        case TEST:
+        case PSC:
+            sendControlMessage(type & ~CR, false, value);
+            break;
+        default:
+            // Non supported command
+            sendControlMessage(NSC, false, QByteArray(1, char(type)));
+            break;
+        }
+    }
+}
+
+void QSerialPortMultiplexerPrivate::emitPendingSignals()
+{
+    Q_Q(QSerialPortMultiplexer);
+
+    const QList<Event> events = std::exchange(pendingEvents, {});
+    quint64 readyRead = std::exchange(pendingReadyRead, 0);
+
+    for (const Event &event : events) {
+        switch (event.type) {
+        case Event::Opened:
+            emit q->opened();
+            break;
+        case Event::Closed:
+            emit q->closed();
+            break;
+        case Event::ChannelOpened:
+            emit q->channelOpened(event.dlci);
+            break;
+        case Event::ChannelClosed:
+            emit q->channelClosed(event.dlci);
+            break;
+        case Event::Error:
+            emit q->errorOccurred(event.error, event.dlci);
+            break;
+        }
+    }
+
+    while (readyRead) {
+        const int dlci = qCountTrailingZeroBits(readyRead);
+        readyRead &= readyRead - 1;
+        if (QSerialPortMultiplexerChannel *channel = links[dlci].channel) {
+            emit channel->readyRead();
+            // The handlers may have read without calling readData().
+            resumeFlow(dlci);
+        }
+    }
+}
+
+void QSerialPortMultiplexerPrivate::sendFrame(int dlci, quint8 frameControl, bool command,
+                                              const char *data, qsizetype size)
+{
+    if (!port)
+        return;
+
+    // We are the initiator: our commands carry C/R = 1, our responses 0.
+    char header[5];
+    qsizetype headerSize = 0;
+    header[headerSize++] = char(Flag);
+    header[headerSize++] = char(dlci << 2 | (command ? CR : 0) | EA);
+    header[headerSize++] = char(frameControl);
+    if (size > 127) {
+        header[headerSize++] = char((size << 1) & 0xFE);
+        header[headerSize++] = char(size >> 7);
+    } else {
+        header[headerSize++] = char(size << 1 | EA);
+    }
+
+    quint8 frameFcs = qt_fcs8(QtFcs8Initial, header + 1, headerSize - 1);
+    if ((frameControl & ~PF) == UI)
+        frameFcs = qt_fcs8(frameFcs, data, size);
+
+    QByteArray frame;
+    frame.reserve(headerSize + size + 2);
+    frame.append(header, headerSize);
+    frame.append(data, size);
+    frame.append(char(~frameFcs));
+    frame.append(char(Flag));
+    port->write(frame);
+}
+
+void QSerialPortMultiplexerPrivate::sendControlMessage(quint8 type, bool command,
+                                                       const QByteArray &value)
+{
+    QByteArray message;
+    message.reserve(value.size() + 3);
+    message.append(char(type | (command ? CR : 0)));
+    if (value.size() > 127) {
+        message.append(char((value.size() << 1) & 0xFE));
+        message.append(char(value.size() >> 7));
+    } else {
+        message.append(char(value.size() << 1 | EA));
+    }
+    message.append(value);
+    sendFrame(0, UIH, true, message.constData(), message.size());
+}
+
+void QSerialPortMultiplexerPrivate::sendModemStatus(int dlci, bool flowStopped)
+{
+    char value[2];
+    value[0] = char(dlci << 2 | CR | EA);
+    value[1] = char(RTC | RTR | DV | EA | (flowStopped ? FC : 0));
+    sendControlMessage(MSC, true, QByteArray(value, sizeof(value)));
+}
+
+void QSerialPortMultiplexerPrivate::sendCommand(int dlci, quint8 frameControl)
+{
+    sendFrame(dlci, frameControl | PF, true);
+    links[dlci].deadline = QDeadlineTimer(timeout, Qt::PreciseTimer);
+    updateTimer();
+}
+
+// Sends SABM or DISC on \a dlci, and repeats it until the modem answers.
+void QSerialPortMultiplexerPrivate::startCommand(int dlci, LinkState state)
+{
+    Link &link = links[dlci];
+    link.state = state;
+    link.retries = 0;
+    sendCommand(dlci, state == Connecting ? SABM : DISC);
+}
+
+void QSerialPortMultiplexerPrivate::handleTimeout()
+{
+    for (int dlci = 0; dlci < DlciCount; ++dlci) {
+        Link &link = links[dlci];
+        if (link.deadline.isForever() || !link.deadline.hasExpired())
+            continue;
+
+        link.deadline = QDeadlineTimer::Forever;
+        if (link.state != Connecting && link.state != Disconnecting)
+            continue;
+
+        if (++link.retries <= maximumRetries) {
+            sendCommand(dlci, link.state == Connecting ? SABM : DISC);
+            continue;
+        }
+
+        // A connection that the modem does not confirm is dropped; one that
+        // it does not confirm to close is closed anyway.
+        if (link.state == Connecting)
+            pendingEvents.append({ Event::Error, dlci, QSerialPortMultiplexer::TimeoutError });
+        closeLink(dlci);
+    }
+    updateTimer();
+    emitPendingSignals();
+}
+
+void QSerialPortMultiplexerPrivate::updateTimer()
+{
+    QDeadlineTimer earliest = QDeadlineTimer::Forever;
+    for (const Link &link : links)
+        earliest = qMin(earliest, link.deadline);
+
+    if (earliest.isForever())
+        timer->stop();
+    else
+        timer->start(int(qMin(earliest.remainingTime(), qint64(std::numeric_limits<int>::max()))));
+}
+
+void QSerialPortMultiplexerPrivate::setConnected(int dlci)
+{
+    Link &link = links[dlci];
+    link.state = Connected;
+    link.deadline = QDeadlineTimer::Forever;
+    link.peerFlowStopped = false;
+    link.flowStopped = false;
+
+    if (dlci == 0) {
+        pendingEvents.append({ Event::Opened, 0 });
+        return;
+    }
+
+    // Tell the modem that we are ready to exchange data.
+    sendModemStatus(dlci, false);
+    pendingEvents.append({ Event::ChannelOpened, dlci });
+    scheduleFlush();
+}
+
+void QSerialPortMultiplexerPrivate::closeLink(int dlci)
+{
+    if (dlci == 0) {
+        closeAllLinks();
+        return;
+    }
+
+    Link &link = links[dlci];
+    const bool wasEstablished = link.state == Connected || link.state == Disconnecting;
+    link.state = Disconnected;
+    link.deadline = QDeadlineTimer::Forever;
+    link.peerFlowStopped = false;
+    link.flowStopped = false;
+
+    if (link.channel && link.channel->isOpen())
+        link.channel->QIODevice::close();
+    if (target && target == link.channel)
+        target = nullptr;
+    if (wasEstablished)
+        pendingEvents.append({ Event::ChannelClosed, dlci });
+}
+
+void QSerialPortMultiplexerPrivate::closeAllLinks()
+{
+    for (int dlci = 1; dlci < DlciCount; ++dlci) {
+        if (links[dlci].state != Disconnected)
+            closeLink(dlci);
+    }
+
+    Link &control = links[0];
+    const bool wasOpen = control.state == Connected || control.state == Disconnecting;
+    control.state = Disconnected;
+    control.deadline = QDeadlineTimer::Forever;
+    aggregateFlowStopped = false;
+    if (wasOpen)
+        pendingEvents.append({ Event::Closed, 0 });
+    updateTimer();
+}
+
+void QSerialPortMultiplexerPrivate::scheduleFlush()
+{
+    Q_Q(QSerialPortMultiplexer);
+
+    // Collect the writes of the current event loop iteration into as few
+    // frames as possible.
+    if (flushScheduled)
+        return;
+    flushScheduled = true;
+    QMetaObject::invokeMethod(q, [this]() {
+        flushChannels();
+    }, Qt::QueuedConnection);
+}
+
+void QSerialPortMultiplexerPrivate::flushChannels()
+{
+    flushScheduled = false;
+    if (aggregateFlowStopped)
+        return;
+    for (int dlci = 1; dlci < DlciCount; ++dlci)
+        flushChannel(dlci);
+}
+
+void QSerialPortMultiplexerPrivate::flushChannel(int dlci)
+{
+    const Link &link = links[dlci];
+    if (link.state != Connected || link.peerFlowStopped || !link.channel)
+        return;
+
+    QSerialPortMultiplexerChannelPrivate *channelPrivate =
+            QSerialPortMultiplexerChannel::get(link.channel);
+    QByteArray chunk;
+    qint64 written = 0;
+    while (!channelPrivate->writeBuffer.isEmpty()) {
+        const qint64 size = qMin(channelPrivate->writeBuffer.size(), qint64(maximumFrameSize));
+        chunk.resize(size);
+        channelPrivate->writeBuffer.read(chunk.data(), size);
+        sendFrame(dlci, UIH, true, chunk.constData(), size);
+        written += size;
+    }
+
+    if (written > 0)
+        emit link.channel->bytesWritten(written);
+}
+
+void QSerialPortMultiplexerPrivate::resumeFlow(int dlci)
+{
+    Link &link = links[dlci];
+    if (!link.flowStopped || link.state != Connected)
+        return;
+
+    const qint64 buffered = QSerialPortMultiplexerChannel::get(link.channel)->buffer.size();
+    if (channelReadBufferSize == 0 || buffered < channelReadBufferSize) {
+        link.flowStopped = false;
+        sendModemStatus(dlci, false);
+    }
+}
+
+/*!
+    Constructs a new multiplexer with the given \a parent, on \a port.
+
+    The port must be open and in multiplexer mode before open() is called.
+*/
+QSerialPortMultiplexer::QSerialPortMultiplexer(QSerialPort *port, QObject *parent)
+    : QObject(*new QSerialPortMultiplexerPrivate, parent)
+{
+    Q_D(QSerialPortMultiplexer);
+
+    d->port = port;
+
+    d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
+    d->timer->setTimerType(Qt::PreciseTimer);
+    connect(d->timer, &QTimer::timeout, this, [d]() {
+        d->handleTimeout();
+    });
+
+    if (port) {
+        connect(port, &QIODevice::readyRead, this, [d]() {
+            d->readFromPort();
+        });
+    }
+}
+
+/*!
+    Destroys the multiplexer and its channels, without closing the
+    connections.
+*/
+QSerialPortMultiplexer::~QSerialPortMultiplexer()
+{
+}
+
+/*!
+    Returns the port the multiplexer runs on.
+*/
+QSerialPort *QSerialPortMultiplexer::port() const
+{
+    Q_D(const QSerialPortMultiplexer);
+    return d->port;
+}
+
+/*!
+    Sets the maximum size of the information field of a frame (N1) to
+    \a size bytes. It must match the size configured in the modem.
+
+    The default size is 31 bytes, as defined for the basic option.
+*/
+void QSerialPortMultiplexer::setMaximumFrameSize(int size)
+{
+    Q_D(QSerialPortMultiplexer);
+    d->maximumFrameSize = qBound(1, size, int(MaximumBasicFrameSize));
+}
+
+/*!
+    Returns the maximum size of the information field of a frame.
+*/
+int QSerialPortMultiplexer::maximumFrameSize() const
+{
+    Q_D(const QSerialPortMultiplexer);
+    return d->maximumFrameSize;
+}
+
+/*!
+    Sets the time to wait for the answer to a command (T1) to \a msecs
+    milliseconds. The default is 100 milliseconds.
+*/
+void QSerialPortMultiplexer::setTimeout(int msecs)
+{
+    Q_D(QSerialPortMultiplexer);
+    d->timeout = qMax(msecs, 0);
+}
+
+/*!
+    Returns the time to wait for the answer to a command, in milliseconds.
+*/
+int QSerialPortMultiplexer::timeout() const
+{
+    Q_D(const QSerialPortMultiplexer);
+    return d->timeout;
+}
+
+/*!
+    Sets the number of times a command is repeated (N2) to \a retries. The
+    default is 3.
+*/
+void QSerialPortMultiplexer::setMaximumRetries(int retries)
+{
+    Q_D(QSerialPortMultiplexer);
+    d->maximumRetries = qMax(retries, 0);
+}
+
+/*!
+    Returns the number of times a command is repeated.
+*/
+int QSerialPortMultiplexer::maximumRetries() const
+{
+    Q_D(const QSerialPortMultiplexer);
+    return d->maximumRetries;
+}
+
+/*!
+    Sets the size of the read buffers of the channels to \a size bytes.
+    When the buffer of a channel is full, the modem is asked to stop
+    sending on it until the data was read.
+
+    The default size is 0, which means that the buffers are unlimited.
+*/
+void QSerialPortMultiplexer::setChannelReadBufferSize(qint64 size)
+{
+    Q_D(QSerialPortMultiplexer);
+    d->channelReadBufferSize = qMax(size, qint64(0));
+}
+
+/*!
+    Returns the size of the read buffers of the channels.
+*/
+qint64 QSerialPortMultiplexer::channelReadBufferSize() const
+{
+    Q_D(const QSerialPortMultiplexer);
+    return d->channelReadBufferSize;
+}
+
+/*!
+    Establishes the control channel (DLCI 0). The opened() signal is
+    emitted when the modem confirmed it.
+*/
+void QSerialPortMultiplexer::open()
+{
+    Q_D(QSerialPortMultiplexer);
+
+    if (d->links[0].state != QSerialPortMultiplexerPrivate::Disconnected)
+        return;
+    d->decoderState = QSerialPortMultiplexerPrivate::WaitingForFlag;
+    d->startCommand(0, QSerialPortMultiplexerPrivate::Connecting);
+}
+
+/*!
+    Closes all channels and leaves multiplexer mode. The closed() signal is
+    emitted when the modem confirmed it, or did not answer.
+*/
+void QSerialPortMultiplexer::close()
+{
+    Q_D(QSerialPortMultiplexer);
+
+    if (d->links[0].state == QSerialPortMultiplexerPrivate::Disconnected
+            || d->links[0].state == QSerialPortMultiplexerPrivate::Disconnecting) {
+        return;
+    }
+    d->startCommand(0, QSerialPortMultiplexerPrivate::Disconnecting);
+}
+
+/*!
+    Returns \c true if the control channel is established.
+*/
+bool QSerialPortMultiplexer::isOpen() const
+{
+    Q_D(const QSerialPortMultiplexer);
+    return d->links[0].state == QSerialPortMultiplexerPrivate::Connected;
+}
+
+/*!
+    Establishes the channel with the identifier \a dlci, from 1 to 63, and
+    returns its device. The device is open at once; data written to it is
+    kept until the modem confirmed the channel with the channelOpened()
+    signal.
+
+    Returns \c nullptr if the multiplexer is not open or \a dlci is out of
+    range. The device is owned by the multiplexer.
+*/
+QIODevice *QSerialPortMultiplexer::openChannel(int dlci)
+{
+    Q_D(QSerialPortMultiplexer);
+
+    if (dlci <= 0 || dlci >= QSerialPortMultiplexerPrivate::DlciCount || !isOpen())
+        return nullptr;
+
+    QSerialPortMultiplexerPrivate::Link &link = d->links[dlci];
+    if (!link.channel)
+        link.channel = new QSerialPortMultiplexerChannel(d, dlci, this);
+    if (!link.channel->isOpen())
+        link.channel->open(QIODevice::ReadWrite);
+    if (link.state == QSerialPortMultiplexerPrivate::Disconnected)
+        d->startCommand(dlci, QSerialPortMultiplexerPrivate::Connecting);
+    return link.channel;
+}
+
+/*!
+    Closes the channel with the identifier \a dlci. The channelClosed()
+    signal is emitted when the modem confirmed it.
+*/
+void QSerialPortMultiplexer::closeChannel(int dlci)
+{
+    Q_D(QSerialPortMultiplexer);
+
+    if (dlci <= 0 || dlci >= QSerialPortMultiplexerPrivate::DlciCount)
+        return;
+    if (QSerialPortMultiplexerChannel *channel = d->links[dlci].channel)
+        channel->close();
+}
+
+/*!
+    Returns the device of the channel with the identifier \a dlci, or
+    \c nullptr if it was never opened.
+*/
+QIODevice *QSerialPortMultiplexer::channel(int dlci) const
+{
+    Q_D(const QSerialPortMultiplexer);
+
+    if (dlci <= 0 || dlci >= QSerialPortMultiplexerPrivate::DlciCount)
+        return nullptr;
+    return d->links[dlci].channel;
+}
+
+/*!
+    Returns \c true if the channel with the identifier \a dlci is
+    established.
+*/
+bool QSerialPortMultiplexer::isChannelOpen(int dlci) const
+{
+    Q_D(const QSerialPortMultiplexer);
+
+    if (dlci <= 0 || dlci >= QSerialPortMultiplexerPrivate::DlciCount)
+        return false;
+    return d->links[dlci].state == QSerialPortMultiplexerPrivate::Connected;
+}
+
+/*!
+    \fn void QSerialPortMultiplexer::opened()
+
+    This signal is emitted when the modem confirmed the control channel.
+*/
+
+/*!
+    \fn void QSerialPortMultiplexer::closed()
+
+    This signal is emitted when the multiplexer was closed, by either side.
+*/
+
+/*!
+    \fn void QSerialPortMultiplexer::channelOpened(int dlci)
+
+    This signal is emitted when the modem confirmed the channel with the
+    identifier \a dlci.
+*/
+
+/*!
+    \fn void QSerialPortMultiplexer::channelClosed(int dlci)
+
+    This signal is emitted when the channel with the identifier \a dlci was
+    closed, by either side.
+*/
+
+/*!
+    \fn void QSerialPortMultiplexer::errorOccurred(QSerialPortMultiplexer::Error error, int dlci)
+
+    This signal is emitted when establishing the channel with the
+    identifier \a dlci failed with \a error. A \a dlci of 0 refers to the
+    control channel.
+*/
+
+QT_END_NAMESPACE
+
+#include "moc_qserialportmultiplexer.cpp"
@@ -0,0 +1,69 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTMULTIPLEXER_H
+#define QSERIALPORTMULTIPLEXER_H
+
+#include <QtCore/qobject.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QIODevice;
+class QSerialPort;
+class QSerialPortMultiplexerPrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortMultiplexer : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortMultiplexer)
+
+public:
+    enum Error {
+        NoError,
+        TimeoutError,
+        RejectedError
+    };
+    Q_ENUM(Error)
+
+    explicit QSerialPortMultiplexer(QSerialPort *port, QObject *parent = nullptr);
+    ~QSerialPortMultiplexer();
+
+    QSerialPort *port() const;
+
+    void setMaximumFrameSize(int size);
+    int maximumFrameSize() const;
+
+    void setTimeout(int msecs);
+    int timeout() const;
+
+    void setMaximumRetries(int retries);
+    int maximumRetries() const;
+
+    void setChannelReadBufferSize(qint64 size);
+    qint64 channelReadBufferSize() const;
+
+    void open();
+    void close();
+    bool isOpen() const;
+
+    QIODevice *openChannel(int dlci);
+    void closeChannel(int dlci);
+    QIODevice *channel(int dlci) const;
+    bool isChannelOpen(int dlci) const;
+
+Q_SIGNALS:
+    void opened();
+    void closed();
+    void channelOpened(int dlci);
+    void channelClosed(int dlci);
+    void errorOccurred(QSerialPortMultiplexer::Error error, int dlci);
+
+private:
+    Q_DISABLE_COPY(QSerialPortMultiplexer)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTMULTIPLEXER_H
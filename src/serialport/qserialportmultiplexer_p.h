@@ -0,0 +1,171 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTMULTIPLEXER_P_H
+#define QSERIALPORTMULTIPLEXER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportmultiplexer.h"
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qiodevice.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qpointer.h>
+
+#include <private/qiodevice_p.h>
+#include <private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+class QSerialPortMultiplexerPrivate;
+
+class QSerialPortMultiplexerChannelPrivate : public QIODevicePrivate
+{
+public:
+    QSerialPortMultiplexerChannelPrivate();
+
+    QSerialPortMultiplexerPrivate *multiplexer = nullptr;
+    int dlci = 0;
+};
+
+class QSerialPortMultiplexerChannel : public QIODevice
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortMultiplexerChannel)
+
+public:
+    QSerialPortMultiplexerChannel(QSerialPortMultiplexerPrivate *multiplexer, int dlci,
+                                  QObject *parent);
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    void close() override;
+
+    static QSerialPortMultiplexerChannelPrivate *get(QSerialPortMultiplexerChannel *channel)
+    { return channel->d_func(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    Q_DISABLE_COPY(QSerialPortMultiplexerChannel)
+};
+
+class QSerialPortMultiplexerPrivate : public QObjectPrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortMultiplexer)
+
+    enum { DlciCount = 64 };
+
+    enum LinkState {
+        Disconnected,
+        Connecting,
+        Connected,
+        Disconnecting
+    };
+
+    enum DecoderState {
+        WaitingForFlag,
+        ReadingAddress,
+        ReadingControl,
+        ReadingLength,
+        ReadingExtendedLength,
+        ReadingInformation,
+        ReadingFcs,
+        ReadingClosingFlag
+    };
+
+    struct Link
+    {
+        LinkState state = Disconnected;
+        QSerialPortMultiplexerChannel *channel = nullptr;
+        int retries = 0;
+        QDeadlineTimer deadline = QDeadlineTimer::Forever;
+        // The peer asked us to stop sending.
+        bool peerFlowStopped = false;
+        // We asked the peer to stop sending.
+        bool flowStopped = false;
+    };
+
+    struct Event
+    {
+        enum Type {
+            Opened,
+            Closed,
+            ChannelOpened,
+            ChannelClosed,
+            Error
+        };
+
+        Type type;
+        int dlci;
+        QSerialPortMultiplexer::Error error = QSerialPortMultiplexer::NoError;
+    };
+
+    void readFromPort();
+    void decode(const char *data, qsizetype size);
+    void startInformation();
+    void discardFrame();
+    void handleFrame();
+    void handleControlMessages(const char *data, qsizetype size);
+    void emitPendingSignals();
+
+    void sendFrame(int dlci, quint8 control, bool command,
+                   const char *data = nullptr, qsizetype size = 0);
+    void sendControlMessage(quint8 type, bool command, const QByteArray &value);
+    void sendModemStatus(int dlci, bool flowStopped);
+    void sendCommand(int dlci, quint8 control);
+    void startCommand(int dlci, LinkState state);
+    void handleTimeout();
+    void updateTimer();
+    void setConnected(int dlci);
+    void closeLink(int dlci);
+    void closeAllLinks();
+
+    void scheduleFlush();
+    void flushChannels();
+    void flushChannel(int dlci);
+    void resumeFlow(int dlci);
+
+    QPointer<QSerialPort> port;
+    QTimer *timer = nullptr;
+    Link links[DlciCount];
+    QList<Event> pendingEvents;
+    quint64 pendingReadyRead = 0;
+    bool flushScheduled = false;
+    bool aggregateFlowStopped = false;
+
+    int maximumFrameSize = 31;
+    int timeout = 100;
+    int maximumRetries = 3;
+    qint64 channelReadBufferSize = 0;
+
+    DecoderState decoderState = WaitingForFlag;
+    quint8 address = 0;
+    quint8 control = 0;
+    quint8 fcs = 0;
+    qsizetype length = 0;
+    qsizetype received = 0;
+    QSerialPortMultiplexerChannel *target = nullptr;
+    // The information field of the frame being received, for the control
+    // channel and for established channels.
+    QByteArray information;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTMULTIPLEXER_P_H
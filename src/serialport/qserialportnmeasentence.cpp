@@ -0,0 +1,148 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportnmeasentence.h"
+#include "qserialportchecksum.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QSerialPortNmeaSentence
+    \since 6.6
+
+    \brief Gives access to the fields of an NMEA 0183 sentence without
+    copying them.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    GNSS receivers and other NMEA 0183 devices report their data as
+    sentences of comma separated fields, such as:
+
+    \code
+    $GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
+    \endcode
+
+    QSerialPortNmeaSentence parses such a sentence in place: the address
+    and the fields are returned as views into the data it was constructed
+    from, which must therefore outlive it. Together with the Nmea protocol
+    of QSerialPortFramer and a frame handler, sentences can be decoded
+    without any memory allocation:
+
+    \code
+    framer->setProtocol(QSerialPortFramer::Nmea);
+    framer->setFrameHandler([](QByteArrayView frame) {
+        const QSerialPortNmeaSentence sentence(frame);
+        if (sentence.type() == "GGA")
+            updatePosition(sentence.field(1), sentence.field(3));
+    });
+    \endcode
+
+    \sa QSerialPortFramer
+*/
+
+/*!
+    \fn QSerialPortNmeaSentence::QSerialPortNmeaSentence()
+
+    Constructs an invalid sentence.
+*/
+
+/*!
+    Constructs a sentence that refers to \a sentence.
+
+    The sentence must start with \c{$} or \c{!}. A trailing line terminator
+    is ignored. If the sentence ends with a checksum, the sentence is only
+    valid if the checksum matches.
+*/
+QSerialPortNmeaSentence::QSerialPortNmeaSentence(QByteArrayView sentence)
+{
+    while (sentence.endsWith('\n') || sentence.endsWith('\r'))
+        sentence.chop(1);
+    if (!sentence.startsWith('$') && !sentence.startsWith('!'))
+        return;
+    sentence = sentence.sliced(1);
+
+    const qsizetype size = sentence.size();
+    if (size >= 3 && sentence.at(size - 3) == '*') {
+        bool ok = false;
+        const uint expected = sentence.last(2).toUInt(&ok, 16);
+        sentence.chop(3);
+        if (!ok || QSerialPortChecksum::checksum(sentence, QSerialPortChecksum::Xor) != expected)
+            return;
+    }
+
+    const qsizetype comma = sentence.indexOf(',');
+    if (comma < 0) {
+        m_address = sentence;
+        return;
+    }
+    m_address = sentence.first(comma);
+    m_fields = sentence.sliced(comma + 1);
+    m_fieldCount = m_fields.count(',') + 1;
+}
+
+/*!
+    \fn bool QSerialPortNmeaSentence::isValid() const
+
+    Returns \c true if the sentence has an address and a matching
+    checksum, if any; otherwise returns \c false.
+*/
+
+/*!
+    Returns \c true if the sentence is a proprietary one, whose address
+    starts with \c{P}; otherwise returns \c false.
+*/
+bool QSerialPortNmeaSentence::isProprietary() const
+{
+    return m_address.startsWith('P');
+}
+
+/*!
+    \fn QByteArrayView QSerialPortNmeaSentence::address() const
+
+    Returns the address of the sentence, such as \c{GPGGA}.
+*/
+
+/*!
+    Returns the talker identifier of the sentence, such as \c{GP}. The
+    talker of a proprietary sentence is \c{P}.
+*/
+QByteArrayView QSerialPortNmeaSentence::talker() const
+{
+    return m_address.first(qMin(m_address.size(), qsizetype(isProprietary() ? 1 : 2)));
+}
+
+/*!
+    Returns the sentence formatter of the sentence, such as \c{GGA}, or
+    the manufacturer code and the sentence type of a proprietary sentence.
+*/
+QByteArrayView QSerialPortNmeaSentence::type() const
+{
+    return m_address.sliced(talker().size());
+}
+
+/*!
+    \fn qsizetype QSerialPortNmeaSentence::fieldCount() const
+
+    Returns the number of data fields of the sentence, after its address.
+*/
+
+/*!
+    Returns the data field at position \a index, starting from 0 for the
+    field after the address. Returns an empty view if \a index is out of
+    range.
+*/
+QByteArrayView QSerialPortNmeaSentence::field(qsizetype index) const
+{
+    if (index < 0 || index >= m_fieldCount)
+        return QByteArrayView();
+
+    QByteArrayView rest = m_fields;
+    for (; index > 0; --index)
+        rest = rest.sliced(rest.indexOf(',') + 1);
+
+    const qsizetype comma = rest.indexOf(',');
+    return comma < 0 ? rest : rest.first(comma);
+}
+
+QT_END_NAMESPACE
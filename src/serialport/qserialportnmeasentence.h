@@ -0,0 +1,37 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTNMEASENTENCE_H
+#define QSERIALPORTNMEASENTENCE_H
+
+#include <QtCore/qbytearrayview.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class Q_SERIALPORT_EXPORT QSerialPortNmeaSentence
+{
+public:
+    QSerialPortNmeaSentence() = default;
+    explicit QSerialPortNmeaSentence(QByteArrayView sentence);
+
+    bool isValid() const { return !m_address.isEmpty(); }
+    bool isProprietary() const;
+
+    QByteArrayView address() const { return m_address; }
+    QByteArrayView talker() const;
+    QByteArrayView type() const;
+
+    qsizetype fieldCount() const { return m_fieldCount; }
+    QByteArrayView field(qsizetype index) const;
+
+private:
+    QByteArrayView m_address;
+    QByteArrayView m_fields;
+    qsizetype m_fieldCount = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTNMEASENTENCE_H
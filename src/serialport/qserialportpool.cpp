@@ -0,0 +1,556 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportpool.h"
+#include "qserialportpool_p.h"
+#include "qserialport_p.h"
+#include "qserialportinfo_p.h"
+#include "qserialporttrafficcapture_p.h"
+
+#include <QtCore/qtimer.h>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QSerialPortPool
+    \since 6.6
+
+    \brief Shares opened serial ports between several users by handing out
+    exclusive leases.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    A QSerialPortPool owns a set of opened QSerialPort objects. Instead of
+    opening a port, a user requests a lease for it with requestLease(). The
+    pool opens the port on first use and grants the lease by emitting the
+    leaseGranted() signal, once no other lease is active on the port. When
+    the user is done, the lease is returned with release() and the port is
+    handed to the next waiting request, without being closed.
+
+    The pending requests for a port are served in the order of their
+    priority, and in the order of their arrival within the same priority.
+    A request that is not granted within its timeout is dropped and
+    reported with the leaseTimedOut() signal.
+
+    Each request carries the PortSettings to be used during the lease. All
+    settings that differ from the current ones are applied to the device in
+    a single update when the lease is granted.
+
+    \note The pool disconnects all the connections to the signals of a port
+    when its lease is released, and clears the input buffers of the port.
+    A user that closes a leased port makes the pool release the device
+    when the lease ends.
+
+    The objects that attach to a port, such as QSerialPortFramer,
+    QSerialPortTransactionQueue, QSerialPortModbusClient and
+    QSerialPortMultiplexer, lose their connections to the port with the
+    lease, and must be created again for each lease. A QSerialPortTrafficCapture
+    of the port is stopped when the lease is released.
+
+    \sa QSerialPort
+*/
+
+/*!
+    \class QSerialPortPool::PortSettings
+    \inmodule QtSerialPort
+    \since 6.6
+
+    \brief The settings applied to a serial port for the duration of a lease.
+
+    \sa QSerialPortPool::requestLease()
+*/
+
+/*!
+    \variable QSerialPortPool::PortSettings::baudRate
+    \brief the baud rate in both directions
+*/
+
+/*!
+    \variable QSerialPortPool::PortSettings::dataBits
+    \brief the data bits in a frame
+*/
+
+/*!
+    \variable QSerialPortPool::PortSettings::parity
+    \brief the parity checking mode
+*/
+
+/*!
+    \variable QSerialPortPool::PortSettings::stopBits
+    \brief the number of stop bits in a frame
+*/
+
+/*!
+    \variable QSerialPortPool::PortSettings::flowControl
+    \brief the flow control mode
+*/
+
+QSerialPort *QSerialPortPoolPrivate::grant(const QString &systemLocation, Entry &entry,
+                                           const Request &request)
+{
+    Q_Q(QSerialPortPool);
+
+    const QSerialPortPool::PortSettings &settings = request.settings;
+
+    if (!entry.port) {
+        auto port = new QSerialPort(systemLocation, q);
+        port->setLockingPolicy(lockingPolicy);
+        QSerialPortPrivate::get(port)->updateSettings(settings.baudRate, settings.dataBits,
+                                                      settings.parity, settings.stopBits,
+                                                      settings.flowControl);
+        if (!port->open(openMode)) {
+            port->deleteLater();
+            return port;
+        }
+
+        QObject::connect(port, &QSerialPort::errorOccurred, q,
+                         [this, port](QSerialPort::SerialPortError error) {
+            handlePortError(port, error);
+        });
+        entry.port = port;
+    } else if (!QSerialPortPrivate::get(entry.port)->updateSettings(
+                   settings.baudRate, settings.dataBits, settings.parity,
+                   settings.stopBits, settings.flowControl)) {
+        return entry.port;
+    }
+
+    entry.leaseId = request.leaseId;
+    return entry.port;
+}
+
+void QSerialPortPoolPrivate::scheduleDispatch(const QString &systemLocation)
+{
+    Q_Q(QSerialPortPool);
+
+    // Granting from the event loop keeps the signal emissions out of the
+    // callers of requestLease() and release().
+    QMetaObject::invokeMethod(q, [this, systemLocation]() {
+        dispatch(systemLocation);
+    }, Qt::QueuedConnection);
+}
+
+void QSerialPortPoolPrivate::dispatch(const QString &systemLocation)
+{
+    Q_Q(QSerialPortPool);
+
+    for (;;) {
+        auto it = entries.find(systemLocation);
+        if (it == entries.end() || it->leaseId != 0 || it->pendingRequests.isEmpty())
+            return;
+
+        const Request request = it->pendingRequests.takeFirst();
+        // The expiry timer may not have run yet.
+        if (request.deadline.hasExpired()) {
+            leases.remove(request.leaseId);
+            updateExpiryTimer();
+            emit q->leaseTimedOut(request.leaseId);
+            continue;
+        }
+
+        QSerialPort *port = grant(systemLocation, *it, request);
+        updateExpiryTimer();
+
+        // Note that the slots may modify the entries.
+        if (it->leaseId == request.leaseId) {
+            emit q->leaseGranted(request.leaseId, port);
+            return;
+        }
+
+        leases.remove(request.leaseId);
+        emit q->leaseFailed(request.leaseId, port->error());
+    }
+}
+
+void QSerialPortPoolPrivate::expireRequests()
+{
+    Q_Q(QSerialPortPool);
+
+    QList<quint64> expiredLeaseIds;
+    for (Entry &entry : entries) {
+        entry.pendingRequests.removeIf([&expiredLeaseIds](const Request &request) {
+            if (!request.deadline.hasExpired())
+                return false;
+            expiredLeaseIds.append(request.leaseId);
+            return true;
+        });
+    }
+
+    for (quint64 leaseId : std::as_const(expiredLeaseIds))
+        leases.remove(leaseId);
+
+    updateExpiryTimer();
+
+    for (quint64 leaseId : std::as_const(expiredLeaseIds))
+        emit q->leaseTimedOut(leaseId);
+}
+
+void QSerialPortPoolPrivate::updateExpiryTimer()
+{
+    QDeadlineTimer nextDeadline(QDeadlineTimer::Forever);
+    for (const Entry &entry : std::as_const(entries)) {
+        for (const Request &request : entry.pendingRequests) {
+            if (request.deadline < nextDeadline)
+                nextDeadline = request.deadline;
+        }
+    }
+
+    if (nextDeadline.isForever())
+        expiryTimer->stop();
+    else
+        expiryTimer->start(std::chrono::milliseconds(qMax(qint64(0), nextDeadline.remainingTime())));
+}
+
+void QSerialPortPoolPrivate::resetPort(QSerialPort *port)
+{
+    Q_Q(QSerialPortPool);
+
+    // The capture would stay active, but miss the settings and the errors.
+    if (QSerialPortTrafficCapturePrivate *capture = QSerialPortPrivate::get(port)->capture)
+        static_cast<QSerialPortTrafficCapture *>(capture->q_ptr)->stop();
+    QObject::disconnect(port, nullptr, nullptr, nullptr);
+
+    if (!port->isOpen() || port->error() == QSerialPort::ResourceError) {
+        for (Entry &entry : entries) {
+            if (entry.port == port)
+                entry.port = nullptr;
+        }
+        port->deleteLater();
+        return;
+    }
+
+    QObject::connect(port, &QSerialPort::errorOccurred, q,
+                     [this, port](QSerialPort::SerialPortError error) {
+        handlePortError(port, error);
+    });
+
+    if (port->isBreakEnabled())
+        port->setBreakEnabled(false);
+    port->setReadBufferSize(0);
+    if (port->isReadable())
+        port->clear(QSerialPort::Input);
+    port->clearError();
+}
+
+void QSerialPortPoolPrivate::handlePortError(QSerialPort *port, QSerialPort::SerialPortError error)
+{
+    if (error != QSerialPort::ResourceError)
+        return;
+
+    // A leased port is dropped when its lease ends.
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->port == port && it->leaseId == 0) {
+            QObject::disconnect(port, nullptr, nullptr, nullptr);
+            port->deleteLater();
+            it->port = nullptr;
+            return;
+        }
+    }
+}
+
+/*!
+    Constructs a new serial port pool with the given \a parent.
+*/
+QSerialPortPool::QSerialPortPool(QObject *parent)
+    : QObject(*new QSerialPortPoolPrivate, parent)
+{
+    Q_D(QSerialPortPool);
+    d->expiryTimer = new QTimer(this);
+    d->expiryTimer->setSingleShot(true);
+    d->expiryTimer->setTimerType(Qt::PreciseTimer);
+    connect(d->expiryTimer, &QTimer::timeout, this, [d]() {
+        d->expireRequests();
+    });
+}
+
+/*!
+    Closes all the ports of the pool and destroys the pool.
+*/
+QSerialPortPool::~QSerialPortPool()
+{
+}
+
+/*!
+    Sets the \a mode in which the pool opens new ports.
+
+    The default mode is QIODeviceBase::ReadWrite. The ports that are already
+    open are not affected.
+*/
+void QSerialPortPool::setOpenMode(QIODevice::OpenMode mode)
+{
+    Q_D(QSerialPortPool);
+    d->openMode = mode;
+}
+
+/*!
+    Returns the mode in which the pool opens new ports.
+*/
+QIODevice::OpenMode QSerialPortPool::openMode() const
+{
+    Q_D(const QSerialPortPool);
+    return d->openMode;
+}
+
+/*!
+    Sets the locking \a policy with which the pool opens new ports.
+
+    \sa QSerialPort::setLockingPolicy()
+*/
+void QSerialPortPool::setLockingPolicy(QSerialPort::LockingPolicy policy)
+{
+    Q_D(QSerialPortPool);
+    d->lockingPolicy = policy;
+}
+
+/*!
+    Returns the locking policy with which the pool opens new ports.
+*/
+QSerialPort::LockingPolicy QSerialPortPool::lockingPolicy() const
+{
+    Q_D(const QSerialPortPool);
+    return d->lockingPolicy;
+}
+
+/*!
+    Requests a lease for the serial port with the name \a portName, and
+    returns the identifier of the lease.
+
+    The lease is granted asynchronously with the leaseGranted() signal,
+    once the port is not leased by anyone else and all the pending requests
+    with a higher or equal \a priority are served. The port is opened if
+    necessary, and configured with \a settings.
+
+    If the lease could not be granted within \a msecs milliseconds, the
+    request is dropped and the leaseTimedOut() signal is emitted. If \a msecs
+    is -1, the request does not time out. If the port cannot be opened or
+    configured, the leaseFailed() signal is emitted.
+
+    \sa tryAcquire(), release(), cancelRequest()
+*/
+quint64 QSerialPortPool::requestLease(const QString &portName, const PortSettings &settings,
+                                      int priority, int msecs)
+{
+    Q_D(QSerialPortPool);
+
+    const QString systemLocation = QSerialPortInfoPrivate::portNameToSystemLocation(portName);
+
+    QSerialPortPoolPrivate::Request request;
+    request.leaseId = d->nextLeaseId++;
+    request.settings = settings;
+    request.priority = priority;
+    request.deadline = msecs < 0
+            ? QDeadlineTimer(QDeadlineTimer::Forever)
+            : QDeadlineTimer(msecs, Qt::PreciseTimer);
+
+    QList<QSerialPortPoolPrivate::Request> &pendingRequests = d->entries[systemLocation].pendingRequests;
+    const auto position = std::find_if(pendingRequests.cbegin(), pendingRequests.cend(),
+                                       [priority](const QSerialPortPoolPrivate::Request &other) {
+        return other.priority < priority;
+    });
+    pendingRequests.insert(position, request);
+    d->leases.insert(request.leaseId, systemLocation);
+
+    d->updateExpiryTimer();
+    d->scheduleDispatch(systemLocation);
+    return request.leaseId;
+}
+
+/*!
+    Grants a lease for the serial port with the name \a portName immediately,
+    if the port is neither leased nor requested by anyone else.
+
+    On success, returns the port configured with \a settings, and stores the
+    identifier of the lease in \a leaseId. Otherwise, returns \c nullptr.
+
+    \sa requestLease(), release()
+*/
+QSerialPort *QSerialPortPool::tryAcquire(const QString &portName, quint64 *leaseId,
+                                         const PortSettings &settings)
+{
+    Q_D(QSerialPortPool);
+
+    const QString systemLocation = QSerialPortInfoPrivate::portNameToSystemLocation(portName);
+
+    const auto existing = d->entries.constFind(systemLocation);
+    if (existing != d->entries.cend()
+            && (existing->leaseId != 0 || !existing->pendingRequests.isEmpty())) {
+        return nullptr;
+    }
+
+    QSerialPortPoolPrivate::Entry &entry = d->entries[systemLocation];
+
+    QSerialPortPoolPrivate::Request request;
+    request.leaseId = d->nextLeaseId++;
+    request.settings = settings;
+
+    QSerialPort *port = d->grant(systemLocation, entry, request);
+    if (entry.leaseId != request.leaseId) {
+        if (!entry.port)
+            d->entries.remove(systemLocation);
+        return nullptr;
+    }
+
+    d->leases.insert(request.leaseId, systemLocation);
+    if (leaseId)
+        *leaseId = request.leaseId;
+    return port;
+}
+
+/*!
+    Cancels the pending request with the identifier \a leaseId. A lease that
+    has already been granted is released.
+
+    \sa requestLease(), release()
+*/
+void QSerialPortPool::cancelRequest(quint64 leaseId)
+{
+    release(leaseId);
+}
+
+/*!
+    Releases the lease with the identifier \a leaseId and returns the port
+    to the pool, where it stays open for the next lease.
+
+    If the lease has not yet been granted, the request is cancelled.
+
+    \sa requestLease(), tryAcquire()
+*/
+void QSerialPortPool::release(quint64 leaseId)
+{
+    Q_D(QSerialPortPool);
+
+    const auto lease = d->leases.constFind(leaseId);
+    if (lease == d->leases.cend())
+        return;
+
+    const QString systemLocation = *lease;
+    d->leases.erase(lease);
+
+    auto it = d->entries.find(systemLocation);
+    if (it == d->entries.end())
+        return;
+
+    if (it->leaseId != leaseId) {
+        it->pendingRequests.removeIf([leaseId](const QSerialPortPoolPrivate::Request &request) {
+            return request.leaseId == leaseId;
+        });
+        d->updateExpiryTimer();
+        return;
+    }
+
+    it->leaseId = 0;
+    if (it->port)
+        d->resetPort(it->port);
+    d->scheduleDispatch(systemLocation);
+}
+
+/*!
+    Returns the port leased with the identifier \a leaseId, or \c nullptr if
+    the lease is not active.
+*/
+QSerialPort *QSerialPortPool::leasedPort(quint64 leaseId) const
+{
+    Q_D(const QSerialPortPool);
+
+    const auto lease = d->leases.constFind(leaseId);
+    if (lease == d->leases.cend())
+        return nullptr;
+
+    const auto it = d->entries.constFind(*lease);
+    if (it == d->entries.cend() || it->leaseId != leaseId)
+        return nullptr;
+    return it->port;
+}
+
+/*!
+    Returns \c true if the serial port with the name \a portName is leased;
+    otherwise returns \c false.
+*/
+bool QSerialPortPool::isLeased(const QString &portName) const
+{
+    Q_D(const QSerialPortPool);
+    const auto it = d->entries.constFind(QSerialPortInfoPrivate::portNameToSystemLocation(portName));
+    return it != d->entries.cend() && it->leaseId != 0;
+}
+
+/*!
+    Returns the number of requests waiting for a lease of the serial port
+    with the name \a portName.
+*/
+int QSerialPortPool::pendingRequestCount(const QString &portName) const
+{
+    Q_D(const QSerialPortPool);
+    const auto it = d->entries.constFind(QSerialPortInfoPrivate::portNameToSystemLocation(portName));
+    return it == d->entries.cend() ? 0 : int(it->pendingRequests.size());
+}
+
+/*!
+    Returns the names of the ports that are currently open in the pool.
+*/
+QStringList QSerialPortPool::portNames() const
+{
+    Q_D(const QSerialPortPool);
+
+    QStringList names;
+    for (auto it = d->entries.cbegin(); it != d->entries.cend(); ++it) {
+        if (it->port)
+            names.append(QSerialPortInfoPrivate::portNameFromSystemLocation(it.key()));
+    }
+    return names;
+}
+
+/*!
+    Closes all the ports of the pool that are neither leased nor requested.
+*/
+void QSerialPortPool::closeIdlePorts()
+{
+    Q_D(QSerialPortPool);
+
+    for (auto it = d->entries.begin(); it != d->entries.end();) {
+        if (it->leaseId != 0 || !it->pendingRequests.isEmpty()) {
+            ++it;
+            continue;
+        }
+        if (it->port) {
+            QObject::disconnect(it->port, nullptr, nullptr, nullptr);
+            it->port->close();
+            it->port->deleteLater();
+        }
+        it = d->entries.erase(it);
+    }
+}
+
+/*!
+    \fn void QSerialPortPool::leaseGranted(quint64 leaseId, QSerialPort *port)
+
+    This signal is emitted when the lease with the identifier \a leaseId is
+    granted. The \a port is owned by the pool and may be used until the lease
+    is released.
+
+    \sa requestLease(), release()
+*/
+
+/*!
+    \fn void QSerialPortPool::leaseTimedOut(quint64 leaseId)
+
+    This signal is emitted when the request with the identifier \a leaseId
+    was not granted within its timeout.
+
+    \sa requestLease()
+*/
+
+/*!
+    \fn void QSerialPortPool::leaseFailed(quint64 leaseId, QSerialPort::SerialPortError error)
+
+    This signal is emitted when the request with the identifier \a leaseId
+    cannot be granted, because the port failed to open or to apply the
+    requested settings with the given \a error.
+
+    \sa requestLease()
+*/
+
+QT_END_NAMESPACE
+
+#include "moc_qserialportpool.cpp"
@@ -0,0 +1,64 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTPOOL_H
+#define QSERIALPORTPOOL_H
+
+#include <QtCore/qobject.h>
+
+#include <QtSerialPort/qserialport.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPortPoolPrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortPool : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortPool)
+
+public:
+    struct PortSettings
+    {
+        qint32 baudRate = QSerialPort::Baud9600;
+        QSerialPort::DataBits dataBits = QSerialPort::Data8;
+        QSerialPort::Parity parity = QSerialPort::NoParity;
+        QSerialPort::StopBits stopBits = QSerialPort::OneStop;
+        QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
+    };
+
+    explicit QSerialPortPool(QObject *parent = nullptr);
+    ~QSerialPortPool();
+
+    void setOpenMode(QIODevice::OpenMode mode);
+    QIODevice::OpenMode openMode() const;
+
+    void setLockingPolicy(QSerialPort::LockingPolicy policy);
+    QSerialPort::LockingPolicy lockingPolicy() const;
+
+    quint64 requestLease(const QString &portName, const PortSettings &settings = PortSettings(),
+                         int priority = 0, int msecs = -1);
+    QSerialPort *tryAcquire(const QString &portName, quint64 *leaseId,
+                            const PortSettings &settings = PortSettings());
+    void cancelRequest(quint64 leaseId);
+    void release(quint64 leaseId);
+
+    QSerialPort *leasedPort(quint64 leaseId) const;
+    bool isLeased(const QString &portName) const;
+    int pendingRequestCount(const QString &portName) const;
+
+    QStringList portNames() const;
+    void closeIdlePorts();
+
+Q_SIGNALS:
+    void leaseGranted(quint64 leaseId, QSerialPort *port);
+    void leaseTimedOut(quint64 leaseId);
+    void leaseFailed(quint64 leaseId, QSerialPort::SerialPortError error);
+
+private:
+    Q_DISABLE_COPY(QSerialPortPool)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTPOOL_H
@@ -0,0 +1,68 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTPOOL_P_H
+#define QSERIALPORTPOOL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportpool.h"
+
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+
+#include <private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+class QSerialPortPoolPrivate : public QObjectPrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortPool)
+
+    struct Request
+    {
+        quint64 leaseId = 0;
+        QSerialPortPool::PortSettings settings;
+        int priority = 0;
+        QDeadlineTimer deadline;
+    };
+
+    struct Entry
+    {
+        QSerialPort *port = nullptr;
+        quint64 leaseId = 0;
+        QList<Request> pendingRequests;
+    };
+
+    QSerialPort *grant(const QString &systemLocation, Entry &entry, const Request &request);
+    void scheduleDispatch(const QString &systemLocation);
+    void dispatch(const QString &systemLocation);
+    void expireRequests();
+    void updateExpiryTimer();
+    void resetPort(QSerialPort *port);
+    void handlePortError(QSerialPort *port, QSerialPort::SerialPortError error);
+
+    QHash<QString, Entry> entries;
+    QHash<quint64, QString> leases;
+    quint64 nextLeaseId = 1;
+    QTimer *expiryTimer = nullptr;
+    QIODevice::OpenMode openMode = QIODevice::ReadWrite;
+    QSerialPort::LockingPolicy lockingPolicy = QSerialPort::LockFileLocking;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTPOOL_P_H
@@ -0,0 +1,678 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialportreplay.h"
+#include "qserialportreplay_p.h"
+#include "qserialporttrafficcapture.h"
+#include "qserialporttrafficcapture_p.h"
+
+#include <QtCore/qendian.h>
+#include <QtCore/qtimer.h>
+
+#include <chrono>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum {
+    // When replaying as fast as possible, the delivery pauses once this
+    // much is unread, and resumes when the application has read it.
+    BatchSize = 64 * 1024
+};
+
+} // namespace
+
+/*!
+    \class QSerialPortReplay
+    \since 6.6
+
+    \brief Plays back a capture file through the API of a serial port.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    QSerialPortReplay reads a capture file written by
+    QSerialPortTrafficCapture, and delivers the received bytes as a
+    sequential QIODevice, with the readyRead() signal, and the signals of
+    QSerialPort for the changes of the settings, of the DTR and RTS lines,
+    of the break state and for the errors, in the order in which they were
+    recorded. This allows to reproduce a problem seen in the field, or to
+    test a protocol parser against real traffic, without the hardware.
+
+    \code
+    auto replay = new QSerialPortReplay(QStringLiteral("modem.qspcap"), this);
+    connect(replay, &QIODevice::readyRead, parser, [replay, parser]() {
+        parser->feed(replay->readAll());
+    });
+    replay->open(QIODevice::ReadOnly);
+    \endcode
+
+    By default, the records are delivered with their original timing,
+    relative to the first record of the file. setSpeed() scales the timing,
+    or with a speed of 0, replays the file as fast as possible, which suits
+    benchmarks of parsers.
+
+    The file is mapped into memory, and the received bytes are read
+    directly from the mapping. The transmitted bytes of the capture are not
+    played back, and everything written to the replay is discarded, so that
+    code written for QSerialPort can drive the replay unchanged.
+
+    \sa QSerialPortTrafficCapture
+*/
+
+/*!
+    \fn void QSerialPortReplay::baudRateChanged(qint32 baudRate, QSerialPort::Directions directions)
+
+    This signal is emitted when a replayed record changes the baud rate in
+    the given \a directions to \a baudRate.
+*/
+
+/*!
+    \fn void QSerialPortReplay::dataBitsChanged(QSerialPort::DataBits dataBits)
+
+    This signal is emitted when a replayed record changes the data bits to
+    \a dataBits.
+*/
+
+/*!
+    \fn void QSerialPortReplay::parityChanged(QSerialPort::Parity parity)
+
+    This signal is emitted when a replayed record changes the parity to
+    \a parity.
+*/
+
+/*!
+    \fn void QSerialPortReplay::stopBitsChanged(QSerialPort::StopBits stopBits)
+
+    This signal is emitted when a replayed record changes the stop bits to
+    \a stopBits.
+*/
+
+/*!
+    \fn void QSerialPortReplay::flowControlChanged(QSerialPort::FlowControl flowControl)
+
+    This signal is emitted when a replayed record changes the flow control
+    to \a flowControl.
+*/
+
+/*!
+    \fn void QSerialPortReplay::dataTerminalReadyChanged(bool set)
+
+    This signal is emitted when a replayed record changes the DTR line to
+    \a set.
+*/
+
+/*!
+    \fn void QSerialPortReplay::requestToSendChanged(bool set)
+
+    This signal is emitted when a replayed record changes the RTS line to
+    \a set.
+*/
+
+/*!
+    \fn void QSerialPortReplay::breakEnabledChanged(bool set)
+
+    This signal is emitted when a replayed record changes the break state
+    to \a set.
+*/
+
+/*!
+    \fn void QSerialPortReplay::errorOccurred(QSerialPort::SerialPortError error)
+
+    This signal is emitted when a replayed record reports the \a error.
+*/
+
+/*!
+    \fn void QSerialPortReplay::finished()
+
+    This signal is emitted when the last record of the file has been
+    delivered. The data that is still unread can be read afterwards.
+*/
+
+QSerialPortReplayPrivate::QSerialPortReplayPrivate()
+{
+    // Reads go straight to the mapping, and writes are discarded.
+    readBufferChunkSize = 0;
+    writeBufferChunkSize = 0;
+}
+
+// A record cut off at the end of the file, as left behind by a crash of the
+// capturing application, ends the replay like the end of the file does.
+bool QSerialPortReplayPrivate::readRecordHeader(qint64 offset, qint64 *timestamp,
+                                                int *type, qint64 *size) const
+{
+    if (mapSize - offset < QSerialPortTrafficCapturePrivate::RecordHeaderSize)
+        return false;
+
+    const quint32 typeAndSize = qFromLittleEndian<quint32>(map + offset + 8);
+    *timestamp = qFromLittleEndian<qint64>(map + offset);
+    *type = int(typeAndSize >> 24);
+    *size = typeAndSize & QSerialPortTrafficCapturePrivate::MaximumRecordSize;
+    return mapSize - offset - QSerialPortTrafficCapturePrivate::RecordHeaderSize >= *size;
+}
+
+qint64 QSerialPortReplayPrivate::playbackTime() const
+{
+    return playbackOffset + qint64(clock.nsecsElapsed() * speed);
+}
+
+void QSerialPortReplayPrivate::deliver()
+{
+    Q_Q(QSerialPortReplay);
+
+    const bool asFastAsPossible = qFuzzyIsNull(speed);
+    const qint64 now = asFastAsPossible ? 0 : playbackTime();
+
+    qint64 timestamp = 0;
+    int type = 0;
+    qint64 size = 0;
+    while (readRecordHeader(nextRecord, &timestamp, &type, &size)) {
+        timestamp -= firstTimestamp;
+        if (asFastAsPossible ? available >= BatchSize : timestamp > now)
+            break;
+
+        const QByteArrayView payload(map + nextRecord + QSerialPortTrafficCapturePrivate::RecordHeaderSize,
+                                     size);
+        nextRecord += QSerialPortTrafficCapturePrivate::RecordHeaderSize + size;
+        lastTimestamp = timestamp;
+
+        if (type == QSerialPortTrafficCapture::ReceivedRecord) {
+            if (!payload.isEmpty()) {
+                segments.append(payload);
+                available += size;
+                hasNewData = true;
+            }
+            continue;
+        }
+
+        // Keep the order of the data and of the other records.
+        if (hasNewData) {
+            hasNewData = false;
+            emit q->readyRead();
+            if (!q->isOpen())
+                return;
+        }
+        handleRecord(type, payload);
+        if (!q->isOpen())
+            return;
+    }
+
+    if (hasNewData) {
+        hasNewData = false;
+        emit q->readyRead();
+        if (!q->isOpen())
+            return;
+    }
+
+    scheduleNext();
+}
+
+void QSerialPortReplayPrivate::handleRecord(int type, QByteArrayView payload)
+{
+    Q_Q(QSerialPortReplay);
+
+    const auto bytes = reinterpret_cast<const uchar *>(payload.data());
+
+    switch (type) {
+    case QSerialPortTrafficCapture::SettingsRecord: {
+        if (payload.size() < 12)
+            return;
+        const qint32 newInputBaudRate = qFromLittleEndian<qint32>(bytes);
+        const qint32 newOutputBaudRate = qFromLittleEndian<qint32>(bytes + 4);
+        const auto newDataBits = QSerialPort::DataBits(bytes[8]);
+        const auto newParity = QSerialPort::Parity(bytes[9]);
+        const auto newStopBits = QSerialPort::StopBits(bytes[10]);
+        const auto newFlowControl = QSerialPort::FlowControl(bytes[11]);
+
+        const bool inputChanged = inputBaudRate != newInputBaudRate;
+        const bool outputChanged = outputBaudRate != newOutputBaudRate;
+        inputBaudRate = newInputBaudRate;
+        outputBaudRate = newOutputBaudRate;
+        if (inputChanged && outputChanged && newInputBaudRate == newOutputBaudRate) {
+            emit q->baudRateChanged(newInputBaudRate, QSerialPort::AllDirections);
+        } else {
+            if (inputChanged)
+                emit q->baudRateChanged(newInputBaudRate, QSerialPort::Input);
+            if (outputChanged)
+                emit q->baudRateChanged(newOutputBaudRate, QSerialPort::Output);
+        }
+        if (dataBits != newDataBits) {
+            dataBits = newDataBits;
+            emit q->dataBitsChanged(dataBits);
+        }
+        if (parity != newParity) {
+            parity = newParity;
+            emit q->parityChanged(parity);
+        }
+        if (stopBits != newStopBits) {
+            stopBits = newStopBits;
+            emit q->stopBitsChanged(stopBits);
+        }
+        if (flowControl != newFlowControl) {
+            flowControl = newFlowControl;
+            emit q->flowControlChanged(flowControl);
+        }
+        break;
+    }
+    case QSerialPortTrafficCapture::ControlLineRecord: {
+        if (payload.size() < 5)
+            return;
+        const auto line = QSerialPort::PinoutSignal(qFromLittleEndian<quint32>(bytes));
+        const bool set = bytes[4];
+        if (line != QSerialPort::DataTerminalReadySignal && line != QSerialPort::RequestToSendSignal)
+            return;
+        if (pinoutSignals.testFlag(line) == set)
+            return;
+        pinoutSignals.setFlag(line, set);
+        if (line == QSerialPort::DataTerminalReadySignal)
+            emit q->dataTerminalReadyChanged(set);
+        else
+            emit q->requestToSendChanged(set);
+        break;
+    }
+    case QSerialPortTrafficCapture::BreakRecord: {
+        if (payload.isEmpty())
+            return;
+        const bool set = bytes[0];
+        if (breakEnabled == set)
+            return;
+        breakEnabled = set;
+        emit q->breakEnabledChanged(set);
+        break;
+    }
+    case QSerialPortTrafficCapture::ErrorRecord:
+        if (payload.size() < 4)
+            return;
+        error = QSerialPort::SerialPortError(qFromLittleEndian<quint32>(bytes));
+        emit q->errorOccurred(error);
+        break;
+    default:
+        // The transmitted bytes and the gaps of the capture are not replayed.
+        break;
+    }
+}
+
+void QSerialPortReplayPrivate::scheduleNext()
+{
+    if (finished)
+        return;
+
+    qint64 timestamp = 0;
+    int type = 0;
+    qint64 size = 0;
+    if (!readRecordHeader(nextRecord, &timestamp, &type, &size)) {
+        finish();
+        return;
+    }
+
+    if (qFuzzyIsNull(speed)) {
+        if (available < BatchSize)
+            timer->start(0);
+        return;
+    }
+
+    const qint64 delay = qint64((timestamp - firstTimestamp - playbackTime()) / speed);
+    timer->start(std::chrono::milliseconds(delay > 0 ? (delay + 999999) / 1000000 : 0));
+}
+
+void QSerialPortReplayPrivate::finish()
+{
+    Q_Q(QSerialPortReplay);
+
+    timer->stop();
+    finished = true;
+    emit q->finished();
+}
+
+/*!
+    Constructs a replay with the given \a parent.
+*/
+QSerialPortReplay::QSerialPortReplay(QObject *parent)
+    : QIODevice(*new QSerialPortReplayPrivate, parent)
+{
+    Q_D(QSerialPortReplay);
+    d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
+    d->timer->setTimerType(Qt::PreciseTimer);
+    connect(d->timer, &QTimer::timeout, this, [d]() {
+        d->deliver();
+    });
+}
+
+/*!
+    Constructs a replay of the capture file \a fileName, with the given
+    \a parent.
+*/
+QSerialPortReplay::QSerialPortReplay(const QString &fileName, QObject *parent)
+    : QSerialPortReplay(parent)
+{
+    setFileName(fileName);
+}
+
+/*!
+    Closes the replay, and destroys it.
+*/
+QSerialPortReplay::~QSerialPortReplay()
+{
+    if (isOpen())
+        close();
+}
+
+/*!
+    Sets the name of the capture file to replay to \a fileName. It cannot
+    be changed while the replay is open.
+*/
+void QSerialPortReplay::setFileName(const QString &fileName)
+{
+    Q_D(QSerialPortReplay);
+
+    if (isOpen()) {
+        qWarning("%s: device open", Q_FUNC_INFO);
+        return;
+    }
+    d->file.setFileName(fileName);
+}
+
+/*!
+    Returns the name of the capture file to replay.
+*/
+QString QSerialPortReplay::fileName() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->file.fileName();
+}
+
+/*!
+    Sets the \a speed of the replay, as a factor of the original timing of
+    the capture: a speed of 2 replays twice as fast, a speed of 0.5 half as
+    fast. A speed of 0 replays the file as fast as the application reads
+    the data. Negative speeds are treated as 0.
+
+    The speed can be changed while the replay is open; the replay then
+    continues with the new speed from the record it has reached.
+
+    The default speed is 1.
+*/
+void QSerialPortReplay::setSpeed(qreal speed)
+{
+    Q_D(QSerialPortReplay);
+
+    speed = qMax(speed, qreal(0));
+    if (isOpen()) {
+        d->playbackOffset = qFuzzyIsNull(d->speed) ? d->lastTimestamp : d->playbackTime();
+        d->clock.start();
+    }
+    d->speed = speed;
+    if (isOpen() && !d->finished) {
+        d->timer->stop();
+        d->scheduleNext();
+    }
+}
+
+/*!
+    Returns the speed of the replay.
+*/
+qreal QSerialPortReplay::speed() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->speed;
+}
+
+/*!
+    \reimp
+
+    Opens the capture file, and starts the replay with the given \a mode,
+    which must include QIODevice::ReadOnly. Returns \c true on success;
+    otherwise returns \c false and sets the errorString().
+
+    The settings start with the defaults of QSerialPort, and are updated as
+    the records of the file are replayed.
+*/
+bool QSerialPortReplay::open(OpenMode mode)
+{
+    Q_D(QSerialPortReplay);
+
+    if (isOpen()) {
+        setErrorString(tr("Device is already open"));
+        return false;
+    }
+    if (!(mode & ReadOnly)) {
+        setErrorString(tr("The replay can only be opened for reading"));
+        return false;
+    }
+
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        setErrorString(d->file.errorString());
+        return false;
+    }
+
+    const qint64 size = d->file.size();
+    if (size < QSerialPortTrafficCapturePrivate::FileHeaderSize) {
+        setErrorString(tr("Not a serial port traffic capture"));
+        d->file.close();
+        return false;
+    }
+    const uchar *map = d->file.map(0, size);
+    if (!map) {
+        setErrorString(d->file.errorString());
+        d->file.close();
+        return false;
+    }
+    if (memcmp(map, "QSPC", 4) != 0
+            || qFromLittleEndian<quint32>(map + 4) != QSerialPortTrafficCapturePrivate::FormatVersion) {
+        setErrorString(tr("Not a serial port traffic capture"));
+        d->file.unmap(const_cast<uchar *>(map));
+        d->file.close();
+        return false;
+    }
+
+    d->map = map;
+    d->mapSize = size;
+    d->nextRecord = QSerialPortTrafficCapturePrivate::FileHeaderSize;
+    d->firstTimestamp = 0;
+    d->lastTimestamp = 0;
+    d->playbackOffset = 0;
+    d->finished = false;
+    d->hasNewData = false;
+    d->segments.clear();
+    d->available = 0;
+
+    d->inputBaudRate = QSerialPort::Baud9600;
+    d->outputBaudRate = QSerialPort::Baud9600;
+    d->dataBits = QSerialPort::Data8;
+    d->parity = QSerialPort::NoParity;
+    d->stopBits = QSerialPort::OneStop;
+    d->flowControl = QSerialPort::NoFlowControl;
+    d->pinoutSignals = QSerialPort::NoSignal;
+    d->breakEnabled = false;
+    d->error = QSerialPort::NoError;
+
+    int type = 0;
+    qint64 recordSize = 0;
+    d->readRecordHeader(d->nextRecord, &d->firstTimestamp, &type, &recordSize);
+
+    QIODevice::open(mode | Unbuffered);
+    d->clock.start();
+    // The first records are delivered from the event loop, after the
+    // application had a chance to connect to the signals.
+    d->timer->start(0);
+    return true;
+}
+
+/*!
+    \reimp
+
+    Stops the replay, and closes the capture file. The data that is still
+    unread is discarded.
+*/
+void QSerialPortReplay::close()
+{
+    Q_D(QSerialPortReplay);
+
+    if (!isOpen())
+        return;
+
+    QIODevice::close();
+    d->timer->stop();
+    d->segments.clear();
+    d->available = 0;
+    d->file.unmap(const_cast<uchar *>(d->map));
+    d->map = nullptr;
+    d->mapSize = 0;
+    d->file.close();
+}
+
+/*!
+    Returns \c true if all records of the file have been delivered.
+
+    \sa finished()
+*/
+bool QSerialPortReplay::isFinished() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->finished;
+}
+
+/*!
+    Returns the baud rate in the given \a directions, as last replayed.
+    For both directions, -1 is returned if the input baud rate differs from
+    the output baud rate, like QSerialPort::baudRate() does.
+*/
+qint32 QSerialPortReplay::baudRate(QSerialPort::Directions directions) const
+{
+    Q_D(const QSerialPortReplay);
+    if (directions == QSerialPort::AllDirections)
+        return d->inputBaudRate == d->outputBaudRate ? d->inputBaudRate : -1;
+    return directions & QSerialPort::Input ? d->inputBaudRate : d->outputBaudRate;
+}
+
+/*!
+    Returns the data bits, as last replayed.
+*/
+QSerialPort::DataBits QSerialPortReplay::dataBits() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->dataBits;
+}
+
+/*!
+    Returns the parity, as last replayed.
+*/
+QSerialPort::Parity QSerialPortReplay::parity() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->parity;
+}
+
+/*!
+    Returns the stop bits, as last replayed.
+*/
+QSerialPort::StopBits QSerialPortReplay::stopBits() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->stopBits;
+}
+
+/*!
+    Returns the flow control, as last replayed.
+*/
+QSerialPort::FlowControl QSerialPortReplay::flowControl() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->flowControl;
+}
+
+/*!
+    Returns the states of the DTR and RTS lines, as last replayed. The
+    other signals are not recorded in a capture, and are never set.
+*/
+QSerialPort::PinoutSignals QSerialPortReplay::pinoutSignals() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->pinoutSignals;
+}
+
+/*!
+    Returns the break state, as last replayed.
+*/
+bool QSerialPortReplay::isBreakEnabled() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->breakEnabled;
+}
+
+/*!
+    Returns the last error replayed, or QSerialPort::NoError.
+*/
+QSerialPort::SerialPortError QSerialPortReplay::error() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->error;
+}
+
+/*!
+    \reimp
+
+    Always returns \c true. The replay is a sequential device.
+*/
+bool QSerialPortReplay::isSequential() const
+{
+    return true;
+}
+
+/*!
+    \reimp
+
+    Returns the number of bytes that have been delivered, and are waiting
+    to be read.
+*/
+qint64 QSerialPortReplay::bytesAvailable() const
+{
+    Q_D(const QSerialPortReplay);
+    return d->available + QIODevice::bytesAvailable();
+}
+
+/*!
+    \reimp
+*/
+qint64 QSerialPortReplay::readData(char *data, qint64 maxSize)
+{
+    Q_D(QSerialPortReplay);
+
+    qint64 readBytes = 0;
+    while (readBytes < maxSize && !d->segments.isEmpty()) {
+        QByteArrayView &segment = d->segments.first();
+        const qint64 chunk = qMin(maxSize - readBytes, qint64(segment.size()));
+        memcpy(data + readBytes, segment.data(), chunk);
+        readBytes += chunk;
+        if (chunk == segment.size())
+            d->segments.removeFirst();
+        else
+            segment = segment.sliced(chunk);
+    }
+    d->available -= readBytes;
+
+    // Resume a replay as fast as possible that waited for the application.
+    if (qFuzzyIsNull(d->speed) && !d->finished && d->available < BatchSize
+            && !d->timer->isActive()) {
+        d->timer->start(0);
+    }
+    return readBytes;
+}
+
+/*!
+    \reimp
+
+    Discards the data, and returns \a maxSize.
+*/
+qint64 QSerialPortReplay::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    return maxSize;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qserialportreplay.cpp"
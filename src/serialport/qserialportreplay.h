@@ -0,0 +1,69 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTREPLAY_H
+#define QSERIALPORTREPLAY_H
+
+#include <QtCore/qiodevice.h>
+
+#include <QtSerialPort/qserialport.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPortReplayPrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortReplay : public QIODevice
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortReplay)
+
+public:
+    explicit QSerialPortReplay(QObject *parent = nullptr);
+    explicit QSerialPortReplay(const QString &fileName, QObject *parent = nullptr);
+    ~QSerialPortReplay();
+
+    void setFileName(const QString &fileName);
+    QString fileName() const;
+
+    void setSpeed(qreal speed);
+    qreal speed() const;
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isFinished() const;
+
+    qint32 baudRate(QSerialPort::Directions directions = QSerialPort::AllDirections) const;
+    QSerialPort::DataBits dataBits() const;
+    QSerialPort::Parity parity() const;
+    QSerialPort::StopBits stopBits() const;
+    QSerialPort::FlowControl flowControl() const;
+    QSerialPort::PinoutSignals pinoutSignals() const;
+    bool isBreakEnabled() const;
+    QSerialPort::SerialPortError error() const;
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+Q_SIGNALS:
+    void baudRateChanged(qint32 baudRate, QSerialPort::Directions directions);
+    void dataBitsChanged(QSerialPort::DataBits dataBits);
+    void parityChanged(QSerialPort::Parity parity);
+    void stopBitsChanged(QSerialPort::StopBits stopBits);
+    void flowControlChanged(QSerialPort::FlowControl flowControl);
+    void dataTerminalReadyChanged(bool set);
+    void requestToSendChanged(bool set);
+    void breakEnabledChanged(bool set);
+    void errorOccurred(QSerialPort::SerialPortError error);
+    void finished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    Q_DISABLE_COPY(QSerialPortReplay)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTREPLAY_H
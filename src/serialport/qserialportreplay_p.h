@@ -0,0 +1,78 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTREPLAY_P_H
+#define QSERIALPORTREPLAY_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialportreplay.h"
+
+#include <QtCore/qbytearrayview.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qlist.h>
+
+#include <private/qiodevice_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+class QSerialPortReplayPrivate : public QIODevicePrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortReplay)
+
+    QSerialPortReplayPrivate();
+
+    bool readRecordHeader(qint64 offset, qint64 *timestamp, int *type, qint64 *size) const;
+    qint64 playbackTime() const;
+    void deliver();
+    void handleRecord(int type, QByteArrayView payload);
+    void scheduleNext();
+    void finish();
+
+    QFile file;
+    const uchar *map = nullptr;
+    qint64 mapSize = 0;
+    qint64 nextRecord = 0;
+    qint64 firstTimestamp = 0;
+    qint64 lastTimestamp = 0;
+    qreal speed = 1;
+
+    // The playback time is playbackOffset at the start of the clock, and
+    // advances with the clock scaled by the speed.
+    QTimer *timer = nullptr;
+    QElapsedTimer clock;
+    qint64 playbackOffset = 0;
+    bool finished = false;
+    bool hasNewData = false;
+
+    // The received payloads delivered, but not yet read, refer to the map.
+    QList<QByteArrayView> segments;
+    qint64 available = 0;
+
+    qint32 inputBaudRate = QSerialPort::Baud9600;
+    qint32 outputBaudRate = QSerialPort::Baud9600;
+    QSerialPort::DataBits dataBits = QSerialPort::Data8;
+    QSerialPort::Parity parity = QSerialPort::NoParity;
+    QSerialPort::StopBits stopBits = QSerialPort::OneStop;
+    QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
+    QSerialPort::PinoutSignals pinoutSignals;
+    bool breakEnabled = false;
+    QSerialPort::SerialPortError error = QSerialPort::NoError;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTREPLAY_P_H
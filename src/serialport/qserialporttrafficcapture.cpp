@@ -0,0 +1,456 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialporttrafficcapture.h"
+#include "qserialporttrafficcapture_p.h"
+#include "qserialport_p.h"
+
+#include <QtCore/qdatetime.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qendian.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum {
+    MinimumBufferSize = 4096,
+    // The writer is woken up early once this much is pending, and
+    // otherwise writes what has accumulated at every flush interval.
+    BatchSize = 64 * 1024,
+    FlushInterval = 100
+};
+
+} // namespace
+
+/*!
+    \class QSerialPortTrafficCapture
+    \since 6.6
+
+    \brief Records the traffic of a serial port into a capture file.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    QSerialPortTrafficCapture tees everything that crosses the wire of a
+    QSerialPort into a compact binary file: the bytes received and
+    transmitted, together with the changes of the settings, of the DTR
+    and RTS lines and of the break state, and the errors. Each record
+    carries a monotonic timestamp, so that the capture can tell exactly
+    what happened when, for example for debugging problems in the field.
+
+    \code
+    auto capture = new QSerialPortTrafficCapture(port, port);
+    if (!capture->start(QStringLiteral("/var/log/modem.qspcap")))
+        qWarning() << capture->errorString();
+    \endcode
+
+    The data path of the port is not slowed down by the capture: the
+    records are appended to an in-memory buffer of bufferSize() bytes, and
+    written to the file in large batches by a background thread. When the
+    file cannot keep up and the buffer is full, records are dropped and
+    counted by droppedRecords() and droppedBytes(); a DroppedRecord marks
+    the gap in the file.
+
+    The capture must live in the thread of the port.
+
+    \section1 File Format
+
+    All values are stored in little-endian byte order. The file starts
+    with a header of 16 bytes:
+
+    \table
+    \header \li Offset \li Size \li Content
+    \row \li 0 \li 4 \li The magic \c{QSPC}.
+    \row \li 4 \li 4 \li The format version, currently 1.
+    \row \li 8 \li 8 \li The wall clock time at the start of the capture,
+                          in milliseconds since the epoch.
+    \endtable
+
+    It is followed by the records, each of them made up of a header of
+    12 bytes and the payload:
+
+    \table
+    \header \li Offset \li Size \li Content
+    \row \li 0 \li 8 \li The monotonic time since the start of the capture,
+                          in nanoseconds.
+    \row \li 8 \li 4 \li The RecordType in the upper 8 bits, and the size
+                          of the payload in the lower 24 bits.
+    \endtable
+
+    \sa RecordType
+*/
+
+/*!
+    \enum QSerialPortTrafficCapture::RecordType
+
+    This enum describes the types of records in a capture file, and their
+    payloads.
+
+    \value ReceivedRecord       The bytes read from the port.
+    \value TransmittedRecord    The bytes written to the port.
+    \value SettingsRecord       The settings of the port: the input and the
+                                output baud rate as 32-bit integers,
+                                followed by the data bits, the parity, the
+                                stop bits and the flow control as 8-bit
+                                values of the QSerialPort enums. It is
+                                recorded at the start, and whenever a
+                                setting changes.
+    \value ControlLineRecord    A change of a line controlled by the
+                                application: the QSerialPort::PinoutSignal
+                                as a 32-bit integer, followed by its new
+                                state as a byte.
+    \value BreakRecord          A change of the break state, as a byte.
+    \value ErrorRecord          A QSerialPort::SerialPortError that
+                                occurred, as a 32-bit integer.
+    \value DroppedRecord        The number of records and the number of
+                                bytes dropped before this record, as two
+                                64-bit integers.
+*/
+
+void QSerialPortTrafficCapturePrivate::record(QSerialPortTrafficCapture::RecordType type,
+                                              const char *data, qint64 size)
+{
+    const qint64 timestamp = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs() - startTime;
+    const bool isTraffic = type == QSerialPortTrafficCapture::ReceivedRecord
+            || type == QSerialPortTrafficCapture::TransmittedRecord;
+
+    QMutexLocker locker(&mutex);
+
+    const qint64 pendingSize = pending.size();
+    const qint64 markerSize = unreportedDroppedRecords ? RecordHeaderSize + 16 : 0;
+    if (writeFailed || pendingSize + markerSize + RecordHeaderSize + size > bufferSize) {
+        ++droppedRecords;
+        ++unreportedDroppedRecords;
+        if (isTraffic) {
+            droppedBytes += size;
+            unreportedDroppedBytes += size;
+        }
+        return;
+    }
+
+    if (markerSize)
+        appendDroppedRecord(timestamp);
+
+    appendRecord(timestamp, type, data, size);
+    if (isTraffic)
+        capturedBytes += size;
+
+    if (pendingSize < batchSize() && pending.size() >= batchSize())
+        condition.wakeOne();
+}
+
+qint64 QSerialPortTrafficCapturePrivate::batchSize() const
+{
+    return qMin(qint64(BatchSize), bufferSize / 2);
+}
+
+void QSerialPortTrafficCapturePrivate::recordSettings()
+{
+    char payload[12];
+    qToLittleEndian<qint32>(port->baudRate(QSerialPort::Input), payload);
+    qToLittleEndian<qint32>(port->baudRate(QSerialPort::Output), payload + 4);
+    payload[8] = char(port->dataBits());
+    payload[9] = char(port->parity());
+    payload[10] = char(port->stopBits());
+    payload[11] = char(port->flowControl());
+    record(QSerialPortTrafficCapture::SettingsRecord, payload, sizeof(payload));
+}
+
+void QSerialPortTrafficCapturePrivate::recordControlLine(QSerialPort::PinoutSignal line, bool set)
+{
+    char payload[5];
+    qToLittleEndian<quint32>(line, payload);
+    payload[4] = char(set);
+    record(QSerialPortTrafficCapture::ControlLineRecord, payload, sizeof(payload));
+}
+
+void QSerialPortTrafficCapturePrivate::appendRecord(qint64 timestamp,
+                                                    QSerialPortTrafficCapture::RecordType type,
+                                                    const char *data, qint64 size)
+{
+    char header[RecordHeaderSize];
+    qToLittleEndian<qint64>(timestamp, header);
+    qToLittleEndian<quint32>(quint32(type) << 24 | quint32(size), header + 8);
+    pending.append(header, RecordHeaderSize);
+    pending.append(data, size);
+}
+
+// Marks the gap left by the records dropped since the last marker.
+void QSerialPortTrafficCapturePrivate::appendDroppedRecord(qint64 timestamp)
+{
+    char payload[16];
+    qToLittleEndian<quint64>(unreportedDroppedRecords, payload);
+    qToLittleEndian<quint64>(unreportedDroppedBytes, payload + 8);
+    appendRecord(timestamp, QSerialPortTrafficCapture::DroppedRecord, payload, sizeof(payload));
+    unreportedDroppedRecords = 0;
+    unreportedDroppedBytes = 0;
+}
+
+// Runs in the writer thread, and writes out what is pending in batches,
+// so that the port only ever waits for a copy into the pending buffer.
+void QSerialPortTrafficCapturePrivate::writeBatches()
+{
+    QByteArray batch;
+    batch.reserve(bufferSize);
+
+    QMutexLocker locker(&mutex);
+    for (;;) {
+        if (!stopping && pending.size() < batchSize())
+            condition.wait(&mutex, FlushInterval);
+        if (pending.isEmpty()) {
+            if (stopping)
+                break;
+            continue;
+        }
+
+        pending.swap(batch);
+        locker.unlock();
+        const bool written = file.write(batch) == batch.size();
+        batch.resize(0);
+        locker.relock();
+
+        if (!written && !writeFailed) {
+            writeFailed = true;
+            errorString = file.errorString();
+        }
+    }
+}
+
+/*!
+    Constructs a traffic capture for \a port, with the given \a parent.
+*/
+QSerialPortTrafficCapture::QSerialPortTrafficCapture(QSerialPort *port, QObject *parent)
+    : QObject(*new QSerialPortTrafficCapturePrivate, parent)
+{
+    Q_D(QSerialPortTrafficCapture);
+    d->port = port;
+}
+
+/*!
+    Destroys the capture, after writing out what is still pending.
+*/
+QSerialPortTrafficCapture::~QSerialPortTrafficCapture()
+{
+    stop();
+}
+
+/*!
+    Returns the port whose traffic is captured.
+*/
+QSerialPort *QSerialPortTrafficCapture::port() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    return d->port;
+}
+
+/*!
+    Sets the size of the buffer that holds the records until they are
+    written to \a size bytes. It takes effect with the next start().
+
+    The size is bounded to the range from 4 KiB to 16 MiB. The default
+    size is 1 MiB, enough to capture a fully loaded port at 921600 baud for
+    more than ten seconds without writing to the file.
+*/
+void QSerialPortTrafficCapture::setBufferSize(qint64 size)
+{
+    Q_D(QSerialPortTrafficCapture);
+    d->bufferSize = qBound(qint64(MinimumBufferSize), size,
+                           qint64(QSerialPortTrafficCapturePrivate::MaximumRecordSize));
+}
+
+/*!
+    Returns the size of the buffer that holds the records until they are
+    written.
+*/
+qint64 QSerialPortTrafficCapture::bufferSize() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    return d->bufferSize;
+}
+
+/*!
+    Starts capturing the traffic of the port into the file \a fileName,
+    which is replaced if it exists. Returns \c true on success; otherwise
+    returns \c false and sets errorString().
+
+    A capture that is active is stopped first. Only one capture at a time
+    can be active for a port.
+*/
+bool QSerialPortTrafficCapture::start(const QString &fileName)
+{
+    Q_D(QSerialPortTrafficCapture);
+
+    stop();
+
+    if (!d->port) {
+        d->errorString = tr("No serial port to capture");
+        return false;
+    }
+    QSerialPortPrivate *portPrivate = QSerialPortPrivate::get(d->port);
+    if (portPrivate->capture) {
+        d->errorString = tr("The serial port is already being captured");
+        return false;
+    }
+
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        d->errorString = d->file.errorString();
+        return false;
+    }
+
+    char header[QSerialPortTrafficCapturePrivate::FileHeaderSize];
+    memcpy(header, "QSPC", 4);
+    qToLittleEndian<quint32>(QSerialPortTrafficCapturePrivate::FormatVersion, header + 4);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 8);
+    if (d->file.write(header, sizeof(header)) != qint64(sizeof(header))) {
+        d->errorString = d->file.errorString();
+        d->file.close();
+        return false;
+    }
+
+    d->startTime = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+    d->pending.reserve(d->bufferSize);
+    d->capturedBytes = 0;
+    d->droppedBytes = 0;
+    d->droppedRecords = 0;
+    d->unreportedDroppedBytes = 0;
+    d->unreportedDroppedRecords = 0;
+    d->stopping = false;
+    d->writeFailed = false;
+    d->errorString.clear();
+
+    d->writer.reset(QThread::create([d]() {
+        d->writeBatches();
+    }));
+    d->writer->setObjectName(QStringLiteral("QSerialPortTrafficCapture"));
+    d->writer->start(QThread::LowPriority);
+
+    QSerialPort *port = d->port;
+    const auto recordSettings = [d]() {
+        d->recordSettings();
+    };
+    d->connections = {
+        connect(port, &QSerialPort::baudRateChanged, this, recordSettings),
+        connect(port, &QSerialPort::dataBitsChanged, this, recordSettings),
+        connect(port, &QSerialPort::parityChanged, this, recordSettings),
+        connect(port, &QSerialPort::stopBitsChanged, this, recordSettings),
+        connect(port, &QSerialPort::flowControlChanged, this, recordSettings),
+        connect(port, &QSerialPort::dataTerminalReadyChanged, this, [d](bool set) {
+            d->recordControlLine(QSerialPort::DataTerminalReadySignal, set);
+        }),
+        connect(port, &QSerialPort::requestToSendChanged, this, [d](bool set) {
+            d->recordControlLine(QSerialPort::RequestToSendSignal, set);
+        }),
+        connect(port, &QSerialPort::breakEnabledChanged, this, [d](bool set) {
+            const char payload = char(set);
+            d->record(QSerialPortTrafficCapture::BreakRecord, &payload, 1);
+        }),
+        connect(port, &QSerialPort::errorOccurred, this, [d](QSerialPort::SerialPortError error) {
+            if (error == QSerialPort::NoError)
+                return;
+            char payload[4];
+            qToLittleEndian<quint32>(error, payload);
+            d->record(QSerialPortTrafficCapture::ErrorRecord, payload, sizeof(payload));
+        })
+    };
+
+    portPrivate->capture = d;
+    d->recordSettings();
+    return true;
+}
+
+/*!
+    Stops the capture, and returns once all records that are still pending
+    have been written to the file.
+*/
+void QSerialPortTrafficCapture::stop()
+{
+    Q_D(QSerialPortTrafficCapture);
+
+    if (!d->writer)
+        return;
+
+    if (d->port)
+        QSerialPortPrivate::get(d->port)->capture = nullptr;
+    for (const QMetaObject::Connection &connection : std::as_const(d->connections))
+        disconnect(connection);
+    d->connections.clear();
+
+    const qint64 timestamp = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs() - d->startTime;
+    {
+        QMutexLocker locker(&d->mutex);
+        // No record follows to carry the marker of the last records dropped.
+        if (d->unreportedDroppedRecords && !d->writeFailed)
+            d->appendDroppedRecord(timestamp);
+        d->stopping = true;
+        d->condition.wakeOne();
+    }
+    d->writer->wait();
+    d->writer.reset();
+    d->file.close();
+}
+
+/*!
+    Returns \c true if the traffic is being captured.
+*/
+bool QSerialPortTrafficCapture::isActive() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    return d->writer != nullptr;
+}
+
+/*!
+    Returns the number of received and transmitted bytes that were
+    recorded since the start of the capture.
+*/
+quint64 QSerialPortTrafficCapture::capturedBytes() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    QMutexLocker locker(&d->mutex);
+    return d->capturedBytes;
+}
+
+/*!
+    Returns the number of received and transmitted bytes that were
+    dropped since the start of the capture, because the buffer was full.
+
+    \sa droppedRecords(), setBufferSize()
+*/
+quint64 QSerialPortTrafficCapture::droppedBytes() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    QMutexLocker locker(&d->mutex);
+    return d->droppedBytes;
+}
+
+/*!
+    Returns the number of records of any type that were dropped since the
+    start of the capture, because the buffer was full or the file could not
+    be written.
+
+    \sa droppedBytes()
+*/
+quint64 QSerialPortTrafficCapture::droppedRecords() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    QMutexLocker locker(&d->mutex);
+    return d->droppedRecords;
+}
+
+/*!
+    Returns a human-readable description of the last error that occurred
+    while starting the capture or writing the file.
+*/
+QString QSerialPortTrafficCapture::errorString() const
+{
+    Q_D(const QSerialPortTrafficCapture);
+    QMutexLocker locker(&d->mutex);
+    return d->errorString;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qserialporttrafficcapture.cpp"
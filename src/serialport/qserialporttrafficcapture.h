@@ -0,0 +1,57 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTTRAFFICCAPTURE_H
+#define QSERIALPORTTRAFFICCAPTURE_H
+
+#include <QtCore/qobject.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPort;
+class QSerialPortTrafficCapturePrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortTrafficCapture : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortTrafficCapture)
+
+public:
+    enum RecordType {
+        ReceivedRecord = 1,
+        TransmittedRecord,
+        SettingsRecord,
+        ControlLineRecord,
+        BreakRecord,
+        ErrorRecord,
+        DroppedRecord
+    };
+    Q_ENUM(RecordType)
+
+    explicit QSerialPortTrafficCapture(QSerialPort *port, QObject *parent = nullptr);
+    ~QSerialPortTrafficCapture();
+
+    QSerialPort *port() const;
+
+    void setBufferSize(qint64 size);
+    qint64 bufferSize() const;
+
+    bool start(const QString &fileName);
+    void stop();
+    bool isActive() const;
+
+    quint64 capturedBytes() const;
+    quint64 droppedBytes() const;
+    quint64 droppedRecords() const;
+
+    QString errorString() const;
+
+private:
+    Q_DISABLE_COPY(QSerialPortTrafficCapture)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTTRAFFICCAPTURE_H
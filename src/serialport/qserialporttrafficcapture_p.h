@@ -0,0 +1,80 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTTRAFFICCAPTURE_P_H
+#define QSERIALPORTTRAFFICCAPTURE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialporttrafficcapture.h"
+#include "qserialport.h"
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qwaitcondition.h>
+
+#include <private/qobject_p.h>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPortTrafficCapturePrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QSerialPortTrafficCapture)
+
+public:
+    enum {
+        FormatVersion = 1,
+        FileHeaderSize = 16,
+        RecordHeaderSize = 12,
+        MaximumRecordSize = 0xFFFFFF
+    };
+
+    void record(QSerialPortTrafficCapture::RecordType type, const char *data, qint64 size);
+    void recordSettings();
+    void recordControlLine(QSerialPort::PinoutSignal line, bool set);
+    void appendRecord(qint64 timestamp, QSerialPortTrafficCapture::RecordType type,
+                      const char *data, qint64 size);
+    void appendDroppedRecord(qint64 timestamp);
+    void writeBatches();
+    qint64 batchSize() const;
+
+    QPointer<QSerialPort> port;
+    QList<QMetaObject::Connection> connections;
+    qint64 bufferSize = 1024 * 1024;
+    qint64 startTime = 0;
+
+    QFile file;
+    std::unique_ptr<QThread> writer;
+
+    // Shared with the writer thread.
+    mutable QMutex mutex;
+    QWaitCondition condition;
+    QByteArray pending;
+    quint64 capturedBytes = 0;
+    quint64 droppedBytes = 0;
+    quint64 droppedRecords = 0;
+    quint64 unreportedDroppedBytes = 0;
+    quint64 unreportedDroppedRecords = 0;
+    bool stopping = false;
+    bool writeFailed = false;
+    QString errorString;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTTRAFFICCAPTURE_P_H
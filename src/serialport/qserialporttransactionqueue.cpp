@@ -0,0 +1,473 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialporttransactionqueue.h"
+#include "qserialporttransactionqueue_p.h"
+#include "qserialport.h"
+#include "qserialport_p.h"
+
+#include <QtCore/qtimer.h>
+
+#include <limits>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+static qint64 currentTimestamp()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+/*!
+    \class QSerialPortTransactionQueue
+    \since 6.6
+
+    \brief Sends requests on a serial port and matches the responses to them.
+
+    \ingroup serialport-main
+    \inmodule QtSerialPort
+
+    QSerialPortTransactionQueue drives devices that answer every command
+    with a response, without blocking the thread. Requests are queued with
+    sendRequest(), together with the rule that tells where the response
+    ends:
+
+    \list
+        \li a delimiter, such as \c{"\r\n"}, which is part of the response;
+        \li a fixed response length, in bytes;
+        \li a ResponseMatcher function, for everything else.
+    \endlist
+
+    By default, a request is written when the response to the previous one
+    has arrived. Devices that buffer their commands can be kept busy by
+    allowing more requests in flight with setMaximumRequestsInFlight(). The
+    device must answer the requests in the order it received them.
+
+    Each request has a deadline, which starts when the request is written.
+    The response is reported with the replyReceived() signal, together with
+    the time between writing the request and reading the end of the
+    response. A request that is not answered in time fails with
+    TimeoutError; as a late response cannot be told apart from the response
+    to the next request, the data received so far is dropped.
+
+    Data that arrives while no request is in flight is discarded.
+
+    Requests are only written while the port is open. A request that is
+    due to be written while there is no open port fails with WriteError.
+
+    The queue takes over the read channel of the port.
+
+    \sa QSerialPort
+*/
+
+/*!
+    \enum QSerialPortTransactionQueue::Error
+
+    This enum describes the reasons why a request failed.
+
+    \value NoError          No error occurred.
+    \value TimeoutError     The response did not arrive in time.
+    \value ResponseError    The response matcher rejected the received data.
+    \value WriteError       The request could not be written to the port,
+                            or the port was not open.
+    \value PortChangedError The port was replaced with setPort() before
+                            the response arrived.
+*/
+
+/*!
+    \typealias QSerialPortTransactionQueue::ResponseMatcher
+
+    A function that is called with the data received since the end of the
+    previous response. It returns the length of the response when the data
+    holds a complete response, 0 when more data is needed, or a negative
+    value when the data cannot be the response to the request.
+*/
+
+quint64 QSerialPortTransactionQueuePrivate::enqueue(Request &&request, int msecs)
+{
+    request.requestId = nextRequestId++;
+    request.timeout = msecs < 0 ? timeout : msecs;
+    const quint64 requestId = request.requestId;
+    pendingRequests.append(std::move(request));
+    sendPending();
+    return requestId;
+}
+
+void QSerialPortTransactionQueuePrivate::sendPending()
+{
+    while (!pendingRequests.isEmpty() && requestsInFlight.size() < maximumRequestsInFlight) {
+        Request request = pendingRequests.takeFirst();
+        // Nothing would write the request once the port is open.
+        if (!port || !port->isOpen() || port->write(request.data) != request.data.size()) {
+            failLater(request, QSerialPortTransactionQueue::WriteError);
+            continue;
+        }
+        request.sentTimestamp = currentTimestamp();
+        request.deadline = QDeadlineTimer(request.timeout, Qt::PreciseTimer);
+        requestsInFlight.append(std::move(request));
+    }
+    updateTimer();
+}
+
+void QSerialPortTransactionQueuePrivate::readFromPort()
+{
+    if (!port)
+        return;
+
+    const QByteArray data = port->readAll();
+    if (data.isEmpty() || requestsInFlight.isEmpty())
+        return;
+
+    // The time the data was read from the driver, rather than the time the
+    // event was processed.
+    qint64 timestamp = QSerialPortPrivate::get(port)->lastReadTimestamp;
+    if (timestamp == 0)
+        timestamp = currentTimestamp();
+
+    buffer.append(data);
+    processResponses(timestamp);
+}
+
+void QSerialPortTransactionQueuePrivate::processResponses(qint64 timestamp)
+{
+    Q_Q(QSerialPortTransactionQueue);
+
+    while (!requestsInFlight.isEmpty() && !buffer.isEmpty()) {
+        const qsizetype length = matchResponse(requestsInFlight.constFirst());
+        if (length == 0)
+            return;
+
+        const Request request = requestsInFlight.takeFirst();
+        if (length < 0 || length > buffer.size()) {
+            buffer.clear();
+            sendPending();
+            fail(request, QSerialPortTransactionQueue::ResponseError);
+            continue;
+        }
+
+        const QByteArray reply = buffer.left(length);
+        buffer.remove(0, length);
+
+        // Keep the device busy while the slots run.
+        sendPending();
+        emit q->replyReceived(request.requestId, reply,
+                              qMax(timestamp - request.sentTimestamp, qint64(0)));
+    }
+
+    // Nobody asked for what is left.
+    if (requestsInFlight.isEmpty())
+        buffer.clear();
+}
+
+// Returns the length of the response to the \a request at the start of the
+// buffer, 0 if it is incomplete, or a negative value if it is invalid.
+qsizetype QSerialPortTransactionQueuePrivate::matchResponse(const Request &request) const
+{
+    if (request.matcher)
+        return request.matcher(buffer);
+
+    if (!request.delimiter.isEmpty()) {
+        const qsizetype index = buffer.indexOf(request.delimiter);
+        return index < 0 ? 0 : index + request.delimiter.size();
+    }
+
+    return buffer.size() >= request.responseLength ? request.responseLength : 0;
+}
+
+void QSerialPortTransactionQueuePrivate::expireRequests()
+{
+    qsizetype first = 0;
+    while (first < requestsInFlight.size() && !requestsInFlight.at(first).deadline.hasExpired())
+        ++first;
+    if (first == requestsInFlight.size()) {
+        updateTimer();
+        return;
+    }
+
+    // The responses are matched in order: a late response to the expired
+    // request would be taken for the one after it, so the requests after
+    // it are failed too, and the data received so far is dropped.
+    const QList<Request> expired = requestsInFlight.sliced(first);
+    requestsInFlight.resize(first);
+    buffer.clear();
+
+    sendPending();
+    for (const Request &request : expired)
+        fail(request, QSerialPortTransactionQueue::TimeoutError);
+}
+
+void QSerialPortTransactionQueuePrivate::updateTimer()
+{
+    QDeadlineTimer earliest = QDeadlineTimer::Forever;
+    for (const Request &request : std::as_const(requestsInFlight))
+        earliest = qMin(earliest, request.deadline);
+
+    if (earliest.isForever())
+        timer->stop();
+    else
+        timer->start(int(qMin(earliest.remainingTime(),
+                              qint64(std::numeric_limits<int>::max()))));
+}
+
+void QSerialPortTransactionQueuePrivate::fail(const Request &request,
+                                              QSerialPortTransactionQueue::Error error)
+{
+    Q_Q(QSerialPortTransactionQueue);
+    emit q->requestFailed(request.requestId, error);
+}
+
+// Requests are written from sendRequest(), so the failure is reported once
+// the caller has the identifier of the request.
+void QSerialPortTransactionQueuePrivate::failLater(const Request &request,
+                                                   QSerialPortTransactionQueue::Error error)
+{
+    Q_Q(QSerialPortTransactionQueue);
+    const quint64 requestId = request.requestId;
+    QMetaObject::invokeMethod(q, [q, requestId, error]() {
+        emit q->requestFailed(requestId, error);
+    }, Qt::QueuedConnection);
+}
+
+/*!
+    Constructs a new transaction queue with the given \a parent, without a
+    port.
+
+    \sa setPort()
+*/
+QSerialPortTransactionQueue::QSerialPortTransactionQueue(QObject *parent)
+    : QSerialPortTransactionQueue(nullptr, parent)
+{
+}
+
+/*!
+    Constructs a new transaction queue with the given \a parent, which
+    sends its requests on \a port.
+*/
+QSerialPortTransactionQueue::QSerialPortTransactionQueue(QSerialPort *port, QObject *parent)
+    : QObject(*new QSerialPortTransactionQueuePrivate, parent)
+{
+    Q_D(QSerialPortTransactionQueue);
+
+    d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
+    d->timer->setTimerType(Qt::PreciseTimer);
+    connect(d->timer, &QTimer::timeout, this, [d]() {
+        d->expireRequests();
+    });
+
+    setPort(port);
+}
+
+/*!
+    Destroys the transaction queue. The pending requests are dropped, and
+    the port is not closed.
+*/
+QSerialPortTransactionQueue::~QSerialPortTransactionQueue()
+{
+}
+
+/*!
+    Sets the \a port on which the requests are sent. The requests in flight
+    on the previous port are failed with PortChangedError, and the pending
+    requests are then sent on the new port.
+*/
+void QSerialPortTransactionQueue::setPort(QSerialPort *port)
+{
+    Q_D(QSerialPortTransactionQueue);
+
+    if (d->port == port)
+        return;
+
+    disconnect(d->readyReadConnection);
+    d->port = port;
+    d->buffer.clear();
+
+    if (port) {
+        d->readyReadConnection = connect(port, &QIODevice::readyRead, this, [d]() {
+            d->readFromPort();
+        });
+    }
+
+    const QList<QSerialPortTransactionQueuePrivate::Request> dropped =
+            std::exchange(d->requestsInFlight, {});
+    for (const auto &request : dropped)
+        d->fail(request, PortChangedError);
+    d->sendPending();
+}
+
+/*!
+    Returns the port on which the requests are sent.
+*/
+QSerialPort *QSerialPortTransactionQueue::port() const
+{
+    Q_D(const QSerialPortTransactionQueue);
+    return d->port;
+}
+
+/*!
+    Sets the time to wait for a response to \a msecs milliseconds, for the
+    requests that do not specify their own timeout. A negative value waits
+    forever.
+
+    The default timeout is 1000 milliseconds.
+*/
+void QSerialPortTransactionQueue::setTimeout(int msecs)
+{
+    Q_D(QSerialPortTransactionQueue);
+    d->timeout = msecs;
+}
+
+/*!
+    Returns the time to wait for a response, in milliseconds.
+*/
+int QSerialPortTransactionQueue::timeout() const
+{
+    Q_D(const QSerialPortTransactionQueue);
+    return d->timeout;
+}
+
+/*!
+    Sets the number of requests that may be written before their responses
+    have arrived to \a count. The default is 1, which waits for every
+    response before writing the next request.
+*/
+void QSerialPortTransactionQueue::setMaximumRequestsInFlight(int count)
+{
+    Q_D(QSerialPortTransactionQueue);
+    d->maximumRequestsInFlight = qMax(count, 1);
+    d->sendPending();
+}
+
+/*!
+    Returns the number of requests that may be written before their
+    responses have arrived.
+*/
+int QSerialPortTransactionQueue::maximumRequestsInFlight() const
+{
+    Q_D(const QSerialPortTransactionQueue);
+    return d->maximumRequestsInFlight;
+}
+
+/*!
+    Queues \a request, whose response ends with \a delimiter, and returns
+    the identifier of the request. The response is reported including the
+    delimiter.
+
+    The response must arrive within \a msecs milliseconds after the request
+    was written. If \a msecs is negative, timeout() applies.
+*/
+quint64 QSerialPortTransactionQueue::sendRequest(const QByteArray &request,
+                                                 QByteArrayView delimiter, int msecs)
+{
+    Q_D(QSerialPortTransactionQueue);
+
+    QSerialPortTransactionQueuePrivate::Request entry;
+    entry.data = request;
+    entry.delimiter = delimiter.toByteArray();
+    return d->enqueue(std::move(entry), msecs);
+}
+
+/*!
+    \overload
+
+    Queues \a request, whose response is \a responseLength bytes long.
+
+    Returns 0 without queuing the request if \a responseLength is not
+    positive.
+*/
+quint64 QSerialPortTransactionQueue::sendRequest(const QByteArray &request,
+                                                 qsizetype responseLength, int msecs)
+{
+    Q_D(QSerialPortTransactionQueue);
+
+    if (responseLength <= 0) {
+        qWarning("%s: invalid response length", Q_FUNC_INFO);
+        return 0;
+    }
+
+    QSerialPortTransactionQueuePrivate::Request entry;
+    entry.data = request;
+    entry.responseLength = responseLength;
+    return d->enqueue(std::move(entry), msecs);
+}
+
+/*!
+    \overload
+
+    Queues \a request, whose response is found by \a matcher.
+*/
+quint64 QSerialPortTransactionQueue::sendRequest(const QByteArray &request,
+                                                 const ResponseMatcher &matcher, int msecs)
+{
+    Q_D(QSerialPortTransactionQueue);
+
+    QSerialPortTransactionQueuePrivate::Request entry;
+    entry.data = request;
+    entry.matcher = matcher;
+    return d->enqueue(std::move(entry), msecs);
+}
+
+/*!
+    Removes the request with the identifier \a requestId from the queue. A
+    request that was already written is not cancelled, as the device will
+    answer it anyway.
+*/
+void QSerialPortTransactionQueue::cancelRequest(quint64 requestId)
+{
+    Q_D(QSerialPortTransactionQueue);
+
+    for (qsizetype i = 0; i < d->pendingRequests.size(); ++i) {
+        if (d->pendingRequests.at(i).requestId == requestId) {
+            d->pendingRequests.removeAt(i);
+            return;
+        }
+    }
+}
+
+/*!
+    Removes all requests that were not written yet from the queue.
+*/
+void QSerialPortTransactionQueue::clear()
+{
+    Q_D(QSerialPortTransactionQueue);
+    d->pendingRequests.clear();
+}
+
+/*!
+    Returns the number of requests that were not written yet.
+*/
+qsizetype QSerialPortTransactionQueue::pendingRequestCount() const
+{
+    Q_D(const QSerialPortTransactionQueue);
+    return d->pendingRequests.size();
+}
+
+/*!
+    Returns the number of requests that were written, and wait for their
+    responses.
+*/
+qsizetype QSerialPortTransactionQueue::requestsInFlight() const
+{
+    Q_D(const QSerialPortTransactionQueue);
+    return d->requestsInFlight.size();
+}
+
+/*!
+    \fn void QSerialPortTransactionQueue::replyReceived(quint64 requestId, const QByteArray &reply, qint64 latencyNSecs)
+
+    This signal is emitted when the response \a reply to the request with
+    the identifier \a requestId has arrived. \a latencyNSecs is the time
+    between writing the request and reading the end of the response, in
+    nanoseconds.
+*/
+
+/*!
+    \fn void QSerialPortTransactionQueue::requestFailed(quint64 requestId, QSerialPortTransactionQueue::Error error)
+
+    This signal is emitted when the request with the identifier
+    \a requestId failed with \a error.
+*/
+
+QT_END_NAMESPACE
+
+#include "moc_qserialporttransactionqueue.cpp"
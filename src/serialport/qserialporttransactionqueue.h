@@ -0,0 +1,69 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTTRANSACTIONQUEUE_H
+#define QSERIALPORTTRANSACTIONQUEUE_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qobject.h>
+
+#include <QtSerialPort/qserialportglobal.h>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialPort;
+class QSerialPortTransactionQueuePrivate;
+
+class Q_SERIALPORT_EXPORT QSerialPortTransactionQueue : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QSerialPortTransactionQueue)
+
+public:
+    enum Error {
+        NoError,
+        TimeoutError,
+        ResponseError,
+        WriteError,
+        PortChangedError
+    };
+    Q_ENUM(Error)
+
+    using ResponseMatcher = std::function<qsizetype(QByteArrayView)>;
+
+    explicit QSerialPortTransactionQueue(QObject *parent = nullptr);
+    explicit QSerialPortTransactionQueue(QSerialPort *port, QObject *parent = nullptr);
+    ~QSerialPortTransactionQueue();
+
+    void setPort(QSerialPort *port);
+    QSerialPort *port() const;
+
+    void setTimeout(int msecs);
+    int timeout() const;
+
+    void setMaximumRequestsInFlight(int count);
+    int maximumRequestsInFlight() const;
+
+    quint64 sendRequest(const QByteArray &request, QByteArrayView delimiter, int msecs = -1);
+    quint64 sendRequest(const QByteArray &request, qsizetype responseLength, int msecs = -1);
+    quint64 sendRequest(const QByteArray &request, const ResponseMatcher &matcher,
+                        int msecs = -1);
+    void cancelRequest(quint64 requestId);
+    void clear();
+
+    qsizetype pendingRequestCount() const;
+    qsizetype requestsInFlight() const;
+
+Q_SIGNALS:
+    void replyReceived(quint64 requestId, const QByteArray &reply, qint64 latencyNSecs);
+    void requestFailed(quint64 requestId, QSerialPortTransactionQueue::Error error);
+
+private:
+    Q_DISABLE_COPY(QSerialPortTransactionQueue)
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTTRANSACTIONQUEUE_H
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTTRANSACTIONQUEUE_P_H
+#define QSERIALPORTTRANSACTIONQUEUE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qserialporttransactionqueue.h"
+
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qpointer.h>
+
+#include <private/qobject_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+class QSerialPortTransactionQueuePrivate : public QObjectPrivate
+{
+public:
+    Q_DECLARE_PUBLIC(QSerialPortTransactionQueue)
+
+    struct Request
+    {
+        quint64 requestId = 0;
+        QByteArray data;
+        QByteArray delimiter;
+        qsizetype responseLength = 0;
+        QSerialPortTransactionQueue::ResponseMatcher matcher;
+        int timeout = -1;
+        QDeadlineTimer deadline;
+        qint64 sentTimestamp = 0;
+    };
+
+    quint64 enqueue(Request &&request, int msecs);
+    void sendPending();
+    void readFromPort();
+    void processResponses(qint64 timestamp);
+    void expireRequests();
+    void updateTimer();
+    void fail(const Request &request, QSerialPortTransactionQueue::Error error);
+    void failLater(const Request &request, QSerialPortTransactionQueue::Error error);
+
+    qsizetype matchResponse(const Request &request) const;
+
+    QPointer<QSerialPort> port;
+    QMetaObject::Connection readyReadConnection;
+
+    QList<Request> pendingRequests;
+    QList<Request> requestsInFlight;
+    quint64 nextRequestId = 1;
+    QByteArray buffer;
+
+    QTimer *timer = nullptr;
+
+    int timeout = 1000;
+    int maximumRequestsInFlight = 1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTTRANSACTIONQUEUE_P_H
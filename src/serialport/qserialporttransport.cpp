@@ -0,0 +1,159 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qserialporttransport_p.h"
+
+#include <QtCore/qthread.h>
+#include <QtCore/qvarlengtharray.h>
+
+#include <private/qcore_unix_p.h>
+
+#include <errno.h>
+
+QT_BEGIN_NAMESPACE
+
+QSerialPortTransport::~QSerialPortTransport() = default;
+
+qint64 QSerialPortTransport::read(int descriptor, char *data, qint64 maxSize)
+{
+    return qt_safe_read(descriptor, data, maxSize);
+}
+
+qint64 QSerialPortTransport::write(int descriptor, const char *data, qint64 maxSize)
+{
+    return qt_safe_write(descriptor, data, maxSize);
+}
+
+QSerialPortFaultInjectionTransport::QSerialPortFaultInjectionTransport(quint32 seed)
+    : m_random(seed)
+{
+}
+
+bool QSerialPortFaultInjectionTransport::isDisconnected() const
+{
+    return m_disconnectAfter >= 0
+            && m_readStatistics.transferredBytes + m_writeStatistics.transferredBytes
+               >= m_disconnectAfter;
+}
+
+// Returns false, with errno set, if the call fails before any transfer.
+bool QSerialPortFaultInjectionTransport::injectCallFaults(const Faults &faults,
+                                                          Statistics *statistics)
+{
+    ++statistics->calls;
+
+    if (faults.delay > std::chrono::microseconds::zero())
+        QThread::usleep(faults.delay.count());
+
+    if (isDisconnected()) {
+        ++statistics->disconnectedCalls;
+        errno = EIO;
+        return false;
+    }
+    if (faults.wouldBlockRate > 0 && m_random.generateDouble() < faults.wouldBlockRate) {
+        ++statistics->wouldBlocks;
+        errno = EAGAIN;
+        return false;
+    }
+    return true;
+}
+
+// Drops and corrupts bytes in place, and returns the number of bytes left.
+qint64 QSerialPortFaultInjectionTransport::injectDataFaults(const Faults &faults, char *data,
+                                                            qint64 size, Statistics *statistics)
+{
+    if (faults.dropRate <= 0 && faults.corruptionRate <= 0)
+        return size;
+
+    qint64 kept = 0;
+    for (qint64 i = 0; i < size; ++i) {
+        if (faults.dropRate > 0 && m_random.generateDouble() < faults.dropRate) {
+            ++statistics->droppedBytes;
+            continue;
+        }
+        char c = data[i];
+        if (faults.corruptionRate > 0 && m_random.generateDouble() < faults.corruptionRate) {
+            c ^= char(1 << m_random.bounded(8));
+            ++statistics->corruptedBytes;
+        }
+        data[kept++] = c;
+    }
+    return kept;
+}
+
+qint64 QSerialPortFaultInjectionTransport::read(int descriptor, char *data, qint64 maxSize)
+{
+    if (!injectCallFaults(m_readFaults, &m_readStatistics))
+        return -1;
+
+    qint64 size = maxSize;
+    if (m_readFaults.maximumSize > 0)
+        size = qMin(size, m_readFaults.maximumSize);
+    if (m_disconnectAfter >= 0) {
+        size = qMin(size, m_disconnectAfter - m_readStatistics.transferredBytes
+                                            - m_writeStatistics.transferredBytes);
+    }
+
+    const qint64 bytesRead = QSerialPortTransport::read(descriptor, data, size);
+    if (bytesRead <= 0)
+        return bytesRead;
+    if (size < maxSize && bytesRead == size)
+        ++m_readStatistics.shortTransfers;
+    m_readStatistics.transferredBytes += bytesRead;
+
+    const qint64 bytesKept = injectDataFaults(m_readFaults, data, bytesRead, &m_readStatistics);
+    if (bytesKept == 0) {
+        // Everything was lost, like in an overrun; the port sees no data.
+        errno = EAGAIN;
+        return -1;
+    }
+    return bytesKept;
+}
+
+qint64 QSerialPortFaultInjectionTransport::write(int descriptor, const char *data, qint64 maxSize)
+{
+    if (!injectCallFaults(m_writeFaults, &m_writeStatistics))
+        return -1;
+
+    qint64 size = maxSize;
+    if (m_writeFaults.maximumSize > 0)
+        size = qMin(size, m_writeFaults.maximumSize);
+    if (m_disconnectAfter >= 0) {
+        size = qMin(size, m_disconnectAfter - m_readStatistics.transferredBytes
+                                            - m_writeStatistics.transferredBytes);
+    }
+
+    qint64 bytesWritten = 0;
+    if (m_writeFaults.dropRate <= 0 && m_writeFaults.corruptionRate <= 0) {
+        bytesWritten = QSerialPortTransport::write(descriptor, data, size);
+    } else {
+        // The faults apply to a copy, and the offsets of the bytes kept in
+        // it map a short write back to the bytes consumed from the caller.
+        QVarLengthArray<char, 4096> copy;
+        QVarLengthArray<qint64, 4096> offsets;
+        for (qint64 i = 0; i < size; ++i) {
+            char c = data[i];
+            if (injectDataFaults(m_writeFaults, &c, 1, &m_writeStatistics)) {
+                copy.append(c);
+                offsets.append(i);
+            }
+        }
+
+        const qint64 kept = copy.size();
+        const qint64 keptWritten = kept ? QSerialPortTransport::write(descriptor, copy.constData(),
+                                                                      kept)
+                                        : 0;
+        if (keptWritten < 0)
+            return keptWritten;
+        bytesWritten = keptWritten < kept ? offsets.at(keptWritten) : size;
+    }
+
+    if (bytesWritten <= 0)
+        return bytesWritten;
+    if (size < maxSize)
+        ++m_writeStatistics.shortTransfers;
+    m_writeStatistics.transferredBytes += bytesWritten;
+    return bytesWritten;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,103 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSERIALPORTTRANSPORT_P_H
+#define QSERIALPORTTRANSPORT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSerialPort/qserialportglobal.h>
+
+#include <QtCore/qrandom.h>
+
+#include <chrono>
+
+QT_BEGIN_NAMESPACE
+
+// The layer through which QSerialPortPrivate reads from and writes to the
+// descriptor of an open port. Failures are reported like the system calls
+// do, by returning -1 and setting errno.
+class Q_AUTOTEST_EXPORT QSerialPortTransport
+{
+public:
+    virtual ~QSerialPortTransport();
+
+    virtual qint64 read(int descriptor, char *data, qint64 maxSize);
+    virtual qint64 write(int descriptor, const char *data, qint64 maxSize);
+};
+
+// Injects the faults of flaky hardware and drivers into the I/O of a port,
+// deterministically for a given seed. Used from the thread of the port.
+class Q_AUTOTEST_EXPORT QSerialPortFaultInjectionTransport : public QSerialPortTransport
+{
+public:
+    struct Faults
+    {
+        // At most this many bytes are transferred per call, 0 for no limit.
+        qint64 maximumSize = 0;
+        // Every call is delayed by this long, as by a slow driver.
+        std::chrono::microseconds delay = std::chrono::microseconds::zero();
+        // The probabilities of a call failing with EAGAIN, and of each
+        // transferred byte being lost, or having a bit flipped.
+        double wouldBlockRate = 0;
+        double dropRate = 0;
+        double corruptionRate = 0;
+    };
+
+    struct Statistics
+    {
+        qint64 calls = 0;
+        qint64 wouldBlocks = 0;
+        qint64 shortTransfers = 0;
+        qint64 transferredBytes = 0;
+        qint64 droppedBytes = 0;
+        qint64 corruptedBytes = 0;
+        qint64 disconnectedCalls = 0;
+    };
+
+    explicit QSerialPortFaultInjectionTransport(quint32 seed = 1);
+
+    void setReadFaults(const Faults &faults) { m_readFaults = faults; }
+    Faults readFaults() const { return m_readFaults; }
+    void setWriteFaults(const Faults &faults) { m_writeFaults = faults; }
+    Faults writeFaults() const { return m_writeFaults; }
+
+    // From the given number of transferred bytes on, or right away, all
+    // calls fail with EIO, like they do for an unplugged device.
+    void setDisconnectAfter(qint64 bytes) { m_disconnectAfter = bytes; }
+    void disconnect() { m_disconnectAfter = m_readStatistics.transferredBytes
+                                            + m_writeStatistics.transferredBytes; }
+    void reconnect() { m_disconnectAfter = -1; }
+    bool isDisconnected() const;
+
+    Statistics readStatistics() const { return m_readStatistics; }
+    Statistics writeStatistics() const { return m_writeStatistics; }
+
+    qint64 read(int descriptor, char *data, qint64 maxSize) override;
+    qint64 write(int descriptor, const char *data, qint64 maxSize) override;
+
+private:
+    bool injectCallFaults(const Faults &faults, Statistics *statistics);
+    qint64 injectDataFaults(const Faults &faults, char *data, qint64 size,
+                            Statistics *statistics);
+
+    QRandomGenerator m_random;
+    Faults m_readFaults;
+    Faults m_writeFaults;
+    Statistics m_readStatistics;
+    Statistics m_writeStatistics;
+    qint64 m_disconnectAfter = -1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSERIALPORTTRANSPORT_P_H
@@ -56,6 +56,7 @@ GENERATE_SYMBOL_VARIABLE(struct udev_device *, udev_device_new_from_syspath, str
 GENERATE_SYMBOL_VARIABLE(const char *, udev_list_entry_get_name, struct udev_list_entry *)
 GENERATE_SYMBOL_VARIABLE(const char *, udev_device_get_devnode, struct udev_device *)
 GENERATE_SYMBOL_VARIABLE(const char *, udev_device_get_sysname, struct udev_device *)
+GENERATE_SYMBOL_VARIABLE(const char *, udev_device_get_syspath, struct udev_device *)
 GENERATE_SYMBOL_VARIABLE(const char *, udev_device_get_driver, struct udev_device *)
 GENERATE_SYMBOL_VARIABLE(struct udev_device *, udev_device_get_parent, struct udev_device *)
 GENERATE_SYMBOL_VARIABLE(const char *, udev_device_get_subsystem, struct udev_device *)
@@ -96,6 +97,7 @@ inline bool resolveSymbols(QLibrary *udevLibrary)
     RESOLVE_SYMBOL(udev_list_entry_get_name)
     RESOLVE_SYMBOL(udev_device_get_devnode)
     RESOLVE_SYMBOL(udev_device_get_sysname)
+    RESOLVE_SYMBOL(udev_device_get_syspath)
     RESOLVE_SYMBOL(udev_device_get_driver)
     RESOLVE_SYMBOL(udev_device_get_parent)
     RESOLVE_SYMBOL(udev_device_get_subsystem)
@@ -5,14 +5,27 @@
 #include <QtSerialPort/QSerialPort>
 #include <QtSerialPort/QSerialPortInfo>
 
+#include <QScopeGuard>
 #include <QThread>
 
+#include <memory>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include "../../shared/qserialportptypair.h"
+
 Q_DECLARE_METATYPE(QSerialPort::SerialPortError);
 Q_DECLARE_METATYPE(QSerialPort::BaudRate);
 Q_DECLARE_METATYPE(QSerialPort::DataBits);
 Q_DECLARE_METATYPE(QSerialPort::Parity);
 Q_DECLARE_METATYPE(QSerialPort::StopBits);
 Q_DECLARE_METATYPE(QSerialPort::FlowControl);
+Q_DECLARE_METATYPE(QSerialPort::LockingPolicy);
 Q_DECLARE_METATYPE(QIODevice::OpenMode);
 Q_DECLARE_METATYPE(QIODevice::OpenModeFlag);
 Q_DECLARE_METATYPE(Qt::ConnectionType);
@@ -59,6 +72,8 @@ private slots:
     void openExisting();
     void openNotExisting_data();
     void openNotExisting();
+    void openWithLockingPolicy_data();
+    void openWithLockingPolicy();
 
     void baudRate_data();
     void baudRate();
@@ -104,9 +119,15 @@ private slots:
 
     void clearAfterOpen();
 
+    void suspendAndReopen();
+
     void readWriteWithDifferentBaudRate_data();
     void readWriteWithDifferentBaudRate();
 
+    void latencyRecording();
+
+    void idleMemoryMode();
+
     void bindingsAndProperties();
 
 protected slots:
@@ -117,6 +138,7 @@ private:
     QString m_senderPortName;
     QString m_receiverPortName;
     QStringList m_availablePortNames;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
 
     static int loopLevel;
     static const QByteArray alphabetArray;
@@ -135,27 +157,10 @@ tst_QSerialPort::tst_QSerialPort()
 
 void tst_QSerialPort::initTestCase()
 {
-    m_senderPortName = QString::fromLocal8Bit(qgetenv("QTEST_SERIALPORT_SENDER"));
-    m_receiverPortName = QString::fromLocal8Bit(qgetenv("QTEST_SERIALPORT_RECEIVER"));
-    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty()) {
-        static const char message[] =
-              "Test doesn't work because the names of serial ports aren't found in env.\n"
-              "Please set environment variables:\n"
-              " QTEST_SERIALPORT_SENDER to name of output serial port\n"
-              " QTEST_SERIALPORT_RECEIVER to name of input serial port\n"
-              "Specify short names of port"
-#if defined(Q_OS_UNIX)
-              ", like: ttyS0\n";
-#elif defined(Q_OS_WIN32)
-              ", like: COM1\n";
-#else
-              "\n";
-#endif
-
-        QSKIP(message);
-    } else {
-        m_availablePortNames << m_senderPortName << m_receiverPortName;
-    }
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+    m_availablePortNames << m_senderPortName << m_receiverPortName;
 }
 
 void tst_QSerialPort::defaultConstruct()
@@ -174,6 +179,7 @@ void tst_QSerialPort::defaultConstruct()
     QCOMPARE(serialPort.parity(), QSerialPort::NoParity);
     QCOMPARE(serialPort.stopBits(), QSerialPort::OneStop);
     QCOMPARE(serialPort.flowControl(), QSerialPort::NoFlowControl);
+    QCOMPARE(serialPort.lockingPolicy(), QSerialPort::LockFileLocking);
 
     QCOMPARE(serialPort.pinoutSignals(), QSerialPort::NoSignal);
     QCOMPARE(serialPort.isRequestToSend(), false);
@@ -293,6 +299,79 @@ void tst_QSerialPort::openNotExisting()
     //QCOMPARE(qvariant_cast<QSerialPort::SerialPortError>(errorSpy.at(0).at(0)), errorCode);
 }
 
+void tst_QSerialPort::openWithLockingPolicy_data()
+{
+    QTest::addColumn<QSerialPort::LockingPolicy>("lockingPolicy");
+    QTest::addColumn<bool>("secondOpenResult");
+
+#if defined(Q_OS_UNIX)
+    QTest::newRow("LockFileLocking") << QSerialPort::LockFileLocking << false;
+    QTest::newRow("FlockLocking") << QSerialPort::FlockLocking << false;
+    QTest::newRow("ExclusiveModeLocking") << QSerialPort::ExclusiveModeLocking << false;
+#endif
+    QTest::newRow("NoLocking") << QSerialPort::NoLocking << true;
+}
+
+void tst_QSerialPort::openWithLockingPolicy()
+{
+    QFETCH(QSerialPort::LockingPolicy, lockingPolicy);
+    QFETCH(bool, secondOpenResult);
+
+#if defined(Q_OS_WIN32)
+    // The system always grants exclusive access.
+    secondOpenResult = false;
+#elif defined(Q_OS_UNIX)
+    if (lockingPolicy == QSerialPort::ExclusiveModeLocking && ::geteuid() == 0)
+        QSKIP("The exclusive mode of a device does not keep out the superuser");
+
+    // The exclusive mode set by the port refuses later opens by itself, so
+    // open the device beforehand to see the lock of the descriptor.
+    int observer = -1;
+    if (lockingPolicy == QSerialPort::FlockLocking) {
+        const QByteArray location = (m_senderPortName.startsWith(QLatin1Char('/'))
+                                     ? m_senderPortName
+                                     : QLatin1String("/dev/") + m_senderPortName).toLocal8Bit();
+        observer = ::open(location.constData(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        QVERIFY2(observer != -1, qPrintable(qt_error_string(errno)));
+    }
+    const auto closeObserver = qScopeGuard([observer]() {
+        if (observer != -1)
+            ::close(observer);
+    });
+#endif
+
+    QSerialPort serialPort(m_senderPortName);
+    serialPort.setLockingPolicy(lockingPolicy);
+    QCOMPARE(serialPort.lockingPolicy(), lockingPolicy);
+    QVERIFY(serialPort.open(QIODevice::ReadWrite));
+
+#if defined(Q_OS_UNIX)
+    if (observer != -1) {
+        QCOMPARE(::flock(observer, LOCK_EX | LOCK_NB), -1);
+        QCOMPARE(errno, EWOULDBLOCK);
+    }
+#endif
+
+    QSerialPort secondSerialPort(m_senderPortName);
+    secondSerialPort.setLockingPolicy(lockingPolicy);
+    QCOMPARE(secondSerialPort.open(QIODevice::ReadWrite), secondOpenResult);
+    if (!secondOpenResult) {
+        QCOMPARE(secondSerialPort.error(), QSerialPort::PermissionError);
+
+        // The port is unlocked as it was locked, whatever the policy is by
+        // the time it is closed.
+        serialPort.setLockingPolicy(QSerialPort::NoLocking);
+        serialPort.close();
+#if defined(Q_OS_UNIX)
+        if (observer != -1) {
+            QCOMPARE(::flock(observer, LOCK_EX | LOCK_NB), 0);
+            QCOMPARE(::flock(observer, LOCK_UN), 0);
+        }
+#endif
+        QVERIFY(secondSerialPort.open(QIODevice::ReadWrite));
+    }
+}
+
 void tst_QSerialPort::baudRate_data()
 {
     QTest::addColumn<qint32>("baudrate");
@@ -452,6 +531,9 @@ void tst_QSerialPort::flowControl()
 
 void tst_QSerialPort::rts()
 {
+    if (m_ptyPair)
+        QSKIP("Pseudo terminals have no modem control lines");
+
     QSerialPort serialPort(m_senderPortName);
 
     QSignalSpy errorSpy(&serialPort, &QSerialPort::errorOccurred);
@@ -491,6 +573,9 @@ void tst_QSerialPort::rts()
 
 void tst_QSerialPort::dtr()
 {
+    if (m_ptyPair)
+        QSKIP("Pseudo terminals have no modem control lines");
+
     QSerialPort serialPort(m_senderPortName);
 
     QSignalSpy errorSpy(&serialPort, &QSerialPort::errorOccurred);
@@ -529,6 +614,9 @@ void tst_QSerialPort::dtr()
 
 void tst_QSerialPort::independenceRtsAndDtr()
 {
+    if (m_ptyPair)
+        QSKIP("Pseudo terminals have no modem control lines");
+
     QSerialPort serialPort(m_senderPortName);
     QVERIFY(serialPort.open(QIODevice::ReadWrite)); // No flow control by default!
 
@@ -1147,6 +1235,9 @@ private:
 
 void tst_QSerialPort::controlBreak()
 {
+    if (m_ptyPair)
+        QSKIP("Pseudo terminals do not transmit breaks");
+
     QSerialPort senderPort(m_senderPortName);
     QVERIFY(senderPort.open(QSerialPort::WriteOnly));
     QCOMPARE(senderPort.isBreakEnabled(), false);
@@ -1187,6 +1278,48 @@ void tst_QSerialPort::clearAfterOpen()
     QCOMPARE(senderPort.error(), QSerialPort::NoError);
 }
 
+void tst_QSerialPort::suspendAndReopen()
+{
+    const int waitMsecs = 50;
+
+    QSerialPort senderSerialPort(m_senderPortName);
+    QVERIFY(senderSerialPort.open(QIODevice::WriteOnly));
+#if defined(Q_OS_UNIX)
+    const QSerialPort::Handle handle = senderSerialPort.handle();
+    QVERIFY(senderSerialPort.suspend());
+    QVERIFY(!senderSerialPort.isOpen());
+    QVERIFY(senderSerialPort.isSuspended());
+    QCOMPARE(senderSerialPort.handle(), handle);
+
+    QVERIFY(senderSerialPort.setBaudRate(QSerialPort::Baud115200));
+    QVERIFY(senderSerialPort.open(QIODevice::WriteOnly));
+    QVERIFY(!senderSerialPort.isSuspended());
+    QCOMPARE(senderSerialPort.handle(), handle);
+    QCOMPARE(senderSerialPort.error(), QSerialPort::NoError);
+
+    QSerialPort receiverSerialPort(m_receiverPortName);
+    receiverSerialPort.setBaudRate(QSerialPort::Baud115200);
+    QVERIFY(receiverSerialPort.open(QIODevice::ReadOnly));
+    QCOMPARE(senderSerialPort.write(alphabetArray), qint64(alphabetArray.size()));
+    QVERIFY(senderSerialPort.waitForBytesWritten(waitMsecs));
+    QVERIFY(receiverSerialPort.waitForReadyRead(waitMsecs));
+
+    // A different access mode opens the device again.
+    QVERIFY(senderSerialPort.suspend());
+    QVERIFY(senderSerialPort.open(QIODevice::ReadWrite));
+    QVERIFY(!senderSerialPort.isSuspended());
+
+    QVERIFY(senderSerialPort.suspend());
+    senderSerialPort.close();
+    QVERIFY(!senderSerialPort.isSuspended());
+    QCOMPARE(senderSerialPort.handle(), QSerialPort::Handle(-1));
+#else
+    QVERIFY(!senderSerialPort.suspend());
+    QCOMPARE(senderSerialPort.error(), QSerialPort::UnsupportedOperationError);
+    QVERIFY(senderSerialPort.isOpen());
+#endif
+}
+
 void tst_QSerialPort::readWriteWithDifferentBaudRate_data()
 {
     QTest::addColumn<int>("senderBaudRate");
@@ -1212,6 +1345,9 @@ void tst_QSerialPort::readWriteWithDifferentBaudRate()
     QFETCH(int, receiverBaudRate);
     QFETCH(bool, expectedResult);
 
+    if (m_ptyPair && !expectedResult)
+        QSKIP("Pseudo terminals transfer the data regardless of the baud rate");
+
     {
         // setup before opening
         QSerialPort senderSerialPort(m_senderPortName);
@@ -1261,6 +1397,90 @@ void tst_QSerialPort::readWriteWithDifferentBaudRate()
     }
 }
 
+void tst_QSerialPort::latencyRecording()
+{
+    QSerialPort senderPort(m_senderPortName);
+    QVERIFY(senderPort.open(QSerialPort::WriteOnly));
+
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(!receiverPort.isLatencyRecordingEnabled());
+    QVERIFY(receiverPort.latencyHistogram(QSerialPort::ReadLatency).isEmpty());
+    receiverPort.setLatencyRecordingEnabled(true);
+    QVERIFY(receiverPort.isLatencyRecordingEnabled());
+    QVERIFY(receiverPort.open(QSerialPort::ReadOnly));
+
+    // A slow handler must show up in the handler stage.
+    QByteArray readData;
+    connect(&receiverPort, &QSerialPort::readyRead, [&]() {
+        readData += receiverPort.readAll();
+        QTest::qSleep(5);
+    });
+
+    QCOMPARE(senderPort.write(alphabetArray), qint64(alphabetArray.size()));
+    QVERIFY2(senderPort.waitForBytesWritten(500), "Waiting for bytes written failed");
+    QTRY_COMPARE(readData, alphabetArray);
+
+    const QSerialPortLatencyHistogram handler =
+            receiverPort.latencyHistogram(QSerialPort::ReadyReadLatency);
+    QVERIFY(!handler.isEmpty());
+    QVERIFY(handler.minimum() >= 5000000);
+    QVERIFY(handler.minimum() <= handler.mean());
+    QVERIFY(handler.mean() <= handler.maximum());
+    QVERIFY(handler.percentile(50) >= handler.minimum());
+    QCOMPARE(handler.percentile(100), handler.maximum());
+
+    const QSerialPortLatencyHistogram notification =
+            receiverPort.latencyHistogram(QSerialPort::NotificationLatency);
+    QCOMPARE(notification.count(), handler.count());
+    QVERIFY(notification.minimum() >= handler.minimum());
+    QCOMPARE(receiverPort.latencyHistogram(QSerialPort::ReadLatency).count(), handler.count());
+    QCOMPARE(receiverPort.latencyHistogram(QSerialPort::QueueLatency).count(), handler.count());
+
+    receiverPort.resetLatencyHistograms();
+    QVERIFY(receiverPort.latencyHistogram(QSerialPort::ReadyReadLatency).isEmpty());
+}
+
+void tst_QSerialPort::idleMemoryMode()
+{
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(!senderPort.isIdleMemoryModeEnabled());
+    QVERIFY(senderPort.memoryFootprint() > 0);
+    senderPort.setIdleMemoryModeEnabled(true);
+    receiverPort.setIdleMemoryModeEnabled(true);
+    QVERIFY(senderPort.isIdleMemoryModeEnabled());
+    QVERIFY(senderPort.open(QSerialPort::WriteOnly));
+    QVERIFY(receiverPort.open(QSerialPort::ReadOnly));
+
+    qint64 bytesWritten = 0;
+    connect(&senderPort, &QSerialPort::bytesWritten, [&bytesWritten](qint64 bytes) {
+        bytesWritten += bytes;
+    });
+    QByteArray readData;
+    connect(&receiverPort, &QSerialPort::readyRead, [&]() {
+        readData += receiverPort.readAll();
+    });
+
+    // Small writes are taken at once, large ones stall and go on from the
+    // write notifier.
+    QByteArray data = alphabetArray;
+    QCOMPARE(senderPort.write(alphabetArray), qint64(alphabetArray.size()));
+    QTRY_COMPARE(bytesWritten, qint64(data.size()));
+    const QByteArray largeData(20000, 'x');
+    data += largeData;
+    QCOMPARE(senderPort.write(largeData), qint64(largeData.size()));
+    QTRY_COMPARE(bytesWritten, qint64(data.size()));
+    QTRY_COMPARE(readData, data);
+
+    // The blocking API does not depend on the event loop.
+    QCOMPARE(senderPort.write(alphabetArray), qint64(alphabetArray.size()));
+    QVERIFY2(senderPort.waitForBytesWritten(500), "Waiting for bytes written failed");
+    data += alphabetArray;
+    QTRY_COMPARE(readData, data);
+    QCOMPARE(senderPort.error(), QSerialPort::NoError);
+    QCOMPARE(receiverPort.error(), QSerialPort::NoError);
+}
+
 void tst_QSerialPort::bindingsAndProperties()
 {
     QSerialPort sp;
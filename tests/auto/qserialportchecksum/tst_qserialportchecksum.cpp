@@ -0,0 +1,102 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPortChecksum>
+
+Q_DECLARE_METATYPE(QSerialPortChecksum::Algorithm);
+
+class tst_QSerialPortChecksum : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortChecksum();
+
+private slots:
+    void checkValue_data();
+    void checkValue();
+    void incremental_data();
+    void incremental();
+    void size();
+};
+
+tst_QSerialPortChecksum::tst_QSerialPortChecksum()
+{
+}
+
+void tst_QSerialPortChecksum::checkValue_data()
+{
+    QTest::addColumn<QSerialPortChecksum::Algorithm>("algorithm");
+    QTest::addColumn<quint32>("check");
+
+    QTest::newRow("Crc8") << QSerialPortChecksum::Crc8 << quint32(0xF4);
+    QTest::newRow("Crc8Maxim") << QSerialPortChecksum::Crc8Maxim << quint32(0xA1);
+    QTest::newRow("Crc16Modbus") << QSerialPortChecksum::Crc16Modbus << quint32(0x4B37);
+    QTest::newRow("Crc16CcittFalse") << QSerialPortChecksum::Crc16CcittFalse << quint32(0x29B1);
+    QTest::newRow("Crc16Kermit") << QSerialPortChecksum::Crc16Kermit << quint32(0x2189);
+    QTest::newRow("Crc16Xmodem") << QSerialPortChecksum::Crc16Xmodem << quint32(0x31C3);
+    QTest::newRow("Crc16X25") << QSerialPortChecksum::Crc16X25 << quint32(0x906E);
+    QTest::newRow("Crc32") << QSerialPortChecksum::Crc32 << quint32(0xCBF43926);
+    QTest::newRow("Crc32C") << QSerialPortChecksum::Crc32C << quint32(0xE3069283);
+    QTest::newRow("Lrc") << QSerialPortChecksum::Lrc << quint32(0x23);
+    QTest::newRow("Xor") << QSerialPortChecksum::Xor << quint32(0x31);
+}
+
+void tst_QSerialPortChecksum::checkValue()
+{
+    QFETCH(QSerialPortChecksum::Algorithm, algorithm);
+    QFETCH(quint32, check);
+
+    QCOMPARE(QSerialPortChecksum::checksum("123456789", algorithm), check);
+
+    QSerialPortChecksum checksum(algorithm);
+    QCOMPARE(checksum.algorithm(), algorithm);
+    checksum.addData("garbage");
+    checksum.reset();
+    checksum.addData("123456789");
+    QCOMPARE(checksum.result(), check);
+}
+
+void tst_QSerialPortChecksum::incremental_data()
+{
+    checkValue_data();
+}
+
+// The checksum must not depend on how the data is split, so that it may be
+// computed over the blocks of a ring buffer. The sizes cover the vectorized
+// code paths, which process 8, 16 and 64 bytes at a time.
+void tst_QSerialPortChecksum::incremental()
+{
+    QFETCH(QSerialPortChecksum::Algorithm, algorithm);
+
+    QByteArray data(4099, Qt::Uninitialized);
+    for (qsizetype i = 0; i < data.size(); ++i)
+        data[i] = char((i * 7919) >> 3);
+
+    for (qsizetype size : {0, 1, 7, 8, 15, 16, 63, 64, 65, 127, 128, 1000, 4099}) {
+        const QByteArrayView view(data.constData(), size);
+        const quint32 expected = QSerialPortChecksum::checksum(view, algorithm);
+
+        for (qsizetype chunkSize : {1, 3, 17, 64, 333}) {
+            QSerialPortChecksum checksum(algorithm);
+            for (qsizetype offset = 0; offset < size; offset += chunkSize)
+                checksum.addData(view.sliced(offset, qMin(chunkSize, size - offset)));
+            QCOMPARE(checksum.result(), expected);
+        }
+    }
+}
+
+void tst_QSerialPortChecksum::size()
+{
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Crc8), 1);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Crc8Maxim), 1);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Crc16Modbus), 2);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Crc16Xmodem), 2);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Crc32), 4);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Crc32C), 4);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Lrc), 1);
+    QCOMPARE(QSerialPortChecksum::size(QSerialPortChecksum::Xor), 1);
+}
+
+QTEST_MAIN(tst_QSerialPortChecksum)
+#include "tst_qserialportchecksum.moc"
@@ -0,0 +1,370 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortFileTransfer>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+class tst_QSerialPortFileTransfer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortFileTransfer();
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void xmodemChecksum();
+    void xmodem1K();
+    void ymodemBatch();
+    void zmodem();
+    void receiverCancel();
+
+private:
+    QString createFile(const QByteArray &content);
+    QByteArray readBlock(quint8 blockNumber, bool crc);
+    QByteArray readZmodem(qsizetype size);
+    void writeHexHeader(quint8 type, quint32 value);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+    QSerialPort *m_senderPort = nullptr;
+    QSerialPort *m_receiverPort = nullptr;
+    QTemporaryDir m_dir;
+};
+
+// A straightforward bitwise implementation, to cross-check the transfer.
+static quint16 crc16(const QByteArray &data)
+{
+    quint16 crc = 0;
+    for (char byte : data) {
+        crc ^= quint16(quint8(byte) << 8);
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 0x8000) ? quint16((crc << 1) ^ 0x1021) : quint16(crc << 1);
+    }
+    return crc;
+}
+
+static QByteArray testData(qsizetype size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; ++i)
+        data[i] = char((i * 7 + i / 251) & 0xFF);
+    return data;
+}
+
+tst_QSerialPortFileTransfer::tst_QSerialPortFileTransfer()
+{
+}
+
+void tst_QSerialPortFileTransfer::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+    QVERIFY(m_dir.isValid());
+}
+
+void tst_QSerialPortFileTransfer::init()
+{
+    m_senderPort = new QSerialPort(m_senderPortName, this);
+    m_receiverPort = new QSerialPort(m_receiverPortName, this);
+    m_senderPort->setBaudRate(QSerialPort::Baud115200);
+    m_receiverPort->setBaudRate(QSerialPort::Baud115200);
+    QVERIFY(m_senderPort->open(QIODevice::ReadWrite));
+    QVERIFY(m_receiverPort->open(QIODevice::ReadWrite));
+}
+
+void tst_QSerialPortFileTransfer::cleanup()
+{
+    delete m_senderPort;
+    m_senderPort = nullptr;
+    delete m_receiverPort;
+    m_receiverPort = nullptr;
+}
+
+QString tst_QSerialPortFileTransfer::createFile(const QByteArray &content)
+{
+    static int count = 0;
+    const QString fileName = m_dir.filePath(QStringLiteral("file%1.bin").arg(++count));
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+        return QString();
+    return fileName;
+}
+
+// Reads an XMODEM block on the receiver port, and returns its payload.
+QByteArray tst_QSerialPortFileTransfer::readBlock(quint8 blockNumber, bool crc)
+{
+    if (!QTest::qWaitFor([this]() { return m_receiverPort->bytesAvailable() >= 3; }))
+        return QByteArray();
+    const QByteArray header = m_receiverPort->peek(3);
+    const qsizetype payloadSize = header.at(0) == 0x02 ? 1024 : 128;
+    const qsizetype blockSize = 3 + payloadSize + (crc ? 2 : 1);
+    if (!QTest::qWaitFor([&]() { return m_receiverPort->bytesAvailable() >= blockSize; }))
+        return QByteArray();
+
+    const QByteArray block = m_receiverPort->read(blockSize);
+    if (quint8(block.at(1)) != blockNumber || quint8(block.at(2)) != quint8(~blockNumber))
+        return QByteArray();
+    const QByteArray payload = block.mid(3, payloadSize);
+    if (crc) {
+        if (crc16(block.mid(3)) != 0)
+            return QByteArray();
+    } else {
+        quint8 sum = 0;
+        for (char c : payload)
+            sum += quint8(c);
+        if (sum != quint8(block.back()))
+            return QByteArray();
+    }
+    return payload;
+}
+
+void tst_QSerialPortFileTransfer::writeHexHeader(quint8 type, quint32 value)
+{
+    QByteArray bytes(1, char(type));
+    for (int i = 0; i < 4; ++i)
+        bytes.append(char(value >> (8 * i)));
+    const quint16 crc = crc16(bytes);
+    bytes.append(char(crc >> 8));
+    bytes.append(char(crc & 0xFF));
+    m_receiverPort->write("**\x18" "B" + bytes.toHex() + "\r\n");
+}
+
+// Reads ZMODEM data subpackets with a 16-bit CRC until the end of the
+// frame, and returns the unescaped data.
+QByteArray tst_QSerialPortFileTransfer::readZmodem(qsizetype size)
+{
+    QByteArray stream;
+    QByteArray data;
+    QByteArray subpacket;
+    qsizetype i = 0;
+    const auto next = [&]() -> int {
+        if (i >= stream.size()) {
+            if (!QTest::qWaitFor([this]() { return m_receiverPort->bytesAvailable() > 0; }))
+                return -1;
+            stream.append(m_receiverPort->readAll());
+        }
+        return quint8(stream.at(i++));
+    };
+
+    // Skip the ZDATA header: ZPAD ZDLE 'A' and 7 escaped bytes.
+    for (int c = next(); c != 0x18; c = next()) {
+        if (c < 0)
+            return QByteArray();
+    }
+    next();
+    for (int n = 0; n < 7; ++n) {
+        if (next() == 0x18)
+            next();
+    }
+
+    for (;;) {
+        int c = next();
+        if (c < 0)
+            return QByteArray();
+        if (c == 0x18) {
+            c = next();
+            if (c >= 'h' && c <= 'k') {
+                subpacket.append(char(c));
+                QByteArray crc;
+                while (crc.size() < 2) {
+                    int b = next();
+                    if (b == 0x18)
+                        b = next() ^ 0x40;
+                    crc.append(char(b));
+                }
+                if (crc16(subpacket + crc) != 0)
+                    return QByteArray();
+                subpacket.chop(1);
+                data.append(subpacket);
+                subpacket.clear();
+                if (c == 'h' || data.size() >= size)
+                    return data;
+                continue;
+            }
+            c ^= 0x40;
+        }
+        subpacket.append(char(c));
+    }
+}
+
+void tst_QSerialPortFileTransfer::xmodemChecksum()
+{
+    const QByteArray content = testData(300);
+    const QString fileName = createFile(content);
+    QVERIFY(!fileName.isEmpty());
+
+    QSerialPortFileTransfer transfer(m_senderPort);
+    transfer.setProtocol(QSerialPortFileTransfer::Xmodem);
+    QSignalSpy finishedSpy(&transfer, &QSerialPortFileTransfer::finished);
+    QVERIFY(transfer.sendFile(fileName));
+
+    // NAK asks for the arithmetic checksum.
+    m_receiverPort->write("\x15");
+    QByteArray received;
+    for (quint8 blockNumber = 1; blockNumber <= 3; ++blockNumber) {
+        const QByteArray payload = readBlock(blockNumber, false);
+        QCOMPARE(payload.size(), 128);
+        received.append(payload);
+        m_receiverPort->write("\x06");
+    }
+    QTRY_COMPARE(m_receiverPort->bytesAvailable(), qint64(1));
+    QCOMPARE(m_receiverPort->read(1), QByteArray("\x04"));
+    m_receiverPort->write("\x06");
+
+    QTRY_COMPARE(finishedSpy.size(), 1);
+    QCOMPARE(received.left(content.size()), content);
+    QCOMPARE(received.mid(content.size()), QByteArray(84, 0x1A));
+}
+
+void tst_QSerialPortFileTransfer::xmodem1K()
+{
+    const QByteArray content = testData(2100);
+    const QString fileName = createFile(content);
+    QVERIFY(!fileName.isEmpty());
+
+    QSerialPortFileTransfer transfer(m_senderPort);
+    transfer.setProtocol(QSerialPortFileTransfer::Xmodem1K);
+    QSignalSpy finishedSpy(&transfer, &QSerialPortFileTransfer::finished);
+    QVERIFY(transfer.sendFile(fileName));
+
+    m_receiverPort->write("C");
+    QCOMPARE(readBlock(1, true), content.left(1024));
+    // A rejected block is sent again.
+    m_receiverPort->write("\x15");
+    QCOMPARE(readBlock(1, true), content.left(1024));
+    m_receiverPort->write("\x06");
+    QCOMPARE(readBlock(2, true), content.mid(1024, 1024));
+    m_receiverPort->write("\x06");
+    QCOMPARE(readBlock(3, true).left(52), content.mid(2048));
+    m_receiverPort->write("\x06");
+
+    // The first EOT is rejected, as many receivers do.
+    QTRY_COMPARE(m_receiverPort->bytesAvailable(), qint64(1));
+    QCOMPARE(m_receiverPort->read(1), QByteArray("\x04"));
+    m_receiverPort->write("\x15");
+    QTRY_COMPARE(m_receiverPort->bytesAvailable(), qint64(1));
+    QCOMPARE(m_receiverPort->read(1), QByteArray("\x04"));
+    m_receiverPort->write("\x06");
+
+    QTRY_COMPARE(finishedSpy.size(), 1);
+}
+
+void tst_QSerialPortFileTransfer::ymodemBatch()
+{
+    const QList<QByteArray> contents = { testData(1500), testData(10) };
+    QStringList fileNames;
+    for (const QByteArray &content : contents) {
+        fileNames.append(createFile(content));
+        QVERIFY(!fileNames.constLast().isEmpty());
+    }
+
+    QSerialPortFileTransfer transfer(m_senderPort);
+    transfer.setProtocol(QSerialPortFileTransfer::Ymodem);
+    QSignalSpy sentSpy(&transfer, &QSerialPortFileTransfer::fileSent);
+    QSignalSpy finishedSpy(&transfer, &QSerialPortFileTransfer::finished);
+    QVERIFY(transfer.sendFiles(fileNames));
+
+    for (qsizetype i = 0; i < contents.size(); ++i) {
+        const QByteArray &content = contents.at(i);
+        m_receiverPort->write("C");
+        const QByteArray header = readBlock(0, true);
+        const QList<QByteArray> fields = header.split('\0');
+        QCOMPARE(fields.at(0), QFileInfo(fileNames.at(i)).fileName().toLocal8Bit());
+        QCOMPARE(fields.at(1).split(' ').at(0), QByteArray::number(content.size()));
+        m_receiverPort->write("\x06");
+
+        m_receiverPort->write("C");
+        QByteArray received;
+        for (quint8 blockNumber = 1; received.size() < content.size(); ++blockNumber) {
+            const QByteArray payload = readBlock(blockNumber, true);
+            QVERIFY(!payload.isEmpty());
+            received.append(payload);
+            m_receiverPort->write("\x06");
+        }
+        QCOMPARE(received.left(content.size()), content);
+
+        QTRY_COMPARE(m_receiverPort->bytesAvailable(), qint64(1));
+        QCOMPARE(m_receiverPort->read(1), QByteArray("\x04"));
+        m_receiverPort->write("\x06");
+    }
+
+    // An empty header block ends the batch.
+    m_receiverPort->write("C");
+    QCOMPARE(readBlock(0, true), QByteArray(128, 0));
+    m_receiverPort->write("\x06");
+
+    QTRY_COMPARE(finishedSpy.size(), 1);
+    QCOMPARE(sentSpy.size(), 2);
+}
+
+void tst_QSerialPortFileTransfer::zmodem()
+{
+    const QByteArray content = testData(5000);
+    const QString fileName = createFile(content);
+    QVERIFY(!fileName.isEmpty());
+
+    QSerialPortFileTransfer transfer(m_senderPort);
+    transfer.setProtocol(QSerialPortFileTransfer::Zmodem);
+    QSignalSpy finishedSpy(&transfer, &QSerialPortFileTransfer::finished);
+    QVERIFY(transfer.sendFile(fileName));
+
+    // "rz\r" and ZRQINIT
+    QTRY_VERIFY(m_receiverPort->bytesAvailable() >= 24);
+    QVERIFY(m_receiverPort->readAll().startsWith("rz\r**\x18" "B00"));
+
+    // ZRINIT with CANFDX | CANOVIO, without a 32-bit CRC.
+    writeHexHeader(1, 0x03000000);
+    QTRY_VERIFY(m_receiverPort->bytesAvailable() > 0);
+    QTest::qWait(100);
+    const QByteArray fileHeader = m_receiverPort->readAll();
+    QVERIFY(fileHeader.startsWith("*\x18" "A"));
+    QVERIFY(fileHeader.contains(QFileInfo(fileName).fileName().toLocal8Bit()));
+
+    // ZRPOS 0
+    writeHexHeader(9, 0);
+    QCOMPARE(readZmodem(content.size()), content);
+
+    // ZEOF, then ZRINIT and ZFIN
+    QTest::qWait(100);
+    m_receiverPort->readAll();
+    writeHexHeader(1, 0x03000000);
+    QTRY_VERIFY(m_receiverPort->bytesAvailable() >= 20);
+    QVERIFY(m_receiverPort->readAll().startsWith("**\x18" "B08"));
+    writeHexHeader(8, 0);
+    QTRY_COMPARE(finishedSpy.size(), 1);
+    QTRY_VERIFY(m_receiverPort->bytesAvailable() >= 2);
+    QCOMPARE(m_receiverPort->readAll(), QByteArray("OO"));
+}
+
+void tst_QSerialPortFileTransfer::receiverCancel()
+{
+    const QString fileName = createFile(testData(4096));
+    QVERIFY(!fileName.isEmpty());
+
+    QSerialPortFileTransfer transfer(m_senderPort);
+    transfer.setProtocol(QSerialPortFileTransfer::Xmodem1K);
+    QSignalSpy errorSpy(&transfer, &QSerialPortFileTransfer::errorOccurred);
+    QVERIFY(transfer.sendFile(fileName));
+
+    m_receiverPort->write("C");
+    QVERIFY(!readBlock(1, true).isEmpty());
+    m_receiverPort->write("\x18\x18");
+
+    QTRY_COMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFileTransfer::Error>(),
+             QSerialPortFileTransfer::CancelledError);
+    QVERIFY(!transfer.isActive());
+}
+
+QTEST_MAIN(tst_QSerialPortFileTransfer)
+#include "tst_qserialportfiletransfer.moc"
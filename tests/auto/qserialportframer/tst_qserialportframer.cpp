@@ -0,0 +1,458 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortFramer>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+class tst_QSerialPortFramer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortFramer();
+
+private slots:
+    void initTestCase();
+
+    void encodeFrame_data();
+    void encodeFrame();
+
+    void decodeFrames_data();
+    void decodeFrames();
+    void decodeMalformedFrame();
+    void decodeOversizedFrame();
+    void decodeHdlcFrameCheckSequence_data();
+    void decodeHdlcFrameCheckSequence();
+    void decodeIdleGap();
+    void decodeLengthField();
+    void decodeLengthFieldDefaultLimit();
+    void frameHandler();
+    void readBufferLimit();
+    void decodeNmea();
+
+private:
+    bool openPorts(QSerialPort &sender, QSerialPort &receiver);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+};
+
+tst_QSerialPortFramer::tst_QSerialPortFramer()
+{
+}
+
+void tst_QSerialPortFramer::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them;
+    // the tests that need ports skip on their own when neither is there.
+    QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair);
+}
+
+bool tst_QSerialPortFramer::openPorts(QSerialPort &sender, QSerialPort &receiver)
+{
+    sender.setPortName(m_senderPortName);
+    receiver.setPortName(m_receiverPortName);
+    return sender.open(QIODevice::WriteOnly) && receiver.open(QIODevice::ReadOnly);
+}
+
+static QByteArray bytes(std::initializer_list<uchar> values)
+{
+    QByteArray result;
+    for (uchar value : values)
+        result.append(char(value));
+    return result;
+}
+
+void tst_QSerialPortFramer::encodeFrame_data()
+{
+    QTest::addColumn<QSerialPortFramer::Protocol>("protocol");
+    QTest::addColumn<QByteArray>("payload");
+    QTest::addColumn<QByteArray>("encoded");
+
+    QTest::newRow("slip-empty") << QSerialPortFramer::Slip << QByteArray()
+                                << bytes({0xC0, 0xC0});
+    QTest::newRow("slip-plain") << QSerialPortFramer::Slip << QByteArray("abc")
+                                << bytes({0xC0, 'a', 'b', 'c', 0xC0});
+    QTest::newRow("slip-escapes") << QSerialPortFramer::Slip << bytes({0xC0, 'x', 0xDB})
+                                  << bytes({0xC0, 0xDB, 0xDC, 'x', 0xDB, 0xDD, 0xC0});
+
+    QTest::newRow("cobs-empty") << QSerialPortFramer::Cobs << QByteArray()
+                                << bytes({0x01, 0x00});
+    QTest::newRow("cobs-zero") << QSerialPortFramer::Cobs << bytes({0x00})
+                               << bytes({0x01, 0x01, 0x00});
+    QTest::newRow("cobs-mixed") << QSerialPortFramer::Cobs << bytes({0x11, 0x22, 0x00, 0x33})
+                                << bytes({0x03, 0x11, 0x22, 0x02, 0x33, 0x00});
+    QTest::newRow("cobs-trailing-zero") << QSerialPortFramer::Cobs << bytes({0x11, 0x00})
+                                        << bytes({0x02, 0x11, 0x01, 0x00});
+
+    QByteArray longPayload(254, 'x');
+    QTest::newRow("cobs-254") << QSerialPortFramer::Cobs << longPayload
+                              << bytes({0xFF}) + longPayload + bytes({0x00});
+    QTest::newRow("cobs-255") << QSerialPortFramer::Cobs << longPayload + "y"
+                              << bytes({0xFF}) + longPayload + bytes({0x02, 'y', 0x00});
+
+    QTest::newRow("hdlc-check") << QSerialPortFramer::Hdlc << QByteArray("123456789")
+                                << bytes({0x7E}) + "123456789" + bytes({0x6E, 0x90, 0x7E});
+    QTest::newRow("hdlc-escapes") << QSerialPortFramer::Hdlc << bytes({0x7E, 'A', 0x01})
+                                  << bytes({0x7E, 0x7D, 0x5E, 'A', 0x7D, 0x21,
+                                            0x38, 0x7D, 0x38, 0x7E});
+
+    QTest::newRow("nmea") << QSerialPortFramer::Nmea << QByteArray("$PMTK220,100")
+                          << QByteArray("$PMTK220,100*2F\r\n");
+    QTest::newRow("nmea-no-start") << QSerialPortFramer::Nmea << QByteArray("GPRMC,1,A")
+                                   << QByteArray("$GPRMC,1,A*3B\r\n");
+    QTest::newRow("nmea-ais") << QSerialPortFramer::Nmea
+                              << QByteArray("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0")
+                              << QByteArray("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n");
+}
+
+void tst_QSerialPortFramer::encodeFrame()
+{
+    QFETCH(QSerialPortFramer::Protocol, protocol);
+    QFETCH(QByteArray, payload);
+    QFETCH(QByteArray, encoded);
+
+    QCOMPARE(QSerialPortFramer::encodeFrame(protocol, payload), encoded);
+}
+
+void tst_QSerialPortFramer::decodeFrames_data()
+{
+    QTest::addColumn<QSerialPortFramer::Protocol>("protocol");
+
+    QTest::newRow("slip") << QSerialPortFramer::Slip;
+    QTest::newRow("cobs") << QSerialPortFramer::Cobs;
+    QTest::newRow("hdlc") << QSerialPortFramer::Hdlc;
+}
+
+void tst_QSerialPortFramer::decodeFrames()
+{
+    QFETCH(QSerialPortFramer::Protocol, protocol);
+
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer framer(&receiver, protocol);
+    QSignalSpy receivedSpy(&framer, &QSerialPortFramer::frameReceived);
+
+    QList<QByteArray> payloads;
+    payloads << QByteArray("hello") << bytes({0x00, 0xC0, 0xDB, 0xDC, 0xDD, 0x00})
+             << QByteArray(1000, '\0') << QByteArray(600, 'z');
+
+    QSerialPortFramer senderFramer(&sender, protocol);
+    for (const QByteArray &payload : std::as_const(payloads))
+        QVERIFY(senderFramer.writeFrame(payload) > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), payloads.size());
+    QVERIFY(receivedSpy.size() > 0);
+    for (const QByteArray &payload : std::as_const(payloads))
+        QCOMPARE(framer.readFrame(), payload);
+    QVERIFY(!framer.hasPendingFrames());
+    QVERIFY(framer.readFrame().isEmpty());
+}
+
+void tst_QSerialPortFramer::decodeMalformedFrame()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::Slip);
+    QSignalSpy errorSpy(&framer, &QSerialPortFramer::frameError);
+
+    QVERIFY(sender.write(bytes({0xC0, 'a', 0xDB, 'b', 'c', 0xC0})) > 0);
+    QVERIFY(sender.write(QSerialPortFramer::encodeFrame(QSerialPortFramer::Slip, "good")) > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), 1);
+    QCOMPARE(framer.readFrame(), QByteArray("good"));
+    QCOMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::MalformedFrameError);
+}
+
+void tst_QSerialPortFramer::decodeOversizedFrame()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::Cobs);
+    framer.setMaximumFrameSize(16);
+    QSignalSpy errorSpy(&framer, &QSerialPortFramer::frameError);
+
+    QVERIFY(sender.write(QSerialPortFramer::encodeFrame(QSerialPortFramer::Cobs,
+                                                        QByteArray(17, 'a'))) > 0);
+    QVERIFY(sender.write(QSerialPortFramer::encodeFrame(QSerialPortFramer::Cobs,
+                                                        QByteArray(16, 'b'))) > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), 1);
+    QCOMPARE(framer.readFrame(), QByteArray(16, 'b'));
+    QCOMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::OversizedFrameError);
+}
+
+void tst_QSerialPortFramer::decodeHdlcFrameCheckSequence_data()
+{
+    QTest::addColumn<QSerialPortFramer::FrameCheckSequence>("fcs");
+    QTest::addColumn<quint32>("accm");
+
+    QTest::newRow("fcs16") << QSerialPortFramer::Fcs16 << quint32(0xFFFFFFFF);
+    QTest::newRow("fcs32") << QSerialPortFramer::Fcs32 << quint32(0);
+    QTest::newRow("none") << QSerialPortFramer::NoFrameCheckSequence << quint32(0x000A0000);
+}
+
+void tst_QSerialPortFramer::decodeHdlcFrameCheckSequence()
+{
+    QFETCH(QSerialPortFramer::FrameCheckSequence, fcs);
+    QFETCH(quint32, accm);
+
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer senderFramer(&sender, QSerialPortFramer::Hdlc);
+    senderFramer.setFrameCheckSequence(fcs);
+    senderFramer.setAsyncControlCharacterMap(accm);
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::Hdlc);
+    framer.setFrameCheckSequence(fcs);
+    framer.setAsyncControlCharacterMap(accm);
+    QSignalSpy errorSpy(&framer, &QSerialPortFramer::frameError);
+
+    const QByteArray payload = bytes({0x7E, 0x7D, 0x11, 0x13, 0x00, 0xFF}) + QByteArray(300, 'p');
+    QVERIFY(senderFramer.writeFrame(payload) > 0);
+
+    if (fcs != QSerialPortFramer::NoFrameCheckSequence) {
+        // Corrupt one byte of a frame.
+        QByteArray corrupted = QSerialPortFramer::encodeFrame(QSerialPortFramer::Hdlc, "corrupted");
+        corrupted[3] = 'X';
+        QVERIFY(sender.write(corrupted) > 0);
+    }
+    QVERIFY(senderFramer.writeFrame("last") > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), 2);
+    QCOMPARE(framer.readFrame(), payload);
+    QCOMPARE(framer.readFrame(), QByteArray("last"));
+    if (fcs != QSerialPortFramer::NoFrameCheckSequence) {
+        QCOMPARE(errorSpy.size(), 1);
+        QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFramer::FrameError>(),
+                 QSerialPortFramer::ChecksumError);
+    }
+}
+
+void tst_QSerialPortFramer::decodeIdleGap()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::IdleGap);
+    QCOMPARE(framer.idleGap(), 3.5);
+    QSignalSpy receivedSpy(&framer, &QSerialPortFramer::frameReceived);
+
+    // At 9600 baud, 3.5 character times are about 4 milliseconds.
+    QSerialPortFramer senderFramer(&sender, QSerialPortFramer::IdleGap);
+    QVERIFY(senderFramer.writeFrame("first") > 0);
+    QVERIFY(sender.waitForBytesWritten(500));
+    QTest::qWait(100);
+    QVERIFY(senderFramer.writeFrame("second") > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), 2);
+    QCOMPARE(framer.readFrame(), QByteArray("first"));
+    QCOMPARE(framer.readFrame(), QByteArray("second"));
+    QCOMPARE(receivedSpy.size(), 2);
+}
+
+void tst_QSerialPortFramer::decodeLengthField()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    // A type byte, a little endian length, the value and a 2 byte checksum
+    // that the length does not count.
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::LengthField);
+    framer.setLengthFieldOffset(1);
+    framer.setLengthFieldSize(2);
+    framer.setLengthFieldByteOrder(QSysInfo::LittleEndian);
+    framer.setLengthAdjustment(2);
+    framer.setMaximumFrameSize(1024);
+    QSignalSpy errorSpy(&framer, &QSerialPortFramer::frameError);
+
+    const QByteArray empty = bytes({0x01, 0x00, 0x00, 0xAA, 0xBB});
+    const QByteArray large = bytes({0x02, 0xE8, 0x03}) + QByteArray(1000, 'v') + bytes({0xCC, 0xDD});
+    const QByteArray oversized = bytes({0x03, 0x00, 0x04}) + QByteArray(1026, 'x');
+    const QByteArray last = bytes({0x04, 0x02, 0x00, 'o', 'k', 0xEE, 0xFF});
+
+    QVERIFY(sender.write(empty + large) > 0);
+    QVERIFY(sender.write(oversized + last) > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), 3);
+    QCOMPARE(framer.readFrame(), empty);
+    QCOMPARE(framer.readFrame(), large);
+    QCOMPARE(framer.readFrame(), last);
+    QCOMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::OversizedFrameError);
+}
+
+void tst_QSerialPortFramer::decodeLengthFieldDefaultLimit()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    // A corrupt length field is dropped at once, rather than buffering up
+    // to 4 GiB while waiting for the rest of the frame.
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::LengthField);
+    framer.setLengthFieldSize(4);
+    QCOMPARE(framer.maximumFrameSize(), qsizetype(65536));
+    QSignalSpy errorSpy(&framer, &QSerialPortFramer::frameError);
+
+    QVERIFY(sender.write(bytes({0xFF, 0xFF, 0xFF, 0xF0}) + QByteArray(16, 'x')) > 0);
+
+    QTRY_COMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::OversizedFrameError);
+    QVERIFY(!framer.hasPendingFrames());
+}
+
+void tst_QSerialPortFramer::frameHandler()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::LengthField);
+    framer.setLengthFieldSize(1);
+    QSignalSpy receivedSpy(&framer, &QSerialPortFramer::frameReceived);
+
+    QList<QByteArray> frames;
+    framer.setFrameHandler([&frames](QByteArrayView frame) {
+        frames.append(frame.toByteArray());
+    });
+
+    QByteArray data;
+    for (int i = 0; i < 100; ++i)
+        data += char(i) + QByteArray(i, char(i));
+    QVERIFY(sender.write(data) > 0);
+
+    QTRY_COMPARE(frames.size(), 100);
+    for (int i = 0; i < 100; ++i)
+        QCOMPARE(frames.at(i), QByteArray(char(i) + QByteArray(i, char(i))));
+    QVERIFY(!framer.hasPendingFrames());
+    QCOMPARE(receivedSpy.size(), 0);
+}
+
+void tst_QSerialPortFramer::readBufferLimit()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+    receiver.setReadBufferSize(64);
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::Cobs);
+
+    QByteArray data;
+    for (int i = 0; i < 20; ++i)
+        data += QSerialPortFramer::encodeFrame(QSerialPortFramer::Cobs, QByteArray(16, char('a' + i)));
+    QVERIFY(sender.write(data) > 0);
+    QVERIFY(sender.waitForBytesWritten(500));
+
+    // No more frames are decoded than fit in the read buffer.
+    QTRY_COMPARE(framer.pendingFrameCount(), 4);
+    QTest::qWait(100);
+    QCOMPARE(framer.pendingFrameCount(), 4);
+
+    for (int i = 0; i < 20; ++i) {
+        QTRY_VERIFY(framer.hasPendingFrames());
+        QCOMPARE(framer.readFrame(), QByteArray(16, char('a' + i)));
+    }
+}
+
+void tst_QSerialPortFramer::decodeNmea()
+{
+    if (m_senderPortName.isEmpty() || m_receiverPortName.isEmpty())
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+
+    QSerialPort sender;
+    QSerialPort receiver;
+    QVERIFY(openPorts(sender, receiver));
+
+    QSerialPortFramer framer(&receiver, QSerialPortFramer::Nmea);
+    framer.setMaximumFrameSize(82);
+    QSignalSpy errorSpy(&framer, &QSerialPortFramer::frameError);
+
+    const QByteArray gga("$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    QByteArray data;
+    data += "noise" + gga + "*47\r\n";
+    data += "$GPRMC,1,A*3C\r\n";                // Wrong checksum
+    data += "$GPRMC,1,$GPRMC,1,A\n";              // Truncated sentence
+    data += '$' + QByteArray(100, 'x') + "\r\n";  // Oversized sentence
+    data += "!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n";
+    data += "$GPRMC,1,!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n"; // Truncated by AIS
+    QVERIFY(sender.write(data) > 0);
+
+    QTRY_COMPARE(framer.pendingFrameCount(), 4);
+    QCOMPARE(framer.readFrame(), gga);
+    QCOMPARE(framer.readFrame(), QByteArray("$GPRMC,1,A"));
+    QCOMPARE(framer.readFrame(), QByteArray("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0"));
+    QCOMPARE(framer.readFrame(), QByteArray("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0"));
+
+    QCOMPARE(errorSpy.size(), 4);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::ChecksumError);
+    QCOMPARE(errorSpy.at(1).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::MalformedFrameError);
+    QCOMPARE(errorSpy.at(2).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::OversizedFrameError);
+    QCOMPARE(errorSpy.at(3).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::MalformedFrameError);
+
+    // An AIS sentence also ends one that arrives in pieces.
+    QVERIFY(sender.write("$GPRMC,1,") > 0);
+    QVERIFY(sender.waitForBytesWritten(100));
+    QTest::qWait(50);
+    QVERIFY(sender.write("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n") > 0);
+    QTRY_COMPARE(framer.pendingFrameCount(), 1);
+    QCOMPARE(framer.readFrame(), QByteArray("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0"));
+    QCOMPARE(errorSpy.size(), 5);
+    QCOMPARE(errorSpy.at(4).at(0).value<QSerialPortFramer::FrameError>(),
+             QSerialPortFramer::MalformedFrameError);
+}
+
+QTEST_MAIN(tst_QSerialPortFramer)
+#include "tst_qserialportframer.moc"
@@ -14,6 +14,9 @@ public:
 private slots:
     void canonical_data();
     void canonical();
+    void usbPortPath_data();
+    void usbPortPath();
+    void persistentIdentifiers();
 };
 
 tst_QSerialPortInfoPrivate::tst_QSerialPortInfoPrivate()
@@ -68,5 +71,62 @@ void tst_QSerialPortInfoPrivate::canonical()
     QCOMPARE(QSerialPortInfoPrivate::portNameToSystemLocation(source), location);
 }
 
+void tst_QSerialPortInfoPrivate::usbPortPath_data()
+{
+    QTest::addColumn<QString>("sysfsPath");
+    QTest::addColumn<QString>("usbPortPath");
+    QTest::addColumn<QString>("usbInterface");
+
+    QTest::newRow("Empty") << "" << "" << "";
+    QTest::newRow("Platform") << "/sys/devices/platform/serial8250/tty/ttyS0" << "" << "";
+    QTest::newRow("RootHub") << "/sys/devices/pci0000:00/0000:00:14.0/usb1/1-0:1.0" << "" << "";
+    QTest::newRow("Direct")
+            << "/sys/devices/pci0000:00/0000:00:14.0/usb1/1-2/1-2:1.0/ttyUSB0/tty/ttyUSB0"
+            << "1-2" << "1.0";
+    QTest::newRow("Hub")
+            << "/sys/devices/pci0000:00/0000:00:14.0/usb3/3-1/3-1.4/3-1.4.2/3-1.4.2:1.0/tty/ttyACM0"
+            << "3-1.4.2" << "1.0";
+    QTest::newRow("TrailingSlash") << "/sys/devices/usb2/2-11/2-11:1.1/" << "2-11" << "1.1";
+    QTest::newRow("NoInterface") << "/sys/devices/usb2/2-11/tty/ttyGS0" << "2-11" << "";
+    QTest::newRow("NoBus") << "10-3.1" << "" << "";
+    QTest::newRow("I2c")
+            << "/sys/devices/platform/soc/fe804000.i2c/i2c-1/1-0048/tty/ttySC0" << "" << "";
+    QTest::newRow("Malformed") << "/sys/devices/usb1/1-/1-.2/1-2./a-1" << "" << "";
+}
+
+void tst_QSerialPortInfoPrivate::usbPortPath()
+{
+    QFETCH(QString, sysfsPath);
+    QFETCH(QString, usbPortPath);
+    QFETCH(QString, usbInterface);
+
+    QString interfaceName = QStringLiteral("stale");
+    QCOMPARE(QSerialPortInfoPrivate::usbPortPathFromSysfsPath(sysfsPath, &interfaceName), usbPortPath);
+    QCOMPARE(interfaceName, usbInterface);
+}
+
+void tst_QSerialPortInfoPrivate::persistentIdentifiers()
+{
+    // Two ttys of a multi-port adapter, on different interfaces of the
+    // same USB device.
+    const QString base = QStringLiteral("/sys/devices/pci0000:00/0000:00:14.0/usb1/1-1/1-1.4/");
+    QSerialPortInfoPrivate first;
+    first.usbPortPath = QSerialPortInfoPrivate::usbPortPathFromSysfsPath(
+                base + QStringLiteral("1-1.4:1.0/ttyUSB0/tty/ttyUSB0"), &first.usbInterface);
+    QSerialPortInfoPrivate second;
+    second.usbPortPath = QSerialPortInfoPrivate::usbPortPathFromSysfsPath(
+                base + QStringLiteral("1-1.4:1.2/ttyUSB2/tty/ttyUSB2"), &second.usbInterface);
+
+    QCOMPARE(first.usbPortPath, second.usbPortPath);
+    QCOMPARE(first.persistentIdentifiers(), QStringList(QStringLiteral("1-1.4:1.0")));
+    QCOMPARE(second.persistentIdentifiers(), QStringList(QStringLiteral("1-1.4:1.2")));
+
+    QSerialPortInfoPrivate located;
+    located.persistentIdLocation = QStringLiteral("/dev/serial/by-id/usb-FTDI-if00-port0");
+    located.persistentPathLocation = QStringLiteral("/dev/serial/by-path/pci-usb-0:1.4:1.0-port0");
+    QCOMPARE(located.persistentIdentifiers(),
+             QStringList({ located.persistentIdLocation, located.persistentPathLocation }));
+}
+
 QTEST_MAIN(tst_QSerialPortInfoPrivate)
 #include "tst_qserialportinfoprivate.moc"
@@ -0,0 +1,264 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortModbusClient>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+class tst_QSerialPortModbusClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortModbusClient();
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void interFrameDelay_data();
+    void interFrameDelay();
+
+    void readHoldingRegisters();
+    void exceptionResponse();
+    void checksumError();
+    void timeout();
+    void pipelinedRequests();
+    void writeError();
+    void closedPort();
+
+private:
+    void answer(const QByteArray &pdu, bool corruptChecksum = false);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+    QSerialPort *m_clientPort = nullptr;
+    QSerialPort *m_serverPort = nullptr;
+};
+
+// A straightforward bitwise implementation, to cross-check the client.
+static quint16 crc16(const QByteArray &data)
+{
+    quint16 crc = 0xFFFF;
+    for (char byte : data) {
+        crc ^= quint8(byte);
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? quint16((crc >> 1) ^ 0xA001) : quint16(crc >> 1);
+    }
+    return crc;
+}
+
+static QByteArray withCrc(const QByteArray &frame)
+{
+    const quint16 crc = crc16(frame);
+    return frame + char(crc & 0xFF) + char(crc >> 8);
+}
+
+tst_QSerialPortModbusClient::tst_QSerialPortModbusClient()
+{
+}
+
+void tst_QSerialPortModbusClient::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+void tst_QSerialPortModbusClient::init()
+{
+    m_clientPort = new QSerialPort(m_senderPortName, this);
+    m_serverPort = new QSerialPort(m_receiverPortName, this);
+    m_clientPort->setBaudRate(QSerialPort::Baud19200);
+    m_serverPort->setBaudRate(QSerialPort::Baud19200);
+    QVERIFY(m_clientPort->open(QIODevice::ReadWrite));
+    QVERIFY(m_serverPort->open(QIODevice::ReadWrite));
+}
+
+void tst_QSerialPortModbusClient::cleanup()
+{
+    delete m_clientPort;
+    m_clientPort = nullptr;
+    delete m_serverPort;
+    m_serverPort = nullptr;
+}
+
+// Waits for a complete request on the server port, and answers it with
+// the frame made of the address of the request and \a pdu.
+void tst_QSerialPortModbusClient::answer(const QByteArray &pdu, bool corruptChecksum)
+{
+    QTRY_VERIFY(m_serverPort->bytesAvailable() >= 8);
+    const QByteArray request = m_serverPort->read(8);
+    QCOMPARE(crc16(request), quint16(0));
+
+    QByteArray response = withCrc(request.left(1) + pdu);
+    if (corruptChecksum)
+        response[response.size() - 1] = char(response.at(response.size() - 1) ^ 0x55);
+    QCOMPARE(m_serverPort->write(response), response.size());
+}
+
+void tst_QSerialPortModbusClient::interFrameDelay_data()
+{
+    QTest::addColumn<qint32>("baudRate");
+    QTest::addColumn<QSerialPort::Parity>("parity");
+    QTest::addColumn<qint64>("interCharacterTimeout");
+    QTest::addColumn<qint64>("interFrameDelay");
+
+    // 11 bits per character.
+    QTest::newRow("9600-even") << qint32(9600) << QSerialPort::EvenParity
+                               << qint64(1718749) << qint64(4010415);
+    // 10 bits per character.
+    QTest::newRow("9600-none") << qint32(9600) << QSerialPort::NoParity
+                               << qint64(1562499) << qint64(3645831);
+    QTest::newRow("115200") << qint32(115200) << QSerialPort::EvenParity
+                            << qint64(750000) << qint64(1750000);
+}
+
+void tst_QSerialPortModbusClient::interFrameDelay()
+{
+    QFETCH(qint32, baudRate);
+    QFETCH(QSerialPort::Parity, parity);
+    QFETCH(qint64, interCharacterTimeout);
+    QFETCH(qint64, interFrameDelay);
+
+    QVERIFY(m_clientPort->setBaudRate(baudRate));
+    QVERIFY(m_clientPort->setParity(parity));
+
+    QSerialPortModbusClient client(m_clientPort);
+    QCOMPARE(client.interCharacterTimeoutNSecs(), interCharacterTimeout);
+    QCOMPARE(client.interFrameDelayNSecs(), interFrameDelay);
+}
+
+void tst_QSerialPortModbusClient::readHoldingRegisters()
+{
+    QSerialPortModbusClient client(m_clientPort);
+    QSignalSpy replySpy(&client, &QSerialPortModbusClient::replyReceived);
+
+    const quint64 requestId = client.sendRequest(17, 0x03, QByteArray::fromHex("006b0003"));
+    answer(QByteArray::fromHex("0306ae4156524340"));
+
+    QTRY_COMPARE(replySpy.size(), 1);
+    const QList<QVariant> reply = replySpy.takeFirst();
+    QCOMPARE(reply.at(0).toULongLong(), requestId);
+    QCOMPARE(reply.at(1).value<quint8>(), quint8(17));
+    QCOMPARE(reply.at(2).value<quint8>(), quint8(0x03));
+    QCOMPARE(reply.at(3).toByteArray(), QByteArray::fromHex("06ae4156524340"));
+    QCOMPARE(client.pendingRequestCount(), 0);
+}
+
+void tst_QSerialPortModbusClient::exceptionResponse()
+{
+    QSerialPortModbusClient client(m_clientPort);
+    QSignalSpy failedSpy(&client, &QSerialPortModbusClient::requestFailed);
+
+    const quint64 requestId = client.sendRequest(10, 0x06, QByteArray::fromHex("00010003"));
+    answer(QByteArray::fromHex("8602"));
+
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), requestId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortModbusClient::Error>(),
+             QSerialPortModbusClient::ExceptionError);
+    QCOMPARE(failedSpy.at(0).at(2).value<quint8>(), quint8(0x02));
+}
+
+void tst_QSerialPortModbusClient::checksumError()
+{
+    QSerialPortModbusClient client(m_clientPort);
+    client.setNumberOfRetries(0);
+    QSignalSpy failedSpy(&client, &QSerialPortModbusClient::requestFailed);
+
+    client.sendRequest(1, 0x06, QByteArray::fromHex("00010003"));
+    answer(QByteArray::fromHex("0600010003"), true);
+
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortModbusClient::Error>(),
+             QSerialPortModbusClient::ChecksumError);
+}
+
+void tst_QSerialPortModbusClient::timeout()
+{
+    QSerialPortModbusClient client(m_clientPort);
+    client.setTimeout(50);
+    client.setNumberOfRetries(2);
+    QSignalSpy failedSpy(&client, &QSerialPortModbusClient::requestFailed);
+
+    client.sendRequest(1, 0x03, QByteArray::fromHex("00000001"));
+
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortModbusClient::Error>(),
+             QSerialPortModbusClient::TimeoutError);
+
+    // The original request and two retries.
+    QTRY_COMPARE(m_serverPort->bytesAvailable(), qint64(24));
+}
+
+void tst_QSerialPortModbusClient::pipelinedRequests()
+{
+    QSerialPortModbusClient client(m_clientPort);
+    QSignalSpy replySpy(&client, &QSerialPortModbusClient::replyReceived);
+
+    QList<quint64> requestIds;
+    for (quint8 address = 1; address <= 5; ++address)
+        requestIds.append(client.sendRequest(address, 0x04, QByteArray::fromHex("00000001")));
+    QCOMPARE(client.pendingRequestCount(), 5);
+
+    for (quint8 address = 1; address <= 5; ++address)
+        answer(QByteArray::fromHex("0402") + char(0) + char(address));
+
+    QTRY_COMPARE(replySpy.size(), 5);
+    for (int i = 0; i < 5; ++i) {
+        QCOMPARE(replySpy.at(i).at(0).toULongLong(), requestIds.at(i));
+        QCOMPARE(replySpy.at(i).at(1).value<quint8>(), quint8(i + 1));
+        QCOMPARE(replySpy.at(i).at(3).toByteArray(), QByteArray("\x02\x00", 2) + char(i + 1));
+    }
+}
+
+void tst_QSerialPortModbusClient::writeError()
+{
+    m_clientPort->close();
+    QVERIFY(m_clientPort->open(QIODevice::ReadOnly));
+
+    QSerialPortModbusClient client(m_clientPort);
+    QSignalSpy failedSpy(&client, &QSerialPortModbusClient::requestFailed);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("ReadOnly device"));
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("ReadOnly device"));
+    const quint64 firstId = client.sendRequest(1, 0x03, QByteArray::fromHex("00000001"));
+    const quint64 secondId = client.sendRequest(2, 0x03, QByteArray::fromHex("00000001"));
+    // Reported once the caller has the identifiers, and in order.
+    QCOMPARE(failedSpy.size(), 0);
+    QTRY_COMPARE(failedSpy.size(), 2);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), firstId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortModbusClient::Error>(),
+             QSerialPortModbusClient::WriteError);
+    QCOMPARE(failedSpy.at(1).at(0).toULongLong(), secondId);
+}
+
+void tst_QSerialPortModbusClient::closedPort()
+{
+    m_clientPort->close();
+
+    QSerialPortModbusClient client(m_clientPort);
+    QSignalSpy failedSpy(&client, &QSerialPortModbusClient::requestFailed);
+
+    // The requests fail rather than wait for the port, one at a time.
+    QList<quint64> requestIds;
+    for (int i = 0; i < 100; ++i)
+        requestIds.append(client.sendRequest(1, 0x03, QByteArray::fromHex("00000001")));
+    QCOMPARE(failedSpy.size(), 0);
+    QTRY_COMPARE(failedSpy.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        QCOMPARE(failedSpy.at(i).at(0).toULongLong(), requestIds.at(i));
+        QCOMPARE(failedSpy.at(i).at(1).value<QSerialPortModbusClient::Error>(),
+                 QSerialPortModbusClient::WriteError);
+    }
+    QCOMPARE(client.pendingRequestCount(), 0);
+}
+
+QTEST_MAIN(tst_QSerialPortModbusClient)
+#include "tst_qserialportmodbusclient.moc"
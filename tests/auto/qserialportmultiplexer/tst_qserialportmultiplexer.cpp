@@ -0,0 +1,393 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortMultiplexer>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+namespace {
+
+enum : quint8 {
+    SABM = 0x3F,
+    UA = 0x73,
+    DM = 0x1F,
+    DISC = 0x53,
+    UIH = 0xEF
+};
+
+struct Frame
+{
+    int dlci = -1;
+    bool command = false;
+    quint8 control = 0;
+    QByteArray data;
+};
+
+quint8 fcs(const QByteArray &data)
+{
+    quint8 crc = 0xFF;
+    for (char c : data) {
+        crc ^= quint8(c);
+        for (int i = 0; i < 8; ++i)
+            crc = (crc & 1) ? quint8((crc >> 1) ^ 0xE0) : quint8(crc >> 1);
+    }
+    return quint8(0xFF - crc);
+}
+
+// Builds a frame as sent by the modem, the responding side.
+QByteArray frame(int dlci, quint8 control, bool command, const QByteArray &data = QByteArray())
+{
+    QByteArray header;
+    header.append(char(dlci << 2 | (command ? 0 : 0x02) | 0x01));
+    header.append(char(control));
+    header.append(char(data.size() << 1 | 0x01));
+    return '\xF9' + header + data + char(fcs(header)) + '\xF9';
+}
+
+QByteArray modemStatus(int dlci, bool command, bool flowStopped)
+{
+    QByteArray message;
+    message.append(char(command ? 0xE3 : 0xE1));
+    message.append(char(0x05));
+    message.append(char(dlci << 2 | 0x03));
+    message.append(char(flowStopped ? 0x8F : 0x8D));
+    return message;
+}
+
+} // namespace
+
+class tst_QSerialPortMultiplexer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortMultiplexer();
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void openAndClose();
+    void closeFlushesWrites();
+    void channelData();
+    void damagedFrames();
+    void flowControl();
+    void rejected();
+    void timeout();
+
+private:
+    Frame readFrame();
+    void openMultiplexer(QSerialPortMultiplexer *mux);
+    QIODevice *openChannel(QSerialPortMultiplexer *mux, int dlci);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+    QSerialPort *m_hostPort = nullptr;
+    QSerialPort *m_modemPort = nullptr;
+    QByteArray m_received;
+};
+
+tst_QSerialPortMultiplexer::tst_QSerialPortMultiplexer()
+{
+}
+
+void tst_QSerialPortMultiplexer::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+void tst_QSerialPortMultiplexer::init()
+{
+    m_hostPort = new QSerialPort(m_senderPortName, this);
+    m_modemPort = new QSerialPort(m_receiverPortName, this);
+    m_hostPort->setBaudRate(QSerialPort::Baud115200);
+    m_modemPort->setBaudRate(QSerialPort::Baud115200);
+    QVERIFY(m_hostPort->open(QIODevice::ReadWrite));
+    QVERIFY(m_modemPort->open(QIODevice::ReadWrite));
+    m_received.clear();
+}
+
+void tst_QSerialPortMultiplexer::cleanup()
+{
+    delete m_hostPort;
+    m_hostPort = nullptr;
+    delete m_modemPort;
+    m_modemPort = nullptr;
+}
+
+// Waits for the next frame from the multiplexer on the modem port.
+Frame tst_QSerialPortMultiplexer::readFrame()
+{
+    Frame result;
+    const auto complete = [this]() {
+        const qsizetype start = m_received.indexOf('\xF9');
+        return start >= 0 && m_received.size() >= start + 4
+                && m_received.size() >= start + 4 + (quint8(m_received.at(start + 3)) >> 1) + 2;
+    };
+    if (!QTest::qWaitFor([&]() {
+            m_received += m_modemPort->readAll();
+            return complete();
+        })) {
+        return result;
+    }
+
+    const qsizetype start = m_received.indexOf('\xF9');
+    const qsizetype length = quint8(m_received.at(start + 3)) >> 1;
+    result.dlci = quint8(m_received.at(start + 1)) >> 2;
+    result.command = m_received.at(start + 1) & 0x02;
+    result.control = quint8(m_received.at(start + 2));
+    result.data = m_received.mid(start + 4, length);
+    if (quint8(m_received.at(start + 4 + length)) != fcs(m_received.mid(start + 1, 3)))
+        result.dlci = -1;
+    m_received.remove(0, start + 4 + length + 2);
+    return result;
+}
+
+void tst_QSerialPortMultiplexer::openMultiplexer(QSerialPortMultiplexer *mux)
+{
+    QSignalSpy openedSpy(mux, &QSerialPortMultiplexer::opened);
+    mux->open();
+
+    const Frame sabm = readFrame();
+    QCOMPARE(sabm.dlci, 0);
+    QVERIFY(sabm.command);
+    QCOMPARE(sabm.control, SABM);
+    m_modemPort->write(frame(0, UA, false));
+
+    QTRY_COMPARE(openedSpy.size(), 1);
+    QVERIFY(mux->isOpen());
+}
+
+QIODevice *tst_QSerialPortMultiplexer::openChannel(QSerialPortMultiplexer *mux, int dlci)
+{
+    QSignalSpy openedSpy(mux, &QSerialPortMultiplexer::channelOpened);
+    QIODevice *channel = mux->openChannel(dlci);
+    if (!channel)
+        return nullptr;
+
+    const Frame sabm = readFrame();
+    if (sabm.dlci != dlci || sabm.control != SABM)
+        return nullptr;
+    m_modemPort->write(frame(dlci, UA, false));
+    if (!QTest::qWaitFor([&]() { return openedSpy.size() == 1; }))
+        return nullptr;
+
+    // The multiplexer announces its modem status.
+    const Frame msc = readFrame();
+    if (msc.dlci != 0 || msc.control != UIH || msc.data != modemStatus(dlci, true, false))
+        return nullptr;
+    return channel;
+}
+
+void tst_QSerialPortMultiplexer::openAndClose()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    QSignalSpy closedSpy(&mux, &QSerialPortMultiplexer::closed);
+    QSignalSpy channelClosedSpy(&mux, &QSerialPortMultiplexer::channelClosed);
+
+    QCOMPARE(mux.openChannel(1), nullptr);
+    openMultiplexer(&mux);
+    QVERIFY(openChannel(&mux, 1));
+    QVERIFY(mux.isChannelOpen(1));
+
+    mux.close();
+    const Frame disc = readFrame();
+    QCOMPARE(disc.dlci, 0);
+    QCOMPARE(disc.control, DISC);
+    m_modemPort->write(frame(0, UA, false));
+
+    QTRY_COMPARE(closedSpy.size(), 1);
+    QCOMPARE(channelClosedSpy.size(), 1);
+    QCOMPARE(channelClosedSpy.at(0).at(0).toInt(), 1);
+    QVERIFY(!mux.isOpen());
+    QVERIFY(!mux.channel(1)->isOpen());
+}
+
+void tst_QSerialPortMultiplexer::closeFlushesWrites()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    QSignalSpy channelClosedSpy(&mux, &QSerialPortMultiplexer::channelClosed);
+    openMultiplexer(&mux);
+    QIODevice *channel = openChannel(&mux, 1);
+    QVERIFY(channel);
+
+    // Closing right after a write still sends the data, ahead of DISC.
+    channel->write("ATH\r");
+    channel->close();
+    Frame data = readFrame();
+    QCOMPARE(data.dlci, 1);
+    QCOMPARE(data.control, UIH);
+    QCOMPARE(data.data, QByteArray("ATH\r"));
+    Frame disc = readFrame();
+    QCOMPARE(disc.dlci, 1);
+    QCOMPARE(disc.control, DISC);
+    m_modemPort->write(frame(1, UA, false));
+    QTRY_COMPARE(channelClosedSpy.size(), 1);
+
+    // The same goes for closeChannel().
+    QVERIFY(openChannel(&mux, 2));
+    mux.channel(2)->write("ATZ\r");
+    mux.closeChannel(2);
+    data = readFrame();
+    QCOMPARE(data.dlci, 2);
+    QCOMPARE(data.data, QByteArray("ATZ\r"));
+    QCOMPARE(readFrame().control, DISC);
+}
+
+void tst_QSerialPortMultiplexer::channelData()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    mux.setMaximumFrameSize(8);
+    openMultiplexer(&mux);
+    QIODevice *at = openChannel(&mux, 1);
+    QIODevice *gnss = openChannel(&mux, 2);
+    QVERIFY(at);
+    QVERIFY(gnss);
+
+    // Several frames, for several channels, arrive at once.
+    m_modemPort->write(frame(1, UIH, true, "OK\r\n") + frame(2, UIH, true, "$GPGGA")
+                       + frame(1, UIH, true, "RING"));
+    QTRY_COMPARE(at->bytesAvailable(), qint64(8));
+    QCOMPARE(at->readAll(), QByteArray("OK\r\nRING"));
+    QTRY_COMPARE(gnss->readAll(), QByteArray("$GPGGA"));
+
+    // Writes are split at the maximum frame size.
+    QSignalSpy bytesWrittenSpy(at, &QIODevice::bytesWritten);
+    at->write("AT+CGMR;+CSQ\r");
+    Frame first = readFrame();
+    QCOMPARE(first.dlci, 1);
+    QVERIFY(first.command);
+    QCOMPARE(first.control, UIH);
+    QCOMPARE(first.data, QByteArray("AT+CGMR;"));
+    QCOMPARE(readFrame().data, QByteArray("+CSQ\r"));
+    QCOMPARE(bytesWrittenSpy.size(), 1);
+    QCOMPARE(bytesWrittenSpy.at(0).at(0).toLongLong(), qint64(13));
+}
+
+void tst_QSerialPortMultiplexer::damagedFrames()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    openMultiplexer(&mux);
+    QIODevice *channel = openChannel(&mux, 3);
+    QVERIFY(channel);
+
+    QByteArray damaged = frame(3, UIH, true, "lost");
+    damaged[damaged.size() - 2] = char(damaged.at(damaged.size() - 2) ^ 0x01);
+
+    // A damaged frame, noise and a good frame, arriving byte by byte.
+    const QByteArray stream = damaged + QByteArray("\x00\x42", 2) + frame(3, UIH, true, "kept");
+    for (char c : stream) {
+        m_modemPort->write(&c, 1);
+        QVERIFY(m_modemPort->waitForBytesWritten(100));
+    }
+
+    QTRY_COMPARE(channel->bytesAvailable(), qint64(4));
+    QCOMPARE(channel->readAll(), QByteArray("kept"));
+
+    // The information is not readable before the frame is verified.
+    const QByteArray pending = frame(3, UIH, true, "late");
+    m_modemPort->write(pending.first(pending.size() - 2));
+    QVERIFY(m_modemPort->waitForBytesWritten(100));
+    QTest::qWait(50);
+    QCOMPARE(channel->bytesAvailable(), qint64(0));
+    m_modemPort->write(pending.last(2));
+    QTRY_COMPARE(channel->readAll(), QByteArray("late"));
+}
+
+void tst_QSerialPortMultiplexer::flowControl()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    mux.setChannelReadBufferSize(4);
+    openMultiplexer(&mux);
+    QIODevice *channel = openChannel(&mux, 1);
+    QVERIFY(channel);
+
+    // The modem stops our flow; writes are held back.
+    m_modemPort->write(frame(0, UIH, true, modemStatus(1, true, true)));
+    Frame response = readFrame();
+    QCOMPARE(response.data, modemStatus(1, false, true));
+    channel->write("held");
+    QTest::qWait(50);
+    QVERIFY(m_modemPort->readAll().isEmpty());
+
+    m_modemPort->write(frame(0, UIH, true, modemStatus(1, true, false)));
+    QCOMPARE(readFrame().data, modemStatus(1, false, false));
+    QCOMPARE(readFrame().data, QByteArray("held"));
+
+    // A full read buffer stops the flow of the modem until it is read.
+    m_modemPort->write(frame(1, UIH, true, "full"));
+    Frame stop = readFrame();
+    QCOMPARE(stop.dlci, 0);
+    QCOMPARE(stop.data, modemStatus(1, true, true));
+    QCOMPARE(channel->readAll(), QByteArray("full"));
+    QCOMPARE(readFrame().data, modemStatus(1, true, false));
+
+    // Reads of fixed-size chunks are served from the buffer of QIODevice
+    // without calling readData(), and still resume the flow.
+    QByteArray chunks;
+    auto connection = connect(channel, &QIODevice::readyRead, this, [&]() {
+        for (int i = 0; i < 4; ++i)
+            chunks += channel->read(2);
+    });
+    m_modemPort->write(frame(1, UIH, true, "chunked!"));
+    QCOMPARE(readFrame().data, modemStatus(1, true, true));
+    QCOMPARE(readFrame().data, modemStatus(1, true, false));
+    QCOMPARE(chunks, QByteArray("chunked!"));
+    disconnect(connection);
+
+    // Outside of readyRead(), asking for the size after a read does so.
+    m_modemPort->write(frame(1, UIH, true, "more"));
+    QCOMPARE(readFrame().data, modemStatus(1, true, true));
+    QCOMPARE(channel->read(4), QByteArray("more"));
+    QCOMPARE(channel->bytesAvailable(), qint64(0));
+    QCOMPARE(readFrame().data, modemStatus(1, true, false));
+}
+
+void tst_QSerialPortMultiplexer::rejected()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    QSignalSpy errorSpy(&mux, &QSerialPortMultiplexer::errorOccurred);
+    openMultiplexer(&mux);
+
+    mux.openChannel(5);
+    QCOMPARE(readFrame().control, SABM);
+    m_modemPort->write(frame(5, DM, false));
+
+    QTRY_COMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortMultiplexer::Error>(),
+             QSerialPortMultiplexer::RejectedError);
+    QCOMPARE(errorSpy.at(0).at(1).toInt(), 5);
+    QVERIFY(!mux.isChannelOpen(5));
+    QVERIFY(!mux.channel(5)->isOpen());
+}
+
+void tst_QSerialPortMultiplexer::timeout()
+{
+    QSerialPortMultiplexer mux(m_hostPort);
+    mux.setTimeout(30);
+    mux.setMaximumRetries(2);
+    QSignalSpy errorSpy(&mux, &QSerialPortMultiplexer::errorOccurred);
+
+    mux.open();
+    for (int i = 0; i < 3; ++i) {
+        const Frame sabm = readFrame();
+        QCOMPARE(sabm.dlci, 0);
+        QCOMPARE(sabm.control, SABM);
+    }
+
+    QTRY_COMPARE(errorSpy.size(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPortMultiplexer::Error>(),
+             QSerialPortMultiplexer::TimeoutError);
+    QCOMPARE(errorSpy.at(0).at(1).toInt(), 0);
+    QVERIFY(!mux.isOpen());
+}
+
+QTEST_MAIN(tst_QSerialPortMultiplexer)
+#include "tst_qserialportmultiplexer.moc"
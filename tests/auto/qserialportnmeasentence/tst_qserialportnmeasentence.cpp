@@ -0,0 +1,90 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPortNmeaSentence>
+
+class tst_QSerialPortNmeaSentence : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortNmeaSentence();
+
+private slots:
+    void parse_data();
+    void parse();
+    void fields();
+};
+
+tst_QSerialPortNmeaSentence::tst_QSerialPortNmeaSentence()
+{
+}
+
+void tst_QSerialPortNmeaSentence::parse_data()
+{
+    QTest::addColumn<QByteArray>("sentence");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QByteArray>("talker");
+    QTest::addColumn<QByteArray>("type");
+    QTest::addColumn<int>("fieldCount");
+
+    QTest::newRow("gga")
+            << QByteArray("$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n")
+            << true << QByteArray("GP") << QByteArray("GGA") << 14;
+    QTest::newRow("no-checksum") << QByteArray("$GPRMC,1,A") << true
+                                 << QByteArray("GP") << QByteArray("RMC") << 2;
+    QTest::newRow("lowercase-checksum") << QByteArray("$GPRMC,1,A*3b") << true
+                                        << QByteArray("GP") << QByteArray("RMC") << 2;
+    QTest::newRow("bad-checksum") << QByteArray("$GPRMC,1,A*3C") << false
+                                  << QByteArray() << QByteArray() << 0;
+    QTest::newRow("proprietary") << QByteArray("$PMTK220,100*2F") << true
+                                 << QByteArray("P") << QByteArray("MTK220") << 1;
+    QTest::newRow("encapsulation")
+            << QByteArray("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26") << true
+            << QByteArray("AI") << QByteArray("VDM") << 6;
+    QTest::newRow("address-only") << QByteArray("$GPTXT") << true
+                                  << QByteArray("GP") << QByteArray("TXT") << 0;
+    QTest::newRow("no-start") << QByteArray("GPRMC,1,A") << false
+                              << QByteArray() << QByteArray() << 0;
+    QTest::newRow("empty") << QByteArray() << false << QByteArray() << QByteArray() << 0;
+}
+
+void tst_QSerialPortNmeaSentence::parse()
+{
+    QFETCH(QByteArray, sentence);
+    QFETCH(bool, valid);
+    QFETCH(QByteArray, talker);
+    QFETCH(QByteArray, type);
+    QFETCH(int, fieldCount);
+
+    const QSerialPortNmeaSentence parsed(sentence);
+    QCOMPARE(parsed.isValid(), valid);
+    QCOMPARE(parsed.talker().toByteArray(), talker);
+    QCOMPARE(parsed.type().toByteArray(), type);
+    QCOMPARE(parsed.fieldCount(), qsizetype(fieldCount));
+}
+
+void tst_QSerialPortNmeaSentence::fields()
+{
+    const QByteArray data("$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47");
+    const QSerialPortNmeaSentence sentence(data);
+
+    QCOMPARE(sentence.address(), QByteArrayView("GPGGA"));
+    QCOMPARE(sentence.field(0), QByteArrayView("123519"));
+    QCOMPARE(sentence.field(1), QByteArrayView("4807.038"));
+    QCOMPARE(sentence.field(11), QByteArrayView("M"));
+    QVERIFY(sentence.field(12).isEmpty());
+    QVERIFY(sentence.field(13).isEmpty());
+    QVERIFY(sentence.field(14).isEmpty());
+    QVERIFY(sentence.field(-1).isEmpty());
+
+    // The fields refer to the original data.
+    QCOMPARE(sentence.field(0).data(), data.constData() + 7);
+
+    const QSerialPortNmeaSentence trailing(QByteArrayView("$GPRMC,"));
+    QCOMPARE(trailing.fieldCount(), qsizetype(1));
+    QVERIFY(trailing.field(0).isEmpty());
+}
+
+QTEST_MAIN(tst_QSerialPortNmeaSentence)
+#include "tst_qserialportnmeasentence.moc"
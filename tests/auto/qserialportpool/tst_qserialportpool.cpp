@@ -0,0 +1,232 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortPool>
+#include <QtSerialPort/QSerialPortTrafficCapture>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+class tst_QSerialPortPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortPool();
+
+private slots:
+    void initTestCase();
+
+    void leaseUnknownPort();
+    void tryAcquire();
+    void leaseIsExclusive();
+    void leasePriority();
+    void leaseTimeout();
+    void cancelRequest();
+    void settingsAppliedOnGrant();
+    void expiredRequestNotGranted();
+    void attachmentsEndWithLease();
+
+private:
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+};
+
+tst_QSerialPortPool::tst_QSerialPortPool()
+{
+}
+
+void tst_QSerialPortPool::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+void tst_QSerialPortPool::leaseUnknownPort()
+{
+    QSerialPortPool pool;
+    QSignalSpy failedSpy(&pool, &QSerialPortPool::leaseFailed);
+
+    const quint64 leaseId = pool.requestLease(QStringLiteral("invalidportname"));
+    QVERIFY(leaseId != 0);
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), leaseId);
+    QVERIFY(!pool.leasedPort(leaseId));
+    QVERIFY(pool.portNames().isEmpty());
+}
+
+void tst_QSerialPortPool::tryAcquire()
+{
+    QSerialPortPool pool;
+
+    quint64 leaseId = 0;
+    QSerialPort *port = pool.tryAcquire(m_senderPortName, &leaseId);
+    QVERIFY(port);
+    QVERIFY(port->isOpen());
+    QCOMPARE(pool.leasedPort(leaseId), port);
+    QVERIFY(pool.isLeased(m_senderPortName));
+
+    quint64 otherLeaseId = 0;
+    QVERIFY(!pool.tryAcquire(m_senderPortName, &otherLeaseId));
+
+    pool.release(leaseId);
+    QVERIFY(!pool.isLeased(m_senderPortName));
+    QVERIFY(port->isOpen());
+
+    QCOMPARE(pool.tryAcquire(m_senderPortName, &otherLeaseId), port);
+    pool.release(otherLeaseId);
+}
+
+void tst_QSerialPortPool::leaseIsExclusive()
+{
+    QSerialPortPool pool;
+    QSignalSpy grantedSpy(&pool, &QSerialPortPool::leaseGranted);
+
+    const quint64 firstLeaseId = pool.requestLease(m_senderPortName);
+    const quint64 secondLeaseId = pool.requestLease(m_senderPortName);
+    QTRY_COMPARE(grantedSpy.size(), 1);
+    QCOMPARE(grantedSpy.at(0).at(0).toULongLong(), firstLeaseId);
+    QCOMPARE(pool.pendingRequestCount(m_senderPortName), 1);
+
+    QTest::qWait(50);
+    QCOMPARE(grantedSpy.size(), 1);
+
+    pool.release(firstLeaseId);
+    QTRY_COMPARE(grantedSpy.size(), 2);
+    QCOMPARE(grantedSpy.at(1).at(0).toULongLong(), secondLeaseId);
+    pool.release(secondLeaseId);
+}
+
+void tst_QSerialPortPool::leasePriority()
+{
+    QSerialPortPool pool;
+    QSignalSpy grantedSpy(&pool, &QSerialPortPool::leaseGranted);
+
+    quint64 leaseId = 0;
+    QVERIFY(pool.tryAcquire(m_senderPortName, &leaseId));
+
+    const quint64 lowLeaseId = pool.requestLease(m_senderPortName, {}, 0);
+    const quint64 highLeaseId = pool.requestLease(m_senderPortName, {}, 10);
+    pool.release(leaseId);
+
+    QTRY_COMPARE(grantedSpy.size(), 1);
+    QCOMPARE(grantedSpy.at(0).at(0).toULongLong(), highLeaseId);
+
+    pool.release(highLeaseId);
+    QTRY_COMPARE(grantedSpy.size(), 2);
+    QCOMPARE(grantedSpy.at(1).at(0).toULongLong(), lowLeaseId);
+    pool.release(lowLeaseId);
+}
+
+void tst_QSerialPortPool::leaseTimeout()
+{
+    QSerialPortPool pool;
+    QSignalSpy timedOutSpy(&pool, &QSerialPortPool::leaseTimedOut);
+
+    quint64 leaseId = 0;
+    QVERIFY(pool.tryAcquire(m_senderPortName, &leaseId));
+
+    const quint64 waitingLeaseId = pool.requestLease(m_senderPortName, {}, 0, 50);
+    QTRY_COMPARE(timedOutSpy.size(), 1);
+    QCOMPARE(timedOutSpy.at(0).at(0).toULongLong(), waitingLeaseId);
+    QCOMPARE(pool.pendingRequestCount(m_senderPortName), 0);
+    pool.release(leaseId);
+}
+
+void tst_QSerialPortPool::cancelRequest()
+{
+    QSerialPortPool pool;
+    QSignalSpy grantedSpy(&pool, &QSerialPortPool::leaseGranted);
+
+    quint64 leaseId = 0;
+    QVERIFY(pool.tryAcquire(m_senderPortName, &leaseId));
+
+    const quint64 waitingLeaseId = pool.requestLease(m_senderPortName);
+    QCOMPARE(pool.pendingRequestCount(m_senderPortName), 1);
+    pool.cancelRequest(waitingLeaseId);
+    QCOMPARE(pool.pendingRequestCount(m_senderPortName), 0);
+
+    pool.release(leaseId);
+    QTest::qWait(50);
+    QCOMPARE(grantedSpy.size(), 0);
+}
+
+void tst_QSerialPortPool::settingsAppliedOnGrant()
+{
+    QSerialPortPool pool;
+
+    QSerialPortPool::PortSettings settings;
+    settings.baudRate = QSerialPort::Baud115200;
+    settings.parity = QSerialPort::EvenParity;
+
+    quint64 leaseId = 0;
+    QSerialPort *port = pool.tryAcquire(m_senderPortName, &leaseId, settings);
+    QVERIFY(port);
+    QCOMPARE(port->baudRate(), qint32(QSerialPort::Baud115200));
+    QCOMPARE(port->parity(), QSerialPort::EvenParity);
+    pool.release(leaseId);
+
+    QCOMPARE(pool.tryAcquire(m_senderPortName, &leaseId), port);
+    QCOMPARE(port->baudRate(), qint32(QSerialPort::Baud9600));
+    QCOMPARE(port->parity(), QSerialPort::NoParity);
+    pool.release(leaseId);
+}
+
+void tst_QSerialPortPool::expiredRequestNotGranted()
+{
+    QSerialPortPool pool;
+    QSignalSpy grantedSpy(&pool, &QSerialPortPool::leaseGranted);
+    QSignalSpy timedOutSpy(&pool, &QSerialPortPool::leaseTimedOut);
+
+    quint64 leaseId = 0;
+    QVERIFY(pool.tryAcquire(m_senderPortName, &leaseId));
+    const quint64 waitingLeaseId = pool.requestLease(m_senderPortName, {}, 0, 20);
+    pool.release(leaseId);
+
+    // The deadline passes before the event loop gets to grant the lease.
+    QThread::msleep(50);
+    QTRY_COMPARE(timedOutSpy.size(), 1);
+    QCOMPARE(timedOutSpy.at(0).at(0).toULongLong(), waitingLeaseId);
+    QTest::qWait(20);
+    QCOMPARE(grantedSpy.size(), 0);
+    QVERIFY(!pool.isLeased(m_senderPortName));
+}
+
+void tst_QSerialPortPool::attachmentsEndWithLease()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    QSerialPortPool pool;
+
+    quint64 leaseId = 0;
+    QSerialPort *port = pool.tryAcquire(m_senderPortName, &leaseId);
+    QVERIFY(port);
+
+    bool notified = false;
+    connect(port, &QSerialPort::baudRateChanged, this, [&notified]() { notified = true; });
+    QSerialPortTrafficCapture capture(port);
+    QVERIFY(capture.start(directory.filePath(QStringLiteral("first.cap"))));
+
+    // The capture would no longer see the settings and errors of the port.
+    pool.release(leaseId);
+    QVERIFY(!capture.isActive());
+
+    QCOMPARE(pool.tryAcquire(m_senderPortName, &leaseId), port);
+    QVERIFY(port->setBaudRate(QSerialPort::Baud115200));
+    QVERIFY(!notified);
+
+    // An attachment created for the new lease works.
+    QSerialPortTrafficCapture nextCapture(port);
+    QVERIFY(nextCapture.start(directory.filePath(QStringLiteral("second.cap"))));
+    QVERIFY(nextCapture.isActive());
+    nextCapture.stop();
+    pool.release(leaseId);
+}
+
+QTEST_MAIN(tst_QSerialPortPool)
+#include "tst_qserialportpool.moc"
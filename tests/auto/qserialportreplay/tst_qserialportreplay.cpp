@@ -0,0 +1,242 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPortReplay>
+#include <QtSerialPort/QSerialPortTrafficCapture>
+
+namespace {
+
+class CaptureWriter
+{
+public:
+    CaptureWriter()
+        : m_data("QSPC", 4)
+    {
+        char header[12];
+        qToLittleEndian<quint32>(1, header);
+        qToLittleEndian<qint64>(0, header + 4);
+        m_data.append(header, sizeof(header));
+    }
+
+    void append(qint64 msecs, QSerialPortTrafficCapture::RecordType type, const QByteArray &payload)
+    {
+        char header[12];
+        qToLittleEndian<qint64>(msecs * 1000000, header);
+        qToLittleEndian<quint32>(quint32(type) << 24 | quint32(payload.size()), header + 8);
+        m_data.append(header, sizeof(header));
+        m_data.append(payload);
+    }
+
+    void appendSettings(qint64 msecs, qint32 baudRate, QSerialPort::Parity parity)
+    {
+        char payload[12];
+        qToLittleEndian<qint32>(baudRate, payload);
+        qToLittleEndian<qint32>(baudRate, payload + 4);
+        payload[8] = char(QSerialPort::Data8);
+        payload[9] = char(parity);
+        payload[10] = char(QSerialPort::OneStop);
+        payload[11] = char(QSerialPort::NoFlowControl);
+        append(msecs, QSerialPortTrafficCapture::SettingsRecord, QByteArray(payload, sizeof(payload)));
+    }
+
+    bool save(const QString &fileName, qsizetype truncate = 0) const
+    {
+        QFile file(fileName);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                && file.write(m_data.chopped(truncate)) == m_data.size() - truncate;
+    }
+
+private:
+    QByteArray m_data;
+};
+
+} // namespace
+
+class tst_QSerialPortReplay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortReplay();
+
+private slots:
+    void initTestCase();
+
+    void openErrors();
+    void asFastAsPossible();
+    void timing();
+    void truncatedFile();
+
+private:
+    QTemporaryDir m_directory;
+};
+
+tst_QSerialPortReplay::tst_QSerialPortReplay()
+{
+}
+
+void tst_QSerialPortReplay::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+}
+
+void tst_QSerialPortReplay::openErrors()
+{
+    QSerialPortReplay missing(m_directory.filePath(QStringLiteral("missing.qspcap")));
+    QVERIFY(!missing.open(QIODevice::ReadOnly));
+    QVERIFY(!missing.isOpen());
+
+    const QString fileName = m_directory.filePath(QStringLiteral("invalid.qspcap"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("QSPX0000000000000000");
+    file.close();
+    QSerialPortReplay invalid(fileName);
+    QVERIFY(!invalid.open(QIODevice::ReadOnly));
+    QVERIFY(!invalid.errorString().isEmpty());
+
+    const QString emptyFileName = m_directory.filePath(QStringLiteral("empty.qspcap"));
+    QVERIFY(CaptureWriter().save(emptyFileName));
+    QSerialPortReplay empty(emptyFileName);
+    QVERIFY(!empty.open(QIODevice::WriteOnly));
+    QVERIFY(empty.open(QIODevice::ReadOnly));
+    QVERIFY(!empty.open(QIODevice::ReadOnly));
+    QSignalSpy finishedSpy(&empty, &QSerialPortReplay::finished);
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(empty.isFinished());
+}
+
+void tst_QSerialPortReplay::asFastAsPossible()
+{
+    QByteArray data(300000, Qt::Uninitialized);
+    for (qsizetype i = 0; i < data.size(); ++i)
+        data[i] = char(i * 7);
+
+    CaptureWriter writer;
+    writer.appendSettings(0, QSerialPort::Baud9600, QSerialPort::NoParity);
+    writer.append(1, QSerialPortTrafficCapture::ReceivedRecord, data.first(1000));
+    writer.append(2, QSerialPortTrafficCapture::TransmittedRecord, QByteArray("ignored"));
+    writer.appendSettings(3, QSerialPort::Baud115200, QSerialPort::EvenParity);
+    char line[5];
+    qToLittleEndian<quint32>(QSerialPort::DataTerminalReadySignal, line);
+    line[4] = 1;
+    writer.append(4, QSerialPortTrafficCapture::ControlLineRecord, QByteArray(line, sizeof(line)));
+    for (qsizetype offset = 1000; offset < data.size(); offset += 10000)
+        writer.append(offset, QSerialPortTrafficCapture::ReceivedRecord, data.mid(offset, 10000));
+    char error[4];
+    qToLittleEndian<quint32>(QSerialPort::ResourceError, error);
+    writer.append(3600000, QSerialPortTrafficCapture::ErrorRecord, QByteArray(error, sizeof(error)));
+    const QString fileName = m_directory.filePath(QStringLiteral("fast.qspcap"));
+    QVERIFY(writer.save(fileName));
+
+    QSerialPortReplay replay(fileName);
+    replay.setSpeed(0);
+    QStringList events;
+    QByteArray received;
+    connect(&replay, &QIODevice::readyRead, this, [&]() {
+        if (events.isEmpty() || events.last() != QLatin1String("data"))
+            events.append(QStringLiteral("data"));
+        received += replay.readAll();
+    });
+    connect(&replay, &QSerialPortReplay::baudRateChanged, this,
+            [&](qint32 baudRate, QSerialPort::Directions directions) {
+        QCOMPARE(directions, QSerialPort::Directions(QSerialPort::AllDirections));
+        events.append(QStringLiteral("baud %1").arg(baudRate));
+    });
+    connect(&replay, &QSerialPortReplay::parityChanged, this, [&](QSerialPort::Parity parity) {
+        events.append(QStringLiteral("parity %1").arg(parity));
+    });
+    connect(&replay, &QSerialPortReplay::dataTerminalReadyChanged, this, [&](bool set) {
+        events.append(QStringLiteral("dtr %1").arg(set));
+    });
+    connect(&replay, &QSerialPortReplay::errorOccurred, this,
+            [&](QSerialPort::SerialPortError error) {
+        events.append(QStringLiteral("error %1").arg(error));
+    });
+    QSignalSpy finishedSpy(&replay, &QSerialPortReplay::finished);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(replay.open(QIODevice::ReadWrite));
+    QCOMPARE(replay.write("discarded"), qint64(9));
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(timer.elapsed() < 60000);
+
+    QCOMPARE(received, data);
+    QCOMPARE(events, QStringList({
+        QStringLiteral("data"),
+        QStringLiteral("baud 115200"),
+        QStringLiteral("parity %1").arg(QSerialPort::EvenParity),
+        QStringLiteral("dtr 1"),
+        QStringLiteral("data"),
+        QStringLiteral("error %1").arg(QSerialPort::ResourceError)
+    }));
+    QCOMPARE(replay.baudRate(), qint32(QSerialPort::Baud115200));
+    QCOMPARE(replay.parity(), QSerialPort::EvenParity);
+    QCOMPARE(replay.pinoutSignals(),
+             QSerialPort::PinoutSignals(QSerialPort::DataTerminalReadySignal));
+    QCOMPARE(replay.error(), QSerialPort::ResourceError);
+    QVERIFY(replay.isFinished());
+
+    // Reopening starts over with the default settings.
+    replay.close();
+    received.clear();
+    QVERIFY(replay.open(QIODevice::ReadOnly));
+    QCOMPARE(replay.baudRate(), qint32(QSerialPort::Baud9600));
+    QCOMPARE(replay.error(), QSerialPort::NoError);
+    QVERIFY(finishedSpy.wait());
+    QCOMPARE(received, data);
+}
+
+void tst_QSerialPortReplay::timing()
+{
+    CaptureWriter writer;
+    writer.append(1000, QSerialPortTrafficCapture::ReceivedRecord, QByteArray("first"));
+    writer.append(1400, QSerialPortTrafficCapture::ReceivedRecord, QByteArray("second"));
+    const QString fileName = m_directory.filePath(QStringLiteral("timing.qspcap"));
+    QVERIFY(writer.save(fileName));
+
+    QSerialPortReplay replay(fileName);
+    replay.setSpeed(2);
+    QCOMPARE(replay.speed(), qreal(2));
+
+    QList<qint64> arrivals;
+    QByteArray received;
+    QElapsedTimer timer;
+    connect(&replay, &QIODevice::readyRead, this, [&]() {
+        arrivals.append(timer.elapsed());
+        received += replay.readAll();
+    });
+    QSignalSpy finishedSpy(&replay, &QSerialPortReplay::finished);
+
+    timer.start();
+    QVERIFY(replay.open(QIODevice::ReadOnly));
+    QVERIFY(finishedSpy.wait());
+
+    // The timing is relative to the first record, and scaled by the speed.
+    QCOMPARE(received, QByteArray("firstsecond"));
+    QCOMPARE(arrivals.size(), 2);
+    QVERIFY2(arrivals.at(0) < 150, QByteArray::number(arrivals.at(0)));
+    QVERIFY2(arrivals.at(1) - arrivals.at(0) >= 190, QByteArray::number(arrivals.at(1)));
+}
+
+void tst_QSerialPortReplay::truncatedFile()
+{
+    CaptureWriter writer;
+    writer.append(0, QSerialPortTrafficCapture::ReceivedRecord, QByteArray("complete"));
+    writer.append(0, QSerialPortTrafficCapture::ReceivedRecord, QByteArray("incomplete"));
+    const QString fileName = m_directory.filePath(QStringLiteral("truncated.qspcap"));
+    QVERIFY(writer.save(fileName, 3));
+
+    QSerialPortReplay replay(fileName);
+    replay.setSpeed(0);
+    QSignalSpy finishedSpy(&replay, &QSerialPortReplay::finished);
+    QVERIFY(replay.open(QIODevice::ReadOnly));
+    QVERIFY(finishedSpy.wait());
+    QCOMPARE(replay.bytesAvailable(), qint64(8));
+    QCOMPARE(replay.readAll(), QByteArray("complete"));
+    QVERIFY(replay.atEnd());
+}
+
+QTEST_MAIN(tst_QSerialPortReplay)
+#include "tst_qserialportreplay.moc"
@@ -0,0 +1,275 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortTrafficCapture>
+
+#include <memory>
+#include <thread>
+
+#if defined(Q_OS_UNIX)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../../shared/qserialportptypair.h"
+
+namespace {
+
+struct Record
+{
+    qint64 timestamp = 0;
+    int type = 0;
+    QByteArray payload;
+};
+
+bool parseCapture(const QByteArray &data, QList<Record> *records)
+{
+    if (data.size() < 16 || !data.startsWith("QSPC") || qFromLittleEndian<quint32>(data.constData() + 4) != 1)
+        return false;
+
+    qsizetype offset = 16;
+    while (offset < data.size()) {
+        if (data.size() - offset < 12)
+            return false;
+        Record record;
+        record.timestamp = qFromLittleEndian<qint64>(data.constData() + offset);
+        const quint32 typeAndSize = qFromLittleEndian<quint32>(data.constData() + offset + 8);
+        record.type = typeAndSize >> 24;
+        const qsizetype size = typeAndSize & 0xFFFFFF;
+        if (data.size() - offset - 12 < size)
+            return false;
+        record.payload = data.mid(offset + 12, size);
+        records->append(record);
+        offset += 12 + size;
+    }
+    return true;
+}
+
+bool readCapture(const QString &fileName, QList<Record> *records)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    return parseCapture(file.readAll(), records);
+}
+
+QByteArray payloadOf(const QList<Record> &records, int type)
+{
+    QByteArray result;
+    for (const Record &record : records) {
+        if (record.type == type)
+            result += record.payload;
+    }
+    return result;
+}
+
+} // namespace
+
+class tst_QSerialPortTrafficCapture : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortTrafficCapture();
+
+private slots:
+    void initTestCase();
+
+    void startErrors();
+    void capture();
+    void settings();
+    void droppedRecords();
+
+private:
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+    QTemporaryDir m_directory;
+};
+
+tst_QSerialPortTrafficCapture::tst_QSerialPortTrafficCapture()
+{
+}
+
+void tst_QSerialPortTrafficCapture::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+void tst_QSerialPortTrafficCapture::startErrors()
+{
+    QSerialPortTrafficCapture withoutPort(nullptr);
+    QVERIFY(!withoutPort.start(m_directory.filePath(QStringLiteral("none.qspcap"))));
+    QVERIFY(!withoutPort.isActive());
+    QVERIFY(!withoutPort.errorString().isEmpty());
+
+    QSerialPort port(m_senderPortName);
+    QSerialPortTrafficCapture capture(&port);
+    QVERIFY(!capture.start(m_directory.filePath(QStringLiteral("missing/capture.qspcap"))));
+    QVERIFY(!capture.isActive());
+
+    QVERIFY(capture.start(m_directory.filePath(QStringLiteral("first.qspcap"))));
+    QSerialPortTrafficCapture second(&port);
+    QVERIFY(!second.start(m_directory.filePath(QStringLiteral("second.qspcap"))));
+    QVERIFY(capture.isActive());
+
+    capture.stop();
+    QVERIFY(!capture.isActive());
+    QVERIFY(second.start(m_directory.filePath(QStringLiteral("second.qspcap"))));
+}
+
+void tst_QSerialPortTrafficCapture::capture()
+{
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(receiverPort.open(QIODevice::ReadOnly));
+
+    const QString senderFileName = m_directory.filePath(QStringLiteral("sender.qspcap"));
+    const QString receiverFileName = m_directory.filePath(QStringLiteral("receiver.qspcap"));
+    QSerialPortTrafficCapture senderCapture(&senderPort);
+    QSerialPortTrafficCapture receiverCapture(&receiverPort);
+    QVERIFY(senderCapture.start(senderFileName));
+    QVERIFY(receiverCapture.start(receiverFileName));
+
+    QByteArray data(20000, Qt::Uninitialized);
+    for (qsizetype i = 0; i < data.size(); ++i)
+        data[i] = char(i * 7);
+
+    QByteArray received;
+    connect(&receiverPort, &QIODevice::readyRead, this, [&]() {
+        received += receiverPort.readAll();
+    });
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(received.size(), data.size());
+
+    QCOMPARE(senderCapture.capturedBytes(), quint64(data.size()));
+    QCOMPARE(receiverCapture.capturedBytes(), quint64(data.size()));
+    senderCapture.stop();
+    receiverCapture.stop();
+    QCOMPARE(senderCapture.droppedRecords(), quint64(0));
+    QCOMPARE(receiverCapture.droppedRecords(), quint64(0));
+
+    QList<Record> records;
+    QVERIFY(readCapture(senderFileName, &records));
+    QVERIFY(!records.isEmpty());
+    QCOMPARE(records.first().type, int(QSerialPortTrafficCapture::SettingsRecord));
+    QCOMPARE(payloadOf(records, QSerialPortTrafficCapture::TransmittedRecord), data);
+    QVERIFY(payloadOf(records, QSerialPortTrafficCapture::ReceivedRecord).isEmpty());
+    for (qsizetype i = 1; i < records.size(); ++i)
+        QVERIFY(records.at(i).timestamp >= records.at(i - 1).timestamp);
+
+    records.clear();
+    QVERIFY(readCapture(receiverFileName, &records));
+    QCOMPARE(payloadOf(records, QSerialPortTrafficCapture::ReceivedRecord), data);
+    QVERIFY(payloadOf(records, QSerialPortTrafficCapture::TransmittedRecord).isEmpty());
+}
+
+void tst_QSerialPortTrafficCapture::settings()
+{
+    QSerialPort port(m_senderPortName);
+    QVERIFY(port.open(QIODevice::ReadWrite));
+    QVERIFY(port.setBaudRate(QSerialPort::Baud9600));
+
+    const QString fileName = m_directory.filePath(QStringLiteral("settings.qspcap"));
+    QSerialPortTrafficCapture capture(&port);
+    QVERIFY(capture.start(fileName));
+    QVERIFY(port.setBaudRate(QSerialPort::Baud115200));
+    QVERIFY(port.setParity(QSerialPort::EvenParity));
+    capture.stop();
+
+    // Changes made while the capture is stopped are not recorded.
+    QVERIFY(port.setParity(QSerialPort::OddParity));
+
+    QList<Record> records;
+    QVERIFY(readCapture(fileName, &records));
+    QCOMPARE(records.size(), 3);
+    for (const Record &record : std::as_const(records)) {
+        QCOMPARE(record.type, int(QSerialPortTrafficCapture::SettingsRecord));
+        QCOMPARE(record.payload.size(), 12);
+    }
+    QCOMPARE(qFromLittleEndian<qint32>(records.at(0).payload.constData()), 9600);
+    QCOMPARE(qFromLittleEndian<qint32>(records.at(1).payload.constData()), 115200);
+    QCOMPARE(qFromLittleEndian<qint32>(records.at(1).payload.constData() + 4), 115200);
+    QCOMPARE(int(records.at(1).payload.at(8)), int(QSerialPort::Data8));
+    QCOMPARE(int(records.at(1).payload.at(9)), int(QSerialPort::NoParity));
+    QCOMPARE(int(records.at(2).payload.at(9)), int(QSerialPort::EvenParity));
+}
+
+void tst_QSerialPortTrafficCapture::droppedRecords()
+{
+#if defined(Q_OS_UNIX)
+    // The capture writes into a pipe that is not read until the end, so
+    // that the writer blocks once the pipe is full.
+    const QString fileName = m_directory.filePath(QStringLiteral("dropped.fifo"));
+    QVERIFY(::mkfifo(QFile::encodeName(fileName).constData(), 0600) == 0);
+    const int reader = ::open(QFile::encodeName(fileName).constData(), O_RDONLY | O_NONBLOCK);
+    QVERIFY(reader != -1);
+
+    QSerialPort port(m_senderPortName);
+    QVERIFY(port.open(QIODevice::ReadWrite));
+
+    QSerialPortTrafficCapture capture(&port);
+    capture.setBufferSize(4096);
+    QVERIFY(capture.start(fileName));
+
+    // Well past the point where the pipe and the buffer are full.
+    for (int i = 0; i < 200000 && capture.droppedRecords() < 1000; ++i)
+        QVERIFY(port.setBaudRate(i % 2 ? QSerialPort::Baud19200 : QSerialPort::Baud9600));
+    QVERIFY(capture.droppedRecords() >= 1000);
+    QCOMPARE(capture.droppedBytes(), quint64(0));
+
+    const QByteArray data(100, 'x');
+    QCOMPARE(port.write(data), qint64(data.size()));
+    QVERIFY(port.waitForBytesWritten(1000));
+    QCOMPARE(capture.droppedBytes(), quint64(data.size()));
+    QCOMPARE(capture.capturedBytes(), quint64(0));
+
+    QByteArray contents;
+    std::thread drain([reader, &contents]() {
+        ::fcntl(reader, F_SETFL, ::fcntl(reader, F_GETFL) & ~O_NONBLOCK);
+        char buffer[4096];
+        for (;;) {
+            const ssize_t bytes = ::read(reader, buffer, sizeof(buffer));
+            if (bytes > 0)
+                contents.append(buffer, bytes);
+            else if (bytes == 0 || errno != EINTR)
+                break;
+        }
+    });
+    const quint64 droppedRecords = capture.droppedRecords();
+    capture.stop();
+    drain.join();
+    ::close(reader);
+
+    // The markers account for every record dropped, and the last one is
+    // written by stop(), as no record followed the drops.
+    QList<Record> records;
+    QVERIFY(parseCapture(contents, &records));
+    QVERIFY(!records.isEmpty());
+    QCOMPARE(records.last().type, int(QSerialPortTrafficCapture::DroppedRecord));
+    quint64 markedRecords = 0;
+    quint64 markedBytes = 0;
+    for (const Record &record : std::as_const(records)) {
+        if (record.type != QSerialPortTrafficCapture::DroppedRecord)
+            continue;
+        QCOMPARE(record.payload.size(), 16);
+        markedRecords += qFromLittleEndian<quint64>(record.payload.constData());
+        markedBytes += qFromLittleEndian<quint64>(record.payload.constData() + 8);
+    }
+    QCOMPARE(markedRecords, droppedRecords);
+    QCOMPARE(markedBytes, quint64(data.size()));
+#else
+    QSKIP("This test needs a named pipe");
+#endif
+}
+
+QTEST_MAIN(tst_QSerialPortTrafficCapture)
+#include "tst_qserialporttrafficcapture.moc"
@@ -0,0 +1,317 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortTransactionQueue>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+class tst_QSerialPortTransactionQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortTransactionQueue();
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void delimiter();
+    void responseLength();
+    void matcher();
+    void pipelining();
+    void timeout();
+    void closedPort();
+    void writeError();
+    void changePort();
+
+private:
+    QByteArray readRequest(qsizetype size);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+    QSerialPort *m_hostPort = nullptr;
+    QSerialPort *m_devicePort = nullptr;
+};
+
+tst_QSerialPortTransactionQueue::tst_QSerialPortTransactionQueue()
+{
+}
+
+void tst_QSerialPortTransactionQueue::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+void tst_QSerialPortTransactionQueue::init()
+{
+    m_hostPort = new QSerialPort(m_senderPortName, this);
+    m_devicePort = new QSerialPort(m_receiverPortName, this);
+    m_hostPort->setBaudRate(QSerialPort::Baud115200);
+    m_devicePort->setBaudRate(QSerialPort::Baud115200);
+    QVERIFY(m_hostPort->open(QIODevice::ReadWrite));
+    QVERIFY(m_devicePort->open(QIODevice::ReadWrite));
+}
+
+void tst_QSerialPortTransactionQueue::cleanup()
+{
+    delete m_hostPort;
+    m_hostPort = nullptr;
+    delete m_devicePort;
+    m_devicePort = nullptr;
+}
+
+// Waits for a request of \a size bytes on the device port.
+QByteArray tst_QSerialPortTransactionQueue::readRequest(qsizetype size)
+{
+    if (!QTest::qWaitFor([&]() { return m_devicePort->bytesAvailable() >= size; }))
+        return QByteArray();
+    return m_devicePort->read(size);
+}
+
+void tst_QSerialPortTransactionQueue::delimiter()
+{
+    QSerialPortTransactionQueue queue(m_hostPort);
+    QSignalSpy replySpy(&queue, &QSerialPortTransactionQueue::replyReceived);
+
+    const quint64 requestId = queue.sendRequest("*IDN?\n", "\r\n");
+    QCOMPARE(queue.requestsInFlight(), 1);
+    QCOMPARE(readRequest(6), QByteArray("*IDN?\n"));
+
+    // The response arrives in two pieces.
+    m_devicePort->write("ACME,42");
+    QTest::qWait(20);
+    QCOMPARE(replySpy.size(), 0);
+    m_devicePort->write(",1.0\r\n");
+
+    QTRY_COMPARE(replySpy.size(), 1);
+    QCOMPARE(replySpy.at(0).at(0).toULongLong(), requestId);
+    QCOMPARE(replySpy.at(0).at(1).toByteArray(), QByteArray("ACME,42,1.0\r\n"));
+    QVERIFY(replySpy.at(0).at(2).toLongLong() > 0);
+    QCOMPARE(queue.requestsInFlight(), 0);
+}
+
+void tst_QSerialPortTransactionQueue::responseLength()
+{
+    QSerialPortTransactionQueue queue(m_hostPort);
+    QSignalSpy replySpy(&queue, &QSerialPortTransactionQueue::replyReceived);
+
+    queue.sendRequest(QByteArray::fromHex("a001"), qsizetype(4));
+    queue.sendRequest(QByteArray::fromHex("a002"), qsizetype(2));
+    QCOMPARE(queue.pendingRequestCount(), 1);
+
+    QCOMPARE(readRequest(2), QByteArray::fromHex("a001"));
+    m_devicePort->write(QByteArray::fromHex("01020304"));
+    QCOMPARE(readRequest(2), QByteArray::fromHex("a002"));
+    m_devicePort->write(QByteArray::fromHex("0506"));
+
+    QTRY_COMPARE(replySpy.size(), 2);
+    QCOMPARE(replySpy.at(0).at(1).toByteArray(), QByteArray::fromHex("01020304"));
+    QCOMPARE(replySpy.at(1).at(1).toByteArray(), QByteArray::fromHex("0506"));
+
+    // A request without a response length could never complete.
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("invalid response length"));
+    QCOMPARE(queue.sendRequest(QByteArray::fromHex("a003"), qsizetype(0)), quint64(0));
+    QCOMPARE(queue.pendingRequestCount(), 0);
+}
+
+void tst_QSerialPortTransactionQueue::matcher()
+{
+    QSerialPortTransactionQueue queue(m_hostPort);
+    QSignalSpy replySpy(&queue, &QSerialPortTransactionQueue::replyReceived);
+    QSignalSpy failedSpy(&queue, &QSerialPortTransactionQueue::requestFailed);
+
+    // A length byte, followed by the payload.
+    const auto lengthPrefixed = [](QByteArrayView data) -> qsizetype {
+        if (data.isEmpty())
+            return 0;
+        if (quint8(data.at(0)) == 0xFF)
+            return -1;
+        const qsizetype length = 1 + quint8(data.at(0));
+        return data.size() >= length ? length : 0;
+    };
+
+    queue.sendRequest("R", lengthPrefixed);
+    QCOMPARE(readRequest(1), QByteArray("R"));
+    m_devicePort->write(QByteArray("\x03" "abcX", 5));
+    QTRY_COMPARE(replySpy.size(), 1);
+    QCOMPARE(replySpy.at(0).at(1).toByteArray(), QByteArray("\x03" "abc"));
+
+    // The trailing "X" is dropped, as no request was in flight.
+    const quint64 requestId = queue.sendRequest("R", lengthPrefixed);
+    QCOMPARE(readRequest(1), QByteArray("R"));
+    m_devicePort->write("\xFF");
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), requestId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::ResponseError);
+}
+
+void tst_QSerialPortTransactionQueue::pipelining()
+{
+    QSerialPortTransactionQueue queue(m_hostPort);
+    queue.setMaximumRequestsInFlight(3);
+    QSignalSpy replySpy(&queue, &QSerialPortTransactionQueue::replyReceived);
+
+    QList<quint64> requestIds;
+    for (int i = 0; i < 5; ++i)
+        requestIds.append(queue.sendRequest(QByteArray::number(i) + '\n', "\n"));
+    QCOMPARE(queue.requestsInFlight(), 3);
+    QCOMPARE(queue.pendingRequestCount(), 2);
+
+    // Three requests arrive before the first response is sent.
+    QCOMPARE(readRequest(6), QByteArray("0\n1\n2\n"));
+    m_devicePort->write("r0\nr1\n");
+    QCOMPARE(readRequest(4), QByteArray("3\n4\n"));
+    m_devicePort->write("r2\nr3\nr4\n");
+
+    QTRY_COMPARE(replySpy.size(), 5);
+    for (int i = 0; i < 5; ++i) {
+        QCOMPARE(replySpy.at(i).at(0).toULongLong(), requestIds.at(i));
+        QCOMPARE(replySpy.at(i).at(1).toByteArray(), QByteArray('r' + QByteArray::number(i) + '\n'));
+    }
+}
+
+void tst_QSerialPortTransactionQueue::timeout()
+{
+    QSerialPortTransactionQueue queue(m_hostPort);
+    queue.setTimeout(50);
+    QSignalSpy replySpy(&queue, &QSerialPortTransactionQueue::replyReceived);
+    QSignalSpy failedSpy(&queue, &QSerialPortTransactionQueue::requestFailed);
+
+    const quint64 lostId = queue.sendRequest("A\n", "\n");
+    const quint64 answeredId = queue.sendRequest("B\n", "\n", 1000);
+    QCOMPARE(readRequest(2), QByteArray("A\n"));
+
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), lostId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::TimeoutError);
+
+    QCOMPARE(readRequest(2), QByteArray("B\n"));
+    m_devicePort->write("ok\n");
+    QTRY_COMPARE(replySpy.size(), 1);
+    QCOMPARE(replySpy.at(0).at(0).toULongLong(), answeredId);
+
+    // The requests written after an expired one are failed with it, as
+    // their responses would be matched to the wrong requests.
+    replySpy.clear();
+    failedSpy.clear();
+    queue.setMaximumRequestsInFlight(2);
+    const quint64 firstId = queue.sendRequest("C\n", "\n", 50);
+    const quint64 secondId = queue.sendRequest("D\n", "\n", 1000);
+    QCOMPARE(readRequest(4), QByteArray("C\nD\n"));
+    m_devicePort->write("partial");
+    QTRY_COMPARE(failedSpy.size(), 2);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), firstId);
+    QCOMPARE(failedSpy.at(1).at(0).toULongLong(), secondId);
+
+    // The data received before the expiry is dropped.
+    const quint64 nextId = queue.sendRequest("E\n", "\n", 1000);
+    QCOMPARE(readRequest(2), QByteArray("E\n"));
+    m_devicePort->write("ok\n");
+    QTRY_COMPARE(replySpy.size(), 1);
+    QCOMPARE(replySpy.at(0).at(0).toULongLong(), nextId);
+    QCOMPARE(replySpy.at(0).at(1).toByteArray(), QByteArray("ok\n"));
+}
+
+void tst_QSerialPortTransactionQueue::closedPort()
+{
+    // Nothing would write the requests, so they fail rather than wait.
+    QSerialPortTransactionQueue queue;
+    QSignalSpy failedSpy(&queue, &QSerialPortTransactionQueue::requestFailed);
+
+    const quint64 noPortId = queue.sendRequest("A\n", "\n");
+    // Reported once the caller has the identifier.
+    QCOMPARE(failedSpy.size(), 0);
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), noPortId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::WriteError);
+
+    m_hostPort->close();
+    queue.setPort(m_hostPort);
+    failedSpy.clear();
+    const quint64 closedId = queue.sendRequest("B\n", "\n");
+    QCOMPARE(failedSpy.size(), 0);
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), closedId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::WriteError);
+    QCOMPARE(queue.pendingRequestCount(), 0);
+
+    // A request queued behind one in flight fails once the port was closed
+    // and the one in flight timed out.
+    QVERIFY(m_hostPort->open(QIODevice::ReadWrite));
+    failedSpy.clear();
+    const quint64 inFlightId = queue.sendRequest("C\n", "\n", 50);
+    const quint64 pendingId = queue.sendRequest("D\n", "\n");
+    QCOMPARE(queue.pendingRequestCount(), 1);
+    m_hostPort->close();
+    QTRY_COMPARE(failedSpy.size(), 2);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), inFlightId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::TimeoutError);
+    QCOMPARE(failedSpy.at(1).at(0).toULongLong(), pendingId);
+    QCOMPARE(failedSpy.at(1).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::WriteError);
+}
+
+void tst_QSerialPortTransactionQueue::writeError()
+{
+    m_hostPort->close();
+    QVERIFY(m_hostPort->open(QIODevice::ReadOnly));
+
+    QSerialPortTransactionQueue queue(m_hostPort);
+    QSignalSpy failedSpy(&queue, &QSerialPortTransactionQueue::requestFailed);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("ReadOnly device"));
+    const quint64 requestId = queue.sendRequest("A\n", "\n");
+    QCOMPARE(failedSpy.size(), 0);
+    QTRY_COMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), requestId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::WriteError);
+}
+
+void tst_QSerialPortTransactionQueue::changePort()
+{
+    QSerialPortTransactionQueue queue(m_hostPort);
+    QSignalSpy failedSpy(&queue, &QSerialPortTransactionQueue::requestFailed);
+
+    // The request in flight is failed before the next one is written to
+    // the new port.
+    qsizetype inFlightOnFailure = -1;
+    connect(&queue, &QSerialPortTransactionQueue::requestFailed, this, [&]() {
+        inFlightOnFailure = queue.requestsInFlight();
+    });
+
+    const quint64 droppedId = queue.sendRequest("A\n", "\n");
+    const quint64 pendingId = queue.sendRequest("B\n", "\n");
+    QCOMPARE(readRequest(2), QByteArray("A\n"));
+
+    queue.setPort(m_devicePort);
+    QCOMPARE(failedSpy.size(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toULongLong(), droppedId);
+    QCOMPARE(failedSpy.at(0).at(1).value<QSerialPortTransactionQueue::Error>(),
+             QSerialPortTransactionQueue::PortChangedError);
+    QCOMPARE(inFlightOnFailure, 0);
+    QCOMPARE(queue.requestsInFlight(), 1);
+
+    QSignalSpy replySpy(&queue, &QSerialPortTransactionQueue::replyReceived);
+    QTRY_COMPARE(m_hostPort->bytesAvailable(), 2);
+    QCOMPARE(m_hostPort->readAll(), QByteArray("B\n"));
+    m_hostPort->write("ok\n");
+    QTRY_COMPARE(replySpy.size(), 1);
+    QCOMPARE(replySpy.at(0).at(0).toULongLong(), pendingId);
+}
+
+QTEST_MAIN(tst_QSerialPortTransactionQueue)
+#include "tst_qserialporttransactionqueue.moc"
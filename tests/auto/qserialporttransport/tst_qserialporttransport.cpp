@@ -0,0 +1,335 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+
+#include <private/qserialport_p.h>
+#include <private/qserialporttransport_p.h>
+
+#include <memory>
+
+#include "../../shared/qserialportptypair.h"
+
+// Records the sizes the port asks to read.
+class RecordingTransport : public QSerialPortTransport
+{
+public:
+    qint64 read(int descriptor, char *data, qint64 maxSize) override
+    {
+        readSizes.append(maxSize);
+        return QSerialPortTransport::read(descriptor, data, maxSize);
+    }
+
+    QList<qint64> readSizes;
+};
+
+class tst_QSerialPortTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_QSerialPortTransport();
+
+private slots:
+    void initTestCase();
+
+    void partialWrites_data();
+    void partialWrites();
+    void wouldBlockStorm();
+    void droppedAndCorruptedBytes();
+    void unplug();
+    void idleMemoryMode();
+
+private:
+    static QByteArray testData(qsizetype size);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+};
+
+tst_QSerialPortTransport::tst_QSerialPortTransport()
+{
+}
+
+QByteArray tst_QSerialPortTransport::testData(qsizetype size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; ++i)
+        data[i] = char(i * 7 + i / 256);
+    return data;
+}
+
+void tst_QSerialPortTransport::initTestCase()
+{
+    // Without real ports, two linked pseudo terminals stand in for them.
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+void tst_QSerialPortTransport::partialWrites_data()
+{
+    QTest::addColumn<bool>("blocking");
+    QTest::addColumn<qint64>("maximumSize");
+
+    QTest::newRow("async, 1") << false << qint64(1);
+    QTest::newRow("async, 7") << false << qint64(7);
+    QTest::newRow("async, 1000") << false << qint64(1000);
+    QTest::newRow("blocking, 7") << true << qint64(7);
+}
+
+void tst_QSerialPortTransport::partialWrites()
+{
+    QFETCH(bool, blocking);
+    QFETCH(qint64, maximumSize);
+
+    const QByteArray data = testData(blocking ? 4000 : 20000);
+
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(receiverPort.open(QIODevice::ReadOnly));
+
+    QSerialPortFaultInjectionTransport transport;
+    QSerialPortFaultInjectionTransport::Faults faults;
+    faults.maximumSize = maximumSize;
+    transport.setWriteFaults(faults);
+    QSerialPortPrivate::get(&senderPort)->transport = &transport;
+
+    qint64 bytesWritten = 0;
+    connect(&senderPort, &QIODevice::bytesWritten, this, [&bytesWritten](qint64 bytes) {
+        bytesWritten += bytes;
+    });
+    QSignalSpy errorSpy(&senderPort, &QSerialPort::errorOccurred);
+    QByteArray received;
+    connect(&receiverPort, &QIODevice::readyRead, this, [&]() {
+        received += receiverPort.readAll();
+    });
+
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    if (blocking) {
+        while (senderPort.bytesToWrite() > 0)
+            QVERIFY(senderPort.waitForBytesWritten(1000));
+    }
+
+    QTRY_COMPARE(bytesWritten, qint64(data.size()));
+    QTRY_COMPARE(received.size(), data.size());
+    QCOMPARE(received, data);
+    QCOMPARE(errorSpy.count(), 0);
+
+    const auto statistics = transport.writeStatistics();
+    QCOMPARE(statistics.transferredBytes, qint64(data.size()));
+    QVERIFY(statistics.shortTransfers >= data.size() / maximumSize - 1);
+
+    QSerialPortPrivate::get(&senderPort)->transport = nullptr;
+}
+
+void tst_QSerialPortTransport::wouldBlockStorm()
+{
+    const QByteArray data = testData(10000);
+
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(receiverPort.open(QIODevice::ReadOnly));
+
+    QSerialPortFaultInjectionTransport senderTransport(1);
+    QSerialPortFaultInjectionTransport receiverTransport(2);
+    QSerialPortFaultInjectionTransport::Faults faults;
+    faults.wouldBlockRate = 0.5;
+    faults.maximumSize = 100;
+    senderTransport.setWriteFaults(faults);
+    faults.wouldBlockRate = 0.9;
+    receiverTransport.setReadFaults(faults);
+    QSerialPortPrivate::get(&senderPort)->transport = &senderTransport;
+    QSerialPortPrivate::get(&receiverPort)->transport = &receiverTransport;
+
+    QSignalSpy senderErrorSpy(&senderPort, &QSerialPort::errorOccurred);
+    QSignalSpy receiverErrorSpy(&receiverPort, &QSerialPort::errorOccurred);
+    QByteArray received;
+    connect(&receiverPort, &QIODevice::readyRead, this, [&]() {
+        received += receiverPort.readAll();
+    });
+
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(received.size(), data.size());
+    QCOMPARE(received, data);
+
+    // Refused calls are retried, and do not surface as errors.
+    QVERIFY(senderTransport.writeStatistics().wouldBlocks > 0);
+    QVERIFY(receiverTransport.readStatistics().wouldBlocks > 0);
+    QCOMPARE(senderErrorSpy.count(), 0);
+    QCOMPARE(receiverErrorSpy.count(), 0);
+    QCOMPARE(senderPort.error(), QSerialPort::NoError);
+    QCOMPARE(receiverPort.error(), QSerialPort::NoError);
+
+    // The blocking API waits through them too.
+    received.clear();
+    QCOMPARE(senderPort.write(data.first(500)), qint64(500));
+    while (senderPort.bytesToWrite() > 0)
+        QVERIFY(senderPort.waitForBytesWritten(1000));
+    while (received.size() < 500 && receiverPort.waitForReadyRead(1000)) {
+    }
+    QCOMPARE(received, data.first(500));
+
+    QSerialPortPrivate::get(&senderPort)->transport = nullptr;
+    QSerialPortPrivate::get(&receiverPort)->transport = nullptr;
+}
+
+void tst_QSerialPortTransport::droppedAndCorruptedBytes()
+{
+    const QByteArray data = testData(10000);
+
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(receiverPort.open(QIODevice::ReadOnly));
+
+    QSerialPortFaultInjectionTransport transport;
+    QSerialPortFaultInjectionTransport::Faults faults;
+    faults.dropRate = 0.05;
+    transport.setReadFaults(faults);
+    QSerialPortPrivate::get(&receiverPort)->transport = &transport;
+
+    QByteArray received;
+    connect(&receiverPort, &QIODevice::readyRead, this, [&]() {
+        received += receiverPort.readAll();
+    });
+
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(transport.readStatistics().transferredBytes, qint64(data.size()));
+    QVERIFY(transport.readStatistics().droppedBytes > 0);
+    QTRY_COMPARE(qint64(received.size()),
+                 qint64(data.size()) - transport.readStatistics().droppedBytes);
+
+    faults.dropRate = 0;
+    faults.corruptionRate = 0.05;
+    transport.setReadFaults(faults);
+    received.clear();
+
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(received.size(), data.size());
+    qint64 corruptedBytes = 0;
+    for (qsizetype i = 0; i < data.size(); ++i) {
+        if (received.at(i) != data.at(i))
+            ++corruptedBytes;
+    }
+    QVERIFY(corruptedBytes > 0);
+    QCOMPARE(corruptedBytes, transport.readStatistics().corruptedBytes);
+    QCOMPARE(receiverPort.error(), QSerialPort::NoError);
+
+    QSerialPortPrivate::get(&receiverPort)->transport = nullptr;
+}
+
+void tst_QSerialPortTransport::unplug()
+{
+    const QByteArray data = testData(5000);
+
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(receiverPort.open(QIODevice::ReadOnly));
+
+    QSerialPortFaultInjectionTransport transport;
+    transport.setDisconnectAfter(1000);
+    QSerialPortPrivate::get(&receiverPort)->transport = &transport;
+
+    QByteArray received;
+    connect(&receiverPort, &QIODevice::readyRead, this, [&]() {
+        received += receiverPort.readAll();
+    });
+    QSignalSpy errorSpy(&receiverPort, &QSerialPort::errorOccurred);
+
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(receiverPort.error(), QSerialPort::ResourceError);
+    QVERIFY(transport.isDisconnected());
+    QCOMPARE(received, data.first(1000));
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(errorSpy.at(0).at(0).value<QSerialPort::SerialPortError>(),
+             QSerialPort::ResourceError);
+
+    QSerialPortPrivate::get(&receiverPort)->transport = nullptr;
+}
+
+void tst_QSerialPortTransport::idleMemoryMode()
+{
+    QSerialPort senderPort(m_senderPortName);
+    QSerialPort receiverPort(m_receiverPortName);
+    senderPort.setIdleMemoryModeEnabled(true);
+    receiverPort.setIdleMemoryModeEnabled(true);
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(receiverPort.open(QIODevice::ReadOnly));
+    QSerialPortPrivate *sender = QSerialPortPrivate::get(&senderPort);
+
+    RecordingTransport receiverTransport;
+    QSerialPortPrivate::get(&receiverPort)->transport = &receiverTransport;
+    QSerialPortFaultInjectionTransport senderTransport;
+    sender->transport = &senderTransport;
+
+    qint64 bytesWritten = 0;
+    bool notifierUsed = false;
+    connect(&senderPort, &QIODevice::bytesWritten, this, [&](qint64 bytes) {
+        bytesWritten += bytes;
+        notifierUsed |= sender->writeNotifier != nullptr;
+    });
+    QByteArray received;
+    connect(&receiverPort, &QIODevice::readyRead, this, [&]() {
+        received += receiverPort.readAll();
+    });
+
+    // A write the device takes at once needs no write notifier, and the
+    // reads are sized by the data that is waiting.
+    const QByteArray data = testData(10);
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QVERIFY(!sender->writeNotifier);
+    QTRY_COMPARE(bytesWritten, qint64(data.size()));
+    QVERIFY(!notifierUsed);
+    QVERIFY(!sender->writeNotifier);
+    QTRY_COMPARE(received, data);
+    QVERIFY(!receiverTransport.readSizes.isEmpty());
+    for (qint64 size : std::as_const(receiverTransport.readSizes))
+        QVERIFY2(size <= data.size(), QByteArray::number(size));
+
+    // A stalled write creates the notifier, which goes away once the write
+    // buffer is drained.
+    QSerialPortFaultInjectionTransport::Faults faults;
+    faults.maximumSize = 7;
+    senderTransport.setWriteFaults(faults);
+    bytesWritten = 0;
+    received.clear();
+    const QByteArray largeData = testData(1000);
+    QCOMPARE(senderPort.write(largeData), qint64(largeData.size()));
+    QTRY_COMPARE(bytesWritten, qint64(largeData.size()));
+    QVERIFY(notifierUsed);
+    QVERIFY(!sender->writeNotifier);
+    QTRY_COMPARE(received, largeData);
+
+    // Suspending in the middle of a stalled write releases the notifier.
+    faults.wouldBlockRate = 1;
+    senderTransport.setWriteFaults(faults);
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_VERIFY(sender->writeNotifier);
+    QVERIFY(senderPort.suspend());
+    QVERIFY(!sender->writeNotifier);
+    senderTransport.setWriteFaults({});
+    QVERIFY(senderPort.open(QIODevice::WriteOnly));
+    QVERIFY(!sender->writeNotifier);
+    received.clear();
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(received, data);
+    QVERIFY(!sender->writeNotifier);
+
+    // Without the mode, every read reserves a full chunk.
+    receiverPort.setIdleMemoryModeEnabled(false);
+    receiverTransport.readSizes.clear();
+    received.clear();
+    QCOMPARE(senderPort.write(data), qint64(data.size()));
+    QTRY_COMPARE(received, data);
+    QCOMPARE(receiverTransport.readSizes.constFirst(), qint64(QSERIALPORT_BUFFERSIZE));
+
+    sender->transport = nullptr;
+    QSerialPortPrivate::get(&receiverPort)->transport = nullptr;
+}
+
+QTEST_MAIN(tst_QSerialPortTransport)
+#include "tst_qserialporttransport.moc"
@@ -0,0 +1,372 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPort>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "../../shared/qserialportptypair.h"
+
+namespace {
+
+enum {
+    Timeout = 5000,
+    PingPongRounds = 1000,
+    StreamSize = 1024 * 1024
+};
+
+bool openPort(QSerialPort &port)
+{
+    port.setBaudRate(QSerialPort::Baud115200);
+    return port.open(QIODevice::ReadWrite);
+}
+
+bool readExactly(QSerialPort &port, char *data, qint64 size)
+{
+    qint64 done = 0;
+    while (done < size) {
+        if (port.bytesAvailable() == 0 && !port.waitForReadyRead(Timeout))
+            return false;
+        const qint64 bytesRead = port.read(data + done, size - done);
+        if (bytesRead < 0)
+            return false;
+        done += bytesRead;
+    }
+    return true;
+}
+
+bool writeAll(QSerialPort &port, const char *data, qint64 size)
+{
+    if (port.write(data, size) != size)
+        return false;
+    while (port.bytesToWrite() > 0) {
+        if (!port.waitForBytesWritten(Timeout))
+            return false;
+    }
+    return true;
+}
+
+void reportLatencies(std::vector<qint64> &latencies, qint64 elapsed)
+{
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](int p) {
+        return qlonglong(latencies.at((latencies.size() - 1) * p / 100));
+    };
+    qInfo("%s: %.0f ops/s, latency p50 %lld ns, p90 %lld ns, p99 %lld ns, max %lld ns",
+          QTest::currentDataTag(), latencies.size() * 1e9 / elapsed,
+          percentile(50), percentile(90), percentile(99), qlonglong(latencies.back()));
+    QTest::setBenchmarkResult(percentile(50), QTest::WalltimeNanoseconds);
+}
+
+void reportThroughput(qint64 bytes, qint64 elapsed)
+{
+    const qreal bytesPerSecond = bytes * 1e9 / elapsed;
+    qInfo("%s: %.2f MB/s", QTest::currentDataTag(), bytesPerSecond / (1024 * 1024));
+    QTest::setBenchmarkResult(bytesPerSecond, QTest::BytesPerSecond);
+}
+
+} // namespace
+
+class tst_QSerialPort : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void pingPong_data();
+    void pingPong();
+    void stream_data();
+    void stream();
+    void fanIn_data();
+    void fanIn();
+    void limitedReadBuffer_data();
+    void limitedReadBuffer();
+
+private:
+    std::unique_ptr<QThread> startPeer(const std::function<void(QSerialPort &port)> &function);
+    qint64 streamAsync(const QList<QSerialPort *> &senders, const QList<QSerialPort *> &receivers,
+                       int chunkSize, qint64 size);
+
+    QString m_senderPortName;
+    QString m_receiverPortName;
+    std::unique_ptr<QSerialPortPtyPair> m_ptyPair;
+};
+
+void tst_QSerialPort::initTestCase()
+{
+    if (!QSerialPortPtyPair::resolvePortNames(&m_senderPortName, &m_receiverPortName, &m_ptyPair))
+        QSKIP(QSerialPortPtyPair::missingPortsMessage);
+}
+
+// Runs the function on the receiver port in a thread of its own, as a
+// blocking peer would, and returns once the port is opened there.
+std::unique_ptr<QThread> tst_QSerialPort::startPeer(
+        const std::function<void(QSerialPort &port)> &function)
+{
+    QSemaphore opened;
+    bool success = false;
+    std::unique_ptr<QThread> thread(QThread::create([&, function]() {
+        QSerialPort port(m_receiverPortName);
+        const bool isOpen = openPort(port);
+        success = isOpen;
+        opened.release();
+        if (isOpen)
+            function(port);
+    }));
+    thread->start();
+    opened.acquire();
+    if (!success) {
+        thread->wait();
+        thread.reset();
+    }
+    return thread;
+}
+
+// Writes size bytes in chunks to each of the senders, and returns the time
+// it took until all of them have arrived at the receivers, or -1 on timeout.
+qint64 tst_QSerialPort::streamAsync(const QList<QSerialPort *> &senders,
+                                    const QList<QSerialPort *> &receivers,
+                                    int chunkSize, qint64 size)
+{
+    const QByteArray chunk(chunkSize, 's');
+    QList<qint64> sent(senders.size(), 0);
+    qint64 remaining = size * receivers.size();
+
+    QTimer watchdog;
+    watchdog.setSingleShot(true);
+    watchdog.setInterval(Timeout);
+
+    const auto writeNext = [&](qsizetype i) {
+        QSerialPort *sender = senders.at(i);
+        if (sender->bytesToWrite() > 0 || sent.at(i) >= size)
+            return;
+        sent[i] += sender->write(chunk.constData(), qMin<qint64>(chunkSize, size - sent.at(i)));
+    };
+
+    // Declared last, so that the connections are gone before the state they use.
+    QEventLoop loop;
+    connect(&watchdog, &QTimer::timeout, &loop, [&loop]() { loop.exit(1); });
+    for (qsizetype i = 0; i < senders.size(); ++i)
+        connect(senders.at(i), &QSerialPort::bytesWritten, &loop, [&writeNext, i]() { writeNext(i); });
+    for (QSerialPort *receiver : receivers) {
+        connect(receiver, &QSerialPort::readyRead, &loop, [&, receiver]() {
+            remaining -= receiver->skip(receiver->bytesAvailable());
+            watchdog.start();
+            if (remaining <= 0)
+                loop.quit();
+        });
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    watchdog.start();
+    for (qsizetype i = 0; i < senders.size(); ++i)
+        writeNext(i);
+    if (loop.exec() != 0)
+        return -1;
+    return timer.nsecsElapsed();
+}
+
+void tst_QSerialPort::pingPong_data()
+{
+    QTest::addColumn<bool>("blocking");
+    QTest::addColumn<int>("size");
+
+    for (int size : {1, 16, 256}) {
+        QTest::addRow("async-%d", size) << false << size;
+        QTest::addRow("blocking-%d", size) << true << size;
+    }
+}
+
+void tst_QSerialPort::pingPong()
+{
+    QFETCH(bool, blocking);
+    QFETCH(int, size);
+
+    const QByteArray message(size, 'p');
+    std::vector<qint64> latencies;
+    latencies.reserve(PingPongRounds);
+    QElapsedTimer total;
+    QElapsedTimer timer;
+
+    if (blocking) {
+        std::unique_ptr<QThread> peer = startPeer([size](QSerialPort &port) {
+            QByteArray buffer(size, Qt::Uninitialized);
+            for (int i = 0; i < PingPongRounds; ++i) {
+                if (!readExactly(port, buffer.data(), size)
+                        || !writeAll(port, buffer.constData(), size)) {
+                    return;
+                }
+            }
+        });
+        QVERIFY(peer);
+        const auto joinPeer = qScopeGuard([&peer]() { peer->wait(); });
+
+        QSerialPort sender(m_senderPortName);
+        QVERIFY(openPort(sender));
+        QByteArray reply(size, Qt::Uninitialized);
+        total.start();
+        for (int i = 0; i < PingPongRounds; ++i) {
+            timer.start();
+            QVERIFY(writeAll(sender, message.constData(), size));
+            QVERIFY(readExactly(sender, reply.data(), size));
+            latencies.push_back(timer.nsecsElapsed());
+        }
+    } else {
+        QSerialPort sender(m_senderPortName);
+        QSerialPort receiver(m_receiverPortName);
+        QVERIFY(openPort(sender));
+        QVERIFY(openPort(receiver));
+
+        qint64 received = 0;
+        QTimer watchdog;
+        watchdog.setSingleShot(true);
+        watchdog.setInterval(Timeout);
+        QEventLoop loop;
+        connect(&watchdog, &QTimer::timeout, &loop, [&loop]() { loop.exit(1); });
+        connect(&receiver, &QSerialPort::readyRead, &loop, [&receiver]() {
+            receiver.write(receiver.readAll());
+        });
+        connect(&sender, &QSerialPort::readyRead, &loop, [&]() {
+            received += sender.skip(sender.bytesAvailable());
+            if (received < size)
+                return;
+            latencies.push_back(timer.nsecsElapsed());
+            received = 0;
+            if (latencies.size() == size_t(PingPongRounds)) {
+                loop.quit();
+                return;
+            }
+            watchdog.start();
+            timer.start();
+            sender.write(message);
+        });
+
+        total.start();
+        watchdog.start();
+        timer.start();
+        sender.write(message);
+        QCOMPARE(loop.exec(), 0);
+    }
+
+    reportLatencies(latencies, total.nsecsElapsed());
+}
+
+void tst_QSerialPort::stream_data()
+{
+    QTest::addColumn<bool>("blocking");
+    QTest::addColumn<int>("chunkSize");
+
+    for (int chunkSize : {64, 4096, 65536}) {
+        QTest::addRow("async-%d", chunkSize) << false << chunkSize;
+        QTest::addRow("blocking-%d", chunkSize) << true << chunkSize;
+    }
+}
+
+void tst_QSerialPort::stream()
+{
+    QFETCH(bool, blocking);
+    QFETCH(int, chunkSize);
+
+    qint64 elapsed = -1;
+    if (blocking) {
+        qint64 received = 0;
+        std::unique_ptr<QThread> peer = startPeer([&received](QSerialPort &port) {
+            while (received < StreamSize) {
+                if (port.bytesAvailable() == 0 && !port.waitForReadyRead(Timeout))
+                    return;
+                received += port.skip(port.bytesAvailable());
+            }
+        });
+        QVERIFY(peer);
+        const auto joinPeer = qScopeGuard([&peer]() { peer->wait(); });
+
+        QSerialPort sender(m_senderPortName);
+        QVERIFY(openPort(sender));
+        const QByteArray chunk(chunkSize, 's');
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 sent = 0; sent < StreamSize; sent += chunkSize)
+            QVERIFY(writeAll(sender, chunk.constData(), qMin<qint64>(chunkSize, StreamSize - sent)));
+        QVERIFY(peer->wait(Timeout));
+        elapsed = timer.nsecsElapsed();
+        QCOMPARE(received, qint64(StreamSize));
+    } else {
+        QSerialPort sender(m_senderPortName);
+        QSerialPort receiver(m_receiverPortName);
+        QVERIFY(openPort(sender));
+        QVERIFY(openPort(receiver));
+        elapsed = streamAsync({&sender}, {&receiver}, chunkSize, StreamSize);
+        QVERIFY(elapsed > 0);
+    }
+
+    reportThroughput(StreamSize, elapsed);
+}
+
+void tst_QSerialPort::fanIn_data()
+{
+    QTest::addColumn<int>("count");
+
+    for (int count : {2, 8, 32})
+        QTest::addRow("%d", count) << count;
+}
+
+void tst_QSerialPort::fanIn()
+{
+    QFETCH(int, count);
+
+    if (!m_ptyPair)
+        QSKIP("This benchmark needs pseudo terminals for the pairs of ports");
+
+    std::vector<std::unique_ptr<QSerialPortPtyPair>> pairs;
+    std::vector<std::unique_ptr<QSerialPort>> ports;
+    QList<QSerialPort *> senders;
+    QList<QSerialPort *> receivers;
+    for (int i = 0; i < count; ++i) {
+        pairs.push_back(std::make_unique<QSerialPortPtyPair>());
+        QVERIFY(pairs.back()->isValid());
+        ports.push_back(std::make_unique<QSerialPort>(pairs.back()->senderPortName()));
+        senders.append(ports.back().get());
+        QVERIFY(openPort(*senders.back()));
+        ports.push_back(std::make_unique<QSerialPort>(pairs.back()->receiverPortName()));
+        receivers.append(ports.back().get());
+        QVERIFY(openPort(*receivers.back()));
+    }
+
+    // All the receivers are served by the one event loop.
+    const qint64 size = StreamSize / count;
+    const qint64 elapsed = streamAsync(senders, receivers, 4096, size);
+    QVERIFY(elapsed > 0);
+    reportThroughput(size * count, elapsed);
+}
+
+void tst_QSerialPort::limitedReadBuffer_data()
+{
+    QTest::addColumn<int>("readBufferSize");
+
+    for (int readBufferSize : {64, 512, 4096, 0})
+        QTest::addRow("%d", readBufferSize) << readBufferSize;
+}
+
+void tst_QSerialPort::limitedReadBuffer()
+{
+    QFETCH(int, readBufferSize);
+
+    QSerialPort sender(m_senderPortName);
+    QSerialPort receiver(m_receiverPortName);
+    receiver.setReadBufferSize(readBufferSize);
+    QVERIFY(openPort(sender));
+    QVERIFY(openPort(receiver));
+
+    const qint64 elapsed = streamAsync({&sender}, {&receiver}, 4096, StreamSize);
+    QVERIFY(elapsed > 0);
+    reportThroughput(StreamSize, elapsed);
+}
+
+QTEST_MAIN(tst_QSerialPort)
+#include "tst_bench_qserialport.moc"
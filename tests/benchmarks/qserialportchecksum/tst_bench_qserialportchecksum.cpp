@@ -0,0 +1,61 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <QtSerialPort/QSerialPortChecksum>
+
+Q_DECLARE_METATYPE(QSerialPortChecksum::Algorithm);
+
+class tst_QSerialPortChecksum : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void checksum_data();
+    void checksum();
+};
+
+void tst_QSerialPortChecksum::checksum_data()
+{
+    QTest::addColumn<QSerialPortChecksum::Algorithm>("algorithm");
+    QTest::addColumn<int>("size");
+
+    const struct {
+        const char *name;
+        QSerialPortChecksum::Algorithm algorithm;
+    } algorithms[] = {
+        { "Crc8", QSerialPortChecksum::Crc8 },
+        { "Crc16Modbus", QSerialPortChecksum::Crc16Modbus },
+        { "Crc16Xmodem", QSerialPortChecksum::Crc16Xmodem },
+        { "Crc32", QSerialPortChecksum::Crc32 },
+        { "Crc32C", QSerialPortChecksum::Crc32C },
+        { "Lrc", QSerialPortChecksum::Lrc },
+        { "Xor", QSerialPortChecksum::Xor },
+    };
+
+    // From a Modbus frame to a full read buffer.
+    for (const auto &entry : algorithms) {
+        for (int size : {8, 256, 32768}) {
+            QTest::addRow("%s-%d", entry.name, size) << entry.algorithm << size;
+        }
+    }
+}
+
+void tst_QSerialPortChecksum::checksum()
+{
+    QFETCH(QSerialPortChecksum::Algorithm, algorithm);
+    QFETCH(int, size);
+
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        data[i] = char(i * 31);
+
+    quint32 result = 0;
+    QBENCHMARK {
+        result ^= QSerialPortChecksum::checksum(data, algorithm);
+    }
+    Q_UNUSED(result);
+}
+
+QTEST_MAIN(tst_QSerialPortChecksum)
+#include "tst_bench_qserialportchecksum.moc"
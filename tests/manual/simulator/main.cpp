@@ -0,0 +1,146 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "qserialportsimulator.h"
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qsocketnotifier.h>
+#include <QtCore/qtextstream.h>
+#include <QtCore/qtimer.h>
+
+#include <signal.h>
+#include <unistd.h>
+
+// Spins up virtual devices on pseudo terminals, prints the names of their
+// ports, and services them until interrupted:
+//
+//   serialportsimulator --devices 200 --model modbus
+//   serialportsimulator --devices 500 --model telemetry --baud 115200 --statistics
+
+namespace {
+
+int signalPipe[2] = { -1, -1 };
+
+void handleSignal(int)
+{
+    const char byte = 0;
+    const ssize_t written = ::write(signalPipe[1], &byte, 1);
+    Q_UNUSED(written);
+}
+
+std::unique_ptr<QSerialPortSimulatorModel> createModel(const QCommandLineParser &parser, int index)
+{
+    const QString model = parser.value(QStringLiteral("model"));
+    if (model == QLatin1String("echo"))
+        return std::make_unique<QSerialPortEchoModel>();
+    if (model == QLatin1String("fixed")) {
+        return std::make_unique<QSerialPortFixedResponseModel>(
+                parser.value(QStringLiteral("response")).toLatin1() + "\r\n");
+    }
+    if (model == QLatin1String("modbus")) {
+        return std::make_unique<QSerialPortModbusServerModel>(
+                quint8(parser.value(QStringLiteral("address")).toUInt()));
+    }
+    if (model == QLatin1String("telemetry")) {
+        const QString frame = parser.value(QStringLiteral("frame"));
+        return std::make_unique<QSerialPortTelemetryModel>(
+                parser.value(QStringLiteral("baud")).toInt(), [frame, index](quint64 sequence) {
+            return frame.arg(index).arg(sequence).toLatin1() + "\r\n";
+        });
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("serialportsimulator"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+            "Simulates serial devices on pseudo terminals, for load tests of QSerialPort."));
+    parser.addHelpOption();
+    parser.addOptions({
+        { { QStringLiteral("n"), QStringLiteral("devices") },
+          QStringLiteral("The number of devices."), QStringLiteral("count"), QStringLiteral("1") },
+        { { QStringLiteral("m"), QStringLiteral("model") },
+          QStringLiteral("The model of the devices: echo, fixed, modbus or telemetry."),
+          QStringLiteral("model"), QStringLiteral("echo") },
+        { { QStringLiteral("t"), QStringLiteral("threads") },
+          QStringLiteral("The number of service threads."), QStringLiteral("count"),
+          QStringLiteral("2") },
+        { QStringLiteral("response"),
+          QStringLiteral("The response of the fixed model to each line."),
+          QStringLiteral("text"), QStringLiteral("OK") },
+        { QStringLiteral("address"),
+          QStringLiteral("The server address of the modbus model."),
+          QStringLiteral("address"), QStringLiteral("1") },
+        { QStringLiteral("baud"),
+          QStringLiteral("The baud rate at which the telemetry model sends."),
+          QStringLiteral("rate"), QStringLiteral("9600") },
+        { QStringLiteral("frame"),
+          QStringLiteral("The line the telemetry model sends, with %1 for the device and "
+                         "%2 for the sequence number."),
+          QStringLiteral("text"), QStringLiteral("$TLM,%1,%2,23.5,1013.2") },
+        { { QStringLiteral("s"), QStringLiteral("statistics") },
+          QStringLiteral("Print the traffic every second.") }
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const int deviceCount = parser.value(QStringLiteral("devices")).toInt();
+    const qint32 baudRate = parser.value(QStringLiteral("baud")).toInt();
+    if (deviceCount < 1 || baudRate < 1 || !createModel(parser, 0)) {
+        err << "Invalid number of devices, baud rate or model" << Qt::endl;
+        return 1;
+    }
+
+    if (!QSerialPortSimulator::raiseFileDescriptorLimit())
+        err << "Could not raise the limit of open files" << Qt::endl;
+
+    QSerialPortSimulator simulator(parser.value(QStringLiteral("threads")).toInt());
+    for (int i = 0; i < deviceCount; ++i) {
+        const QString portName = simulator.addDevice(createModel(parser, i));
+        if (portName.isEmpty()) {
+            err << "Could not create device " << i << ": " << simulator.errorString() << Qt::endl;
+            return 1;
+        }
+        out << portName << Qt::endl;
+    }
+    if (!simulator.start()) {
+        err << "Could not start: " << simulator.errorString() << Qt::endl;
+        return 1;
+    }
+
+    if (::pipe(signalPipe) == 0) {
+        ::signal(SIGINT, handleSignal);
+        ::signal(SIGTERM, handleSignal);
+        auto notifier = new QSocketNotifier(signalPipe[0], QSocketNotifier::Read, &app);
+        QObject::connect(notifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+    }
+
+    if (parser.isSet(QStringLiteral("statistics"))) {
+        auto timer = new QTimer(&app);
+        quint64 receivedBytes = 0;
+        quint64 sentBytes = 0;
+        quint64 wakeups = 0;
+        QObject::connect(timer, &QTimer::timeout, &app, [&]() {
+            err << "received " << simulator.receivedBytes() - receivedBytes << " B/s, sent "
+                << simulator.sentBytes() - sentBytes << " B/s, "
+                << simulator.wakeups() - wakeups << " wakeups/s" << Qt::endl;
+            receivedBytes = simulator.receivedBytes();
+            sentBytes = simulator.sentBytes();
+            wakeups = simulator.wakeups();
+        });
+        timer->start(1000);
+    }
+
+    const int result = app.exec();
+    simulator.stop();
+    return result;
+}
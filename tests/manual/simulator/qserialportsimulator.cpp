@@ -0,0 +1,518 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "qserialportsimulator.h"
+
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qendian.h>
+#include <QtSerialPort/qserialportchecksum.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+enum {
+    // A device that cannot send queues no more than this.
+    MaximumQueuedBytes = 64 * 1024,
+    MaximumModbusFrameSize = 9 + 255,
+    EventsPerWait = 64
+};
+
+qint64 currentTime()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+} // namespace
+
+QSerialPortSimulatorModel::~QSerialPortSimulatorModel() = default;
+
+qint64 QSerialPortSimulatorModel::nextTick(qint64 now) const
+{
+    Q_UNUSED(now);
+    return -1;
+}
+
+void QSerialPortSimulatorModel::tick(qint64 now, QByteArray *output)
+{
+    Q_UNUSED(now);
+    Q_UNUSED(output);
+}
+
+void QSerialPortEchoModel::received(QByteArrayView data, QByteArray *output)
+{
+    output->append(data);
+}
+
+QSerialPortFixedResponseModel::QSerialPortFixedResponseModel(const QByteArray &response,
+                                                             char terminator)
+    : m_response(response)
+    , m_terminator(terminator)
+{
+}
+
+void QSerialPortFixedResponseModel::received(QByteArrayView data, QByteArray *output)
+{
+    for (char c : data) {
+        if (c == m_terminator)
+            output->append(m_response);
+    }
+}
+
+QSerialPortModbusServerModel::QSerialPortModbusServerModel(quint8 address, int registerCount)
+    : m_address(address)
+    , m_registers(registerCount, 0)
+{
+    for (int i = 0; i < registerCount; ++i)
+        m_registers[i] = quint16(i);
+}
+
+// Returns the size of the request at the front, or 0 if it is not known yet.
+qsizetype QSerialPortModbusServerModel::frameSize() const
+{
+    if (m_request.size() < 2)
+        return 0;
+    if (quint8(m_request.at(1)) != 16)
+        return 8;
+    if (m_request.size() < 7)
+        return 0;
+    return 9 + quint8(m_request.at(6));
+}
+
+void QSerialPortModbusServerModel::received(QByteArrayView data, QByteArray *output)
+{
+    m_request.append(data);
+
+    for (;;) {
+        const qsizetype size = frameSize();
+        if (size == 0 || m_request.size() < size)
+            break;
+
+        // The CRC over a frame including its own CRC is zero. Otherwise,
+        // the start of the next frame is searched byte by byte.
+        const QByteArrayView frame(m_request.constData(), size);
+        if (QSerialPortChecksum::checksum(frame, QSerialPortChecksum::Crc16Modbus) != 0) {
+            m_request.remove(0, 1);
+            continue;
+        }
+        handleFrame(frame, output);
+        m_request.remove(0, size);
+    }
+
+    if (m_request.size() > MaximumModbusFrameSize)
+        m_request.clear();
+}
+
+void QSerialPortModbusServerModel::handleFrame(QByteArrayView frame, QByteArray *output)
+{
+    const quint8 address = quint8(frame.at(0));
+    const quint8 function = quint8(frame.at(1));
+    if (address != m_address && address != 0)
+        return;
+
+    const auto bytes = reinterpret_cast<const uchar *>(frame.data());
+    const int start = qFromBigEndian<quint16>(bytes + 2);
+    const int quantity = qFromBigEndian<quint16>(bytes + 4);
+
+    QByteArray pdu;
+    const auto exception = [&pdu, function](quint8 code) {
+        pdu = QByteArray(1, char(function | 0x80));
+        pdu.append(char(code));
+    };
+
+    switch (function) {
+    case 3:
+    case 4:
+        if (quantity < 1 || quantity > 125) {
+            exception(3);
+        } else if (start + quantity > m_registers.size()) {
+            exception(2);
+        } else {
+            pdu.append(char(function));
+            pdu.append(char(quantity * 2));
+            for (int i = 0; i < quantity; ++i) {
+                char value[2];
+                qToBigEndian<quint16>(m_registers.at(start + i), value);
+                pdu.append(value, sizeof(value));
+            }
+        }
+        break;
+    case 6:
+        if (start >= m_registers.size()) {
+            exception(2);
+        } else {
+            m_registers[start] = quint16(quantity);
+            pdu = frame.sliced(1, 5).toByteArray();
+        }
+        break;
+    case 16:
+        if (quantity < 1 || quantity > 123 || quint8(frame.at(6)) != quantity * 2) {
+            exception(3);
+        } else if (start + quantity > m_registers.size()) {
+            exception(2);
+        } else {
+            for (int i = 0; i < quantity; ++i)
+                m_registers[start + i] = qFromBigEndian<quint16>(bytes + 7 + 2 * i);
+            pdu = frame.sliced(1, 5).toByteArray();
+        }
+        break;
+    default:
+        exception(1);
+        break;
+    }
+
+    // Broadcasts are not answered.
+    if (address != 0)
+        appendReply(pdu, output);
+}
+
+void QSerialPortModbusServerModel::appendReply(QByteArray pdu, QByteArray *output) const
+{
+    pdu.prepend(char(m_address));
+    char crc[2];
+    qToLittleEndian<quint16>(
+            quint16(QSerialPortChecksum::checksum(pdu, QSerialPortChecksum::Crc16Modbus)), crc);
+    output->append(pdu);
+    output->append(crc, sizeof(crc));
+}
+
+QSerialPortTelemetryModel::QSerialPortTelemetryModel(qint32 baudRate, const Generator &generator)
+    : m_baudRate(baudRate)
+    , m_generator(generator)
+{
+    Q_ASSERT(baudRate > 0);
+}
+
+QSerialPortTelemetryModel::QSerialPortTelemetryModel(qint32 baudRate, const QByteArray &frame)
+    : QSerialPortTelemetryModel(baudRate, [frame](quint64) { return frame; })
+{
+}
+
+void QSerialPortTelemetryModel::received(QByteArrayView data, QByteArray *output)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(output);
+}
+
+// The next frame is due when the link is done with the previous ones.
+qint64 QSerialPortTelemetryModel::nextTick(qint64 now) const
+{
+    if (m_startTime < 0)
+        return now;
+    constexpr qint64 BitTimesPerSecond = Q_INT64_C(10000000000);
+    return m_startTime + m_sentBytes / m_baudRate * BitTimesPerSecond
+            + m_sentBytes % m_baudRate * BitTimesPerSecond / m_baudRate;
+}
+
+void QSerialPortTelemetryModel::tick(qint64 now, QByteArray *output)
+{
+    // Start over after a stall, instead of sending a burst to catch up.
+    if (m_startTime < 0 || nextTick(now) < now - 100000000) {
+        m_startTime = now;
+        m_sentBytes = 0;
+    }
+
+    while (nextTick(now) <= now) {
+        const QByteArray frame = m_generator(m_sequence++);
+        if (output->size() + frame.size() > MaximumQueuedBytes)
+            ++m_droppedFrames;
+        else
+            output->append(frame);
+        m_sentBytes += qMax(frame.size(), qsizetype(1));
+    }
+}
+
+struct QSerialPortSimulator::Device
+{
+    int master = -1;
+    int slave = -1;
+    QString portName;
+    std::unique_ptr<QSerialPortSimulatorModel> model;
+    // What the device has yet to send.
+    QByteArray output;
+    bool writeInterest = false;
+    qint64 nextTick = -1;
+};
+
+struct QSerialPortSimulator::Worker
+{
+    int epoll = -1;
+    int wakeup = -1;
+    std::vector<Device *> devices;
+    qint64 nextTick = -1;
+};
+
+QSerialPortSimulator::QSerialPortSimulator(int threadCount)
+    : m_threadCount(qMax(threadCount, 1))
+{
+}
+
+QSerialPortSimulator::~QSerialPortSimulator()
+{
+    stop();
+    for (const std::unique_ptr<Device> &device : m_devices) {
+        if (device->slave != -1)
+            ::close(device->slave);
+        if (device->master != -1)
+            ::close(device->master);
+    }
+}
+
+QString QSerialPortSimulator::addDevice(std::unique_ptr<QSerialPortSimulatorModel> model)
+{
+    if (isRunning()) {
+        m_errorString = QStringLiteral("Devices cannot be added while the simulator runs");
+        return QString();
+    }
+
+    auto device = std::make_unique<Device>();
+    device->model = std::move(model);
+
+    const auto fail = [this, &device]() {
+        m_errorString = qt_error_string(errno);
+        if (device->slave != -1)
+            ::close(device->slave);
+        if (device->master != -1)
+            ::close(device->master);
+        return QString();
+    };
+
+    device->master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (device->master == -1 || ::grantpt(device->master) == -1
+            || ::unlockpt(device->master) == -1) {
+        return fail();
+    }
+    char slaveName[PATH_MAX];
+    if (::ptsname_r(device->master, slaveName, sizeof(slaveName)) != 0)
+        return fail();
+
+    // The slave stays open, so that the master does not fail with EIO
+    // while no port has the device open.
+    device->slave = ::open(slaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (device->slave == -1)
+        return fail();
+
+    termios tio;
+    if (::tcgetattr(device->slave, &tio) == -1)
+        return fail();
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    if (::tcsetattr(device->slave, TCSANOW, &tio) == -1)
+        return fail();
+    if (::fcntl(device->master, F_SETFL, ::fcntl(device->master, F_GETFL) | O_NONBLOCK) == -1)
+        return fail();
+
+    const QString location = QString::fromLocal8Bit(slaveName);
+    device->portName = location.startsWith(QLatin1String("/dev/")) ? location.mid(5) : location;
+    m_devices.push_back(std::move(device));
+    return m_devices.back()->portName;
+}
+
+QStringList QSerialPortSimulator::portNames() const
+{
+    QStringList names;
+    names.reserve(qsizetype(m_devices.size()));
+    for (const std::unique_ptr<Device> &device : m_devices)
+        names.append(device->portName);
+    return names;
+}
+
+bool QSerialPortSimulator::start()
+{
+    if (isRunning())
+        return true;
+
+    for (int i = 0; i < m_threadCount; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        worker->wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        const bool created = worker->epoll != -1 && worker->wakeup != -1
+                && ::epoll_ctl(worker->epoll, EPOLL_CTL_ADD, worker->wakeup, &event) == 0;
+        m_workers.push_back(std::move(worker));
+        if (!created) {
+            m_errorString = qt_error_string(errno);
+            stop();
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < m_devices.size(); ++i) {
+        Device *device = m_devices[i].get();
+        Worker *worker = m_workers[i % m_workers.size()].get();
+        device->writeInterest = false;
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = device;
+        if (::epoll_ctl(worker->epoll, EPOLL_CTL_ADD, device->master, &event) == -1) {
+            m_errorString = qt_error_string(errno);
+            stop();
+            return false;
+        }
+        worker->devices.push_back(device);
+    }
+
+    for (const std::unique_ptr<Worker> &worker : m_workers) {
+        Worker *w = worker.get();
+        m_threads.emplace_back([this, w]() { service(w); });
+    }
+    return true;
+}
+
+void QSerialPortSimulator::stop()
+{
+    for (const std::unique_ptr<Worker> &worker : m_workers) {
+        if (worker->wakeup != -1) {
+            const quint64 value = 1;
+            while (::write(worker->wakeup, &value, sizeof(value)) == -1 && errno == EINTR) {
+            }
+        }
+    }
+    for (std::thread &thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    for (const std::unique_ptr<Worker> &worker : m_workers) {
+        if (worker->wakeup != -1)
+            ::close(worker->wakeup);
+        if (worker->epoll != -1)
+            ::close(worker->epoll);
+    }
+    m_workers.clear();
+}
+
+bool QSerialPortSimulator::raiseFileDescriptorLimit()
+{
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == -1)
+        return false;
+    if (limit.rlim_cur == limit.rlim_max)
+        return true;
+    limit.rlim_cur = limit.rlim_max;
+    return ::setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+void QSerialPortSimulator::service(Worker *worker)
+{
+    qint64 now = currentTime();
+    for (Device *device : worker->devices) {
+        device->nextTick = device->model->nextTick(now);
+        if (device->nextTick >= 0 && (worker->nextTick < 0 || device->nextTick < worker->nextTick))
+            worker->nextTick = device->nextTick;
+    }
+
+    epoll_event events[EventsPerWait];
+    for (;;) {
+        int timeout = -1;
+        if (worker->nextTick >= 0) {
+            now = currentTime();
+            timeout = worker->nextTick <= now
+                    ? 0 : int(qMin((worker->nextTick - now + 999999) / 1000000, qint64(INT_MAX)));
+        }
+
+        const int count = ::epoll_wait(worker->epoll, events, EventsPerWait, timeout);
+        if (count == -1) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        m_wakeups.fetchAndAddRelaxed(1);
+
+        for (int i = 0; i < count; ++i) {
+            auto device = static_cast<Device *>(events[i].data.ptr);
+            if (!device)
+                return;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                readDevice(worker, device);
+            if (events[i].events & EPOLLOUT)
+                writeDevice(worker, device);
+        }
+
+        if (worker->nextTick < 0)
+            continue;
+        now = currentTime();
+        if (now < worker->nextTick)
+            continue;
+
+        worker->nextTick = -1;
+        for (Device *device : worker->devices) {
+            if (device->nextTick >= 0 && device->nextTick <= now) {
+                device->model->tick(now, &device->output);
+                writeDevice(worker, device);
+                device->nextTick = device->model->nextTick(now);
+            }
+            if (device->nextTick >= 0 && (worker->nextTick < 0 || device->nextTick < worker->nextTick))
+                worker->nextTick = device->nextTick;
+        }
+    }
+}
+
+void QSerialPortSimulator::readDevice(Worker *worker, Device *device)
+{
+    char buffer[16384];
+    for (;;) {
+        const ssize_t bytes = ::read(device->master, buffer, sizeof(buffer));
+        if (bytes > 0) {
+            m_receivedBytes.fetchAndAddRelaxed(quint64(bytes));
+            device->model->received(QByteArrayView(buffer, bytes), &device->output);
+            if (size_t(bytes) < sizeof(buffer))
+                break;
+            continue;
+        }
+        if (bytes == -1 && errno == EINTR)
+            continue;
+        if (bytes == -1 && errno == EAGAIN)
+            break;
+
+        // The terminal is gone; stop watching it rather than spinning.
+        ::epoll_ctl(worker->epoll, EPOLL_CTL_DEL, device->master, nullptr);
+        return;
+    }
+    writeDevice(worker, device);
+}
+
+void QSerialPortSimulator::writeDevice(Worker *worker, Device *device)
+{
+    qsizetype written = 0;
+    while (written < device->output.size()) {
+        const ssize_t bytes = ::write(device->master, device->output.constData() + written,
+                                      size_t(device->output.size() - written));
+        if (bytes > 0) {
+            written += bytes;
+            continue;
+        }
+        if (bytes == -1 && errno == EINTR)
+            continue;
+        break;
+    }
+
+    if (written > 0) {
+        m_sentBytes.fetchAndAddRelaxed(quint64(written));
+        if (written == device->output.size())
+            device->output.resize(0);
+        else
+            device->output.remove(0, written);
+    }
+    setWriteInterest(worker, device, !device->output.isEmpty());
+}
+
+void QSerialPortSimulator::setWriteInterest(Worker *worker, Device *device, bool enabled)
+{
+    if (device->writeInterest == enabled)
+        return;
+    epoll_event event = {};
+    event.events = enabled ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.ptr = device;
+    if (::epoll_ctl(worker->epoll, EPOLL_CTL_MOD, device->master, &event) == 0)
+        device->writeInterest = enabled;
+}
@@ -0,0 +1,161 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#ifndef QSERIALPORTSIMULATOR_H
+#define QSERIALPORTSIMULATOR_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qstringlist.h>
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// The behavior of a simulated device. A model is only ever called from the
+// thread that services its device.
+class QSerialPortSimulatorModel
+{
+public:
+    virtual ~QSerialPortSimulatorModel();
+
+    // Handles the bytes that the port wrote to the device, and appends the
+    // reply of the device, if any, to output.
+    virtual void received(QByteArrayView data, QByteArray *output) = 0;
+
+    // Returns the monotonic time in nanoseconds at which tick() is to be
+    // called next, or -1 if the model does not send on its own.
+    virtual qint64 nextTick(qint64 now) const;
+    virtual void tick(qint64 now, QByteArray *output);
+};
+
+// Sends back everything it receives.
+class QSerialPortEchoModel : public QSerialPortSimulatorModel
+{
+public:
+    void received(QByteArrayView data, QByteArray *output) override;
+};
+
+// Answers each request, terminated by the terminator, with a fixed response.
+class QSerialPortFixedResponseModel : public QSerialPortSimulatorModel
+{
+public:
+    explicit QSerialPortFixedResponseModel(const QByteArray &response, char terminator = '\n');
+
+    void received(QByteArrayView data, QByteArray *output) override;
+
+private:
+    QByteArray m_response;
+    char m_terminator;
+};
+
+// A Modbus RTU server with a table of registers, that answers the reading
+// of holding and input registers (functions 3 and 4) and the writing of
+// single and multiple registers (functions 6 and 16), and the other
+// functions with an exception.
+class QSerialPortModbusServerModel : public QSerialPortSimulatorModel
+{
+public:
+    explicit QSerialPortModbusServerModel(quint8 address, int registerCount = 1024);
+
+    void received(QByteArrayView data, QByteArray *output) override;
+
+    quint16 registerValue(int address) const { return m_registers.at(address); }
+    void setRegisterValue(int address, quint16 value) { m_registers[address] = value; }
+
+private:
+    qsizetype frameSize() const;
+    void handleFrame(QByteArrayView frame, QByteArray *output);
+    void appendReply(QByteArray pdu, QByteArray *output) const;
+
+    quint8 m_address;
+    QList<quint16> m_registers;
+    QByteArray m_request;
+};
+
+// Sends frames back to back, as fast as a link at the given baud rate with
+// 10 bits per character carries them. The frames are made by the generator
+// from a running sequence number. No more than a limited amount is queued
+// while the port does not read, like a device that drops what it cannot
+// send.
+class QSerialPortTelemetryModel : public QSerialPortSimulatorModel
+{
+public:
+    using Generator = std::function<QByteArray(quint64 sequence)>;
+
+    QSerialPortTelemetryModel(qint32 baudRate, const Generator &generator);
+    QSerialPortTelemetryModel(qint32 baudRate, const QByteArray &frame);
+
+    void received(QByteArrayView data, QByteArray *output) override;
+    qint64 nextTick(qint64 now) const override;
+    void tick(qint64 now, QByteArray *output) override;
+
+    quint64 sentFrames() const { return m_sequence - m_droppedFrames; }
+    quint64 droppedFrames() const { return m_droppedFrames; }
+
+private:
+    qint32 m_baudRate;
+    Generator m_generator;
+    qint64 m_startTime = -1;
+    qint64 m_sentBytes = 0;
+    quint64 m_sequence = 0;
+    quint64 m_droppedFrames = 0;
+};
+
+// Virtual devices on the master sides of pseudo terminals, whose slave
+// devices the ports open like any other port. The devices are serviced by
+// a small pool of threads, each of them waiting on an epoll set.
+//
+// Devices are added before start(), and live until the simulator is
+// destroyed. Linux only.
+class QSerialPortSimulator
+{
+public:
+    explicit QSerialPortSimulator(int threadCount = 2);
+    ~QSerialPortSimulator();
+
+    // Returns the short name of the port of the new device, such as
+    // "pts/7", or an empty string on failure.
+    QString addDevice(std::unique_ptr<QSerialPortSimulatorModel> model);
+    QStringList portNames() const;
+    qsizetype deviceCount() const { return qsizetype(m_devices.size()); }
+
+    bool start();
+    void stop();
+    bool isRunning() const { return !m_threads.empty(); }
+
+    QString errorString() const { return m_errorString; }
+
+    quint64 receivedBytes() const { return m_receivedBytes.loadRelaxed(); }
+    quint64 sentBytes() const { return m_sentBytes.loadRelaxed(); }
+    quint64 wakeups() const { return m_wakeups.loadRelaxed(); }
+
+    // Raises the limit of open files to the hard limit, as every device
+    // takes two descriptors, and every port one more.
+    static bool raiseFileDescriptorLimit();
+
+private:
+    Q_DISABLE_COPY(QSerialPortSimulator)
+
+    struct Device;
+    struct Worker;
+
+    void service(Worker *worker);
+    void readDevice(Worker *worker, Device *device);
+    void writeDevice(Worker *worker, Device *device);
+    void setWriteInterest(Worker *worker, Device *device, bool enabled);
+
+    int m_threadCount;
+    std::vector<std::unique_ptr<Device>> m_devices;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    QString m_errorString;
+
+    QAtomicInteger<quint64> m_receivedBytes;
+    QAtomicInteger<quint64> m_sentBytes;
+    QAtomicInteger<quint64> m_wakeups;
+};
+
+#endif // QSERIALPORTSIMULATOR_H
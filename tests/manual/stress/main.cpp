@@ -0,0 +1,390 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "../simulator/qserialportsimulator.h"
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtextstream.h>
+#include <QtSerialPort/qserialport.h>
+
+#include <memory>
+#include <vector>
+
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+// Opens many ports on simulated devices, spread over one or several
+// threads, drives traffic through them for a while, and reports what the
+// ports cost: the CPU time, the wakeups and the read and write system calls
+// of the threads of the ports per message, and the memory per open port.
+//
+//   serialportstress --ports 1000 --threads 4 --mode telemetry --baud 115200
+//   serialportstress --ports 200 --mode request --locking none
+
+namespace {
+
+struct Options
+{
+    bool requestMode = false;
+    bool idleMemoryMode = false;
+    qint64 readBufferSize = 0;
+    QSerialPort::LockingPolicy lockingPolicy = QSerialPort::LockFileLocking;
+};
+
+// The counters of a thread, and of the ports it serves.
+struct Counters
+{
+    qint64 cpuTime = 0;
+    qint64 voluntarySwitches = 0;
+    qint64 involuntarySwitches = 0;
+    qint64 readCalls = 0;
+    qint64 writeCalls = 0;
+    qint64 notifications = 0;
+    qint64 messages = 0;
+    qint64 bytes = 0;
+    // A level rather than a count.
+    qint64 memoryFootprint = 0;
+
+    Counters &operator+=(const Counters &other)
+    {
+        cpuTime += other.cpuTime;
+        voluntarySwitches += other.voluntarySwitches;
+        involuntarySwitches += other.involuntarySwitches;
+        readCalls += other.readCalls;
+        writeCalls += other.writeCalls;
+        notifications += other.notifications;
+        messages += other.messages;
+        bytes += other.bytes;
+        memoryFootprint += other.memoryFootprint;
+        return *this;
+    }
+
+    Counters operator-(const Counters &other) const
+    {
+        Counters result = *this;
+        result.cpuTime -= other.cpuTime;
+        result.voluntarySwitches -= other.voluntarySwitches;
+        result.involuntarySwitches -= other.involuntarySwitches;
+        result.readCalls -= other.readCalls;
+        result.writeCalls -= other.writeCalls;
+        result.notifications -= other.notifications;
+        result.messages -= other.messages;
+        result.bytes -= other.bytes;
+        return result;
+    }
+};
+
+qint64 residentSetSize()
+{
+    QFile file(QStringLiteral("/proc/self/statm"));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * ::sysconf(_SC_PAGESIZE) : 0;
+}
+
+qint64 processCpuTime()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000
+            + (qint64(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+}
+
+class PortWorker : public QObject
+{
+public:
+    bool open(const QStringList &portNames, const Options &options)
+    {
+        m_options = options;
+        for (const QString &portName : portNames) {
+            auto port = new QSerialPort(portName, this);
+            port->setLockingPolicy(options.lockingPolicy);
+            port->setIdleMemoryModeEnabled(options.idleMemoryMode);
+            if (options.readBufferSize)
+                port->setReadBufferSize(options.readBufferSize);
+            if (!port->open(QIODevice::ReadWrite)) {
+                QTextStream(stderr) << "Could not open " << portName << ": "
+                                    << port->errorString() << Qt::endl;
+                return false;
+            }
+            connect(port, &QIODevice::readyRead, this, [this, port]() {
+                handleReadyRead(port);
+            });
+            m_ports.push_back(port);
+        }
+        return true;
+    }
+
+    void start()
+    {
+        if (!m_options.requestMode)
+            return;
+        for (QSerialPort *port : m_ports)
+            port->write("REQ\n", 4);
+    }
+
+    void close()
+    {
+        qDeleteAll(m_ports);
+        m_ports.clear();
+    }
+
+    Counters counters() const
+    {
+        Counters counters = m_counters;
+        for (const QSerialPort *port : m_ports)
+            counters.memoryFootprint += port->memoryFootprint();
+
+        timespec cpuTime;
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+        counters.cpuTime = qint64(cpuTime.tv_sec) * 1000000000 + cpuTime.tv_nsec;
+
+        rusage usage;
+        ::getrusage(RUSAGE_THREAD, &usage);
+        counters.voluntarySwitches = usage.ru_nvcsw;
+        counters.involuntarySwitches = usage.ru_nivcsw;
+
+        // Only the read and write calls are counted per thread by Linux.
+        QFile io(QStringLiteral("/proc/thread-self/io"));
+        if (io.open(QIODevice::ReadOnly)) {
+            const QList<QByteArray> lines = io.readAll().split('\n');
+            for (const QByteArray &line : lines) {
+                if (line.startsWith("syscr:"))
+                    counters.readCalls = line.mid(6).trimmed().toLongLong();
+                else if (line.startsWith("syscw:"))
+                    counters.writeCalls = line.mid(6).trimmed().toLongLong();
+            }
+        }
+        return counters;
+    }
+
+private:
+    void handleReadyRead(QSerialPort *port)
+    {
+        ++m_counters.notifications;
+        char buffer[4096];
+        qint64 bytes;
+        while ((bytes = port->read(buffer, sizeof(buffer))) > 0) {
+            m_counters.bytes += bytes;
+            for (qint64 i = 0; i < bytes; ++i) {
+                if (buffer[i] != '\n')
+                    continue;
+                ++m_counters.messages;
+                if (m_options.requestMode)
+                    port->write("REQ\n", 4);
+            }
+        }
+    }
+
+    Options m_options;
+    std::vector<QSerialPort *> m_ports;
+    Counters m_counters;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("serialportstress"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+            "Measures the cost of many open serial ports on simulated devices."));
+    parser.addHelpOption();
+    parser.addOptions({
+        { { QStringLiteral("n"), QStringLiteral("ports") },
+          QStringLiteral("The number of ports."), QStringLiteral("count"), QStringLiteral("100") },
+        { { QStringLiteral("t"), QStringLiteral("threads") },
+          QStringLiteral("The number of threads serving the ports."), QStringLiteral("count"),
+          QStringLiteral("1") },
+        { { QStringLiteral("d"), QStringLiteral("duration") },
+          QStringLiteral("The duration of the measurement in seconds."),
+          QStringLiteral("seconds"), QStringLiteral("10") },
+        { { QStringLiteral("m"), QStringLiteral("mode") },
+          QStringLiteral("telemetry, where the devices send lines at the baud rate, or "
+                         "request, where each port sends the next request line as soon as "
+                         "the previous one is answered."),
+          QStringLiteral("mode"), QStringLiteral("telemetry") },
+        { QStringLiteral("baud"),
+          QStringLiteral("The baud rate at which the telemetry devices send."),
+          QStringLiteral("rate"), QStringLiteral("9600") },
+        { QStringLiteral("read-buffer-size"),
+          QStringLiteral("The read buffer size of the ports, 0 for unlimited."),
+          QStringLiteral("bytes"), QStringLiteral("0") },
+        { QStringLiteral("locking"),
+          QStringLiteral("The locking policy of the ports: lockfile, flock, exclusive or none."),
+          QStringLiteral("policy"), QStringLiteral("lockfile") },
+        { QStringLiteral("idle-memory"),
+          QStringLiteral("Open the ports in the idle memory mode.") },
+        { QStringLiteral("simulator-threads"),
+          QStringLiteral("The number of threads serving the simulated devices."),
+          QStringLiteral("count"), QStringLiteral("2") }
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const int portCount = parser.value(QStringLiteral("ports")).toInt();
+    const int duration = parser.value(QStringLiteral("duration")).toInt();
+    const QString mode = parser.value(QStringLiteral("mode"));
+    const qint32 baudRate = parser.value(QStringLiteral("baud")).toInt();
+    const QString locking = parser.value(QStringLiteral("locking"));
+
+    Options options;
+    options.requestMode = mode == QLatin1String("request");
+    options.idleMemoryMode = parser.isSet(QStringLiteral("idle-memory"));
+    options.readBufferSize = parser.value(QStringLiteral("read-buffer-size")).toLongLong();
+    bool validLocking = true;
+    if (locking == QLatin1String("lockfile"))
+        options.lockingPolicy = QSerialPort::LockFileLocking;
+    else if (locking == QLatin1String("flock"))
+        options.lockingPolicy = QSerialPort::FlockLocking;
+    else if (locking == QLatin1String("exclusive"))
+        options.lockingPolicy = QSerialPort::ExclusiveModeLocking;
+    else if (locking == QLatin1String("none"))
+        options.lockingPolicy = QSerialPort::NoLocking;
+    else
+        validLocking = false;
+
+    if (portCount < 1 || duration < 1 || baudRate < 1 || !validLocking
+            || (!options.requestMode && mode != QLatin1String("telemetry"))) {
+        err << "Invalid arguments" << Qt::endl;
+        return 1;
+    }
+
+    const int threadCount = qBound(1, parser.value(QStringLiteral("threads")).toInt(), portCount);
+
+    if (!QSerialPortSimulator::raiseFileDescriptorLimit())
+        err << "Could not raise the limit of open files" << Qt::endl;
+
+    QSerialPortSimulator simulator(parser.value(QStringLiteral("simulator-threads")).toInt());
+    for (int i = 0; i < portCount; ++i) {
+        std::unique_ptr<QSerialPortSimulatorModel> model;
+        if (options.requestMode) {
+            model = std::make_unique<QSerialPortFixedResponseModel>(QByteArray("OK\r\n"));
+        } else {
+            model = std::make_unique<QSerialPortTelemetryModel>(baudRate, [i](quint64 sequence) {
+                return QByteArray("$TLM,") + QByteArray::number(i) + ','
+                        + QByteArray::number(sequence) + ",23.5,1013.2\r\n";
+            });
+        }
+        if (simulator.addDevice(std::move(model)).isEmpty()) {
+            err << "Could not create device " << i << ": " << simulator.errorString() << Qt::endl;
+            return 1;
+        }
+    }
+
+    // The ports are spread evenly over the threads, and each port lives in
+    // the thread that serves it.
+    const QStringList portNames = simulator.portNames();
+    std::vector<std::unique_ptr<QThread>> threads;
+    std::vector<std::unique_ptr<PortWorker>> workers;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.push_back(std::make_unique<QThread>());
+        workers.push_back(std::make_unique<PortWorker>());
+        workers.back()->moveToThread(threads.back().get());
+        threads.back()->start();
+    }
+    const auto shutdown = [&]() {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            PortWorker *worker = workers[i].get();
+            QMetaObject::invokeMethod(worker, [worker]() { worker->close(); },
+                                      Qt::BlockingQueuedConnection);
+            threads[i]->quit();
+            threads[i]->wait();
+        }
+        simulator.stop();
+    };
+
+    const qint64 memoryBeforeOpen = residentSetSize();
+    for (int i = 0; i < threadCount; ++i) {
+        QStringList names;
+        for (int j = i; j < portNames.size(); j += threadCount)
+            names.append(portNames.at(j));
+        PortWorker *worker = workers[i].get();
+        bool opened = false;
+        QMetaObject::invokeMethod(worker, [worker, names, options]() {
+            return worker->open(names, options);
+        }, Qt::BlockingQueuedConnection, &opened);
+        if (!opened) {
+            shutdown();
+            return 1;
+        }
+    }
+    const qint64 memoryAfterOpen = residentSetSize();
+
+    if (!simulator.start()) {
+        err << "Could not start the simulator: " << simulator.errorString() << Qt::endl;
+        shutdown();
+        return 1;
+    }
+    for (const std::unique_ptr<PortWorker> &worker : workers) {
+        PortWorker *w = worker.get();
+        QMetaObject::invokeMethod(w, [w]() { w->start(); }, Qt::BlockingQueuedConnection);
+    }
+
+    // Let the traffic settle before measuring.
+    QThread::sleep(1);
+
+    const auto collect = [&]() {
+        Counters total;
+        for (const std::unique_ptr<PortWorker> &worker : workers) {
+            PortWorker *w = worker.get();
+            Counters counters;
+            QMetaObject::invokeMethod(w, [w]() { return w->counters(); },
+                                      Qt::BlockingQueuedConnection, &counters);
+            total += counters;
+        }
+        return total;
+    };
+
+    const Counters start = collect();
+    const qint64 processCpuStart = processCpuTime();
+    const quint64 simulatorWakeupsStart = simulator.wakeups();
+    QElapsedTimer timer;
+    timer.start();
+
+    QThread::sleep(duration);
+
+    const Counters counters = collect() - start;
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    const qint64 processCpu = processCpuTime() - processCpuStart;
+    const quint64 simulatorWakeups = simulator.wakeups() - simulatorWakeupsStart;
+    const qint64 memoryAfterTraffic = residentSetSize();
+
+    shutdown();
+
+    const double messages = qMax(counters.messages, qint64(1));
+    out << "ports " << portCount << ", threads " << threadCount << ", mode " << mode
+        << ", " << seconds << " s" << Qt::endl;
+    out << "messages:            " << counters.messages << " (" << counters.messages / seconds
+        / portCount << " per port per second, " << counters.bytes / seconds << " B/s in total)"
+        << Qt::endl;
+    out << "CPU of port threads: " << counters.cpuTime / 1e6 << " ms, "
+        << counters.cpuTime / 1e3 / messages << " us per message, "
+        << 100.0 * counters.cpuTime / 1e9 / seconds / portCount << " % of a core per port"
+        << Qt::endl;
+    out << "wakeups:             " << counters.voluntarySwitches / seconds
+        << " voluntary and " << counters.involuntarySwitches / seconds
+        << " involuntary context switches per second, "
+        << counters.voluntarySwitches / messages << " per message" << Qt::endl;
+    out << "notifications:       " << counters.notifications / messages << " readyRead per message"
+        << Qt::endl;
+    out << "system calls:        " << counters.readCalls / messages << " read and "
+        << counters.writeCalls / messages << " write calls per message" << Qt::endl;
+    out << "memory per port:     " << (memoryAfterOpen - memoryBeforeOpen) / 1024.0 / portCount
+        << " KiB after opening, " << (memoryAfterTraffic - memoryBeforeOpen) / 1024.0 / portCount
+        << " KiB after traffic, " << counters.memoryFootprint / 1024.0 / portCount
+        << " KiB reported by the ports" << Qt::endl;
+    out << "process CPU:         " << processCpu / 1e6 << " ms, including "
+        << simulatorWakeups / seconds << " wakeups per second of the simulator" << Qt::endl;
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#ifndef QSERIALPORTPTYPAIR_H
+#define QSERIALPORTPTYPAIR_H
+
+#include <QtCore/qglobal.h>
+#include <QtCore/qstring.h>
+
+#include <memory>
+
+#if defined(Q_OS_UNIX)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <thread>
+#endif
+
+// Two pseudo terminals whose master sides are linked by a relay thread,
+// so that what is written to one slave device can be read from the other,
+// as with two serial ports connected by a null modem cable.
+//
+// The slave devices are real terminals, configured like a serial port, and
+// QSerialPort opens them by their names like any other port. They are not
+// listed by QSerialPortInfo, and have no modem control lines: the pinout
+// signals, breaks and mismatched baud rates cannot be tested with them.
+class QSerialPortPtyPair
+{
+public:
+    QSerialPortPtyPair()
+    {
+#if defined(Q_OS_UNIX)
+        if (::pipe(m_stopPipe) == -1)
+            return;
+        for (End &end : m_ends) {
+            if (!openEnd(end))
+                return;
+        }
+        m_relay = std::thread([this]() { relay(); });
+#endif
+    }
+
+    ~QSerialPortPtyPair()
+    {
+#if defined(Q_OS_UNIX)
+        if (m_relay.joinable()) {
+            const char stop = 0;
+            while (::write(m_stopPipe[1], &stop, 1) == -1 && errno == EINTR) {
+            }
+            m_relay.join();
+        }
+        for (End &end : m_ends) {
+            if (end.slave != -1)
+                ::close(end.slave);
+            if (end.master != -1)
+                ::close(end.master);
+        }
+        for (int fd : m_stopPipe) {
+            if (fd != -1)
+                ::close(fd);
+        }
+#endif
+    }
+
+    bool isValid() const
+    {
+#if defined(Q_OS_UNIX)
+        return m_relay.joinable();
+#else
+        return false;
+#endif
+    }
+
+    // Short port names, such as "pts/3", like the ones the tests take from
+    // QTEST_SERIALPORT_SENDER and QTEST_SERIALPORT_RECEIVER.
+    QString senderPortName() const { return m_ends[0].portName; }
+    QString receiverPortName() const { return m_ends[1].portName; }
+
+    // Takes the port names from QTEST_SERIALPORT_SENDER and
+    // QTEST_SERIALPORT_RECEIVER, or from a new pair of pseudo terminals,
+    // which is kept in ptyPair, when either is unset. Returns false when
+    // there are no ports to test with; the tests then skip with
+    // missingPortsMessage.
+    static bool resolvePortNames(QString *senderPortName, QString *receiverPortName,
+                                 std::unique_ptr<QSerialPortPtyPair> *ptyPair)
+    {
+        *senderPortName = QString::fromLocal8Bit(qgetenv("QTEST_SERIALPORT_SENDER"));
+        *receiverPortName = QString::fromLocal8Bit(qgetenv("QTEST_SERIALPORT_RECEIVER"));
+        if (senderPortName->isEmpty() || receiverPortName->isEmpty()) {
+            *ptyPair = std::make_unique<QSerialPortPtyPair>();
+            if ((*ptyPair)->isValid()) {
+                *senderPortName = (*ptyPair)->senderPortName();
+                *receiverPortName = (*ptyPair)->receiverPortName();
+            } else {
+                ptyPair->reset();
+            }
+        }
+        return !senderPortName->isEmpty() && !receiverPortName->isEmpty();
+    }
+
+    static constexpr char missingPortsMessage[] =
+            "Test doesn't work because the names of serial ports aren't found in env.\n"
+            "Please set environment variables:\n"
+            " QTEST_SERIALPORT_SENDER to name of output serial port\n"
+            " QTEST_SERIALPORT_RECEIVER to name of input serial port\n"
+            "Specify short names of port"
+#if defined(Q_OS_UNIX)
+            ", like: ttyS0\n";
+#elif defined(Q_OS_WIN32)
+            ", like: COM1\n";
+#else
+            "\n";
+#endif
+
+private:
+    Q_DISABLE_COPY(QSerialPortPtyPair)
+
+    struct End
+    {
+        int master = -1;
+        int slave = -1;
+        QString portName;
+        // Read from the master, waiting to be written to the other master.
+        char buffer[4096];
+        qint64 offset = 0;
+        qint64 pending = 0;
+    };
+
+#if defined(Q_OS_UNIX)
+    static bool openEnd(End &end)
+    {
+        end.master = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (end.master == -1 || ::grantpt(end.master) == -1 || ::unlockpt(end.master) == -1)
+            return false;
+        const char *slaveName = ::ptsname(end.master);
+        if (!slaveName)
+            return false;
+
+        // The slave stays open, so that the master does not fail with EIO
+        // while no port has the device open.
+        end.slave = ::open(slaveName, O_RDWR | O_NOCTTY);
+        if (end.slave == -1)
+            return false;
+
+        termios tio;
+        if (::tcgetattr(end.slave, &tio) == -1)
+            return false;
+        ::cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        ::cfsetispeed(&tio, B9600);
+        ::cfsetospeed(&tio, B9600);
+        if (::tcsetattr(end.slave, TCSANOW, &tio) == -1)
+            return false;
+
+        if (::fcntl(end.master, F_SETFL, ::fcntl(end.master, F_GETFL) | O_NONBLOCK) == -1)
+            return false;
+
+        const QString location = QString::fromLocal8Bit(slaveName);
+        end.portName = location.startsWith(QLatin1String("/dev/")) ? location.mid(5) : location;
+        return true;
+    }
+
+    void relay()
+    {
+        for (;;) {
+            pollfd fds[3];
+            for (int i = 0; i < 2; ++i) {
+                fds[i].fd = m_ends[i].master;
+                fds[i].events = 0;
+                fds[i].revents = 0;
+                if (m_ends[i].pending == 0)
+                    fds[i].events |= POLLIN;
+                if (m_ends[1 - i].pending > 0)
+                    fds[i].events |= POLLOUT;
+            }
+            fds[2].fd = m_stopPipe[0];
+            fds[2].events = POLLIN;
+            fds[2].revents = 0;
+
+            if (::poll(fds, 3, -1) == -1) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            if (fds[2].revents)
+                return;
+
+            for (int i = 0; i < 2; ++i) {
+                End &end = m_ends[i];
+                if ((fds[i].revents & POLLIN) && end.pending == 0) {
+                    const ssize_t bytes = ::read(end.master, end.buffer, sizeof(end.buffer));
+                    if (bytes > 0) {
+                        end.offset = 0;
+                        end.pending = bytes;
+                    }
+                }
+            }
+            for (int i = 0; i < 2; ++i) {
+                End &source = m_ends[1 - i];
+                if ((fds[i].revents & POLLOUT) && source.pending > 0) {
+                    const ssize_t bytes = ::write(m_ends[i].master, source.buffer + source.offset,
+                                                  size_t(source.pending));
+                    if (bytes > 0) {
+                        source.offset += bytes;
+                        source.pending -= bytes;
+                    }
+                }
+            }
+        }
+    }
+
+    int m_stopPipe[2] = { -1, -1 };
+    std::thread m_relay;
+#endif
+    End m_ends[2];
+};
+
+#endif // QSERIALPORTPTYPAIR_H